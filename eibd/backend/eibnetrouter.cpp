@@ -32,7 +32,13 @@ Element * EIBNetIPRouter::_xml(Element *parent) const
   Element *n = parent->addElement(XMLBACKENDELEMENT);
   n->addAttribute(XMLBACKENDELEMENTTYPEATTR, _str());
   n->addAttribute(XMLBACKENDSTATUSATTR, "?");
+  if (mode || vmode || allgroups)
+    n->addAttribute(XMLBACKENDGROUPFILTERATTR, "all");
+  else
+    n->addAttribute(XMLBACKENDGROUPFILTERATTR, (int) groupaddr ());
+  n->addAttribute(XMLBACKENDFILTEREDATTR, (int) filtered);
   outqueue._xml(n);
+  pacer._xml(n);
   if (ipnetfilters.size())
     {
       std::string r="";
@@ -62,6 +68,8 @@ EIBNetIPRouter::EIBNetIPRouter (const char *multicastaddr, int port,
   addr = a;
   mode = 0;
   vmode = 0;
+  allgroups = 0;
+  filtered = 0;
   memset (&baddr, 0, sizeof (baddr));
 #ifdef HAVE_SOCKADDR_IN_LEN
   baddr.sin_len = sizeof (baddr);
@@ -70,6 +78,9 @@ EIBNetIPRouter::EIBNetIPRouter (const char *multicastaddr, int port,
   baddr.sin_port = htons (port);
   baddr.sin_addr.s_addr = htonl (INADDR_ANY);
   pth_sem_init (&out_signal);
+  pth_sem_init (&send_signal);
+  pth_sem_init (&send_empty);
+  pth_sem_set_value (&send_empty, 1);
   sock = new EIBNetIPSocket (baddr, 1, Thread::Loggers(), inquemaxlen, outquemaxlen, peerquemaxlen,ipnetfilters);
   if (!sock->init ())
     {
@@ -78,6 +89,7 @@ EIBNetIPRouter::EIBNetIPRouter (const char *multicastaddr, int port,
       throw Exception (DEV_OPEN_FAIL);
     }
   sock->recvall = 2;
+  sock->SetRecvView (ROUTING_INDICATION, this);
   if (GetHostIP (&sock->sendaddr, multicastaddr) == 0)
     {
 		  delete sock;
@@ -106,9 +118,13 @@ EIBNetIPRouter::EIBNetIPRouter (const char *multicastaddr, int port,
 EIBNetIPRouter::~EIBNetIPRouter ()
 {
   TRACEPRINTF (Thread::Loggers(), 2, this, "Destroy");
+  if (sock)
+    sock->SetRecvView (-1, NULL);
   Stop ();
   while (!outqueue.isempty ())
     delete outqueue.get ();
+  while (!sendqueue.isempty ())
+    delete sendqueue.get ();
   if (sock)
     delete sock;
 }
@@ -121,6 +137,23 @@ EIBNetIPRouter::init ()
 
 bool
 EIBNetIPRouter::Send_L_Data (LPDU * l)
+{
+  return Send (l, true);
+}
+
+unsigned
+EIBNetIPRouter::Send_L_Data_Batch (LPDU ** l, unsigned n)
+{
+  unsigned sent = 0;
+  // the router thread is woken once for the whole batch
+  for (unsigned i = 0; i < n; i++)
+    if (Send (l[i], i == n - 1))
+      sent++;
+  return sent;
+}
+
+bool
+EIBNetIPRouter::Send (LPDU * l, bool yield)
 {
   TRACEPRINTF (Thread::Loggers(), 2, this, "Send %s", l->Decode ()());
   if (l->getType () != L_Data)
@@ -128,25 +161,52 @@ EIBNetIPRouter::Send_L_Data (LPDU * l)
       delete l;
       return false;
     }
-  L_Data_PDU *l1 = (L_Data_PDU *) l;
-  EIBNetIPPacket p;
-  p.data = L_Data_ToCEMI (0x29, *l1);
-  p.service = ROUTING_INDICATION;
-  sock->Send (p);
-  if (vmode)
+  // paced by the router thread, so the caller never blocks
+  sendqueue.put (l);
+  pth_sem_set_value (&send_empty, 0);
+  pth_sem_inc (&send_signal, yield);
+  return true;
+}
+
+pth_event_t
+EIBNetIPRouter::Transmit ()
+{
+  while (!sendqueue.isempty ())
     {
-      L_Busmonitor_PDU *l2 = new L_Busmonitor_PDU;
-      l2->pdu.set (l->ToPacket ());
-      outqueue.put (l2);
-      pth_sem_inc (&out_signal, 1);
+      LPDU *l = sendqueue.top ();
+      EIBNetIPPacket p;
+      p.data = L_Data_ToCEMI (0x29, *(L_Data_PDU *) l);
+      p.service = ROUTING_INDICATION;
+      if (!pacer.Ready (p.data ()))
+	return pacer.Wait (p.data ());
+      sendqueue.get ();
+      pth_sem_dec (&send_signal);
+      if (sendqueue.isempty ())
+	pth_sem_set_value (&send_empty, 1);
+      pacer.Sent (p.data ());
+      sock->Send (p);
+      if (vmode)
+	{
+	  L_Busmonitor_PDU *l2 = new L_Busmonitor_PDU;
+	  l2->pdu.set (l->ToPacket ());
+	  outqueue.put (l2);
+	  pth_sem_inc (&out_signal, 0);
+	}
+      outqueue.put (l);
+      pth_sem_inc (&out_signal, 0);
     }
-  outqueue.put (l);
-  pth_sem_inc (&out_signal, 1);
-  return true;
+  return NULL;
 }
 
 LPDU *
 EIBNetIPRouter::Get_L_Data (pth_event_t stop)
+{
+  LPDU *l;
+  return Get_L_Data_Batch (stop, &l, 1) ? l : 0;
+}
+
+unsigned
+EIBNetIPRouter::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
 {
   pth_event_t getwait = pth_event (PTH_EVENT_SEM, &out_signal);
   if (stop != NULL)
@@ -163,10 +223,10 @@ EIBNetIPRouter::Get_L_Data (pth_event_t stop)
 
   if (s)
     {
-      pth_sem_dec (&out_signal);
-      LPDU *l = outqueue.get ();
-      TRACEPRINTF (Thread::Loggers(), 2, this, "Recv %s", l->Decode ()());
-      return l;
+      unsigned n = Take_From_Queue<LPDU *> (outqueue, l, max, &out_signal);
+      for (unsigned i = 0; i < n; i++)
+	TRACEPRINTF (Thread::Loggers(), 2, this, "Recv %s", l[i]->Decode ()());
+      return n;
     }
   else
     return 0;
@@ -177,61 +237,98 @@ void
 EIBNetIPRouter::Run (pth_sem_t * stop1)
 {
   pth_event_t stop = pth_event (PTH_EVENT_SEM, stop1);
+  pth_event_t sendev = pth_event (PTH_EVENT_SEM, &send_signal);
   while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
     {
-      EIBNetIPPacket *p = sock->Get (stop);
+      // wake up for a new frame to send or, while the pacer holds back
+      // the next one, when it may be sent
+      pth_event_t paced = Transmit ();
+      pth_event_t wake = paced ? paced : sendev;
+      pth_event_concat (wake, stop, NULL);
+      // routing indications are normally consumed by Recv_View
+      EIBNetIPPacket *p = sock->Get (wake);
+      pth_event_isolate (wake);
+      pth_event_isolate (stop);
       if (p)
 	{
-	  if (p->service != ROUTING_INDICATION)
-	    {
-	      delete p;
-	      continue;
-	    }
-	  if (p->data () < 2 || p->data[0] != 0x29)
-	    {
-	      delete p;
-	      continue;
-	    }
-	  const CArray data = p->data;
+	  if (p->service == ROUTING_INDICATION)
+	    Recv (p->data.array (), p->data ());
 	  delete p;
-	  L_Data_PDU *c = CEMI_to_L_Data (data);
-	  if (c)
-	    {
-	      TRACEPRINTF (Thread::Loggers(), 2, this, "Recv %s", c->Decode ()());
-	      if (mode == 0)
-		{
-		  if (vmode)
-		    {
-		      L_Busmonitor_PDU *l2 = new L_Busmonitor_PDU;
-		      l2->pdu.set (c->ToPacket ());
-		      outqueue.put (l2);
-		      pth_sem_inc (&out_signal, 1);
-		    }
-		  outqueue.put (c);
-		  pth_sem_inc (&out_signal, 1);
-		  continue;
-		}
-	      L_Busmonitor_PDU *p1 = new L_Busmonitor_PDU;
-	      p1->pdu = c->ToPacket ();
-	      delete c;
-	      outqueue.put (p1);
-	      pth_sem_inc (&out_signal, 1);
-	      continue;
-	    }
 	}
     }
+  pth_event_free (sendev, PTH_FREE_THIS);
   pth_event_free (stop, PTH_FREE_THIS);
 }
 
+bool
+EIBNetIPRouter::Recv_View (const uchar * data, unsigned len,
+			   const struct sockaddr_in & src)
+{
+  Recv (data, len);
+  return true;
+}
+
+void
+EIBNetIPRouter::Recv (const uchar * data, unsigned len)
+{
+  if (len < 2 || data[0] != 0x29)
+    return;
+  if (!Wanted (data, len))
+    {
+      filtered++;
+      return;
+    }
+  L_Data_PDU *c = CEMI_to_L_Data (data, len);
+  if (!c)
+    return;
+  TRACEPRINTF (Thread::Loggers(), 2, this, "Recv %s", c->Decode ()());
+  // no yield: a backlog of datagrams is queued before layer 3
+  // runs and then taken as one batch
+  if (mode == 0)
+    {
+      if (vmode)
+	{
+	  L_Busmonitor_PDU *l2 = new L_Busmonitor_PDU;
+	  l2->pdu.set (c->ToPacket ());
+	  outqueue.put (l2);
+	  pth_sem_inc (&out_signal, 0);
+	}
+      outqueue.put (c);
+      pth_sem_inc (&out_signal, 0);
+      return;
+    }
+  L_Busmonitor_PDU *p1 = new L_Busmonitor_PDU;
+  p1->pdu = c->ToPacket ();
+  delete c;
+  outqueue.put (p1);
+  pth_sem_inc (&out_signal, 0);
+}
+
 bool
 EIBNetIPRouter::addAddress (eibaddr_t addr)
 {
   return 1;
 }
 
+bool
+EIBNetIPRouter::Wanted (const uchar * data, unsigned len) const
+{
+  if (mode || vmode || allgroups)
+    return true;
+  unsigned start = data[1] + 2;
+  // too short frames are rejected by CEMI_to_L_Data
+  if (len < start + 6)
+    return true;
+  if (!(data[start + 1] & 0x80))
+    return true;
+  eibaddr_t dest = (data[start + 4] << 8) | (data[start + 5]);
+  return dest == 0 || groupaddr.test (dest);
+}
+
 bool
 EIBNetIPRouter::addGroupAddress (eibaddr_t addr)
 {
+  groupaddr.set (addr);
   return 1;
 }
 
@@ -244,6 +341,22 @@ EIBNetIPRouter::removeAddress (eibaddr_t addr)
 bool
 EIBNetIPRouter::removeGroupAddress (eibaddr_t addr)
 {
+  groupaddr.reset (addr);
+  return 1;
+}
+
+bool
+EIBNetIPRouter::openGroupMonitor ()
+{
+  allgroups++;
+  return 1;
+}
+
+bool
+EIBNetIPRouter::closeGroupMonitor ()
+{
+  if (allgroups)
+    allgroups--;
   return 1;
 }
 
@@ -297,7 +410,13 @@ EIBNetIPRouter::getDefaultAddr ()
 bool
 EIBNetIPRouter::Send_Queue_Empty ()
 {
-  return 1;
+  return sendqueue.isempty ();
+}
+
+pth_sem_t *
+EIBNetIPRouter::Send_Queue_Empty_Cond ()
+{
+  return &send_empty;
 }
 
 
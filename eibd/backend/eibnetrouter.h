@@ -22,9 +22,11 @@
 
 #include "layer2.h"
 #include "eibnetip.h"
+#include "addrbitmap.h"
 
 /** EIBnet/IP routing backend */
-class EIBNetIPRouter:public Layer2Interface, private Thread
+class EIBNetIPRouter:public Layer2Interface, private Thread,
+  private EIBNetIPRecvCallBack
 {
   /** default address */
   eibaddr_t addr;
@@ -38,10 +40,35 @@ class EIBNetIPRouter:public Layer2Interface, private Thread
   pth_sem_t out_signal;
   /** output queue */
     Queue < LPDU * >outqueue;
+  /** semaphore for sendqueue */
+  pth_sem_t send_signal;
+  /** frames waiting for the pacer */
+    Queue < LPDU * >sendqueue;
+  /** 1, if sendqueue is empty */
+  pth_sem_t send_empty;
+  /** group addresses added by layer 3 */
+  AddressBitmap groupaddr;
+  /** receivers for all group addresses */
+  int allgroups;
+  /** routing indications dropped by the group filter */
+  unsigned long filtered;
 
   const static char outdropmsg[], indropmsg[];
 
   void Run (pth_sem_t * stop);
+  /** queues l for sending, yield is false if more frames follow */
+  bool Send (LPDU * l, bool yield);
+  /** sends queued frames as far as the pacer allows
+   * @return pacer event to wait for, NULL if the queue is empty */
+  pth_event_t Transmit ();
+  /** checks the header of the cEMI frame in data[0..len), returns false
+   * if it is a group frame nobody has subscribed to */
+  bool Wanted (const uchar * data, unsigned len) const;
+  /** parses a routing indication in the receive buffer of sock */
+  bool Recv_View (const uchar * data, unsigned len,
+		  const struct sockaddr_in & src);
+  /** queues the frame of the routing indication data[0..len) */
+  void Recv (const uchar * data, unsigned len);
 public:
     EIBNetIPRouter (const char *multicastaddr, int port, eibaddr_t a,
 		    Logs * tr, int inquemaxlen, int outquemaxlen, int peerquemaxlen,
@@ -51,11 +78,15 @@ public:
 
   bool Send_L_Data (LPDU * l);
   LPDU *Get_L_Data (pth_event_t stop);
+  unsigned Send_L_Data_Batch (LPDU ** l, unsigned n);
+  unsigned Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max);
 
   bool addAddress (eibaddr_t addr);
   bool addGroupAddress (eibaddr_t addr);
   bool removeAddress (eibaddr_t addr);
   bool removeGroupAddress (eibaddr_t addr);
+  bool openGroupMonitor ();
+  bool closeGroupMonitor ();
 
   bool enterBusmonitor ();
   bool leaveBusmonitor ();
@@ -66,6 +97,7 @@ public:
   bool Close ();
   eibaddr_t getDefaultAddr ();
   bool Send_Queue_Empty ();
+  pth_sem_t *Send_Queue_Empty_Cond ();
 
   Element * _xml(Element *parent) const;
   void logtic();
@@ -68,6 +68,8 @@ EIBNetIPTunnel::EIBNetIPTunnel (const char *dest, int port, int sport,
   TRACEPRINTF(Thread::Loggers(), 2, this, "Open");
   pth_sem_init(&insignal);
   pth_sem_init(&outsignal);
+  pth_sem_init(&send_empty);
+  pth_sem_set_value(&send_empty, 1);
   noqueue = flags & FLAG_B_TUNNEL_NOQUEUE;
   sock = 0;
   if (!GetHostIP(&caddr, dest))
@@ -132,6 +134,22 @@ bool EIBNetIPTunnel::init ()
 
 bool
 EIBNetIPTunnel::Send_L_Data (LPDU * l)
+{
+  return Send (l, true);
+}
+
+unsigned
+EIBNetIPTunnel::Send_L_Data_Batch (LPDU ** l, unsigned n)
+{
+  unsigned sent = 0;
+  for (unsigned i = 0; i < n; i++)
+    if (Send (l[i], i == n - 1))
+      sent++;
+  return sent;
+}
+
+bool
+EIBNetIPTunnel::Send (LPDU * l, bool yield)
 {
   TRACEPRINTF(Thread::Loggers(), 2, this, "Send %s", l->Decode ()());
   if (l->getType() != L_Data)
@@ -143,9 +161,9 @@ EIBNetIPTunnel::Send_L_Data (LPDU * l)
 
   // careful logic, only return FALSE if l has to be dropped, CArray copies over
   if (Put_On_Queue_Or_Drop<CArray, CArray>(inqueue, L_Data_ToCEMI(0x11, *l1),
-      &insignal, true, indropmsg))
+      &insignal, yield, indropmsg, &send_empty))
     {
-      if (Put_On_Queue_Or_Drop<LPDU *, LPDU *>(outqueue, l, &outsignal, true,
+      if (Put_On_Queue_Or_Drop<LPDU *, LPDU *>(outqueue, l, &outsignal, yield,
           outdropmsg))
         {
           if (vmode)
@@ -153,7 +171,7 @@ EIBNetIPTunnel::Send_L_Data (LPDU * l)
               L_Busmonitor_PDU *l2 = new L_Busmonitor_PDU;
               l2->pdu.set(l->ToPacket());
               if (!Put_On_Queue_Or_Drop<LPDU *, L_Busmonitor_PDU *>(outqueue,
-                  l2, &outsignal, true, outdropmsg))
+                  l2, &outsignal, false, outdropmsg))
                 {
                   // thta's ok, just drop the vmode ,rest already queued
                   delete l2;
@@ -165,22 +183,31 @@ EIBNetIPTunnel::Send_L_Data (LPDU * l)
         {
           ++stat_senderr;
         }
+      delete l;
       return false;
     }
   else
     {
       ++stat_senderr;
     }
+  delete l;
   return false;
 }
 
 LPDU *
 EIBNetIPTunnel::Get_L_Data (pth_event_t stop)
+{
+  LPDU *l;
+  return Get_L_Data_Batch (stop, &l, 1) ? l : NULL;
+}
+
+unsigned
+EIBNetIPTunnel::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
 {
 
   if (Connection_Lost())
     {
-      return NULL;
+      return 0;
     }
   // wait for according link state change
   pth_event_t le =
@@ -224,15 +251,12 @@ EIBNetIPTunnel::Get_L_Data (pth_event_t stop)
   if (!Connection_Lost()
       && s)
     {
-      pth_sem_dec (&outsignal);
-      LPDU *c = outqueue.get();
-
-      return c;
+      return Take_From_Queue<LPDU *>(outqueue, l, max, &outsignal);
     }
 
   TRACEPRINTF(Thread::Loggers(), 0, this,
       "Send empty as signal up (link loss/up or stop)");
-  return NULL; // also if connection lost
+  return 0; // also if connection lost
 
 }
 
@@ -242,6 +266,21 @@ EIBNetIPTunnel::Send_Queue_Empty ()
   return inqueue.isempty ();
 }
 
+pth_sem_t *
+EIBNetIPTunnel::Send_Queue_Empty_Cond ()
+{
+  return &send_empty;
+}
+
+void
+EIBNetIPTunnel::Dequeue ()
+{
+  pth_sem_dec(&insignal);
+  inqueue.get();
+  if (inqueue.isempty())
+    pth_sem_set_value(&send_empty, 1);
+}
+
 bool
 EIBNetIPTunnel::openVBusmonitor ()
 {
@@ -262,7 +301,8 @@ EIBNetIPTunnel::enterBusmonitor ()
   mode = 1;
   if (support_busmonitor)
     connect_busmonitor = 1;
-  return Put_On_Queue_Or_Drop<CArray, CArray >(inqueue,  CArray(), &insignal, true, indropmsg);
+  return Put_On_Queue_Or_Drop<CArray, CArray >(inqueue,  CArray(), &insignal, true, indropmsg,
+      &send_empty);
 #if 0
   inqueue.put (CArray ());
   pth_sem_inc (&insignal, 1);
@@ -274,7 +314,8 @@ EIBNetIPTunnel::leaveBusmonitor ()
 {
   mode = 0;
   connect_busmonitor = 0;
-  return Put_On_Queue_Or_Drop<CArray, CArray >(inqueue,  CArray(), &insignal, true, indropmsg);
+  return Put_On_Queue_Or_Drop<CArray, CArray >(inqueue,  CArray(), &insignal, true, indropmsg,
+      &send_empty);
 #if 0
   inqueue.put (CArray ());
   pth_sem_inc (&insignal, 1);
@@ -365,8 +406,18 @@ EIBNetIPTunnel::Run (pth_sem_t * stop1)
                           pth_time(1, 0)); // restart in 1
   while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
     {
+      pth_event_t paced = NULL;
       if (GetState() == TUNNEL_CONNECTED)
-        pth_event_concat(stop, input, NULL);
+        {
+          if (inqueue.isempty() || pacer.Ready(inqueue.top()()))
+            pth_event_concat(stop, input, NULL);
+          else
+            {
+              // wake up when the pacer allows the next frame
+              paced = pacer.Wait(inqueue.top()());
+              pth_event_concat(stop, paced, NULL);
+            }
+        }
       if (GetState() == TUNNEL_PACKET_SENT || GetState() == TUNNEL_EXPECT_ACK)
         pth_event_concat(stop, timeout, NULL);
 
@@ -376,6 +427,8 @@ EIBNetIPTunnel::Run (pth_sem_t * stop1)
       pth_event_isolate(stop);
       pth_event_isolate(timeout);
       pth_event_isolate(timeout1);
+      if (paced)
+        pth_event_isolate(paced);
       if (p1)
         {
           switch (p1->service)
@@ -654,8 +707,7 @@ EIBNetIPTunnel::Run (pth_sem_t * stop1)
                 sno++;
                 if (sno > 0xff)
                   sno = 0;
-                pth_sem_dec(&insignal);
-                inqueue.get();
+                Dequeue();
                 if (noqueue)
                   {
                     TransitionToState(TUNNEL_EXPECT_ACK,timeout1);
@@ -813,8 +865,7 @@ EIBNetIPTunnel::Run (pth_sem_t * stop1)
               WARNLOGSHAPE(Thread::Loggers(), LOG_NOTICE,
                   Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
                   "Drop, too many retries");
-              pth_sem_dec(&insignal);
-              inqueue.get();
+              Dequeue();
               retry = 0;
               ++stat_drops;
 
@@ -879,8 +930,7 @@ EIBNetIPTunnel::Run (pth_sem_t * stop1)
 
       if (!inqueue.isempty() && inqueue.top()() == 0)
         {
-          pth_sem_dec(&insignal);
-          inqueue.get();
+          Dequeue();
           if (support_busmonitor)
             {
               dreq.caddr = saddr;
@@ -891,8 +941,10 @@ EIBNetIPTunnel::Run (pth_sem_t * stop1)
             }
         }
 
-      if (!inqueue.isempty() && GetState() == TUNNEL_CONNECTED)
+      if (!inqueue.isempty() && GetState() == TUNNEL_CONNECTED
+          && pacer.Ready(inqueue.top()()))
         {
+          pacer.Sent(inqueue.top()());
           treq.channel = channel;
           treq.seqno = sno;
           treq.CEMI = inqueue.top();
@@ -934,6 +986,7 @@ EIBNetIPTunnel::_xml(Element *parent) const
   ErrCounters::_xml(n);
   outqueue._xml(n);
   inqueue._xml(n);
+  pacer._xml(n);
   return n;
 }
 
@@ -34,6 +34,8 @@ private:
   struct sockaddr_in raddr;
   pth_sem_t insignal;
   pth_sem_t outsignal;
+  /** 1, if inqueue is empty */
+  pth_sem_t send_empty;
     Queue < CArray > inqueue;
     Queue < LPDU * >outqueue;
   int mode;
@@ -62,8 +64,12 @@ private:
   }
   void TransitionToState(TunnelStates s,
                          pth_event_t timeout1);
+  /** removes the sent head of inqueue */
+  void Dequeue ();
 
   void Run (pth_sem_t * stop);
+  /** queues l for sending, yield is false if more frames follow */
+  bool Send (LPDU * l, bool yield);
 public:
     EIBNetIPTunnel (const char *dest, int port, int sport, const char *srcip,
 		    int dataport, int flags, Logs * tr,
@@ -74,6 +80,8 @@ public:
 
   bool Send_L_Data (LPDU * l);
   LPDU *Get_L_Data (pth_event_t stop);
+  unsigned Send_L_Data_Batch (LPDU ** l, unsigned n);
+  unsigned Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max);
 
   bool addAddress (eibaddr_t addr);
   bool addGroupAddress (eibaddr_t addr);
@@ -90,6 +98,7 @@ public:
   bool Close ();
   eibaddr_t getDefaultAddr ();
   bool Send_Queue_Empty ();
+  pth_sem_t *Send_Queue_Empty_Cond ();
 
   bool SendReset() { return true; }
 
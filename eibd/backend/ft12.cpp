@@ -59,9 +59,83 @@ Element * FT12LowLevelDriver::_xml(Element *parent) const
   ErrCounters::_xml(p);
   inqueue._xml(p);
   outqueue._xml(p);
+  pacer._xml(p);
+  ackstats._xml(p);
   return p;
 }
 
+FT12AckStatistics::FT12AckStatistics ()
+{
+  acks = 0;
+  retransmits = 0;
+  failures = 0;
+  samples = 0;
+  minrtt = 0;
+  maxrtt = 0;
+  totalrtt = 0;
+  srtt = 0;
+  rttvar = 0;
+  rto = FT12_INITRTO;
+}
+
+void
+FT12AckStatistics::Ack (bool retransmitted, timestamp_t rtt)
+{
+  acks++;
+  // the acknowledge of a repeated frame may belong to any copy (Karn)
+  if (retransmitted)
+    return;
+  if (!samples || rtt < minrtt)
+    minrtt = rtt;
+  if (rtt > maxrtt)
+    maxrtt = rtt;
+  totalrtt += rtt;
+  if (!samples)
+    {
+      srtt = rtt;
+      rttvar = rtt / 2;
+    }
+  else
+    {
+      timestamp_t d = srtt > rtt ? srtt - rtt : rtt - srtt;
+      rttvar = (3 * rttvar + d) / 4;
+      srtt = (7 * srtt + rtt) / 8;
+    }
+  samples++;
+  rto = srtt + 4 * rttvar;
+  if (rto < FT12_MINRTO)
+    rto = FT12_MINRTO;
+  if (rto > FT12_MAXRTO)
+    rto = FT12_MAXRTO;
+}
+
+void
+FT12AckStatistics::Retransmit ()
+{
+  retransmits++;
+  rto *= 2;
+  if (rto > FT12_MAXRTO)
+    rto = FT12_MAXRTO;
+}
+
+Element *
+FT12AckStatistics::_xml (Element * parent) const
+{
+  Element *a = parent->addElement (XMLFT12ACKELEMENT);
+  a->addAttribute (XMLFT12ACKSATTR, acks);
+  a->addAttribute (XMLFT12RETRANSMITSATTR, retransmits);
+  a->addAttribute (XMLFT12FAILURESATTR, failures);
+  a->addAttribute (XMLFT12TIMEOUTATTR, (int) rto);
+  if (samples)
+    {
+      a->addAttribute (XMLFT12MINRTTATTR, (int) minrtt);
+      a->addAttribute (XMLFT12MAXRTTATTR, (int) maxrtt);
+      a->addAttribute (XMLFT12MEANRTTATTR, (int) (totalrtt / samples));
+      a->addAttribute (XMLFT12SMOOTHEDRTTATTR, (int) srtt);
+    }
+  return a;
+}
+
 FT12LowLevelDriver::FT12LowLevelDriver (const char *dev, Logs * tr, int flags,
 		int inquemaxlen,
 		int outquemaxlen,
@@ -73,6 +147,8 @@ FT12LowLevelDriver::FT12LowLevelDriver (const char *dev, Logs * tr, int flags,
   sendflag = 0;
   recvflag = 0;
   repeatcount = 0;
+  resetpending = false;
+  pth_sem_init (&wakeup);
   TransitionToDownState();
   Start ();
   TRACEPRINTF (Thread::Loggers(), 1, this, "Opened");
@@ -103,6 +179,9 @@ bool FT12LowLevelDriver::TransitionToDownState()
           close (fd);
         }
       fd = INVALID_FD;
+      current.resize (0);
+      next.resize (0);
+      resetpending = false;
       return LowLevelDriverInterface::TransitionToDownState();
     }
   return true;
@@ -195,69 +274,71 @@ bool FT12LowLevelDriver::init ()
 bool
 FT12LowLevelDriver::Send_Packet (CArray l, bool always)
 {
-  CArray pdu;
-  uchar c;
-  unsigned i;
   Thread::Loggers()->TracePacket (1, this, "Send", l);
 
   if (Connection_Lost() && !always) {
     return false;
   }
   assert (l () <= 32);
-  pdu.resize (l () + 7);
-  pdu[0] = 0x68;
-  pdu[1] = l () + 1;
-  pdu[2] = l () + 1;
-  pdu[3] = 0x68;
+  // encoded by Prepare, so the frame count bit follows the frames actually sent
+  return Put_On_Queue_Or_Drop<CArray, CArray>(inqueue, l, &in_signal, true, indropmsg, &send_empty);
+}
+
+void
+FT12LowLevelDriver::Prepare ()
+// takes the next frame from the queue and encodes it with the next frame count bit
+{
+  uchar c;
+  unsigned i;
+
+  pth_sem_dec (&in_signal);
+  CArray l = inqueue.get ();
+  next.resize (l () + 7);
+  next[0] = VARLENFRAME;
+  next[1] = l () + 1;
+  next[2] = l () + 1;
+  next[3] = VARLENFRAME;
   if (sendflag)
-    pdu[4] = 0x53;
+    next[4] = 0x53;
   else
-    pdu[4] = 0x73;
+    next[4] = 0x73;
   sendflag = !sendflag;
 
-  pdu.setpart (l.array (), 5, l ());
-  c = pdu[4];
+  next.setpart (l.array (), 5, l ());
+  c = next[4];
   for (i = 0; i < l (); i++)
     c += l[i];
-  pdu[pdu () - 2] = c;
-  pdu[pdu () - 1] = 0x16;
-
-  return Put_On_Queue_Or_Drop<CArray, CArray>(inqueue, pdu, &in_signal, true, indropmsg, &send_empty);
+  next[next () - 2] = c;
+  next[next () - 1] = 0x16;
+}
 
-#if 0
-  pth_sem_set_value (&send_empty, 0);
-  inqueue.put (pdu);
-  pth_sem_inc (&in_signal, TRUE);
+bool
+FT12LowLevelDriver::Transmit (const CArray & c, pth_event_t stop)
+{
+  Thread::Loggers()->TracePacket(0, this, "Send", c);
+  repeatcount++; // all count for packets/sec on ft1.2 to be secure
+  if (pth_write_ev(fd, c.array(), c(), stop) <= 0)
+    {
+      ++stat_senderr;
+      return false;
+    }
+  senttime = getTime();
   return true;
-#endif
 }
 
 bool
 FT12LowLevelDriver::SendReset ()
 {
-
-  CArray pdu;
   TRACEPRINTF (Thread::Loggers(), 1, this, "Send Interface Reset");
-  pdu.resize (4);
-  pdu[0] = FIXLENFRAME;
-  pdu[1] = 0x40;
-  pdu[2] = 0x40;
-  pdu[3] = 0x16;
   sendflag = 0;
   recvflag = 0;
 
   LowLevelDriverInterface::SendReset();
 
-    state=state_send_reset;
-
-  return Put_On_Queue_Or_Drop<CArray, CArray>(inqueue, pdu, &in_signal, true, indropmsg, &send_empty);
-
-#if 0
-  pth_sem_set_value (&send_empty, 0);
-  inqueue.put (pdu);
-  pth_sem_inc (&in_signal, TRUE);
-#endif
-
+  state=state_send_reset;
+  resetpending = true;
+  pth_sem_inc (&wakeup, FALSE);
+  return true;
 }
 
 bool FT12LowLevelDriver::TransitionToUpState()
@@ -278,19 +359,20 @@ FT12LowLevelDriver::Run (pth_sem_t * stop1)
 {
   CArray last;
   int i;
-  uchar buf[255];
+  int readablefd = INVALID_FD;
 
   pth_event_t stop = pth_event(PTH_EVENT_SEM, stop1);
-  pth_event_t timeout = pth_event(PTH_EVENT_RTIME, pth_time(3, 0));  // retransmit or bring interface up again
-  pth_event_t onesectic = pth_event(PTH_EVENT_TIME, pth_time(1, 0));
-  int pktthissec = 0;
+  pth_event_t timeout = pth_event(PTH_EVENT_RTIME, pth_time(3, 0));  // bring interface up again
+  pth_event_t acktimeout = pth_event(PTH_EVENT_RTIME, pth_time(0, FT12_INITRTO));
+  pth_event_t input = pth_event(PTH_EVENT_SEM, &in_signal);
+  pth_event_t wake = pth_event(PTH_EVENT_SEM, &wakeup);
+  pth_event_t readable = NULL;
 
   while (pth_event_status(stop) != PTH_STATUS_OCCURRED)
     {
-      pth_event_isolate(timeout);
-
-      if (state>state_down && repeatcount >= 5)
+      if (state>state_down && repeatcount >= FT12_MAXREPEAT)
         {
+          ackstats.Failed();
           TransitionToDownState();
           repeatcount = 0;
           ERRORLOGSHAPE(Thread::Loggers(), LOG_ALERT,
@@ -300,250 +382,207 @@ FT12LowLevelDriver::Run (pth_sem_t * stop1)
                                       pth_time(3, 0)); // give it 3 secs
         }
 
-      pth_event_isolate(onesectic);
-      if (pth_event_status(onesectic) == PTH_STATUS_OCCURRED)
+      // encode ahead, so the next frame goes out as soon as the ack arrives
+      if (state >= state_up_ready_to_send && !next() && !inqueue.isempty())
+        Prepare();
+
+      if (state == state_send_reset && resetpending && fd != INVALID_FD)
         {
-          pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, onesectic,
-              pth_time(1, 0));
-          pktthissec = 0;
+          CArray pdu;
+          pdu.resize (4);
+          pdu[0] = FIXLENFRAME;
+          pdu[1] = 0x40;
+          pdu[2] = 0x40;
+          pdu[3] = 0x16;
+          resetpending = false;
+          Transmit(pdu, stop); // repeated by timeout below
         }
-
+      else if (state == state_up_ready_to_send && next() && pacer.Ready(next()))
         {
-          pth_event_t input = pth_event(PTH_EVENT_SEM, &in_signal);
-
-          pth_event_isolate(input);
+          current = next;
+          next.resize(0);
+          pacer.Sent(current());
+          if (!Transmit(current, stop))
+            pth_sleep(0.5); // give 0.5 sec to stabilize
+          state = waiting_for_ack;
+          acktimeout = pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, acktimeout,
+              pth_time(ackstats.Timeout() / 1000000, ackstats.Timeout() % 1000000));
+          if (!inqueue.isempty())
+            Prepare();
+        }
+      else if (state == waiting_for_ack && pth_event_status(acktimeout) == PTH_STATUS_OCCURRED)
+        {
+          ackstats.Retransmit();
+          if (!Transmit(current, stop))
+            pth_sleep(0.5);
+          acktimeout = pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, acktimeout,
+              pth_time(ackstats.Timeout() / 1000000, ackstats.Timeout() % 1000000));
+        }
 
-          if (state == state_up_ready_to_send && (!maxpktsoutpersec || pktthissec < maxpktsoutpersec))
-            pth_event_concat(stop, input, NULL);
-          else
-            pth_event_concat(stop, timeout, NULL);
+      // never block on a single source: wait for bytes, the ack deadline,
+      // new frames, the pacer or a reset, whichever comes first
+      pth_event_t paced = NULL;
+
+      pth_event_concat(stop, wake, NULL);
+      if (state < state_up_ready_to_send)
+        pth_event_concat(stop, timeout, NULL);
+      else if (state == waiting_for_ack)
+        pth_event_concat(stop, acktimeout, NULL);
+      if (state >= state_up_ready_to_send && !next())
+        pth_event_concat(stop, input, NULL);
+      else if (state == state_up_ready_to_send && next())
+        {
+          // wake up when the pacer allows the next frame
+          paced = pacer.Wait(next());
+          pth_event_concat(stop, paced, NULL);
+        }
+      if (fd != INVALID_FD)
+        {
+          if (readablefd != fd)
+            {
+              if (readable)
+                pth_event_free(readable, PTH_FREE_THIS);
+              readable = pth_event(PTH_EVENT_FD | PTH_UNTIL_FD_READABLE, fd);
+              readablefd = fd;
+            }
+          pth_event_concat(stop, readable, NULL);
+        }
 
-          pth_event_concat(stop, onesectic, NULL);
+      pth_wait(stop);
 
-          if (fd != INVALID_FD) // that could starve the rest of the gang actually, needs looking @ if people run lots Ft1.2
+      pth_event_isolate(wake);
+      pth_event_isolate(timeout);
+      pth_event_isolate(acktimeout);
+      pth_event_isolate(input);
+      if (paced)
+        pth_event_isolate(paced);
+      if (readable)
+        pth_event_isolate(readable);
+      pth_sem_set_value(&wakeup, 0);
+
+      if (fd != INVALID_FD && readablefd == fd
+          && pth_event_status(readable) == PTH_STATUS_OCCURRED)
+        {
+          // read straight into the receive ring, the bytes are there already
+          unsigned space;
+          uchar *buf = parser.ring.WritePtr(space);
+          i = read(fd, buf, space);
+          if (i > 0)
             {
-              i = pth_read_ev(fd, buf, sizeof(buf), stop);
-              if (i > 0)
-                {
-                  Thread::Loggers()->TracePacket(0, this, "Recv", i, buf);
-                  akt.setpart(buf, akt(), i);
-                }
+              Thread::Loggers()->TracePacket(0, this, "Recv", i, buf);
+              parser.ring.Written(i);
             }
-          else
+          else if (i == 0 || (errno != EINTR && errno != EAGAIN))
             {
-              pth_wait(stop);
+              // readable without data: the device is gone
+              ++stat_recverr;
+              TransitionToDownState();
+              timeout = pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
+                  pth_time(3, 0));
             }
+        }
 
-          pth_event_isolate(timeout);
-          pth_event_isolate(input);
-          pth_event_isolate(onesectic);
-      }
-
-      try
+      FT12FrameParser::Token tok;
+      while ((tok = parser.Next()) != FT12FrameParser::FT_NONE)
         {
-          while (akt.len() > 0)
+          const uchar *f = parser.Frame();
+          switch (tok)
+            {
+          case FT12FrameParser::FT_ACK:
             {
-              switch (akt[0])
+              if (state < state_up_ready_to_send)
                 {
-              case ACKFRAME:
+                  // first ack is for reset set
+                  DrainIn();
+                  current.resize(0);
+                  next.resize(0);
+                  TransitionToUpState();
+                }
+              else if (state == waiting_for_ack)
                 {
-                  if (state < state_up_ready_to_send)
+                  // ack for current, the next one is encoded already
+                  ackstats.Ack(repeatcount > 1, getTime() - senttime);
+                  current.resize(0);
+                  repeatcount = 0;
+                  if (!next() && inqueue.isempty())
                     {
-                      // first ack is for reset set
-                      DrainIn();
-                      TransitionToUpState();
+                      pth_sem_set_value(&send_empty, 1);
                     }
-                  else if (state == waiting_for_ack)
-                    {
-                      // ack, get first from the queue
-                      inqueue.Lock();
-                      if (!inqueue.isempty())
-                        {
-                          pth_sem_dec(&in_signal);
-                          inqueue.get();
-                          if (inqueue.isempty())
-                            {
-                              pth_sem_set_value(&send_empty, 1);
-                            }
-                          pktthissec++;
-                          repeatcount = 0;
-                        }
-                      inqueue.Unlock();
-                      state = state_up_ready_to_send; // transition
-                    }
-                  akt.deletepart(0, 1);
+                  state = state_up_ready_to_send; // transition
                 }
-                break;
-              case FIXLENFRAME:
+            }
+            break;
+          case FT12FrameParser::FT_FIXED:
+            {
+              // valid frame
+              uchar c1 = ACKFRAME;
+              Thread::Loggers()->TracePacket(0, this, "Send Ack", 1, &c1);
+              write(fd, &c1, 1);
+
+              if ((f[1] == 0xF3 && !recvflag) || (f[1] == 0xD3 && recvflag))
                 {
-                  if (akt() < 4)
-                    {
-                      throw std::exception();
-                    }
-                  if (akt[1] == akt[2] && akt[3] == 0x16)
-                    {
-                      // valid frame
-                      uchar c1 = ACKFRAME;
-                      Thread::Loggers()->TracePacket(0, this, "Send Ack", 1,
-                          &c1);
-                      write(fd, &c1, 1);
-
-                      if ((akt[1] == 0xF3 && !recvflag)
-                          || (akt[1] == 0xD3 && recvflag))
-                        {
-                          // SEND_UDAT
-                          //right sequence number
-                          recvflag = !recvflag;
-                        }
-                      if ((akt[1] & 0x0f) == 0) // a reset request
-                        {
-                          const uchar reset[1] =
-                            { 0xA0 }; // LM_Reset.ind_message
-                          CArray *c = new CArray(reset, sizeof(reset));
-                          Thread::Loggers()->TracePacket(0, this, "RecvReset",
-                              *c);
-
-                          Put_On_Queue_Or_Drop<CArray *, CArray *>(outqueue, c,
-                              &out_signal, true, outdropmsg);
-
-#if 0
-                          outqueue.put (c);
-                          pth_sem_inc (&out_signal, TRUE);
-#endif
-                        }
-                      // ignore 0x09 which is a status link request
-                    }
-                  akt.deletepart(0, 4);
+                  // SEND_UDAT
+                  //right sequence number
+                  recvflag = !recvflag;
                 }
-                break;
-              case VARLENFRAME:
+              if ((f[1] & 0x0f) == 0) // a reset request
                 {
-                  int len;
-                  uchar c1;
-                  if (akt() < 7)
-                    {
-                      throw std::exception();
-                    }
-                  if (akt[1] != akt[2] || akt[3] != 0x68)
-                    {
-                      ++stat_recverr;
-                      //receive error, try to resume
-                      akt.deletepart(0, 1);
-                      continue;
-                    }
-                  if (akt() < akt[1] + 6)
-                    {
-                      throw std::exception();
-                    }
-
-                  c1 = 0;
-                  for (i = 4; i < akt[1] + 4; i++)
-                    c1 += akt[i];
-                  if (akt[akt[1] + 4] != c1 || akt[akt[1] + 5] != 0x16)
-                    {
-                      ++stat_recverr;
-                      len = akt[1] + 6;
-                      //Forget wrong short frame
-                      akt.deletepart(0, len);
-                      continue;
-                    }
+                  const uchar reset[1] =
+                    { 0xA0 }; // LM_Reset.ind_message
+                  CArray *c = new CArray(reset, sizeof(reset));
+                  Thread::Loggers()->TracePacket(0, this, "RecvReset", *c);
 
-                  c1 = ACKFRAME;
-                  Thread::Loggers()->TracePacket(0, this, "Send Ack", 1, &c1);
-                  i = write(fd, &c1, 1);
+                  Put_On_Queue_Or_Drop<CArray *, CArray *>(outqueue, c,
+                      &out_signal, true, outdropmsg);
+                }
+              // ignore 0x09 which is a status link request
+            }
+            break;
+          case FT12FrameParser::FT_VARIABLE:
+            {
+              uchar c1 = ACKFRAME;
+              Thread::Loggers()->TracePacket(0, this, "Send Ack", 1, &c1);
+              i = write(fd, &c1, 1);
 
-                  if ((akt[4] == 0xF3 && recvflag)
-                      || (akt[4] == 0xD3 && !recvflag))
+              if ((f[4] == 0xF3 && recvflag) || (f[4] == 0xD3 && !recvflag))
+                {
+                  if (CArray(f + 5, f[1] - 1) != last)
                     {
-                      if (CArray(akt.array() + 5, akt[1] - 1) != last)
-                        {
-                          WARNLOGSHAPE(Thread::Loggers(), LOG_NOTICE,
-                              Logging::DUPLICATESMAX1PER10SEC, this,
-                              Logging::MSGNOHASH, "Sequence jump for FT1.2");
-                          recvflag = !recvflag;
-                        }
-                      else
-                        {
-                          ++stat_recverr;
-                          WARNLOGSHAPE(Thread::Loggers(), LOG_NOTICE,
-                              Logging::DUPLICATESMAX1PER10SEC, this,
-                              Logging::MSGNOHASH, "Wrong sequence for FT1.2");
-                        }
+                      WARNLOGSHAPE(Thread::Loggers(), LOG_NOTICE,
+                          Logging::DUPLICATESMAX1PER10SEC, this,
+                          Logging::MSGNOHASH, "Sequence jump for FT1.2");
+                      recvflag = !recvflag;
                     }
-
-                  if ((akt[4] == 0xF3 && !recvflag)
-                      || (akt[4] == 0xD3 && recvflag))
+                  else
                     {
-                      recvflag = !recvflag;
-                      CArray *c = new CArray;
-                      len = akt[1] + 6;
-                      c->setpart(akt.array() + 5, 0, len - 7);
-                      last = *c;
-
-                      Put_On_Queue_Or_Drop<CArray *, CArray *>(outqueue, c,
-                          &out_signal, true, outdropmsg);
-
-#if 0
-                      outqueue.put (c);
-                      pth_sem_inc (&out_signal, TRUE);
-#endif
+                      ++stat_recverr;
+                      WARNLOGSHAPE(Thread::Loggers(), LOG_NOTICE,
+                          Logging::DUPLICATESMAX1PER10SEC, this,
+                          Logging::MSGNOHASH, "Wrong sequence for FT1.2");
                     }
-                  akt.deletepart(0, len);
                 }
-                break;
-              default:
+
+              if ((f[4] == 0xF3 && !recvflag) || (f[4] == 0xD3 && recvflag))
                 {
-                  ++stat_recverr;
-                  //Forget unknown byte
-                  akt.deletepart(0, 1);
-                }
-                break;
+                  recvflag = !recvflag;
+                  CArray *c = new CArray(f + 5, parser.FrameLen() - 7);
+                  last = *c;
+
+                  Put_On_Queue_Or_Drop<CArray *, CArray *>(outqueue, c,
+                      &out_signal, true, outdropmsg);
                 }
             }
-      }
-      catch (std::exception &e)
-      {
-          // incomplete frame
-      }
-
-#if 0
-      TRACEPRINTF (Thread::Loggers(), 1, this, "before send fd:%d empty:%d state:%d p/s: %d timeout: %d maxpktsoutpersec: %d",
-          (int) fd, inqueue.isempty(),
-          (int) state,
-          pktthissec,
-          pth_event_status(timeout) == PTH_STATUS_OCCURRED,
-          (int) maxpktsoutpersec);
-#endif
-
-      if (!inqueue.isempty() &&
-          (state==state_send_reset ||
-              state==state_up_ready_to_send
-              || (state == waiting_for_ack && pth_event_status(timeout) == PTH_STATUS_OCCURRED))
-              && (!maxpktsoutpersec || pktthissec < maxpktsoutpersec))
-        {
-          const CArray & c = inqueue.top();
-          if (inqueue.isempty()) {
-              pth_sem_set_value(&send_empty, 1);
-          }
-          Thread::Loggers()->TracePacket(0, this, "Send", c);
-          i = pth_write_ev(fd, c.array(), c(), stop);
-          if (i <= 0)
-            {
-              pth_sleep(0.5); // give 0.5 sec to stabilize
-            }
-          else
-            {
-              if (state==state_up_ready_to_send) {
-                state = waiting_for_ack;
-              } // otherwise we remain in whatever it is, some down state before operational
-              timeout = pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
-                                          pth_time(0,50000)); // ca. 500 bits @ 9600 ?  = 5% = 50 msec
+            break;
+          case FT12FrameParser::FT_ERROR:
+            //receive error, forget the bytes
+            ++stat_recverr;
+            break;
+          default:
+            break;
             }
-          repeatcount++; // all count for packets/sec on ft1.2 to be secure
-
         }
 
-      // try periodically to send a reset out if we're down, last thing since it invalidates some events
+      // try periodically to send a reset out if we're down
       if (state<state_up_ready_to_send && pth_event_status(timeout) == PTH_STATUS_OCCURRED)
         {
           if (init()) { // trying to bring it up
@@ -555,7 +594,11 @@ FT12LowLevelDriver::Run (pth_sem_t * stop1)
     }
   pth_event_free(stop, PTH_FREE_THIS);
   pth_event_free(timeout, PTH_FREE_THIS);
-  pth_event_free(onesectic, PTH_FREE_THIS);
+  pth_event_free(acktimeout, PTH_FREE_THIS);
+  pth_event_free(input, PTH_FREE_THIS);
+  pth_event_free(wake, PTH_FREE_THIS);
+  if (readable)
+    pth_event_free(readable, PTH_FREE_THIS);
 }
 
 EMIVer FT12LowLevelDriver::getEMIVer ()
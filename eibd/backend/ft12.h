@@ -48,6 +48,52 @@
 #include "threads.h"
 #include "lowlevel.h"
 #include "lowlatency.h"
+#include "frameparser.h"
+
+/** first acknowledge timeout in microseconds, before any round trip is known */
+#define FT12_INITRTO 50000
+/** bounds of the acknowledge timeout in microseconds */
+#define FT12_MINRTO 30000
+#define FT12_MAXRTO 1000000
+/** transmissions of a frame without acknowledge before the interface is reset */
+#define FT12_MAXREPEAT 5
+
+/** round trip from writing a frame to its FT1.2 acknowledge, and the
+ * retransmit timeout derived from it as for TCP (RFC 6298) */
+class FT12AckStatistics
+{
+  uint32_t acks;
+  uint32_t retransmits;
+  uint32_t failures;
+  uint32_t samples;
+  timestamp_t minrtt;
+  timestamp_t maxrtt;
+  timestamp_t totalrtt;
+  /** smoothed round trip and its variation */
+  timestamp_t srtt;
+  timestamp_t rttvar;
+  timestamp_t rto;
+
+public:
+  FT12AckStatistics ();
+
+  /** counts an acknowledge, rtt is only used if the frame was sent once */
+  void Ack (bool retransmitted, timestamp_t rtt);
+  /** counts a retransmit and doubles the timeout */
+  void Retransmit ();
+  /** counts a frame given up */
+  void Failed ()
+  {
+    failures++;
+  }
+  /** returns the current retransmit timeout in microseconds */
+  timestamp_t Timeout () const
+  {
+    return rto;
+  }
+
+  Element *_xml (Element * parent) const;
+};
 
 /** FT1.2 lowlevel driver*/
 class FT12LowLevelDriver:public LowLevelDriverInterface, protected Thread
@@ -65,10 +111,21 @@ class FT12LowLevelDriver:public LowLevelDriverInterface, protected Thread
   int sendflag;
   /** recevie state */
   int recvflag;
-    /** frame in receiving */
-  CArray akt;
+  /** frames in receiving */
+  FT12FrameParser parser;
   /** repeatcount of the transmitting frame */
   int repeatcount;
+  /** frame waiting for its acknowledge */
+  CArray current;
+  /** following frame, already encoded while current is pending */
+  CArray next;
+  /** time current was last written */
+  timestamp_t senttime;
+  /** a reset frame has to be written */
+  bool resetpending;
+  /** wakes Run for a reset requested by another thread */
+  pth_sem_t wakeup;
+  FT12AckStatistics ackstats;
 
   typedef enum {
     state_down = 0,
@@ -88,6 +145,8 @@ class FT12LowLevelDriver:public LowLevelDriverInterface, protected Thread
   const static char outdropmsg[], indropmsg[];
 
   void Run (pth_sem_t * stop);
+  void Prepare ();
+  bool Transmit (const CArray & c, pth_event_t stop);
 public:
     FT12LowLevelDriver (const char *device, Logs * tr, int flags,
     		int inquemaxlen,
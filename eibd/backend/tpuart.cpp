@@ -38,6 +38,19 @@ struct message
   unsigned char data[64];
 };
 
+Element *
+TPUARTLayer2Driver::_xml (Element * parent) const
+{
+  Element *n = parent->addElement (XMLBACKENDELEMENT);
+  n->addAttribute (XMLBACKENDELEMENTTYPEATTR, "tpuart");
+  n->addAttribute (XMLBACKENDSTATUSATTR,
+		   Connection_Lost ()? XMLSTATUSDOWN : XMLSTATUSUP);
+  ErrCounters::_xml (n);
+  inqueue._xml (n);
+  outqueue._xml (n);
+  pacer._xml (n);
+  return n;
+}
 
 TPUARTLayer2Driver::TPUARTLayer2Driver (int version, const char *device,
 					eibaddr_t a, Trace * tr)
@@ -164,8 +177,27 @@ TPUARTLayer2Driver::Send_L_Data (LPDU * l)
   pth_sem_inc (&in_signal, 1);
 }
 
+unsigned
+TPUARTLayer2Driver::Send_L_Data_Batch (LPDU ** l, unsigned n)
+{
+  for (unsigned i = 0; i < n; i++)
+    {
+      TRACEPRINTF (t, 2, this, "Send %s", l[i]->Decode ()());
+      inqueue.put (l[i]);
+      pth_sem_inc (&in_signal, i == n - 1);
+    }
+  return n;
+}
+
 LPDU *
 TPUARTLayer2Driver::Get_L_Data (pth_event_t stop)
+{
+  LPDU *l;
+  return Get_L_Data_Batch (stop, &l, 1) ? l : 0;
+}
+
+unsigned
+TPUARTLayer2Driver::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
 {
   if (stop != NULL)
     pth_event_concat (getwait, stop, NULL);
@@ -177,10 +209,10 @@ TPUARTLayer2Driver::Get_L_Data (pth_event_t stop)
 
   if (pth_event_status (getwait) == PTH_STATUS_OCCURRED)
     {
-      pth_sem_dec (&out_signal);
-      LPDU *l = outqueue.get ();
-      TRACEPRINTF (t, 2, this, "Recv %s", l->Decode ()());
-      return l;
+      unsigned n = Take_From_Queue<LPDU *> (outqueue, l, max, &out_signal);
+      for (unsigned i = 0; i < n; i++)
+	TRACEPRINTF (t, 2, this, "Recv %s", l[i]->Decode ()());
+      return n;
     }
   else
     return 0;
@@ -195,7 +227,15 @@ TPUARTLayer2Driver::Run (pth_sem_t * stop1)
   pth_event_t input = pth_event (PTH_EVENT_SEM, &in_signal);
   while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
     {
-      pth_event_concat (stop, input, NULL);
+      pth_event_t paced = NULL;
+      if (inqueue.isempty () || pacer.Ready (inqueue.top ()->ToPacket ()()))
+	pth_event_concat (stop, input, NULL);
+      else
+	{
+	  // wake up when the pacer allows the next frame
+	  paced = pacer.Wait (inqueue.top ()->ToPacket ()());
+	  pth_event_concat (stop, paced, NULL);
+	}
       l = pth_read_ev (fd, &m, sizeof (m), stop);
       if (l >= 0)
 	{
@@ -221,10 +261,14 @@ TPUARTLayer2Driver::Run (pth_sem_t * stop1)
 	  pth_sem_inc (&out_signal, 1);
 	}
       pth_event_isolate (stop);
+      if (paced)
+	pth_event_isolate (paced);
       if (!inqueue.isempty ())
 	{
 	  LPDU *l1 = inqueue.top ();
 	  CArray c = l1->ToPacket ();
+	  if (!pacer.Ready (c ()))
+	    continue;
 	  unsigned len = c ();
 	  if (len > sizeof (m.data))
 	    len = sizeof (m.data);
@@ -243,6 +287,7 @@ TPUARTLayer2Driver::Run (pth_sem_t * stop1)
 		  outqueue.put (l2);
 		  pth_sem_inc (&out_signal, 1);
 		}
+	      pacer.Sent (c ());
 	      pth_sem_dec (&in_signal);
 	      delete inqueue.get ();
 	    }
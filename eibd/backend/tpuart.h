@@ -57,6 +57,8 @@ public:
 
   bool Send_L_Data (LPDU * l);
   LPDU *Get_L_Data (pth_event_t stop);
+  unsigned Send_L_Data_Batch (LPDU ** l, unsigned n);
+  unsigned Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max);
 
   bool addAddress (eibaddr_t addr);
   bool addGroupAddress (eibaddr_t addr);
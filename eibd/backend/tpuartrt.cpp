@@ -0,0 +1,434 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include "tpuartrt.h"
+#include "layer2.h"
+
+const unsigned TPUARTAckStatistics::bound[TPUARTS_ACKBUCKETS - 1] =
+  { 100, 250, 500, 1000, 2000, 5000, 10000 };
+
+TPUARTAckStatistics::TPUARTAckStatistics ()
+{
+  acks = 0;
+  noacks = 0;
+  late = 0;
+  memset (histogram, 0, sizeof (histogram));
+  maxlatency = 0;
+  totallatency = 0;
+}
+
+void
+TPUARTAckStatistics::Record (bool ack, timestamp_t latency)
+{
+  unsigned i;
+  if (ack)
+    acks++;
+  else
+    noacks++;
+  if (latency > TPUARTS_ACKLATE)
+    late++;
+  if (latency > maxlatency)
+    maxlatency = latency;
+  totallatency += latency;
+  for (i = 0; i < TPUARTS_ACKBUCKETS - 1; i++)
+    if (latency < bound[i])
+      break;
+  histogram[i]++;
+}
+
+Element *
+TPUARTAckStatistics::_xml (Element * parent) const
+{
+  Element *a = parent->addElement (XMLTPUARTACKELEMENT);
+  a->addAttribute (XMLTPUARTACKSATTR, acks);
+  a->addAttribute (XMLTPUARTNOACKSATTR, noacks);
+  a->addAttribute (XMLTPUARTACKLATEATTR, late);
+  a->addAttribute (XMLTPUARTACKMAXATTR, (long long) maxlatency);
+  a->addAttribute (XMLTPUARTACKTOTALATTR, (long long) totallatency);
+  for (unsigned i = 0; i < TPUARTS_ACKBUCKETS; i++)
+    {
+      Element *b = a->addElement (XMLTPUARTACKBUCKETELEMENT);
+      if (i < TPUARTS_ACKBUCKETS - 1)
+	b->addAttribute (XMLTPUARTACKBELOWATTR, bound[i]);
+      b->addAttribute (XMLTPUARTACKCOUNTATTR, histogram[i]);
+    }
+  return a;
+}
+
+/** get serial status lines */
+static int
+getstat (int fd)
+{
+  int s;
+  ioctl (fd, TIOCMGET, &s);
+  return s;
+}
+
+/** set serial status lines */
+static void
+setstat (int fd, int s)
+{
+  ioctl (fd, TIOCMSET, &s);
+}
+
+TPUARTRealtimeLink::TPUARTRealtimeLink (int fd,
+					const AddressBitmap & indaddr,
+					const AddressBitmap & groupaddr,
+					int flags,
+					TPUARTAckStatistics & ackstats,
+					int priority) :
+  indaddr (indaddr), groupaddr (groupaddr), ackstats (ackstats)
+{
+  pthread_attr_t attr;
+  struct sched_param param;
+
+  this->fd = fd;
+  ackallgroup = flags & FLAG_B_TPUARTS_ACKGROUP;
+  ackallindividual = flags & FLAG_B_TPUARTS_ACKINDIVIDUAL;
+  dischreset = flags & FLAG_B_TPUARTS_DISCH_RESET;
+  mode = 0;
+  vmode = 0;
+  to = false;
+  watch = 0;
+  out.len = 0;
+  waitconfirm = false;
+  retry = 0;
+  attempts = 0;
+  dropped = 0;
+  started = false;
+  realtime = false;
+  running = true;
+
+  rxevent = eventfd (0, EFD_NONBLOCK);
+  txevent = eventfd (0, EFD_NONBLOCK);
+  if (rxevent == -1 || txevent == -1)
+    return;
+
+  // page faults would delay the thread as much as the pth scheduler
+  locked = mlockall (MCL_CURRENT | MCL_FUTURE) == 0;
+
+  pthread_attr_init (&attr);
+  pthread_attr_setinheritsched (&attr, PTHREAD_EXPLICIT_SCHED);
+  pthread_attr_setschedpolicy (&attr, SCHED_FIFO);
+  param.sched_priority = priority;
+  pthread_attr_setschedparam (&attr, &param);
+  if (pthread_create (&thread, &attr, Start, this) == 0)
+    realtime = true;
+  // without the privilege, run at normal priority
+  else if (pthread_create (&thread, NULL, Start, this) != 0)
+    {
+      pthread_attr_destroy (&attr);
+      return;
+    }
+  pthread_attr_destroy (&attr);
+  started = true;
+}
+
+TPUARTRealtimeLink::~TPUARTRealtimeLink ()
+{
+  if (started)
+    {
+      uint64_t one = 1;
+      running = false;
+      write (txevent, &one, sizeof (one));
+      pthread_join (thread, NULL);
+    }
+  if (rxevent != -1)
+    close (rxevent);
+  if (txevent != -1)
+    close (txevent);
+}
+
+void *
+TPUARTRealtimeLink::Start (void *arg)
+{
+  ((TPUARTRealtimeLink *) arg)->Loop ();
+  return NULL;
+}
+
+void
+TPUARTRealtimeLink::Post (TPUARTRTRing & r, int event, uint8_t type,
+			  const uchar * data, unsigned len, uint8_t attempts)
+{
+  uint64_t one = 1;
+  TPUARTRTMessage *m = r.Reserve ();
+  // a full ring means the other side is stuck, the frame is lost
+  if (!m)
+    {
+      dropped++;
+      return;
+    }
+  m->type = type;
+  m->attempts = attempts;
+  m->len = len;
+  memcpy (m->data, data, len);
+  r.Commit ();
+  write (event, &one, sizeof (one));
+}
+
+void
+TPUARTRealtimeLink::Clear ()
+{
+  uint64_t cnt;
+  read (rxevent, &cnt, sizeof (cnt));
+}
+
+bool
+TPUARTRealtimeLink::Send (const CArray & frame)
+{
+  if (frame () > TPUARTRT_MAXFRAME || !tx.Reserve ())
+    return false;
+  Post (tx, txevent, TPUARTRT_SEND, frame.array (), frame (), 0);
+  return true;
+}
+
+bool
+TPUARTRealtimeLink::Command (uchar c)
+{
+  if (!tx.Reserve ())
+    return false;
+  Post (tx, txevent, TPUARTRT_RAW, &c, 1, 0);
+  return true;
+}
+
+void
+TPUARTRealtimeLink::Deliver (const uchar * data, unsigned len)
+{
+  // keep a slot for the confirmation, else the driver waits for it forever
+  if (rx.Free () <= 1)
+    {
+      dropped++;
+      return;
+    }
+  Post (rx, rxevent, TPUARTRT_FRAME, data, len, 0);
+}
+
+void
+TPUARTRealtimeLink::Confirm (bool ok)
+{
+  uchar c = ok;
+  Post (rx, rxevent, TPUARTRT_CONFIRM, &c, 1, attempts);
+  out.len = 0;
+  waitconfirm = false;
+  retry = 0;
+  attempts = 0;
+}
+
+void
+TPUARTRealtimeLink::Ack (bool group, eibaddr_t dest)
+{
+  uchar c = 0x10;
+  if (group ? ackallgroup || groupaddr.test (dest)
+      : ackallindividual || indaddr.test (dest))
+    c |= 0x1;
+  write (fd, &c, 1);
+  ackstats.Record (c & 0x1, getTime () - recvtime);
+}
+
+void
+TPUARTRealtimeLink::Parse (timestamp_t now)
+{
+  for (;;)
+    {
+      TPUARTFrameParser::Token tok;
+      while ((tok = parser.Next ()) != TPUARTFrameParser::TP_NONE)
+	{
+	  switch (tok)
+	    {
+	    case TPUARTFrameParser::TP_CONFIRM:
+	      if (!mode && vmode)
+		{
+		  const uchar pkt[1] = { 0xCC };
+		  Deliver (pkt, 1);
+		}
+	      if (waitconfirm)
+		{
+		  attempts++;
+		  Confirm (true);
+		}
+	      break;
+
+	    case TPUARTFrameParser::TP_NACK:
+	      if (!mode && vmode)
+		{
+		  const uchar pkt[1] = { 0x0C };
+		  Deliver (pkt, 1);
+		}
+	      if (waitconfirm)
+		{
+		  retry++;
+		  waitconfirm = false;
+		  // the failed attempt used the bus as well
+		  attempts++;
+		  if (retry > 3)
+		    Confirm (false);
+		}
+	      break;
+
+	    case TPUARTFrameParser::TP_STATE:
+	      watch = 2;
+	      watchdog = now + 10000000;
+	      break;
+
+	    case TPUARTFrameParser::TP_ADDRESS:
+	      Ack (parser.Group (), parser.Dest ());
+	      // the rest of the frame is still missing
+	      continue;
+
+	    case TPUARTFrameParser::TP_MONITOR:
+	    case TPUARTFrameParser::TP_FRAME:
+	      Deliver (parser.Frame (), parser.FrameLen ());
+	      break;
+
+	    default:
+	      break;
+	    }
+	  to = false;
+	}
+      if (!parser.ring.len ())
+	break;
+      // incomplete frame, drop its first byte after a timeout
+      if (!to)
+	{
+	  to = true;
+	  timeout = now + 300000;
+	}
+      if (now < timeout)
+	break;
+      parser.Skip ();
+    }
+}
+
+void
+TPUARTRealtimeLink::Transmit (timestamp_t now)
+{
+  uchar w[2 * TPUARTRT_MAXFRAME];
+  unsigned i;
+  for (i = 0; i < out.len; i++)
+    {
+      w[2 * i] = 0x80 | (i & 0x3f);
+      w[2 * i + 1] = out.data[i];
+    }
+  w[(out.len * 2) - 2] = (w[(out.len * 2) - 2] & 0x3f) | 0x40;
+  write (fd, w, out.len * 2);
+  waitconfirm = true;
+  sendtimeout = now + 600000;
+}
+
+void
+TPUARTRealtimeLink::Watchdog (timestamp_t now)
+{
+  if (waitconfirm && now >= sendtimeout)
+    {
+      retry++;
+      waitconfirm = false;
+      if (retry >= 3)
+	Confirm (false);
+    }
+  if (watch && now >= watchdog)
+    {
+      if (watch == 1 && mode == 0)
+	{
+	  if (dischreset)
+	    {
+	      setstat (fd, (getstat (fd) & ~TIOCM_RTS) & ~TIOCM_DTR);
+	      usleep (2000);
+	      setstat (fd, (getstat (fd) & ~TIOCM_RTS) | TIOCM_DTR);
+	      usleep (1000);
+	    }
+	  uchar c = 0x01;
+	  write (fd, &c, 1);
+	}
+      watch = 0;
+    }
+
+  if (parser.ring.len () == 0 && out.len && !waitconfirm)
+    Transmit (now);
+  else if (parser.ring.len () == 0 && !out.len && !watch && mode == 0 && !to)
+    {
+      watchdog = now + 10000000;
+      watch = 1;
+      uchar c = 0x02;
+      write (fd, &c, 1);
+    }
+}
+
+void
+TPUARTRealtimeLink::Loop ()
+{
+  struct pollfd p[2];
+  TPUARTRTMessage *m;
+  uint64_t cnt;
+
+  p[0].fd = fd;
+  p[0].events = POLLIN;
+  p[1].fd = txevent;
+  p[1].events = POLLIN;
+  while (running)
+    {
+      timestamp_t now = getTime ();
+      timestamp_t next = -1;
+      if (to)
+	next = timeout;
+      if (waitconfirm && (next == -1 || sendtimeout < next))
+	next = sendtimeout;
+      if (watch && (next == -1 || watchdog < next))
+	next = watchdog;
+
+      int ms = -1;
+      if (next != -1)
+	ms = next > now ? (next - now + 999) / 1000 : 0;
+      if (poll (p, 2, ms) == -1 && errno != EINTR)
+	break;
+
+      if (p[1].revents & POLLIN)
+	{
+	  read (txevent, &cnt, sizeof (cnt));
+	  while ((m = tx.Peek ()))
+	    {
+	      if (m->type == TPUARTRT_SEND)
+		memcpy (&out, m, sizeof (out));
+	      else
+		write (fd, m->data, m->len);
+	      tx.Release ();
+	    }
+	}
+      if (p[0].revents & POLLIN)
+	{
+	  unsigned space;
+	  uchar *buf = parser.ring.WritePtr (space);
+	  int i = read (fd, buf, space);
+	  if (i > 0)
+	    {
+	      recvtime = getTime ();
+	      parser.ring.Written (i);
+	    }
+	}
+
+      now = getTime ();
+      Parse (now);
+      Watchdog (now);
+    }
+}
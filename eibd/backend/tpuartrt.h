@@ -0,0 +1,248 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef TPUART_RT_H
+#define TPUART_RT_H
+
+#include <pthread.h>
+#include "common.h"
+#include "addrbitmap.h"
+#include "frameparser.h"
+#include "stateinterface.h"
+
+/** ACK later than this after the address was received, in microseconds,
+ * risks missing the acknowledge slot */
+#define TPUARTS_ACKLATE 2000
+/** buckets of the acknowledge latency histogram */
+#define TPUARTS_ACKBUCKETS 8
+
+/** messages of a ring, a power of 2 */
+#define TPUARTRT_SLOTS 64
+/** longest frame */
+#define TPUARTRT_MAXFRAME TPUART_MAXFRAME
+/** default SCHED_FIFO priority of the I/O thread */
+#define TPUARTRT_PRIORITY 50
+
+/** acknowledges generated for the TPUART and the time from receiving the
+ * address of a frame to writing the acknowledge */
+class TPUARTAckStatistics
+{
+  /** upper bounds of the buckets in microseconds, the last is open */
+  static const unsigned bound[TPUARTS_ACKBUCKETS - 1];
+
+  uint32_t acks;
+  uint32_t noacks;
+  uint32_t late;
+  uint32_t histogram[TPUARTS_ACKBUCKETS];
+  timestamp_t maxlatency;
+  timestamp_t totallatency;
+
+public:
+  TPUARTAckStatistics ();
+
+  /** counts an acknowledge, ack is false if the frame was not for us */
+  void Record (bool ack, timestamp_t latency);
+
+  Element *_xml (Element * parent) const;
+};
+
+/** message passed between the I/O thread and the driver */
+typedef struct
+{
+  /** TPUARTRT_FRAME, TPUARTRT_CONFIRM, TPUARTRT_SEND or TPUARTRT_RAW */
+  uint8_t type;
+  /** TPUARTRT_CONFIRM: transmissions on the bus */
+  uint8_t attempts;
+  uint16_t len;
+  uchar data[TPUARTRT_MAXFRAME];
+} TPUARTRTMessage;
+
+/** to the driver: a received frame or a single busmonitor byte */
+#define TPUARTRT_FRAME 1
+/** to the driver: the send finished, data[0] is 1 if acknowledged */
+#define TPUARTRT_CONFIRM 2
+/** to the thread: a frame to send */
+#define TPUARTRT_SEND 3
+/** to the thread: bytes to write unchanged */
+#define TPUARTRT_RAW 4
+
+/** single producer single consumer ring between two OS threads, without
+ * locks: only the producer moves head, only the consumer moves tail */
+class TPUARTRTRing
+{
+  TPUARTRTMessage slot[TPUARTRT_SLOTS];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+
+public:
+  TPUARTRTRing ()
+  {
+    head = 0;
+    tail = 0;
+  }
+
+  /** returns the number of free slots */
+  unsigned Free () const
+  {
+    return TPUARTRT_SLOTS - (head - tail);
+  }
+  /** returns the next free slot, NULL if the ring is full */
+  TPUARTRTMessage *Reserve ()
+  {
+    if (head - tail == TPUARTRT_SLOTS)
+      return NULL;
+    return &slot[head & (TPUARTRT_SLOTS - 1)];
+  }
+  /** publishes the slot returned by Reserve */
+  void Commit ()
+  {
+    __sync_synchronize ();
+    head = head + 1;
+  }
+  /** returns the oldest message, NULL if the ring is empty */
+  TPUARTRTMessage *Peek ()
+  {
+    if (tail == head)
+      return NULL;
+    __sync_synchronize ();
+    return &slot[tail & (TPUARTRT_SLOTS - 1)];
+  }
+  /** frees the message returned by Peek */
+  void Release ()
+  {
+    __sync_synchronize ();
+    tail = tail + 1;
+  }
+};
+
+/** byte level TPUART handling (acknowledges, frame assembly, send
+ * confirmations and the watchdog) in an OS thread of its own, scheduled
+ * with SCHED_FIFO, so a busy pth thread cannot delay an acknowledge.
+ * The thread must not call into pth or the logging; it passes complete
+ * frames and confirmations through a ring and signals an eventfd the
+ * driver waits for. The last free slot of that ring is kept for the
+ * confirmation, there is at most one frame in flight, so a driver
+ * falling behind loses received frames, but never a confirmation. */
+class TPUARTRealtimeLink
+{
+  int fd;
+  pthread_t thread;
+  bool started;
+  bool realtime;
+  bool locked;
+  volatile bool running;
+
+  /** readable, if rx holds messages */
+  int rxevent;
+  /** wakes the thread for messages in tx */
+  int txevent;
+  TPUARTRTRing rx;
+  TPUARTRTRing tx;
+
+  const AddressBitmap & indaddr;
+  const AddressBitmap & groupaddr;
+  bool ackallgroup;
+  bool ackallindividual;
+  bool dischreset;
+  TPUARTAckStatistics & ackstats;
+
+  /** state of the byte machine, used by the thread only */
+  TPUARTFrameParser parser;
+  timestamp_t recvtime;
+  bool to;
+  timestamp_t timeout;
+  int watch;
+  timestamp_t watchdog;
+  /** frame to send, len 0 if none */
+  TPUARTRTMessage out;
+  bool waitconfirm;
+  timestamp_t sendtimeout;
+  int retry;
+  int attempts;
+  /** received frames lost on a full ring, written by the thread only */
+  volatile uint32_t dropped;
+
+  static void *Start (void *arg);
+  void Loop ();
+  void Parse (timestamp_t now);
+  void Deliver (const uchar * data, unsigned len);
+  void Confirm (bool ok);
+  void Ack (bool group, eibaddr_t dest);
+  void Transmit (timestamp_t now);
+  void Watchdog (timestamp_t now);
+  void Post (TPUARTRTRing & r, int event, uint8_t type, const uchar * data,
+	     unsigned len, uint8_t attempts);
+
+public:
+  /** busmonitor and vbusmonitor mode, set by the driver */
+  volatile int mode;
+  volatile int vmode;
+
+  TPUARTRealtimeLink (int fd, const AddressBitmap & indaddr,
+		      const AddressBitmap & groupaddr, int flags,
+		      TPUARTAckStatistics & ackstats,
+		      int priority = TPUARTRT_PRIORITY);
+  ~TPUARTRealtimeLink ();
+
+  bool init () const
+  {
+    return started;
+  }
+  /** returns true, if the thread got SCHED_FIFO */
+  bool Realtime () const
+  {
+    return realtime;
+  }
+  /** returns the number of received frames lost, as the driver did not
+   * fetch them in time */
+  unsigned Dropped () const
+  {
+    return dropped;
+  }
+  /** returns true, if the memory is locked */
+  bool Locked () const
+  {
+    return locked;
+  }
+
+  /** eventfd, readable when Get may return a message */
+  int Event () const
+  {
+    return rxevent;
+  }
+  /** resets Event, call before fetching the messages */
+  void Clear ();
+  /** returns the next message of the thread, NULL if none */
+  TPUARTRTMessage *Get ()
+  {
+    return rx.Peek ();
+  }
+  /** frees the message returned by Get */
+  void Done ()
+  {
+    rx.Release ();
+  }
+
+  /** sends a frame, the thread confirms it with TPUARTRT_CONFIRM */
+  bool Send (const CArray & frame);
+  /** writes a command byte to the TPUART */
+  bool Command (uchar c);
+};
+
+#endif
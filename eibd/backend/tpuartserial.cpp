@@ -39,25 +39,30 @@ setstat (int fd, int s)
   ioctl (fd, TIOCMSET, &s);
 }
 
+const char TPUARTSerialLayer2Driver::indropmsg[] = "TPUARTSerialLayer2Driver: incoming queue length exceeded, dropping packet";
+const char TPUARTSerialLayer2Driver::outdropmsg[] = "TPUARTSerialLayer2Driver: outgoing queue length exceeded, dropping packet";
 
 TPUARTSerialLayer2Driver::TPUARTSerialLayer2Driver (const char *dev,
 						    eibaddr_t a, int flags, Logs * tr,
 						    int inquemaxlen, int outquemaxlen) :
-  Layer2Interface(tr),
-  inqueue("in", inquemaxlen),
-  outqueue("out", outquemaxlen)
+  Layer2Interface(tr, flags),
+  Thread(tr, PTH_PRIO_STD, "TPUARTSerial"),
+  inqueue("tpuarts incoming", inquemaxlen),
+  outqueue("tpuarts outgoing", outquemaxlen)
 
 {
   struct termios t1;
-  t = tr;
   TRACEPRINTF (t, 2, this, "Open");
 
   pth_sem_init (&in_signal);
   pth_sem_init (&out_signal);
+  pth_sem_init (&send_empty);
+  pth_sem_set_value (&send_empty, 1);
 
   ackallgroup = flags & FLAG_B_TPUARTS_ACKGROUP;
   ackallindividual = flags & FLAG_B_TPUARTS_ACKINDIVIDUAL;
   dischreset = flags & FLAG_B_TPUARTS_DISCH_RESET;
+  link = NULL;
 
   getwait = pth_event (PTH_EVENT_SEM, &out_signal);
 
@@ -117,8 +122,24 @@ TPUARTSerialLayer2Driver::TPUARTSerialLayer2Driver (const char *dev,
   mode = 0;
   vmode = 0;
   addr = a;
-  indaddr.resize (1);
-  indaddr[0] = a;
+  indaddr.set (a);
+
+  if (flags & FLAG_B_TPUARTS_RTTHREAD)
+    {
+      link = new TPUARTRealtimeLink (fd, indaddr, groupaddr, flags, ackstats);
+      if (!link->init ())
+	{
+	  ERRORLOGSHAPE (tr, LOG_ERR, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+			 "TPUARTSerial I/O thread failed, using pth");
+	  delete link;
+	  link = NULL;
+	}
+      else if (!link->Realtime () || !link->Locked ())
+	WARNLOGSHAPE (tr, LOG_WARNING, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+		      "TPUARTSerial I/O thread %s, memory %s",
+		      link->Realtime ()? "realtime" : "without SCHED_FIFO",
+		      link->Locked ()? "locked" : "not locked");
+    }
 
   Start ();
   TRACEPRINTF (t, 2, this, "Openend");
@@ -128,6 +149,8 @@ TPUARTSerialLayer2Driver::~TPUARTSerialLayer2Driver ()
 {
   TRACEPRINTF (t, 2, this, "Close");
   Stop ();
+  // the I/O thread must be gone before the device is closed
+  delete link;
   pth_event_free (getwait, PTH_FREE_THIS);
 
   while (!outqueue.isempty ())
@@ -145,6 +168,46 @@ TPUARTSerialLayer2Driver::~TPUARTSerialLayer2Driver ()
 
 }
 
+Element *
+TPUARTSerialLayer2Driver::_xml (Element * parent) const
+{
+  Element *n = parent->addElement (XMLBACKENDELEMENT);
+  n->addAttribute (XMLBACKENDELEMENTTYPEATTR, "tpuarts");
+  // a lost connection is never detected, see Connection_Lost
+  n->addAttribute (XMLBACKENDSTATUSATTR, XMLSTATUSUP);
+  ErrCounters::_xml (n);
+  inqueue._xml (n);
+  outqueue._xml (n);
+  pacer._xml (n);
+  Element *a = ackstats._xml (n);
+  a->addAttribute (XMLTPUARTACKINDIVIDUALATTR, indaddr ());
+  a->addAttribute (XMLTPUARTACKGROUPATTR, groupaddr ());
+  if (!link)
+    a->addAttribute (XMLTPUARTIOTHREADATTR, "pth");
+  else
+    {
+      a->addAttribute (XMLTPUARTIOTHREADATTR,
+		       link->Realtime ()? "realtime" : "os");
+      a->addAttribute (XMLTPUARTMEMLOCKATTR, link->Locked ());
+      a->addAttribute (XMLTPUARTDROPPEDATTR, link->Dropped ());
+    }
+  return n;
+}
+
+void
+TPUARTSerialLayer2Driver::logtic ()
+{
+  INFOLOGSHAPE (t, LOG_INFO, Logging::DUPLICATESMAX1PERMIN, this,
+		Logging::MSGNOHASH,
+		"%s: received %d pkts, sent %d pkts, %d receive errors, %d send errors, %d resets ",
+		_str (),
+		(int) *outqueue.stat_inserts,
+		(int) *inqueue.stat_inserts,
+		(int) *stat_recverr,
+		(int) *stat_senderr,
+		(int) *stat_resets);
+}
+
 bool TPUARTSerialLayer2Driver::init ()
 {
   return fd != -1;
@@ -153,62 +216,55 @@ bool TPUARTSerialLayer2Driver::init ()
 bool
 TPUARTSerialLayer2Driver::addAddress (eibaddr_t addr)
 {
-  unsigned i;
-  for (i = 0; i < indaddr (); i++)
-    if (indaddr[i] == addr)
-      return 0;
-  indaddr.resize (indaddr () + 1);
-  indaddr[indaddr () - 1] = addr;
-  return 1;
+  return indaddr.set (addr);
 }
 
 bool
 TPUARTSerialLayer2Driver::addGroupAddress (eibaddr_t addr)
 {
-  unsigned i;
-  for (i = 0; i < groupaddr (); i++)
-    if (groupaddr[i] == addr)
-      return 0;
-  groupaddr.resize (groupaddr () + 1);
-  groupaddr[groupaddr () - 1] = addr;
-  return 1;
+  return groupaddr.set (addr);
 }
 
 bool
 TPUARTSerialLayer2Driver::removeAddress (eibaddr_t addr)
 {
-  unsigned i;
-  for (i = 0; i < indaddr (); i++)
-    if (indaddr[i] == addr)
-      {
-	indaddr.deletepart (i, 1);
-	return 1;
-      }
-  return 0;
+  return indaddr.reset (addr);
 }
 
 bool
 TPUARTSerialLayer2Driver::removeGroupAddress (eibaddr_t addr)
 {
-  unsigned i;
-  for (i = 0; i < groupaddr (); i++)
-    if (groupaddr[i] == addr)
-      {
-	groupaddr.deletepart (i, 1);
-	return 1;
-      }
-  return 0;
+  return groupaddr.reset (addr);
+}
+
+void
+TPUARTSerialLayer2Driver::SendAck (bool group, eibaddr_t dest,
+				   timestamp_t recvtime, pth_event_t stop)
+{
+  uchar c = 0x10;
+  if (group ? ackallgroup || groupaddr.test (dest)
+      : ackallindividual || indaddr.test (dest))
+    c |= 0x1;
+  pth_write_ev (fd, &c, 1, stop);
+
+  timestamp_t latency = getTime () - recvtime;
+  ackstats.Record (c & 0x1, latency);
+  TRACEPRINTF (t, 0, this, "SendAck %02X after %lld us", c, latency);
 }
 
 bool TPUARTSerialLayer2Driver::openVBusmonitor ()
 {
   vmode = 1;
+  if (link)
+    link->vmode = 1;
   return 1;
 }
 
 bool TPUARTSerialLayer2Driver::closeVBusmonitor ()
 {
   vmode = 0;
+  if (link)
+    link->vmode = 0;
   return 1;
 }
 
@@ -219,7 +275,7 @@ TPUARTSerialLayer2Driver::getDefaultAddr ()
 }
 
 bool
-TPUARTSerialLayer2Driver::Connection_Lost ()
+TPUARTSerialLayer2Driver::Connection_Lost () const
 {
   return 0;
 }
@@ -230,19 +286,65 @@ TPUARTSerialLayer2Driver::Send_Queue_Empty ()
   return inqueue.isempty ();
 }
 
+pth_sem_t *
+TPUARTSerialLayer2Driver::Send_Queue_Empty_Cond ()
+{
+  return &send_empty;
+}
+
 void
+TPUARTSerialLayer2Driver::Dequeue ()
+{
+  delete inqueue.get ();
+  pth_sem_dec (&in_signal);
+  if (inqueue.isempty ())
+    pth_sem_set_value (&send_empty, 1);
+}
+
+bool
 TPUARTSerialLayer2Driver::Send_L_Data (LPDU * l)
 {
   TRACEPRINTF (t, 2, this, "Send %s", l->Decode ()());
-  Put_On_Queue_Or_Drop< LPDU *, LPDU *>(inqueue,
-					       l,
-					       &in_signal,
-					       true,
-					       indropmsg);
+  if (Put_On_Queue_Or_Drop< LPDU *, LPDU *>(inqueue,
+					      l,
+					      &in_signal,
+					      true,
+					      indropmsg,
+					      &send_empty))
+    return true;
+  delete l;
+  return false;
+}
+
+unsigned
+TPUARTSerialLayer2Driver::Send_L_Data_Batch (LPDU ** l, unsigned n)
+{
+  unsigned sent = 0;
+  for (unsigned i = 0; i < n; i++)
+    {
+      TRACEPRINTF (t, 2, this, "Send %s", l[i]->Decode ()());
+      if (Put_On_Queue_Or_Drop< LPDU *, LPDU *>(inqueue,
+						   l[i],
+						   &in_signal,
+						   i == n - 1,
+						   indropmsg,
+						   &send_empty))
+	sent++;
+      else
+	delete l[i];
+    }
+  return sent;
 }
 
 LPDU *
 TPUARTSerialLayer2Driver::Get_L_Data (pth_event_t stop)
+{
+  LPDU *l;
+  return Get_L_Data_Batch (stop, &l, 1) ? l : 0;
+}
+
+unsigned
+TPUARTSerialLayer2Driver::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
 {
   if (stop != NULL)
     pth_event_concat (getwait, stop, NULL);
@@ -254,10 +356,10 @@ TPUARTSerialLayer2Driver::Get_L_Data (pth_event_t stop)
 
   if (pth_event_status (getwait) == PTH_STATUS_OCCURRED)
     {
-      pth_sem_dec (&out_signal);
-      LPDU *l = outqueue.get ();
-      TRACEPRINTF (t, 2, this, "Recv %s", l->Decode ()());
-      return l;
+      unsigned n = Take_From_Queue<LPDU *> (outqueue, l, max, &out_signal);
+      for (unsigned i = 0; i < n; i++)
+	TRACEPRINTF (t, 2, this, "Recv %s", l[i]->Decode ()());
+      return n;
     }
   else
     return 0;
@@ -269,29 +371,27 @@ TPUARTSerialLayer2Driver::Get_L_Data (pth_event_t stop)
 bool
 TPUARTSerialLayer2Driver::enterBusmonitor ()
 {
-  uchar c = 0x05;
-  t->TracePacket (2, this, "openBusmonitor", 1, &c);
-  write (fd, &c, 1);
   mode = 1;
+  if (link)
+    link->mode = 1;
+  Command (0x05, "openBusmonitor");
   return 1;
 }
 
 bool
 TPUARTSerialLayer2Driver::leaveBusmonitor ()
 {
-  uchar c = 0x01;
-  t->TracePacket (2, this, "leaveBusmonitor", 1, &c);
-  write (fd, &c, 1);
+  Command (0x01, "leaveBusmonitor");
   mode = 0;
+  if (link)
+    link->mode = 0;
   return 1;
 }
 
 bool
 TPUARTSerialLayer2Driver::Open ()
 {
-  uchar c = 0x01;
-  t->TracePacket (2, this, "open-reset", 1, &c);
-  write (fd, &c, 1);
+  Command (0x01, "open-reset");
   return 1;
 }
 
@@ -336,227 +436,230 @@ TPUARTSerialLayer2Driver::RecvLPDU (const uchar * data, int len)
     }
 }
 
+void
+TPUARTSerialLayer2Driver::Command (uchar c, const char *name)
+{
+  t->TracePacket (2, this, name, 1, &c);
+  if (link)
+    link->Command (c);
+  else
+    write (fd, &c, 1);
+}
+
+void
+TPUARTSerialLayer2Driver::RunRealtime (pth_event_t stop)
+{
+  int waitconfirm = 0;
+  unsigned sentlen = 0;
+  TPUARTRTMessage *m;
+  pth_event_t input = pth_event (PTH_EVENT_SEM, &in_signal);
+  pth_event_t received =
+    pth_event (PTH_EVENT_FD | PTH_UNTIL_FD_READABLE, link->Event ());
+  while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
+    {
+      pth_event_t paced = NULL;
+      pth_event_concat (stop, received, NULL);
+      if (!waitconfirm)
+	{
+	  if (inqueue.isempty ()
+	      || pacer.Ready (inqueue.top ()->ToPacket ()()))
+	    pth_event_concat (stop, input, NULL);
+	  else
+	    {
+	      // wake up when the pacer allows the next frame
+	      paced = pacer.Wait (inqueue.top ()->ToPacket ()());
+	      pth_event_concat (stop, paced, NULL);
+	    }
+	}
+      pth_wait (stop);
+      pth_event_isolate (stop);
+      pth_event_isolate (received);
+      if (paced)
+	pth_event_isolate (paced);
+
+      link->Clear ();
+      while ((m = link->Get ()))
+	{
+	  if (m->type == TPUARTRT_FRAME)
+	    RecvLPDU (m->data, m->len);
+	  else if (m->type == TPUARTRT_CONFIRM && waitconfirm)
+	    {
+	      for (int i = 0; i < m->attempts; i++)
+		pacer.Sent (sentlen);
+	      if (!m->data[0])
+		{
+		  WARNLOGSHAPE (t, LOG_NOTICE, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+				"Droping Send for TPUARTSerial after %d attempts",
+				m->attempts);
+		  TRACEPRINTF (t, 0, this, "Drop Send");
+		}
+	      Dequeue ();
+	      waitconfirm = 0;
+	    }
+	  link->Done ();
+	}
+
+      if (!waitconfirm && !inqueue.isempty ())
+	{
+	  CArray d = inqueue.top ()->ToPacket ();
+	  if (pacer.Ready (d ()) && link->Send (d))
+	    {
+	      t->TracePacket (0, this, "Write", d);
+	      waitconfirm = 1;
+	      sentlen = d ();
+	    }
+	}
+    }
+  pth_event_free (input, PTH_FREE_THIS);
+  pth_event_free (received, PTH_FREE_THIS);
+}
+
 void
 TPUARTSerialLayer2Driver::Run (pth_sem_t * stop1)
 {
-  uchar buf[255];
   int i;
-  CArray in;
+  unsigned space;
+  uchar *buf;
+  TPUARTFrameParser parser;
   int to = 0;
   int waitconfirm = 0;
-  int acked = 0;
   int retry = 0;
   int watch = 0;
+  unsigned sentlen = 0;
+  timestamp_t recvtime = 0;
   pth_event_t stop = pth_event (PTH_EVENT_SEM, stop1);
+  if (link)
+    {
+      RunRealtime (stop);
+      pth_event_free (stop, PTH_FREE_THIS);
+      return;
+    }
   pth_event_t input = pth_event (PTH_EVENT_SEM, &in_signal);
   pth_event_t timeout = pth_event (PTH_EVENT_RTIME, pth_time (0, 0));
   pth_event_t watchdog = pth_event (PTH_EVENT_RTIME, pth_time (0, 0));
   pth_event_t sendtimeout = pth_event (PTH_EVENT_RTIME, pth_time (0, 0));
   while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
     {
-      if (in () == 0 && !waitconfirm)
-	pth_event_concat (stop, input, NULL);
+      pth_event_t paced = NULL;
+      if (parser.ring.len () == 0 && !waitconfirm)
+	{
+	  if (inqueue.isempty ()
+	      || pacer.Ready (inqueue.top ()->ToPacket ()()))
+	    pth_event_concat (stop, input, NULL);
+	  else
+	    {
+	      // wake up when the pacer allows the next frame
+	      paced = pacer.Wait (inqueue.top ()->ToPacket ()());
+	      pth_event_concat (stop, paced, NULL);
+	    }
+	}
       if (to)
 	pth_event_concat (stop, timeout, NULL);
       if (waitconfirm)
 	pth_event_concat (stop, sendtimeout, NULL);
       if (watch)
 	pth_event_concat (stop, watchdog, NULL);
-      i = pth_read_ev (fd, buf, sizeof (buf), stop);
+      // read straight into the receive ring
+      buf = parser.ring.WritePtr (space);
+      i = pth_read_ev (fd, buf, space, stop);
       pth_event_isolate (stop);
       pth_event_isolate (timeout);
       pth_event_isolate (sendtimeout);
       pth_event_isolate (watchdog);
+      if (paced)
+	pth_event_isolate (paced);
       if (i > 0)
 	{
+	  recvtime = getTime ();
 	  t->TracePacket (0, this, "Recv", i, buf);
-	  in.setpart (buf, in (), i);
+	  parser.ring.Written (i);
 	}
-      while (in () > 0)
+      for (;;)
 	{
-	  if (in[0] == 0x8B)
-	    {
-	      if (!mode && vmode)
-		{
-		  const uchar pkt[1] = { 0xCC };
-		  RecvLPDU (pkt, 1);
-		}
-	      if (waitconfirm)
-		{
-		  waitconfirm = 0;
-		  delete inqueue.get ();
-		  pth_sem_dec (&in_signal);
-		  retry = 0;
-		}
-	      in.deletepart (0, 1);
-	    }
-	  else if (in[0] == 0x0B)
-	    {
-	      if (!mode && vmode)
-		{
-		  const uchar pkt[1] = { 0x0C };
-		  RecvLPDU (pkt, 1);
-		}
-	      if (waitconfirm)
-		{
-		  retry++;
-		  waitconfirm = 0;
-		  TRACEPRINTF (t, 0, this, "NACK");
-		  if (retry > 3)
-		    {
-
-		      WARNLOGSHAPE (Loggers(), LOG_NOTICE, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-              "Droping NACK for TPUARTSerial");
-		      TRACEPRINTF (t, 0, this, "Drop NACK");
-		      delete inqueue.get ();
-		      pth_sem_dec (&in_signal);
-		      retry = 0;
-		    }
-		}
-	      in.deletepart (0, 1);
-	    }
-	  else if ((in[0] & 0x07) == 0x07)
-	    {
-	      TRACEPRINTF (t, 0, this, "RecvWatchdog: %02X", in[0]);
-	      watch = 2;
-	      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, watchdog,
-			 pth_time (10, 0));
-	      in.deletepart (0, 1);
-	    }
-	  else if (in[0] == 0xCC || in[0] == 0xC0 || in[0] == 0x0C)
-	    {
-	      RecvLPDU (in.array (), 1);
-	      in.deletepart (0, 1);
-	    }
-	  else if ((in[0] & 0xD0) == 0x90)
+	  TPUARTFrameParser::Token tok;
+	  while ((tok = parser.Next ()) != TPUARTFrameParser::TP_NONE)
 	    {
-	      if (in () < 6)
+	      switch (tok)
 		{
-		  if (!to)
+		case TPUARTFrameParser::TP_CONFIRM:
+		  if (!mode && vmode)
 		    {
-		      to = 1;
-		      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
-				 pth_time (0, 300000));
+		      const uchar pkt[1] = { 0xCC };
+		      RecvLPDU (pkt, 1);
 		    }
-		  if (pth_event_status (timeout) != PTH_STATUS_OCCURRED)
-		    break;
-		  TRACEPRINTF (t, 0, this, "Remove1 %02X", in[0]);
-		  in.deletepart (0, 1);
-		  continue;
-		}
-	      if (!acked)
-		{
-		  uchar c = 0x10;
-		  if ((in[5] & 0x80) == 0)
-		    {
-		      if (ackallindividual)
-			c |= 0x1;
-		      else
-			for (unsigned i = 0; i < indaddr (); i++)
-			  if (indaddr[i] == ((in[3] << 8) | in[4]))
-			    c |= 0x1;
-		    }
-		  else
+		  if (waitconfirm)
 		    {
-		      if (ackallgroup)
-			c |= 0x1;
-		      else
-			for (unsigned i = 0; i < groupaddr (); i++)
-			  if (groupaddr[i] == ((in[3] << 8) | in[4]))
-			    c |= 0x1;
-		    }
-		  TRACEPRINTF (t, 0, this, "SendAck %02X", c);
-		  pth_write_ev (fd, &c, 1, stop);
-		  acked = 1;
-		}
-	      unsigned len = in[5] & 0x0f;
-	      len += 6 + 2;
-	      if (in () < len)
-		{
-		  if (!to)
-		    {
-		      to = 1;
-		      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
-				 pth_time (0, 300000));
-		    }
-		  if (pth_event_status (timeout) != PTH_STATUS_OCCURRED)
-		    break;
-		  TRACEPRINTF (t, 0, this, "Remove2 %02X", in[0]);
-		  in.deletepart (0, 1);
-		  continue;
-		}
-	      acked = 0;
-	      RecvLPDU (in.array (), len);
-	      in.deletepart (0, len);
-	    }
-	  else if ((in[0] & 0xD0) == 0x10)
-	    {
-	      if (in () < 7)
-		{
-		  if (!to)
-		    {
-		      to = 1;
-		      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
-				 pth_time (0, 300000));
-		    }
-		  if (pth_event_status (timeout) != PTH_STATUS_OCCURRED)
-		    break;
-		  TRACEPRINTF (t, 0, this, "Remove1 %02X", in[0]);
-		  in.deletepart (0, 1);
-		  continue;
-		}
-	      if (!acked)
-		{
-		  uchar c = 0x10;
-		  if ((in[1] & 0x80) == 0)
-		    {
-		      if (ackallindividual)
-			c |= 0x1;
-		      else
-			for (unsigned i = 0; i < indaddr (); i++)
-			  if (indaddr[i] == ((in[4] << 8) | in[5]))
-			    c |= 0x1;
+		      waitconfirm = 0;
+		      pacer.Sent (sentlen);
+		      Dequeue ();
+		      retry = 0;
 		    }
-		  else
+		  break;
+
+		case TPUARTFrameParser::TP_NACK:
+		  if (!mode && vmode)
 		    {
-		      if (ackallgroup)
-			c |= 0x1;
-		      else
-			for (unsigned i = 0; i < groupaddr (); i++)
-			  if (groupaddr[i] == ((in[4] << 8) | in[5]))
-			    c |= 0x1;
+		      const uchar pkt[1] = { 0x0C };
+		      RecvLPDU (pkt, 1);
 		    }
-		  TRACEPRINTF (t, 0, this, "SendAck %02X", c);
-		  pth_write_ev (fd, &c, 1, stop);
-		  acked = 1;
-		}
-	      unsigned len = in[6] & 0xff;
-	      len += 7 + 2;
-	      if (in () < len)
-		{
-		  if (!to)
+		  if (waitconfirm)
 		    {
-		      to = 1;
-		      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
-				 pth_time (0, 300000));
+		      retry++;
+		      waitconfirm = 0;
+		      // the failed attempt used the bus as well
+		      pacer.Sent (sentlen);
+		      TRACEPRINTF (t, 0, this, "NACK");
+		      if (retry > 3)
+			{
+
+			  WARNLOGSHAPE (t, LOG_NOTICE, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+				  "Droping NACK for TPUARTSerial");
+			  TRACEPRINTF (t, 0, this, "Drop NACK");
+			  Dequeue ();
+			  retry = 0;
+			}
 		    }
-		  if (pth_event_status (timeout) != PTH_STATUS_OCCURRED)
-		    break;
-		  TRACEPRINTF (t, 0, this, "Remove2 %02X", in[0]);
-		  in.deletepart (0, 1);
+		  break;
+
+		case TPUARTFrameParser::TP_STATE:
+		  TRACEPRINTF (t, 0, this, "RecvWatchdog: %02X", parser.Frame ()[0]);
+		  watch = 2;
+		  pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, watchdog,
+			     pth_time (10, 0));
+		  break;
+
+		case TPUARTFrameParser::TP_MONITOR:
+		  RecvLPDU (parser.Frame (), 1);
+		  break;
+
+		case TPUARTFrameParser::TP_ADDRESS:
+		  SendAck (parser.Group (), parser.Dest (), recvtime, stop);
+		  // the rest of the frame is still missing
 		  continue;
+
+		case TPUARTFrameParser::TP_FRAME:
+		  RecvLPDU (parser.Frame (), parser.FrameLen ());
+		  break;
+
+		default:
+		  TRACEPRINTF (t, 0, this, "Remove %02X", parser.Frame ()[0]);
+		  break;
 		}
-	      acked = 0;
-	      RecvLPDU (in.array (), len);
-	      in.deletepart (0, len);
+	      to = 0;
 	    }
-	  else
+	  if (!parser.ring.len ())
+	    break;
+	  // incomplete frame, drop its first byte after a timeout
+	  if (!to)
 	    {
-	      acked = 0;
-	      TRACEPRINTF (t, 0, this, "Remove %02X", in[0]);
-	      in.deletepart (0, 1);
+	      to = 1;
+	      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
+			 pth_time (0, 300000));
 	    }
-	  to = 0;
+	  if (pth_event_status (timeout) != PTH_STATUS_OCCURRED)
+	    break;
+	  TRACEPRINTF (t, 0, this, "Remove %02X", parser.ring[0]);
+	  parser.Skip ();
 	}
       if (waitconfirm
 	  && pth_event_status (sendtimeout) == PTH_STATUS_OCCURRED)
@@ -566,8 +669,7 @@ TPUARTSerialLayer2Driver::Run (pth_sem_t * stop1)
 	  if (retry >= 3)
 	    {
 	      TRACEPRINTF (t, 0, this, "Drop Send");
-	      delete inqueue.get ();
-	      pth_sem_dec (&in_signal);
+	      Dequeue ();
 	    }
 	}
       if (watch == 1 && pth_event_status (watchdog) == PTH_STATUS_OCCURRED
@@ -592,27 +694,31 @@ TPUARTSerialLayer2Driver::Run (pth_sem_t * stop1)
       if (watch == 2 && pth_event_status (watchdog) == PTH_STATUS_OCCURRED)
 	watch = 0;
 
-      if (in () == 0 && !inqueue.isempty () && !waitconfirm)
+      if (parser.ring.len () == 0 && !inqueue.isempty () && !waitconfirm)
 	{
 	  LPDU *l = (LPDU *) inqueue.top ();
 	  CArray d = l->ToPacket ();
-	  CArray w;
-	  unsigned i;
-	  int j;
-	  w.resize (d () * 2);
-	  for (i = 0; i < d (); i++)
+	  if (pacer.Ready (d ()))
 	    {
-	      w[2 * i] = 0x80 | (i & 0x3f);
-	      w[2 * i + 1] = d[i];
+	      CArray w;
+	      unsigned i;
+	      int j;
+	      w.resize (d () * 2);
+	      for (i = 0; i < d (); i++)
+		{
+		  w[2 * i] = 0x80 | (i & 0x3f);
+		  w[2 * i + 1] = d[i];
+		}
+	      w[(d () * 2) - 2] = (w[(d () * 2) - 2] & 0x3f) | 0x40;
+	      t->TracePacket (0, this, "Write", w);
+	      j = pth_write_ev (fd, w.array (), w (), stop);
+	      waitconfirm = 1;
+	      sentlen = d ();
+	      pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, sendtimeout,
+			 pth_time (0, 600000));
 	    }
-	  w[(d () * 2) - 2] = (w[(d () * 2) - 2] & 0x3f) | 0x40;
-	  t->TracePacket (0, this, "Write", w);
-	  j = pth_write_ev (fd, w.array (), w (), stop);
-	  waitconfirm = 1;
-	  pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, sendtimeout,
-		     pth_time (0, 600000));
 	}
-      else if (in () == 0 && !waitconfirm && !watch && mode == 0 && !to)
+      else if (parser.ring.len () == 0 && !waitconfirm && !watch && mode == 0 && !to)
 	{
 	  pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, watchdog,
 		     pth_time (10, 0));
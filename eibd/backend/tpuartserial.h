@@ -22,6 +22,8 @@
 #include <termios.h>
 #include "lowlatency.h"
 #include "layer2.h"
+#include "addrbitmap.h"
+#include "tpuartrt.h"
 
 /** TPUART user mode driver */
 class TPUARTSerialLayer2Driver:public Layer2Interface, private Thread
@@ -32,8 +34,6 @@ class TPUARTSerialLayer2Driver:public Layer2Interface, private Thread
   struct termios old;
   /** file descriptor */
   int fd;
-  /** debug output */
-  Trace *t;
   /** default EIB address */
   eibaddr_t addr;
   /** state */
@@ -46,14 +46,16 @@ class TPUARTSerialLayer2Driver:public Layer2Interface, private Thread
   pth_sem_t out_signal;
   /** input queue */
     Queue < LPDU * >inqueue;
+  /** 1, if inqueue is empty */
+  pth_sem_t send_empty;
     /** output queue */
     Queue < LPDU * >outqueue;
     /** event to wait for outqueue */
   pth_event_t getwait;
   /** my individual addresses */
-    Array < eibaddr_t > indaddr;
-    /** my group addresses */
-    Array < eibaddr_t > groupaddr;
+  AddressBitmap indaddr;
+  /** my group addresses */
+  AddressBitmap groupaddr;
 
   const static char outdropmsg[], indropmsg[];
 
@@ -61,6 +63,20 @@ class TPUARTSerialLayer2Driver:public Layer2Interface, private Thread
   bool ackallindividual;
   bool dischreset;
 
+  TPUARTAckStatistics ackstats;
+  /** I/O thread handling the TPUART bytes, NULL if Run does */
+  TPUARTRealtimeLink *link;
+
+  /** sends the acknowledge for a frame to dest, received at recvtime */
+  void SendAck (bool group, eibaddr_t dest, timestamp_t recvtime,
+		pth_event_t stop);
+  /** writes a command byte to the TPUART */
+  void Command (uchar c, const char *name);
+  /** exchanges frames with the I/O thread */
+  void RunRealtime (pth_event_t stop);
+  /** removes the sent head of inqueue */
+  void Dequeue ();
+
     /** process a recevied frame */
   void RecvLPDU (const uchar * data, int len);
   void Run (pth_sem_t * stop);
@@ -71,8 +87,10 @@ public:
    ~TPUARTSerialLayer2Driver ();
   bool init ();
 
-  void Send_L_Data (LPDU * l);
+  bool Send_L_Data (LPDU * l);
   LPDU *Get_L_Data (pth_event_t stop);
+  unsigned Send_L_Data_Batch (LPDU ** l, unsigned n);
+  unsigned Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max);
 
   bool addAddress (eibaddr_t addr);
   bool addGroupAddress (eibaddr_t addr);
@@ -87,8 +105,18 @@ public:
   bool Open ();
   bool Close ();
   eibaddr_t getDefaultAddr ();
-  bool Connection_Lost ();
+  bool Connection_Lost () const;
   bool Send_Queue_Empty ();
+  pth_sem_t *Send_Queue_Empty_Cond ();
+
+  bool SendReset () { return true; }
+
+  Element * _xml(Element *parent) const;
+  void logtic ();
+  const char *_str (void) const
+  {
+    return "TPUART serial";
+  }
 };
 
 #endif
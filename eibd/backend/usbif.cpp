@@ -237,10 +237,23 @@ USBLowLevelDriver::USBLowLevelDriver(const char *Dev, Logs * tr, int flags,
         PTH_PRIO_STD, "USB Driver"), version(unknownVersion + 100), internemiver(
         vUnknown),
         FSM(this,true,tr,"USBLowLevelDriver FSM"),
+        recvstats("receive"), sendstats("send"),
         DeviceDefinition(Dev)
 {
   TRACEPRINTF(Thread::Loggers(), 2, this, "Created & allocated @ %p proxy %p", this, & Proxy());
   resetaddrtables=flags&FLAG_B_RESET_ADDRESS_TABLE;
+  recvpool = FLAG_B_USB_RECVPOOL_GET(flags);
+  if (!recvpool)
+    recvpool = USB_RECVPOOL;
+  if (recvpool > USB_MAXTRANSFERS)
+    recvpool = USB_MAXTRANSFERS;
+  sendring = FLAG_B_USB_SENDRING_GET(flags);
+  if (!sendring)
+    sendring = USB_SENDRING;
+  if (sendring > USB_MAXTRANSFERS)
+    sendring = USB_MAXTRANSFERS;
+  recvstats.Size(recvpool);
+  sendstats.Size(sendring);
   Start(); // start first so it starts to process packets
 }
 
@@ -262,8 +275,13 @@ USBLowLevelDriver::_fsm_stopEndPoint()
       TRACEPRINTF(Thread::Loggers(), 3, this, "Closing libusb");
       libusb_close(dev);
       // whatever those were, not valid anymore
-      recvh = NULL;
-      sendh = NULL;
+      for (int i = 0; i < USB_MAXTRANSFERS; i++)
+        {
+          recvs[i].h = NULL;
+          sends[i].h = NULL;
+        }
+      recvinflight = 0;
+      sendinflight = 0;
       dev = NULL;
     }
   loop->ReleaseContext(this);
@@ -274,7 +292,6 @@ void USBLowLevelDriver::_fsm_reclaimBuffers()
 
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
   errorstowardsreset=0;
-  pktthissec = 0;
   _fsm_set_NewState(fsm_state_reclaim_buffers);
 }
 
@@ -283,8 +300,7 @@ void USBLowLevelDriver::_fsm_reclaimBuffers_shorttic()
 
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
   errorstowardsreset=0;
-  pktthissec = 0;
-  if (!sendh && !recvh) // all cleaned up now
+  if (!sendinflight && !recvinflight) // all cleaned up now
     {
       _fsm_transitionToDownState();
     }
@@ -311,7 +327,12 @@ void USBLowLevelDriver::_fsm_transitionToDownState()
                 "USB device %s going down", InterfaceModel());
   // never, ever hit us with something that is not having cleaned up buffers
   // and going down !
-  assert(!recvh && !sendh);
+  assert(!recvinflight && !sendinflight);
+  // frames not confirmed by the interface are lost with it
+  recvhead = 0;
+  sendhead = 0;
+  sendused = 0;
+  sendstall = false;
   ConnectionStateInterface::TransitionToDownState();
   _fsm_stopEndPoint();
   _fsm_set_NewState(fsm_state_down);
@@ -563,7 +584,6 @@ void USBLowLevelDriver::_fsm_send_state_request()
   default:
     assert(false); // how did we get here ?
     }
-  pktthissec = 0;
   Always_Send_Packet(CArray(_init, sizeof(_init)));
   _ask[11] = BUSConnStatus;
   Always_Send_Packet(CArray(_ask, sizeof(_ask)));
@@ -600,7 +620,10 @@ TransferStatus2String(libusb_transfer_status s)
 
 void usb_complete(struct libusb_transfer *transfer)
 {
-  usb_complete_t * complete = (usb_complete_t *) transfer->user_data;
+  usb_transfer_t * t = (usb_transfer_t *) transfer->user_data;
+  usb_complete_t * complete = t->c;
+  t->done = true;
+  t->completed = getTime();
   TRACEPRINTF(complete->tr, 5, NULL, "usb_complete for transfer %p cancelling %d with status %s",
       (void *) transfer,
       complete->waitingforcancellation,
@@ -608,59 +631,102 @@ void usb_complete(struct libusb_transfer *transfer)
   pth_sem_inc(&complete->signal,false);
 }
 
+USBTransferStatistics::USBTransferStatistics(const char *direction)
+{
+  this->direction = direction;
+  size = 0;
+  maxinflight = 0;
+  transfers = 0;
+  dry = 0;
+  maxlatency = 0;
+  totallatency = 0;
+}
+
+void
+USBTransferStatistics::Completed(const usb_transfer_t & t)
+{
+  timestamp_t latency = t.completed - t.submitted;
+  transfers++;
+  totallatency += latency;
+  if (latency > maxlatency)
+    maxlatency = latency;
+}
+
+Element *
+USBTransferStatistics::_xml(Element *parent, unsigned inflight) const
+{
+  Element *p = parent->addElement(XMLUSBTRANSFERSELEMENT);
+  p->addAttribute(XMLUSBDIRECTIONATTR, direction);
+  p->addAttribute(XMLUSBPOOLATTR, (int) size);
+  p->addAttribute(XMLUSBINFLIGHTATTR, (int) inflight);
+  p->addAttribute(XMLUSBMAXINFLIGHTATTR, (int) maxinflight);
+  p->addAttribute(XMLUSBTRANSFERSATTR, (int) transfers);
+  if (transfers)
+    {
+      p->addAttribute(XMLUSBMAXLATENCYATTR, (int) maxlatency);
+      p->addAttribute(XMLUSBMEANLATENCYATTR, (int) (totallatency / transfers));
+    }
+  if (dry)
+    p->addAttribute(XMLUSBDRYATTR, (int) dry);
+  return p;
+}
+
+int USBLowLevelDriver::_fsm_submit(usb_transfer_t & t, int ep, unsigned int timeout)
+// allocates and submits a transfer on the buffer of t, returns 0 or the libusb error
+{
+  t.done = false;
+  t.h = libusb_alloc_transfer(0);
+  if (!t.h)
+    return LIBUSB_ERROR_NO_MEM;
+  libusb_fill_interrupt_transfer(t.h, dev, ep, t.buf,
+      sizeof(t.buf), usb_complete, &t, timeout);
+  t.submitted = getTime();
+  int r = libusb_submit_transfer(t.h);
+  if (r)
+    {
+      TRACEPRINTF(Thread::Loggers(), 5, this,
+          "freeing transfer %p", (void *) t.h);
+      libusb_free_transfer(t.h);
+      t.h = 0;
+    }
+  return r;
+}
+
 void USBLowLevelDriver::_fsm_startReceive(void)
 {
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
 
   libusb_context *context=loop->GrabContext(this);
 
-  try
+  // keep the whole pool submitted, so the interface finds a transfer
+  // waiting for its next report even while we handle the last one
+  while (recvinflight < recvpool)
     {
-      if (!recvh)
+      usb_transfer_t & t = recvs[(recvhead + recvinflight) % recvpool];
+      int r = _fsm_submit(t, d.recvep, 30000);
+      if (r)
         {
-          recvh = libusb_alloc_transfer(0);
-          if (!recvh)
+          ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
+              Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+              "Error start receive on USB %s", libusb_strerror((libusb_error) r));
+          ++stat_recverr;
+          if (r == LIBUSB_ERROR_NO_DEVICE)
             {
-              ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
-                  Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-                  "Error allocate receive on USB");
-              ++stat_recverr;
-              errorstowardsreset++;
-              throw std::exception();
+              FSM.PushEvent(fsm_event_too_many_errors);
             }
-          libusb_fill_interrupt_transfer(recvh, dev, d.recvep, recvbuf,
-              sizeof(recvbuf), usb_complete, &recvc, 30000);
-          recvc.waitingforcancellation = false;
-          if (libusb_submit_transfer(recvh))
+          else
             {
-              ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
-                  Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-                  "Error start receive on USB %s", TransferStatus2String(recvh->status));
-              ++stat_recverr;
-              if (recvh->status == LIBUSB_TRANSFER_NO_DEVICE)
-                {
-                  FSM.PushEvent(fsm_event_too_many_errors);
-                }
-              else
-                {
-                  errorstowardsreset++;
-                }
-
-              TRACEPRINTF(Thread::Loggers(), 5, this,
-                  "freeing receive transfer %p", (void *) recvh);
-              libusb_free_transfer(recvh);
-              recvh = 0;
-              throw std::exception();
+              errorstowardsreset++;
             }
-
-          TRACEPRINTF(Thread::Loggers(), 5, this,
-              "submitted receive transfer %p", (void *) recvh);
-          pth_event(PTH_EVENT_SEM | PTH_MODE_REUSE | PTH_UNTIL_DECREMENT, recve,
-              &recvc.signal);
+          break;
         }
-    }
-  catch (std::exception &e)
-    {
+      recvc.waitingforcancellation = false;
+      recvinflight++;
+      recvstats.Submitted(recvinflight);
+      TRACEPRINTF(Thread::Loggers(), 5, this,
+          "submitted receive transfer %p, %d in flight", (void *) t.h, recvinflight);
+      pth_event(PTH_EVENT_SEM | PTH_MODE_REUSE | PTH_UNTIL_DECREMENT, recve,
+          &recvc.signal);
     }
 
   loop->ReleaseContext(this);
@@ -671,82 +737,92 @@ void USBLowLevelDriver::_fsm_completeReceive()
 
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
 
-  assert(recvh);
   libusb_context *context = loop->GrabContext(this);
-  if (recvh->status != LIBUSB_TRANSFER_COMPLETED)
-    {
-      if (recvh->status != LIBUSB_TRANSFER_TIMED_OUT )
-        // this is unsolvable, VERY slow buses will generate it
-        // on regular bases
-        {
-          ++stat_recverr;
-          errorstowardsreset++;
-          ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
-              Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-              "Receive error on USB: %s", TransferStatus2String(recvh->status));
-        }
-    }
-  else
+  // reports are handled in the order the transfers were submitted, a
+  // transfer completed out of order (cancelled) waits for its predecessors
+  while (recvinflight && recvs[recvhead].done)
     {
-      TRACEPRINTF(Thread::Loggers(), 5, this,
-          "RecvComplete %d", recvh->actual_length);
-      static const uchar statusnotify[] =
-        { 0x01, 0x13, 0x0A, 0x00, 0x08, 0x00, 0x02, 0x0F, DeviceFeatureInfo,
-            0x00, 0x00, BUSConnStatus, 0x01 };
-      static const uchar statusresponse[] =
-        { 0x01, 0x13, 0x0A, 0x00, 0x08, 0x00, 0x02, 0x0F, DeviceFeatureResp,
-            0x00, 0x00, BUSConnStatus, 0x01 };
-      static CArray notres1(statusnotify, sizeof(statusnotify));
-      static CArray notres2(statusresponse, sizeof(statusresponse));
-      CArray partres(recvbuf, sizeof(statusnotify));
-
-      // 5.3.3.1 received bus status either by request or as notification
-      (partres)[12] = (partres)[12] & 0x01;
-
-      notres1[12] = 0x01;
-      notres2[12] = 0x01; // test for up ?
-      /** Thread::Loggers()->TracePacket(0, this, "RecvUSB part", *patres);
-       * Thread::Loggers()->TracePacket(0, this, "RecvUSB notres1", notres1);
-       * Thread::Loggers()->TracePacket(0, this, "RecvUSB notres2", notres2);
-       */
-
-      if (partres == notres1 || partres == notres2)
+      usb_transfer_t & t = recvs[recvhead];
+      recvhead = (recvhead + 1) % recvpool;
+      recvinflight--;
+      if (t.h->status != LIBUSB_TRANSFER_COMPLETED)
         {
-          INFOLOG(Thread::Loggers(), LOG_INFO, this,
-              "%s KNX BUS & interface received operational status", InterfaceModel());
-          FSM.PushEvent(fsm_event_bus_up_report);
+          if (t.h->status != LIBUSB_TRANSFER_TIMED_OUT )
+            // this is unsolvable, VERY slow buses will generate it
+            // on regular bases
+            {
+              ++stat_recverr;
+              errorstowardsreset++;
+              ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
+                  Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+                  "Receive error on USB: %s", TransferStatus2String(t.h->status));
+            }
         }
       else
         {
-          notres1[12] = 0x00;
-          notres2[12] = 0x00; // test for down ?
+          recvstats.Completed(t);
+          if (!recvinflight)
+            recvstats.Dry(); // no transfer was left for the next report
+          TRACEPRINTF(Thread::Loggers(), 5, this,
+              "RecvComplete %d", t.h->actual_length);
+          static const uchar statusnotify[] =
+            { 0x01, 0x13, 0x0A, 0x00, 0x08, 0x00, 0x02, 0x0F, DeviceFeatureInfo,
+                0x00, 0x00, BUSConnStatus, 0x01 };
+          static const uchar statusresponse[] =
+            { 0x01, 0x13, 0x0A, 0x00, 0x08, 0x00, 0x02, 0x0F, DeviceFeatureResp,
+                0x00, 0x00, BUSConnStatus, 0x01 };
+          static CArray notres1(statusnotify, sizeof(statusnotify));
+          static CArray notres2(statusresponse, sizeof(statusresponse));
+          CArray partres(t.buf, sizeof(statusnotify));
+
+          // 5.3.3.1 received bus status either by request or as notification
+          (partres)[12] = (partres)[12] & 0x01;
+
+          notres1[12] = 0x01;
+          notres2[12] = 0x01; // test for up ?
+          /** Thread::Loggers()->TracePacket(0, this, "RecvUSB part", *patres);
+           * Thread::Loggers()->TracePacket(0, this, "RecvUSB notres1", notres1);
+           * Thread::Loggers()->TracePacket(0, this, "RecvUSB notres2", notres2);
+           */
+
           if (partres == notres1 || partres == notres2)
             {
-              ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
-                                Logging::DUPLICATESMAX1PERMIN, this, Logging::MSGNOHASH,
-                  "%s KNX BUS reported not ready, operational but down", InterfaceModel());
-              FSM.PushEvent(fsm_event_bus_down_report);
+              INFOLOG(Thread::Loggers(), LOG_INFO, this,
+                  "%s KNX BUS & interface received operational status", InterfaceModel());
+              FSM.PushEvent(fsm_event_bus_up_report);
             }
           else
             {
-              CArray *np = new CArray(recvbuf, sizeof(recvbuf));
-              // status check was here
+              notres1[12] = 0x00;
+              notres2[12] = 0x00; // test for down ?
+              if (partres == notres1 || partres == notres2)
+                {
+                  ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
+                                    Logging::DUPLICATESMAX1PERMIN, this, Logging::MSGNOHASH,
+                      "%s KNX BUS reported not ready, operational but down", InterfaceModel());
+                  FSM.PushEvent(fsm_event_bus_down_report);
+                }
+              else
+                {
+                  CArray *np = new CArray(t.buf, sizeof(t.buf));
+                  // status check was here
 
-              Thread::Loggers()->TracePacket(3, this,
-                  "RecvUSB & Queuing for Consumption", *np);
+                  Thread::Loggers()->TracePacket(3, this,
+                      "RecvUSB & Queuing for Consumption", *np);
 
-              Put_On_Queue_Or_Drop<CArray *, CArray *>(outqueue, np,
-                  &out_signal, true, outdropmsg);
+                  Put_On_Queue_Or_Drop<CArray *, CArray *>(outqueue, np,
+                      &out_signal, true, outdropmsg);
+                }
             }
         }
-    }
-  if (recvh)
-    {
       TRACEPRINTF(Thread::Loggers(), 5, this,
-          "freeing receive transfer %p", (void *) recvh);
-      libusb_free_transfer(recvh);
+          "freeing receive transfer %p", (void *) t.h);
+      libusb_free_transfer(t.h);
+      t.h = 0;
     }
-  recvh = 0;
+  // every completion not handled yet follows a pending transfer, which
+  // will signal again
+  pth_sem_set_value(&recvc.signal, 0);
   loop->ReleaseContext(this);
 }
 
@@ -759,79 +835,71 @@ void USBLowLevelDriver::_fsm_completeReceiveAndRedo()
   _fsm_startReceive();
 }
 
-void USBLowLevelDriver::_fsm_startSend()
+bool USBLowLevelDriver::_fsm_sendRingReady()
+// new frames need a free slot and the pacer, and must not overtake a
+// failed one
 {
-  SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
+  if (sendstall)
+    return false;
+  return sendused < sendring && !inqueue.isempty() && pacer.Ready(inqueue.top()());
+}
 
-  libusb_context *context=loop->GrabContext(this);
-  if (!sendh && !inqueue.isempty())
+bool USBLowLevelDriver::_fsm_retrySend()
+// resends the oldest failed frame once all transfers returned, returns
+// true while failed frames are left; a frame overtaken by a later one
+// is dropped, sending it now would reorder the telegrams
+{
+  if (sendinflight)
+    return true;
+  for (int i = 0; i < sendused; i++)
     {
-      try
-        {
-          const CArray & c = inqueue.top();
-          Thread::Loggers()->TracePacket(4, this, "Run Send", c);
-          memset(sendbuf, 0, sizeof(sendbuf));
-          memcpy(sendbuf, c.array(),
-              (c() > sizeof(sendbuf) ? sizeof(sendbuf) : c()));
-          sendh = libusb_alloc_transfer(0);
-          sendc.waitingforcancellation = false;
-          if (!sendh)
-            {
-              ++stat_senderr;
-              errorstowardsreset++;
-              ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
-                  Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-                  "Error start send on USB %s", TransferStatus2String(sendh->status));
-
-              throw std::exception();
-            }
-          libusb_fill_interrupt_transfer(sendh, dev, d.sendep, sendbuf,
-              sizeof(sendbuf), usb_complete, &sendc, 1000);
-          if (libusb_submit_transfer(sendh))
-            {
-              ++stat_senderr;
-              if (sendh->status == LIBUSB_TRANSFER_NO_DEVICE)
-                {
-                  FSM.PushEvent(fsm_event_too_many_errors);
-                }
-              else
-                {
-                  errorstowardsreset++;
-                }
-
-              ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
-                  Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-                  "Error send on USB %s", TransferStatus2String(sendh->status));
-
-              TRACEPRINTF(Thread::Loggers(), 5, this,
-                  "freeing send transfer %p", (void *) sendh);
-              libusb_free_transfer(sendh);
-              sendh = 0;
-              throw std::exception();
-            }
-          TRACEPRINTF(Thread::Loggers(), 5, this,
-              "submitted send transfer %p", (void *) sendh);
-          pth_event(PTH_EVENT_SEM | PTH_MODE_REUSE | PTH_UNTIL_DECREMENT, sende,
-              &sendc.signal);
-        }
-      catch (std::exception &e)
+      usb_transfer_t & t = sends[(sendhead + i) % sendring];
+      if (t.h || t.done)
+        continue;
+      bool overtaken = false;
+      for (int j = i + 1; j < sendused && !overtaken; j++)
+        overtaken = sends[(sendhead + j) % sendring].done;
+      if (overtaken || t.retries >= USB_SENDRETRIES)
         {
-
+          ++stat_drops;
+          WARNLOGSHAPE(Thread::Loggers(), LOG_WARNING,
+              Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+              "Dropping send on USB after %d attempts%s", t.retries,
+              overtaken ? ", later frames already sent" : "");
+          t.done = true;
+          continue;
         }
+      // one at a time, the following failed frames must wait for it
+      while (!_fsm_submitSend(t))
+        if (t.retries >= USB_SENDRETRIES)
+          break;
+      if (t.h)
+        return true;
+      i--; // drop it
     }
-  loop->ReleaseContext(this);
+  _fsm_releaseSent();
+  return false;
 }
 
-void USBLowLevelDriver::_fsm_completeSend(void)
+void USBLowLevelDriver::_fsm_releaseSent()
+// releases the confirmed or dropped frames at the head of the ring
 {
-  SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
+  while (sendused && !sends[sendhead].h && sends[sendhead].done)
+    {
+      sendhead = (sendhead + 1) % sendring;
+      sendused--;
+    }
+  if (!sendused && inqueue.isempty())
+    pth_sem_set_value(&send_empty, 1);
+}
 
-  assert(sendh);
-  libusb_context *context = loop->GrabContext(this);
-  if (sendh->status != LIBUSB_TRANSFER_COMPLETED)
+bool USBLowLevelDriver::_fsm_submitSend(usb_transfer_t & t)
+{
+  int r = _fsm_submit(t, d.sendep, 1000);
+  if (r)
     {
       ++stat_senderr;
-      if (sendh->status == LIBUSB_TRANSFER_NO_DEVICE)
+      if (r == LIBUSB_ERROR_NO_DEVICE)
         {
           FSM.PushEvent(fsm_event_too_many_errors);
         }
@@ -839,27 +907,95 @@ void USBLowLevelDriver::_fsm_completeSend(void)
         {
           errorstowardsreset++;
         }
+
       ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
           Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
-          "Send error %s on USB", TransferStatus2String(sendh->status));
+          "Error send on USB %s", libusb_strerror((libusb_error) r));
+      t.retries++;
+      sendstall = true;
+      return false;
     }
-  else
+  sendc.waitingforcancellation = false;
+  sendinflight++;
+  sendstats.Submitted(sendinflight);
+  TRACEPRINTF(Thread::Loggers(), 5, this,
+      "submitted send transfer %p, %d in flight", (void *) t.h, sendinflight);
+  pth_event(PTH_EVENT_SEM | PTH_MODE_REUSE | PTH_UNTIL_DECREMENT, sende,
+      &sendc.signal);
+  return true;
+}
+
+void USBLowLevelDriver::_fsm_startSend()
+{
+  SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
+
+  libusb_context *context=loop->GrabContext(this);
+  if (sendstall)
+    sendstall = _fsm_retrySend();
+  while (_fsm_sendRingReady())
     {
-      TRACEPRINTF(Thread::Loggers(), 5, this,
-          "SendComplete %d", sendh->actual_length);
+      CArray c = inqueue.get();
       pth_sem_dec(&in_signal);
-      inqueue.get();
-      if (inqueue.isempty())
-        pth_sem_set_value(&send_empty, 1);
-      pktthissec++;
+      // the frame is on its way, account it now so the pacer spaces
+      // the following transfers
+      pacer.Sent(c());
+      Thread::Loggers()->TracePacket(4, this, "Run Send", c);
+      usb_transfer_t & t = sends[(sendhead + sendused) % sendring];
+      sendused++;
+      t.retries = 0;
+      memset(t.buf, 0, sizeof(t.buf));
+      memcpy(t.buf, c.array(),
+          (c() > sizeof(t.buf) ? sizeof(t.buf) : c()));
+      _fsm_submitSend(t);
     }
-  if (sendh)
+  loop->ReleaseContext(this);
+}
+
+void USBLowLevelDriver::_fsm_completeSend(void)
+{
+  SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
+
+  libusb_context *context = loop->GrabContext(this);
+  for (int i = 0; i < sendused; i++)
     {
+      usb_transfer_t & t = sends[(sendhead + i) % sendring];
+      if (!t.h || !t.done)
+        continue;
+      sendinflight--;
+      if (t.h->status != LIBUSB_TRANSFER_COMPLETED)
+        {
+          ++stat_senderr;
+          if (t.h->status == LIBUSB_TRANSFER_NO_DEVICE)
+            {
+              FSM.PushEvent(fsm_event_too_many_errors);
+            }
+          else
+            {
+              errorstowardsreset++;
+            }
+          ERRORLOGSHAPE(Thread::Loggers(), LOG_CRIT,
+              Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+              "Send error %s on USB", TransferStatus2String(t.h->status));
+          // keep the frame for another attempt
+          t.done = false;
+          t.retries++;
+          sendstall = true;
+        }
+      else
+        {
+          TRACEPRINTF(Thread::Loggers(), 5, this,
+              "SendComplete %d", t.h->actual_length);
+          sendstats.Completed(t);
+        }
       TRACEPRINTF(Thread::Loggers(), 5, this,
-          "freeing send transfer %p", (void *) sendh);
-      libusb_free_transfer(sendh);
+          "freeing send transfer %p", (void *) t.h);
+      libusb_free_transfer(t.h);
+      t.h = 0;
     }
-  sendh = 0;
+  pth_sem_set_value(&sendc.signal, 0);
+  _fsm_releaseSent();
+  if (sendstall && !sendinflight)
+    FSM.PushEvent(fsm_event_input_ready); // retry now
   loop->ReleaseContext(this);
 }
 
@@ -892,7 +1028,6 @@ void USBLowLevelDriver::_fsm_send_reset_and_restart_timer(void)
 {
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
 
-  pktthissec = 0;
   SendReset();
   pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, shorttic, pth_time(Time2RetransmitResets, 0));
 }
@@ -974,7 +1109,6 @@ void USBLowLevelDriver::_fsm_up_onesec_tic(void)
 
   pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, shorttic,
                pth_time(1, 0));
-  pktthissec = 0; // just clear number packets
   _fsm_startReceive();
   _fsm_startSend();
 }
@@ -987,18 +1121,27 @@ void USBLowLevelDriver::_fsm_bus_up_to_down(void)
   FSM.PushEvent(fsm_event_spontaneous);
 }
 
+void USBLowLevelDriver::_fsm_cancel(usb_transfer_t *t, int n, usb_complete_t & c)
+{
+  if (c.waitingforcancellation)
+    return;
+  for (int i = 0; i < n; i++)
+    if (t[i].h && !t[i].done)
+      {
+        libusb_cancel_transfer(t[i].h);
+        c.waitingforcancellation=true;
+      }
+}
+
 void USBLowLevelDriver::_fsm_stopReceive(void)
 {
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
 
   libusb_context *context = loop->GrabContext(this);
-  if (recvh)
+  if (recvinflight)
     {
       TRACEPRINTF(Thread::Loggers(), 4, this, "Stop USB Receive");
-      if (!recvc.waitingforcancellation) {
-        libusb_cancel_transfer(recvh);
-        recvc.waitingforcancellation=true;
-      }
+      _fsm_cancel(recvs, recvpool, recvc);
     }
   loop->ReleaseContext(this);
 }
@@ -1008,13 +1151,10 @@ void USBLowLevelDriver::_fsm_stopSend(void)
   SHOWTRANSITION_NAME( __PRETTY_FUNCTION__);
 
   libusb_context *context = loop->GrabContext(this);
-  if (sendh)
+  if (sendinflight)
     {
           TRACEPRINTF(Thread::Loggers(), 4, this, "Stop USB Send");
-          if (!sendc.waitingforcancellation) {
-            libusb_cancel_transfer(sendh);
-            sendc.waitingforcancellation=true;
-          }
+          _fsm_cancel(sends, sendring, sendc);
     }
   loop->ReleaseContext(this);
 }
@@ -1222,18 +1362,25 @@ USBLowLevelDriver::Run(pth_sem_t * stop1)
   stop = pth_event(PTH_EVENT_SEM, stop1);
   InitFSM();
 
-  sendh = 0;
-  recvh = 0;
   dev = NULL;
-  sendh = 0;
-  recvh = 0;
-  pktthissec = 0;
+  for (int i = 0; i < USB_MAXTRANSFERS; i++)
+    {
+      recvs[i].h = 0;
+      recvs[i].c = &recvc;
+      sends[i].h = 0;
+      sends[i].c = &sendc;
+    }
+  recvhead = recvinflight = 0;
+  sendhead = sendused = sendinflight = 0;
+  sendstall = false;
 
   sendc.tr = Thread::Loggers();
   recvc.tr = Thread::Loggers();
 
   pth_sem_init(&sendc.signal);
   pth_sem_init(&recvc.signal);
+  sendc.waitingforcancellation = false;
+  recvc.waitingforcancellation = false;
 
   sende = pth_event(PTH_EVENT_SEM, &sendc.signal);
   recve = pth_event(PTH_EVENT_SEM, &recvc.signal);
@@ -1247,6 +1394,7 @@ USBLowLevelDriver::Run(pth_sem_t * stop1)
 
   while (pth_event_status(stop) != PTH_STATUS_OCCURRED)
     {
+      pth_event_t paced = NULL;
 
       // only run when ALL are detached nicely
       while (FSM.EventsPending())
@@ -1254,18 +1402,27 @@ USBLowLevelDriver::Run(pth_sem_t * stop1)
           FSM.ConsumeEvent(); // one event
         }
 
-      if (recvh)
+      if (recvinflight)
         {
           pth_event_concat(stop, recve, NULL);
         }
-      if (sendh)
+      if (sendinflight)
         {
         pth_event_concat(stop, sende, NULL);
         }
+      if (sendused == sendring || sendstall)
+        {
+          // wait for the ring to make room
+        }
+      else if (inqueue.isempty() || pacer.Ready(inqueue.top()()))
+        {
+          pth_event_concat(stop, input, NULL);
+        }
       else
         {
-          if (!maxpktsoutpersec || pktthissec < maxpktsoutpersec)
-            pth_event_concat(stop, input, NULL);
+          // wake up when the pacer allows the next frame
+          paced = pacer.Wait(inqueue.top()());
+          pth_event_concat(stop, paced, NULL);
         }
 
       pth_event_concat(stop, shorttic, longtic, NULL);
@@ -1283,28 +1440,30 @@ USBLowLevelDriver::Run(pth_sem_t * stop1)
       pth_event_isolate(longtic);
       pth_event_isolate(input);
       pth_event_isolate(output);
+      if (paced)
+        pth_event_isolate(paced);
 
         {
           unsigned int v;
           pth_sem_get_value(&out_signal, &v);
 
           TRACEPRINTF(Thread::Loggers(), 4, this,
-              "state: %d pth_wait recve %d recvh: %p sende %d sendh: %p stop %d inqueue: %d "
-              "outqueue: %d outqueue-sem-count: %d onesec: %d tensec: %d input: %d output: %d pktsthissec: %d",
+              "state: %d pth_wait recve %d receiving: %d sende %d sending: %d stop %d inqueue: %d "
+              "outqueue: %d outqueue-sem-count: %d onesec: %d tensec: %d input: %d output: %d paced: %d",
               (int) FSM.GetCurrentState(),
-              (int) pth_event_status(recve), (void *) recvh, (int) pth_event_status(sende), (void *) sendh,
+              (int) pth_event_status(recve), recvinflight, (int) pth_event_status(sende), sendinflight,
               (int) pth_event_status(stop), (int) inqueue.len(), (int) outqueue.len(), (int) v,
               (int) pth_event_status(shorttic), (int) pth_event_status(longtic), (int) pth_event_status(input),
-              (int) pth_event_status(output), (int) pktthissec);
+              (int) pth_event_status(output), paced != NULL);
         }
 
       // first push all the receive/send things to make sure the buffers are served & freed
 
-      if (sendh && pth_event_status(sende) == PTH_STATUS_OCCURRED)
+      if (sendinflight && pth_event_status(sende) == PTH_STATUS_OCCURRED)
         {
           FSM.PushEvent(fsm_event_USB_transmitted);
         }
-      if (recvh && pth_event_status(recve) == PTH_STATUS_OCCURRED)
+      if (recvinflight && pth_event_status(recve) == PTH_STATUS_OCCURRED)
         {
           FSM.PushEvent(fsm_event_USB_received);
         }
@@ -1326,8 +1485,8 @@ USBLowLevelDriver::Run(pth_sem_t * stop1)
             {
               FSM.PushEvent(fsm_event_long_tic);
             }
-          if (pth_event_status(input) == PTH_STATUS_OCCURRED && !sendh
-              && !(maxpktsoutpersec && pktthissec > maxpktsoutpersec)) // not sending already, no events if overrun with packets ?
+          if (_fsm_sendRingReady()
+              && (pth_event_status(input) == PTH_STATUS_OCCURRED || paced)) // room in the send ring and the pacer allows it
             {
               FSM.PushEvent(fsm_event_input_ready);
             }
@@ -1416,5 +1575,8 @@ USBLowLevelDriver::_xml(Element *parent) const
   ErrCounters::_xml(p);
   inqueue._xml(p);
   outqueue._xml(p);
+  pacer._xml(p);
+  recvstats._xml(p, recvinflight);
+  sendstats._xml(p, sendinflight);
   return p;
 }
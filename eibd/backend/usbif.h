@@ -75,6 +75,64 @@ typedef struct
   Logs *tr;
 } usb_complete_t;
 
+/** receive transfers kept submitted, unless configured otherwise */
+#define USB_RECVPOOL 4
+/** send transfers in flight, unless configured otherwise */
+#define USB_SENDRING 2
+/** upper limit of the receive pool and the send ring */
+#define USB_MAXTRANSFERS 8
+/** failed sends of a frame before it is dropped */
+#define USB_SENDRETRIES 3
+
+/** one libusb transfer of the receive pool or the send ring */
+typedef struct
+{
+  struct libusb_transfer *h; // submitted, NULL if the slot is free
+  usb_complete_t *c; // direction signalled on completion
+  bool done; // completed, but not handled yet
+  timestamp_t submitted;
+  timestamp_t completed;
+  int retries; // failed sends of the frame
+  uchar buf[64];
+} usb_transfer_t;
+
+/** in flight transfers of one direction and their latency from submit to
+ * completion */
+class USBTransferStatistics
+{
+  const char *direction;
+  unsigned size;
+  unsigned maxinflight;
+  uint32_t transfers;
+  uint32_t dry;
+  timestamp_t maxlatency;
+  timestamp_t totallatency;
+
+public:
+  USBTransferStatistics (const char *direction);
+
+  /** sets the number of transfers, which may be in flight */
+  void Size (unsigned size)
+  {
+    this->size = size;
+  }
+  /** counts a submitted transfer, inflight includes it */
+  void Submitted (unsigned inflight)
+  {
+    if (inflight > maxinflight)
+      maxinflight = inflight;
+  }
+  /** counts a transfer handed back by libusb */
+  void Completed (const usb_transfer_t & t);
+  /** counts the receive pool running dry */
+  void Dry ()
+  {
+    dry++;
+  }
+
+  Element *_xml (Element * parent, unsigned inflight) const;
+};
+
 class USBLowLevelDriver:public LowLevelDriverInterface, protected Thread
 {
   typedef enum
@@ -210,19 +268,33 @@ private:
   USBEndpoint parseUSBEndpoint(const char *addr);
   void InitFSM();
 
+  int _fsm_submit(usb_transfer_t & t, int ep, unsigned int timeout);
+  bool _fsm_submitSend(usb_transfer_t & t);
+  void _fsm_cancel(usb_transfer_t *t, int n, usb_complete_t & c);
+  bool _fsm_sendRingReady();
+  bool _fsm_retrySend();
+  void _fsm_releaseSent();
+
   USBEndpoint e;
   pth_event_t stop ;
-  uchar recvbuf[64];
-  uchar sendbuf[64];
-  struct libusb_transfer *sendh;
-  struct libusb_transfer *recvh;
+  /** receive transfers, submitted in ring order starting at recvhead;
+   * libusb completes them in the same order on the interrupt endpoint */
+  usb_transfer_t recvs[USB_MAXTRANSFERS];
+  int recvpool, recvhead, recvinflight;
+  /** send transfers, each holding a frame taken from inqueue until it
+   * has been confirmed, oldest at sendhead */
+  usb_transfer_t sends[USB_MAXTRANSFERS];
+  int sendring, sendhead, sendused, sendinflight;
+  /** a send failed: no new frames until it has been sent again or
+   * dropped */
+  bool sendstall;
+  USBTransferStatistics recvstats, sendstats;
   usb_complete_t sendc, recvc;
   pth_event_t sende, recve;
   pth_event_t shorttic, longtic,input,output;
   libusb_device_handle *dev;
   USBDevice d;
   std::string DeviceDefinition;
-  int pktthissec;
 
   // 5.3.3.1 set EMI type to EMI type
   static uchar _init[64] ;
@@ -311,6 +311,7 @@ int _EIB_GetRequest (EIBConnection * con);
 #define AGARG_OUTINT16(name, args) int16_t *name KAG ## args
 #define AGARG_OUTUINT32(name, args) uint32_t *name KAG ## args
 #define AGARG_ADDR(name, args) eibaddr_t name KAG ## args
+#define AGARG_ADDRa(name, args) eibaddr_t name KAG ## args
 #define AGARG_OUTADDR(name, args) eibaddr_t *name KAG ## args
 #define AGARG_OUTADDRa(name, args) eibaddr_t *name KAG ## args
 #define AGARG_INBUF(name, args) int name##_len, const uint8_t *name KAG ## args
@@ -332,6 +333,7 @@ int _EIB_GetRequest (EIBConnection * con);
 #define ALARG_OUTINT16(name, args) name KAL ## args
 #define ALARG_OUTUINT32(name, args) name KAL ## args
 #define ALARG_ADDR(name, args) name KAL ## args
+#define ALARG_ADDRa(name, args) name KAL ## args
 #define ALARG_OUTADDR(name, args) name KAL ## args
 #define ALARG_OUTADDRa(name, args) name KAL ## args
 #define ALARG_INBUF(name, args) name##_len, name KAL ## args
@@ -0,0 +1,2 @@
+#include "c/eibclient-int.h"
+#include "def/setoverflowpolicy.inc"
@@ -0,0 +1,328 @@
+/*
+    EIBD client library
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    In addition to the permissions in the GNU General Public License, 
+    you may link the compiled version of this file into combinations
+    with other programs, and distribute those combinations without any 
+    restriction coming from the use of this file. (The General Public 
+    License restrictions do apply in other respects; for example, they 
+    cover modification of the file, and distribution when not linked into 
+    a combine executable.)
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include "eibclient-int.h"
+#include "eibshmring.h"
+
+/** attached shared memory ring */
+struct _EIBShmRing
+{
+  /** ring header, mapped read-only */
+  EIBShmRingHeader *hdr;
+  /** consumer page, the only writable mapping */
+  EIBShmRingConsumer *ctl;
+  /** size of the consumer page */
+  size_t ctlsize;
+  /** first slot */
+  EIBShmRingSlot *slot;
+  /** size of the mapping */
+  size_t mapsize;
+  /** slots - 1 */
+  uint32_t mask;
+  /** eventfd for wakeups */
+  int evfd;
+  /** consumer number */
+  int no;
+  /** sequence of the next frame to read */
+  uint32_t next;
+  /** frames lost by overrun */
+  uint32_t lost;
+};
+
+/** reads exactly len bytes */
+static int
+readall (int fd, uchar * buf, int len)
+{
+  int i, start = 0;
+  while (start < len)
+    {
+      i = read (fd, buf + start, len - start);
+      if (i == -1 && errno == EINTR)
+	continue;
+      if (i == -1)
+	return -1;
+      if (i == 0)
+	{
+	  errno = ECONNRESET;
+	  return -1;
+	}
+      start += i;
+    }
+  return 0;
+}
+
+EIBShmRing *
+EIBShmRingAttach (EIBConnection * con)
+{
+  uchar head[2];
+  uchar buf[4];
+  int fds[3] = { -1, -1, -1 };
+  unsigned size;
+  int i;
+  struct msghdr m;
+  struct iovec iov;
+  struct cmsghdr *cm;
+  union
+  {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE (3 * sizeof (int))];
+  } ctl;
+  EIBShmRing *r;
+  void *map;
+
+  if (!con || con->complete)
+    {
+      errno = EINVAL;
+      return 0;
+    }
+  EIBSETTYPE (buf, EIB_OPEN_SHM_RING);
+  if (_EIB_SendRequest (con, 2, buf) == -1)
+    return 0;
+
+  /* the descriptors come along with the length header */
+  iov.iov_base = head;
+  iov.iov_len = 2;
+  memset (&m, 0, sizeof (m));
+  m.msg_iov = &iov;
+  m.msg_iovlen = 1;
+  m.msg_control = ctl.buf;
+  m.msg_controllen = sizeof (ctl.buf);
+  do
+    i = recvmsg (con->fd, &m, MSG_WAITALL);
+  while (i == -1 && errno == EINTR);
+  if (i == -1)
+    return 0;
+  if (i != 2)
+    {
+      errno = ECONNRESET;
+      return 0;
+    }
+  for (cm = CMSG_FIRSTHDR (&m); cm; cm = CMSG_NXTHDR (&m, cm))
+    if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS
+	&& cm->cmsg_len >= CMSG_LEN (3 * sizeof (int)))
+      memcpy (fds, CMSG_DATA (cm), 3 * sizeof (int));
+
+  size = (head[0] << 8) | (head[1]);
+  if (size < 2 || size > sizeof (buf))
+    {
+      errno = ECONNRESET;
+      goto err;
+    }
+  if (readall (con->fd, buf, size) == -1)
+    goto err;
+  if (((buf[0] << 8) | buf[1]) == EIB_CONNECTION_INUSE)
+    {
+      errno = EBUSY;
+      goto err;
+    }
+  if (((buf[0] << 8) | buf[1]) != EIB_OPEN_SHM_RING || size < 4
+      || fds[0] == -1 || fds[1] == -1 || fds[2] == -1)
+    {
+      errno = ENOTSUP;
+      goto err;
+    }
+
+  map = mmap (NULL, sizeof (EIBShmRingHeader), PROT_READ, MAP_SHARED, fds[0], 0);
+  if (map == MAP_FAILED)
+    goto err;
+  if (((EIBShmRingHeader *) map)->magic != EIBSHMRING_MAGIC
+      || ((EIBShmRingHeader *) map)->version != EIBSHMRING_VERSION
+      || ((EIBShmRingHeader *) map)->slotsize != sizeof (EIBShmRingSlot))
+    {
+      munmap (map, sizeof (EIBShmRingHeader));
+      errno = ENOTSUP;
+      goto err;
+    }
+  size = ((EIBShmRingHeader *) map)->slots;
+  munmap (map, sizeof (EIBShmRingHeader));
+
+  r = (EIBShmRing *) malloc (sizeof (EIBShmRing));
+  if (!r)
+    {
+      errno = ENOMEM;
+      goto err;
+    }
+  r->mapsize = sizeof (EIBShmRingHeader) + size * sizeof (EIBShmRingSlot);
+  map = mmap (NULL, r->mapsize, PROT_READ, MAP_SHARED, fds[0], 0);
+  if (map == MAP_FAILED)
+    {
+      free (r);
+      goto err;
+    }
+  r->hdr = (EIBShmRingHeader *) map;
+  r->ctlsize = sysconf (_SC_PAGESIZE);
+  if (r->ctlsize < sizeof (EIBShmRingConsumer))
+    r->ctlsize = sizeof (EIBShmRingConsumer);
+  map = mmap (NULL, r->ctlsize, PROT_READ | PROT_WRITE, MAP_SHARED, fds[1], 0);
+  if (map == MAP_FAILED)
+    {
+      munmap (r->hdr, r->mapsize);
+      free (r);
+      goto err;
+    }
+  close (fds[0]);
+  close (fds[1]);
+  r->ctl = (EIBShmRingConsumer *) map;
+  r->slot = (EIBShmRingSlot *) (r->hdr + 1);
+  r->mask = size - 1;
+  r->evfd = fds[2];
+  r->no = buf[3];
+  r->lost = 0;
+  r->next = r->hdr->head;
+  return r;
+
+err:
+  i = errno;
+  if (fds[0] != -1)
+    close (fds[0]);
+  if (fds[1] != -1)
+    close (fds[1]);
+  if (fds[2] != -1)
+    close (fds[2]);
+  errno = i;
+  return 0;
+}
+
+int
+EIBShmRingRead (EIBShmRing * r, int max_len, uint8_t * buf, uint8_t * type,
+		uint64_t * timestamp)
+{
+  uint32_t head, lock, len;
+  EIBShmRingSlot *s;
+
+  if (!r || !buf || max_len < 0)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  for (;;)
+    {
+      head = r->hdr->head;
+      __sync_synchronize ();
+      if (head == r->next)
+	return 0;
+      if (head - r->next > r->mask + 1)
+	{
+	  r->lost += head - r->next - (r->mask + 1);
+	  r->next = head - (r->mask + 1);
+	}
+      s = &r->slot[r->next & r->mask];
+      lock = s->lock;
+      __sync_synchronize ();
+      if (!(lock & 1) && s->seq == r->next)
+	{
+	  len = s->len;
+	  if (len > (uint32_t) max_len)
+	    len = max_len;
+	  memcpy (buf, s->data, len);
+	  if (type)
+	    *type = s->type;
+	  if (timestamp)
+	    *timestamp = s->timestamp;
+	  __sync_synchronize ();
+	  if (s->lock == lock)
+	    {
+	      r->next++;
+	      return len;
+	    }
+	}
+      /* overwritten while reading */
+      r->lost++;
+      r->next++;
+    }
+}
+
+int
+EIBShmRingArm (EIBShmRing * r)
+{
+  uint64_t v;
+  if (!r)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  while (read (r->evfd, &v, sizeof (v)) == sizeof (v));
+  r->ctl->waiting = 1;
+  __sync_synchronize ();
+  return r->hdr->head != r->next;
+}
+
+int
+EIBShmRingWait (EIBShmRing * r, int timeout)
+{
+  struct pollfd p;
+  int i;
+
+  i = EIBShmRingArm (r);
+  if (i != 0)
+    return i;
+  p.fd = r->evfd;
+  p.events = POLLIN;
+  do
+    i = poll (&p, 1, timeout);
+  while (i == -1 && errno == EINTR);
+  if (i == -1)
+    return -1;
+  return r->hdr->head != r->next;
+}
+
+int
+EIBShmRingPollFD (EIBShmRing * r)
+{
+  if (!r)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  return r->evfd;
+}
+
+uint32_t
+EIBShmRingLost (EIBShmRing * r)
+{
+  return r ? r->lost : 0;
+}
+
+int
+EIBShmRingDetach (EIBShmRing * r)
+{
+  if (!r)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  munmap (r->hdr, r->mapsize);
+  munmap (r->ctl, r->ctlsize);
+  close (r->evfd);
+  free (r);
+  return 0;
+}
@@ -0,0 +1,67 @@
+/*
+    EIB Demo program - timestamped busmonitor
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "common.h"
+#include "eibtypes.h"
+
+int
+main (int ac, char *ag[])
+{
+  uchar buf[8192];
+  int len, pos, i;
+  unsigned flen;
+  unsigned long long ts, last = 0;
+  EIBConnection *con;
+  if (ac != 2 && ac != 3)
+    die ("usage: %s [-v] url", ag[0]);
+  con = EIBSocketURL (ag[ac - 1]);
+  if (!con)
+    die ("Open failed");
+
+  if ((ac == 3 ? EIBOpenVBusmonitorTS (con) : EIBOpenBusmonitorTS (con)) ==
+      -1)
+    die ("Open Busmonitor failed");
+
+  while (1)
+    {
+      len = EIBGetBusmonitorPacketTS (con, sizeof (buf), buf);
+      if (len == -1)
+	die ("Read failed");
+      for (pos = 0; pos + 11 <= len; pos += 11 + flen)
+	{
+	  ts = 0;
+	  for (i = 0; i < 8; i++)
+	    ts = (ts << 8) | buf[pos + i];
+	  flen = (buf[pos + 9] << 8) | buf[pos + 10];
+	  if (pos + 11 + flen > len)
+	    break;
+	  printf ("%llu.%06llu +%8lluus %c%c%c ", ts / 1000000, ts % 1000000,
+		  last ? ts - last : 0,
+		  buf[pos + 8] & EIB_BUSMONITOR_STATUS_FRAMEERROR ? 'F' : '-',
+		  buf[pos + 8] & EIB_BUSMONITOR_STATUS_BITERROR ? 'B' : '-',
+		  buf[pos + 8] & EIB_BUSMONITOR_STATUS_PARITYERROR ? 'P' : '-');
+	  printHex (flen, buf + pos + 11);
+	  printf ("\n");
+	  last = ts;
+	}
+      fflush (stdout);
+    }
+
+  EIBClose (con);
+  return 0;
+}
@@ -0,0 +1,91 @@
+/*
+    EIB Demo program - group cache read throughput under concurrent clients
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "common.h"
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+static long long
+now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/** one client: reads count group addresses starting at first until secs expired */
+static void
+client (const char *url, eibaddr_t first, int count, int secs, int id)
+{
+  uchar buf[255];
+  eibaddr_t src;
+  long reads = 0, hits = 0;
+  long long start, end, t;
+  int len;
+  EIBConnection *con = EIBSocketURL (url);
+  if (!con)
+    die ("Open failed");
+
+  start = now ();
+  end = start + (long long) secs * 1000000;
+  do
+    {
+      len = EIB_Cache_Read (con, first + reads % count, &src, sizeof (buf),
+			    buf);
+      if (len == -1 && errno != ENOENT)
+	die ("Read failed");
+      if (len != -1)
+	hits++;
+      reads++;
+    }
+  while ((reads & 63) || (t = now ()) < end);
+
+  printf ("client %2d %8ld reads %8ld hits %9.1f reads/s %7.2f us/read\n",
+	  id, reads, hits, reads * 1000000.0 / (t - start),
+	  (double) (t - start) / reads);
+  EIBClose (con);
+}
+
+int
+main (int ac, char *ag[])
+{
+  int i, clients, count, secs;
+  eibaddr_t first;
+
+  if (ac != 6)
+    die ("usage: %s url clients first-group count seconds", ag[0]);
+  clients = atoi (ag[2]);
+  first = readgaddr (ag[3]);
+  count = atoi (ag[4]);
+  secs = atoi (ag[5]);
+  if (clients < 1 || count < 1 || secs < 1)
+    die ("invalid parameter");
+
+  for (i = 0; i < clients; i++)
+    switch (fork ())
+      {
+      case -1:
+	die ("fork failed");
+      case 0:
+	client (ag[1], first, count, secs, i);
+	return 0;
+      }
+  while (wait (NULL) > 0);
+  return 0;
+}
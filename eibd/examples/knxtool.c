@@ -518,6 +518,97 @@ main (int ac, char *ag[])
 	}
       printf ("\n");
     }
+  else if (strcmp (ag[0], "groupcachereadage") == 0)
+    {
+      uint16_t maxage, age;
+      uint8_t flags = 0, state;
+
+      if (ac != 4 && ac != 5)
+	die ("usage: %s url eibaddr max-age [swr]", ag[0]);
+      dest = readgaddr (ag[2]);
+      maxage = atoi (ag[3]);
+      if (ac == 5)
+	{
+	  if (strcmp (ag[4], "swr"))
+	    die ("usage: %s url eibaddr max-age [swr]", ag[0]);
+	  flags = EIB_CACHE_STALE_WHILE_REVALIDATE;
+	}
+
+      len = EIB_Cache_Read_Age (con, dest, maxage, flags, &src, &state, &age,
+				sizeof (buf), buf);
+      if (len == -1)
+	die ("Read failed");
+
+      switch (buf[1] & 0xC0)
+	{
+	case 0x40:
+	  printf ("Response");
+	  break;
+	case 0x80:
+	  printf ("Write");
+	  break;
+	}
+      printf (" from ");
+      printIndividual (src);
+      printf (" (%ds old%s)", age,
+	      state == EIB_CACHE_VALUE_STALE ? ", stale" : "");
+      if (buf[1] & 0xC0)
+	{
+	  printf (": ");
+	  if (len == 2)
+	    printf ("%02X", buf[1] & 0x3F);
+	  else
+	    printHex (len - 2, buf + 2);
+	}
+      printf ("\n");
+    }
+  else if (strcmp (ag[0], "groupcachedump") == 0)
+    {
+      uchar *dump;
+      eibaddr_t first = 0, last = 0xffff;
+      uint16_t since = 0, end;
+      uint8_t more;
+      int pos;
+
+      if (ac != 2 && ac != 4 && ac != 5)
+	die ("usage: %s url [first-eibaddr last-eibaddr [since]]", ag[0]);
+      if (ac >= 4)
+	{
+	  first = readgaddr (ag[2]);
+	  last = readgaddr (ag[3]);
+	}
+      if (ac == 5)
+	since = atoi (ag[4]);
+      dump = (uchar *) malloc (EIB_CACHE_DUMP_MSGSIZE);
+      if (!dump)
+	die ("out of memory");
+
+      len = EIB_Cache_Dump (con, first, last, since,
+			    ac == 5 ? EIB_CACHE_DUMP_CHANGED : 0,
+			    EIB_CACHE_DUMP_MSGSIZE, dump, &end, &more);
+      while (1)
+	{
+	  if (len == -1)
+	    die ("Dump failed");
+	  for (pos = 0; pos + 6 <= len && pos + 6 + dump[pos + 5] <= len;
+	       pos += 6 + dump[pos + 5])
+	    {
+	      printGroup ((dump[pos] << 8) | dump[pos + 1]);
+	      printf (" from ");
+	      printIndividual ((dump[pos + 2] << 8) | dump[pos + 3]);
+	      printf ("%s: ",
+		      dump[pos + 4] == EIB_CACHE_VALUE_STALE ? " (stale)" : "");
+	      printHex (dump[pos + 5], dump + pos + 6);
+	      printf ("\n");
+	    }
+	  if (!more)
+	    break;
+	  len = EIB_Cache_Dump_Next (con, EIB_CACHE_DUMP_MSGSIZE, dump, &end,
+				     &more);
+	}
+      printf ("end %d\n", end);
+      free (dump);
+    }
   else if (strcmp (ag[0], "groupcacheremove") == 0)
     {
       if (ac != 3)
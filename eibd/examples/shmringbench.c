@@ -0,0 +1,193 @@
+/*
+    EIB Demo program - compare socket and shared memory ring frame delivery
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "common.h"
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+
+/** consumer CPU time in us */
+static long long
+cputime (void)
+{
+  struct rusage u;
+  getrusage (RUSAGE_SELF, &u);
+  return (long long) (u.ru_utime.tv_sec + u.ru_stime.tv_sec) * 1000000 +
+    u.ru_utime.tv_usec + u.ru_stime.tv_usec;
+}
+
+static long long
+now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return (long long) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void
+report (const char *name, long frames, long long cpu, long long wall)
+{
+  printf ("%-8s %8ld frames %8.1f frames/s %8.2f us CPU/frame\n", name,
+	  frames, frames * 1000000.0 / wall, frames ? (double) cpu / frames : 0.0);
+  fflush (stdout);
+}
+
+/** tell the parent we are attached, then wait for the common start */
+static void
+sync_start (int ready, int go)
+{
+  char c = 0;
+  if (write (ready, &c, 1) != 1)
+    die ("ready failed");
+  /* the parent sees EOF if the other consumer fails to attach */
+  close (ready);
+  if (read (go, &c, 1) != 1)
+    die ("start failed");
+}
+
+/** socket path: one read per frame through the busmonitor */
+static void
+socket_consumer (const char *url, int secs, int ready, int go)
+{
+  uchar buf[300];
+  int len;
+  long frames = 0;
+  long long start, cpu, left;
+  EIBConnection *con;
+  fd_set rd;
+  struct timeval tv;
+
+  con = EIBSocketURL (url);
+  if (!con)
+    die ("Open failed");
+  if (EIBOpenVBusmonitor (con) == -1)
+    die ("Open Busmonitor failed");
+  sync_start (ready, go);
+  start = now ();
+  cpu = cputime ();
+  while ((left = start + secs * 1000000LL - now ()) > 0)
+    {
+      /* wait with the remaining time, a quiet bus must not stall the run */
+      FD_ZERO (&rd);
+      FD_SET (EIB_Poll_FD (con), &rd);
+      tv.tv_sec = left / 1000000;
+      tv.tv_usec = left % 1000000;
+      len = select (EIB_Poll_FD (con) + 1, &rd, 0, 0, &tv);
+      if (len == -1)
+	die ("select failed");
+      if (len == 0)
+	continue;
+      len = EIB_Poll_Complete (con);
+      if (len == -1)
+	die ("Read failed");
+      if (len == 0)
+	continue;
+      len = EIBGetBusmonitorPacket (con, sizeof (buf), buf);
+      if (len == -1)
+	die ("Read failed");
+      frames++;
+    }
+  report ("socket", frames, cputime () - cpu, now () - start);
+  EIBClose (con);
+}
+
+/** shared memory ring: drain without system calls, sleep on the eventfd */
+static void
+ring_consumer (const char *url, int secs, int ready, int go)
+{
+  uchar buf[300];
+  int len;
+  long frames = 0;
+  long long start, cpu, left;
+  EIBConnection *con;
+  EIBShmRing *r;
+
+  con = EIBSocketURL (url);
+  if (!con)
+    die ("Open failed");
+  r = EIBShmRingAttach (con);
+  if (!r)
+    die ("Attach ring failed");
+  sync_start (ready, go);
+  start = now ();
+  cpu = cputime ();
+  while ((left = start + secs * 1000000LL - now ()) > 0)
+    {
+      len = EIBShmRingRead (r, sizeof (buf), buf, 0, 0);
+      if (len == -1)
+	die ("Read failed");
+      if (len > 0)
+	{
+	  frames++;
+	  continue;
+	}
+      if (EIBShmRingWait (r, left < 100000 ? left / 1000 + 1 : 100) == -1)
+	die ("Wait failed");
+    }
+  report ("ring", frames, cputime () - cpu, now () - start);
+  printf ("ring lost %u frames\n", EIBShmRingLost (r));
+  EIBShmRingDetach (r);
+  EIBClose (con);
+}
+
+int
+main (int ac, char *ag[])
+{
+  int secs, ready[2], go[2], i, status, failed = 0;
+  pid_t pid[2];
+  char c = 0;
+
+  if (ac != 3)
+    die ("usage: %s url seconds", ag[0]);
+  secs = atoi (ag[2]);
+  if (pipe (ready) == -1 || pipe (go) == -1)
+    die ("pipe failed");
+
+  /* both consumers see the same frames over the same interval, each in
+     its own process so its CPU time is accounted separately */
+  for (i = 0; i < 2; i++)
+    {
+      pid[i] = fork ();
+      if (pid[i] == -1)
+	die ("fork failed");
+      if (pid[i] == 0)
+	{
+	  close (ready[0]);
+	  close (go[1]);
+	  if (i == 0)
+	    socket_consumer (ag[1], secs, ready[1], go[0]);
+	  else
+	    ring_consumer (ag[1], secs, ready[1], go[0]);
+	  exit (0);
+	}
+    }
+  close (ready[1]);
+  close (go[0]);
+  for (i = 0; i < 2; i++)
+    if (read (ready[0], &c, 1) != 1)
+      die ("consumer failed to attach");
+  if (write (go[1], "gg", 2) != 2)
+    die ("start failed");
+  for (i = 0; i < 2; i++)
+    if (waitpid (pid[i], &status, 0) == -1 || !WIFEXITED (status)
+	|| WEXITSTATUS (status))
+      failed = 1;
+  return failed;
+}
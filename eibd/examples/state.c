@@ -30,6 +30,7 @@
 #include "common.h"
 #include <argp.h>
 #include <stdarg.h>
+#include <string.h>
 #include <zlib.h>
 
 /** option list */
@@ -40,6 +41,12 @@ static struct argp_option options[] = {
    "dump the EIBD backend states"},
   {"servers", 's', 0, 0, 
    "dump the EIBD server states"},
+  {"bus", 'u', 0, 0,
+   "dump the bus statistics"},
+  {"top", 'n', "N", 0,
+   "list the N busiest sources and group addresses with -u"},
+  {"window", 'w', "W", 0,
+   "rank them by 0 all frames, 1 last second, 2 last minute, 3 last 15 minutes"},
   {0}
 };
 
@@ -49,6 +56,8 @@ static char args_doc[] = "URL";
 struct arguments
 {
   int op;
+  int top;
+  int window;
 };
 
 /** parses and stores an option */
@@ -56,10 +65,14 @@ static error_t
 parse_opt (int key, char *arg, struct argp_state *state)
 {
  struct arguments *arguments = (struct arguments *) state->input;
- if (key=='t' || key=='b' || key=='s') 
+ if (key=='t' || key=='b' || key=='s' || key=='u') 
    {      
      arguments->op=key;
    }
+ else if (key=='n')
+   arguments->top=atoi(arg);
+ else if (key=='w')
+   arguments->window=atoi(arg);
  else
    return  ARGP_ERR_UNKNOWN;
  return 0;
@@ -82,6 +95,7 @@ main (int ac, char *ag[])
   int rc;
   int v;
 
+  memset (&arg, 0, sizeof (arg));
   argp_parse (&argp, ac, ag, 0, &index, &arg);
   if (index > ac - 1)
     die ("arguments and backend URL expected, exiting");
@@ -132,6 +146,17 @@ main (int ac, char *ag[])
 	die ("decompressing received buffer failed");
       }
     
+    break;
+  case 'u':
+    len =  EIB_State_BusStatistics(con, arg.top, arg.window, len, buf);
+    if (len == -1)
+      die ("receiving bus statistics failed");
+
+    rc =   uncompress(decbuf,&declen, buf, (unsigned long) len);
+    /** decompress buffer */
+    if (rc!=Z_OK)
+      die ("decompressing received buffer failed");
+
     break;
   default:
     die ("unknown operation"); 
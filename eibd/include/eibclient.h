@@ -40,6 +40,9 @@ typedef struct _EIBConnection EIBConnection;
 /** type for storing a EIB address */
 typedef uint16_t eibaddr_t;
 
+/** type represents an attached shared memory frame ring */
+typedef struct _EIBShmRing EIBShmRing;
+
 /** Opens a connection to eibd.
  *   url can either be <code>ip:host:[port]</code> or <code>local:/path/to/socket</code>
  * \param url contains the url to connect to
@@ -92,6 +95,57 @@ int EIB_Poll_Complete (EIBConnection * con);
  */
 int EIB_Poll_FD (EIBConnection * con);
 
+/** Attaches to the shared memory frame ring of eibd (eibd must run with --shared-ring).
+ * Only works over a local connection. All frames are read from the ring afterwards, the
+ * connection must be kept open as long as the ring is used; closing it releases the consumer.
+ * \param con eibd connection
+ * \return ring handle or NULL
+ */
+EIBShmRing *EIBShmRingAttach (EIBConnection * con);
+
+/** Reads the next frame from the shared memory ring (non-blocking, no system call).
+ * \param r ring handle
+ * \param max_len buffer size
+ * \param buf buffer for the frame
+ * \param type frame type (EIBSHMRING_FRAME_*), may be NULL
+ * \param timestamp receive time in us since the epoch, may be NULL
+ * \return -1 if error, 0 if no frame is available, else length of the frame
+ */
+int EIBShmRingRead (EIBShmRing * r, int max_len, uint8_t * buf, uint8_t * type,
+		    uint64_t * timestamp);
+
+/** Requests a wakeup on the ring poll FD for the next frame.
+ * Must be called before waiting on EIBShmRingPollFD.
+ * \param r ring handle
+ * \return -1 if error, 1 if frames are available already, 0 if armed
+ */
+int EIBShmRingArm (EIBShmRing * r);
+
+/** Waits for the next frame in the shared memory ring.
+ * \param r ring handle
+ * \param timeout timeout in ms, -1 for infinite
+ * \return -1 if error, 0 on timeout, 1 if frames are available
+ */
+int EIBShmRingWait (EIBShmRing * r, int timeout);
+
+/** Returns FD (eventfd) to wait for new frames in the ring, see EIBShmRingArm.
+ * \param r ring handle
+ * \return -1 if error, else file descriptor
+ */
+int EIBShmRingPollFD (EIBShmRing * r);
+
+/** Returns the number of frames lost, because the reader was overrun.
+ * \param r ring handle
+ * \return lost frames
+ */
+uint32_t EIBShmRingLost (EIBShmRing * r);
+
+/** Unmaps the shared memory ring and frees the handle.
+ * \param r ring handle
+ * \return 0 if successful, -1 if error
+ */
+int EIBShmRingDetach (EIBShmRing * r);
+
 /** Switches the connection to pristine state
  * \param con eibd connection
  * \return 0 if successful, -1 if error
@@ -104,6 +158,21 @@ int EIBReset (EIBConnection * con);
  */
 int EIBReset_async (EIBConnection * con);
 
+/** Selects what eibd does with frames for this connection, if it does not read them fast enough.
+ * Must be called before the connection is switched to a mode.
+ * \param con eibd connection
+ * \param policy EIB_OVERFLOW_DROP_NEWEST, EIB_OVERFLOW_DROP_OLDEST, EIB_OVERFLOW_COALESCE (keep the latest value per group address) or EIB_OVERFLOW_DISCONNECT
+ * \return 0 if successful, -1 if error
+ */
+int EIBSetOverflowPolicy (EIBConnection * con, uint8_t policy);
+
+/** Selects what eibd does with frames for this connection, if it does not read them fast enough - asynchronous.
+ * \param con eibd connection
+ * \param policy see EIBSetOverflowPolicy
+ * \return 0 if started, -1 if error
+ */
+int EIBSetOverflowPolicy_async (EIBConnection * con, uint8_t policy);
+
 /** Switches the connection to binary busmonitor mode.
  * \param con eibd connection
  * \return 0 if successful, -1 if error
@@ -160,6 +229,42 @@ int EIBOpenVBusmonitorText_async (EIBConnection * con);
  */
 int EIBGetBusmonitorPacket (EIBConnection * con, int maxlen, uint8_t * buf);
 
+/** Switches the connection to timestamped binary busmonitor mode.
+ * Frames are delivered with their receive time and bus status, see EIBGetBusmonitorPacketTS.
+ * \param con eibd connection
+ * \return 0 if successful, -1 if error
+ */
+int EIBOpenBusmonitorTS (EIBConnection * con);
+
+/** Switches the connection to timestamped binary busmonitor mode - asynchronous.
+ * \param con eibd connection
+ * \return 0 if started, -1 if error
+ */
+int EIBOpenBusmonitorTS_async (EIBConnection * con);
+
+/** Switches the connection to timestamped binary vbusmonitor mode.
+ * \param con eibd connection
+ * \return 0 if successful, -1 if error
+ */
+int EIBOpenVBusmonitorTS (EIBConnection * con);
+
+/** Switches the connection to timestamped binary vbusmonitor mode - asynchronous.
+ * \param con eibd connection
+ * \return 0 if started, -1 if error
+ */
+int EIBOpenVBusmonitorTS_async (EIBConnection * con);
+
+/** Receives a packet on a timestamped busmonitor connection.
+ * A packet contains one or more frames (more if the client lags behind), each encoded as
+ * 8 byte receive time in us since the epoch, 1 byte bus status (EIB_BUSMONITOR_STATUS_*),
+ * 2 byte frame length and the frame; all values big endian.
+ * \param con eibd connection
+ * \param maxlen size of the buffer
+ * \param buf buffer
+ * \return -1 if error, else length of the packet
+ */
+int EIBGetBusmonitorPacketTS (EIBConnection * con, int maxlen, uint8_t * buf);
+
 /** Opens a connection of type T_Connection.
  * \param con eibd connection
  * \param dest destination address
@@ -824,6 +929,51 @@ int EIB_Cache_LastUpdates (EIBConnection * con, uint16_t start,
 			   uint8_t timeout, int max_len, uint8_t * buf,
 			   uint16_t * end);
 
+/** Query the value of a group address, if it is not older than max_age
+ * \param con eibd connection
+ * \param dest group address
+ * \param max_age maximum age in seconds, 0 accepts any age
+ * \param flags EIB_CACHE_STALE_WHILE_REVALIDATE: return an older value at once and refresh it in the background;
+ *   else send a A_GroupValue_Read and wait for the answer
+ * \param src source address of the last APDU
+ * \param state EIB_CACHE_VALUE_FRESH or EIB_CACHE_VALUE_STALE (older than max_age or reloaded at startup)
+ * \param age age of the value in seconds
+ * \param max_len buffer size
+ * \param buf buffer for last APDU
+ * \return -1 if error (ENODEV=group cache not enabled, ENOENT=no value available), else length of APDU
+ */
+int EIB_Cache_Read_Age (EIBConnection * con, eibaddr_t dest, uint16_t max_age,
+			uint8_t flags, eibaddr_t * src, uint8_t * state,
+			uint16_t * age, int max_len, uint8_t * buf);
+
+/** Returns all cached values in a group address range in a few messages
+ * \param con eibd connection
+ * \param first first group address
+ * \param last last group address
+ * \param since with EIB_CACHE_DUMP_CHANGED, only values updated since this position (end of a previous dump or EIB_Cache_LastUpdates)
+ * \param flags 0 or EIB_CACHE_DUMP_CHANGED
+ * \param max_len buffer size, EIB_CACHE_DUMP_MSGSIZE is always sufficient
+ * \param buf buffer for the records: group address (2 bytes), source (2 bytes), EIB_CACHE_VALUE_FRESH/STALE (1 byte), APDU length (1 byte), APDU
+ * \param end position for the next request with EIB_CACHE_DUMP_CHANGED
+ * \param more non-zero, if further records follow; get them with EIB_Cache_Dump_Next
+ * \return -1 if error (ENODEV=group cache not enabled), else number of bytes read
+ */
+int EIB_Cache_Dump (EIBConnection * con, eibaddr_t first, eibaddr_t last,
+		    uint16_t since, uint8_t flags, int max_len, uint8_t * buf,
+		    uint16_t * end, uint8_t * more);
+
+/** Requests the next message of a group cache dump. Until more is 0, no
+ * other request may be sent; it would abandon the dump and be rejected.
+ * \param con eibd connection
+ * \param max_len buffer size
+ * \param buf buffer for the records (see EIB_Cache_Dump)
+ * \param end position for the next request with EIB_CACHE_DUMP_CHANGED
+ * \param more non-zero, if further records follow
+ * \return -1 if error, else number of bytes read
+ */
+int EIB_Cache_Dump_Next (EIBConnection * con, int max_len, uint8_t * buf,
+			 uint16_t * end, uint8_t * more);
+
 /** Enable Group Cache - asynchronous.
  * \param con eibd connection
  * \return 0 if started, -1 if error
@@ -887,6 +1037,51 @@ int EIB_Cache_LastUpdates_async (EIBConnection * con, uint16_t start,
 				 uint8_t timeout, int max_len, uint8_t * buf,
 				 uint16_t * end);
 
+/** Query the value of a group address, if it is not older than max_age - asynchronous.
+ * \param con eibd connection
+ * \param dest group address
+ * \param max_age maximum age in seconds, 0 accepts any age
+ * \param flags see EIB_Cache_Read_Age
+ * \param src source address of the last APDU
+ * \param state EIB_CACHE_VALUE_FRESH or EIB_CACHE_VALUE_STALE
+ * \param age age of the value in seconds
+ * \param max_len buffer size
+ * \param buf buffer for last APDU
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_Read_Age_async (EIBConnection * con, eibaddr_t dest,
+			      uint16_t max_age, uint8_t flags,
+			      eibaddr_t * src, uint8_t * state,
+			      uint16_t * age, int max_len, uint8_t * buf);
+
+/** Returns all cached values in a group address range in a few messages - asynchronous.
+ * \param con eibd connection
+ * \param first first group address
+ * \param last last group address
+ * \param since see EIB_Cache_Dump
+ * \param flags 0 or EIB_CACHE_DUMP_CHANGED
+ * \param max_len buffer size
+ * \param buf buffer for the records
+ * \param end position for the next request with EIB_CACHE_DUMP_CHANGED
+ * \param more non-zero, if further records follow
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_Dump_async (EIBConnection * con, eibaddr_t first,
+			  eibaddr_t last, uint16_t since, uint8_t flags,
+			  int max_len, uint8_t * buf, uint16_t * end,
+			  uint8_t * more);
+
+/** Requests the next message of a group cache dump - asynchronous.
+ * \param con eibd connection
+ * \param max_len buffer size
+ * \param buf buffer for the records
+ * \param end position for the next request with EIB_CACHE_DUMP_CHANGED
+ * \param more non-zero, if further records follow
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_Dump_Next_async (EIBConnection * con, int max_len,
+			       uint8_t * buf, uint16_t * end, uint8_t * more);
+
 
 /** Dump the status of the threads in EIBD.
  * \param con eibd connection
@@ -915,5 +1110,27 @@ int EIB_State_Backends (EIBConnection * con,
 int EIB_State_Servers (EIBConnection * con,
         int maxlen, uint8_t * buf);
 
+/** Dump the bus statistics of EIBD with the busiest sources and group addresses.
+ * \param con eibd connection
+ * \param topn number of sources and group addresses to list, 0 for none
+ * \param window rank by 0 all frames, 1 last second, 2 last minute, 3 last 15 minutes
+ * \param max_len buffer size
+ * \param buf buffer for state output, gzipped XML
+ * \return length of the output, -1 if error
+ */
+int EIB_State_BusStatistics (EIBConnection * con, uint8_t topn,
+        uint8_t window, int maxlen, uint8_t * buf);
+
+/** Dump the bus statistics of EIBD with the busiest sources and group addresses - asynchronous.
+ * \param con eibd connection
+ * \param topn number of sources and group addresses to list, 0 for none
+ * \param window rank by 0 all frames, 1 last second, 2 last minute, 3 last 15 minutes
+ * \param max_len buffer size
+ * \param buf buffer for state output, gzipped XML
+ * \return 0 if started, -1 if error
+ */
+int EIB_State_BusStatistics_async (EIBConnection * con, uint8_t topn,
+        uint8_t window, int maxlen, uint8_t * buf);
+
 __END_DECLS
 #endif
@@ -0,0 +1,94 @@
+/*
+    EIBD client library
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    In addition to the permissions in the GNU General Public License,
+    you may link the compiled version of this file into combinations
+    with other programs, and distribute those combinations without any
+    restriction coming from the use of this file. (The General Public
+    License restrictions do apply in other respects; for example, they
+    cover modification of the file, and distribution when not linked into
+    a combine executable.)
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef EIBSHMRING_H
+#define EIBSHMRING_H
+
+#include <stdint.h>
+
+/** layout of the shared memory frame ring
+ *
+ * The daemon is the only writer. Frame n is written into slot n % slots.
+ * The slot lock is odd while the slot is written (seqlock), so a reader can
+ * detect slots overwritten while it was copying them. head is the sequence
+ * of the next frame to be written. All sequences are 32 bit and wrap, so
+ * they have to be compared by difference.
+ *
+ * The ring is passed read-only to the consumers. Each consumer gets a
+ * separate writable page holding its EIBShmRingConsumer. A consumer which
+ * wants to sleep sets its waiting flag, re-checks head and waits on the
+ * eventfd it got when attaching. The daemon only writes the eventfd of
+ * consumers with the waiting flag set and clears the flag. */
+
+#define EIBSHMRING_MAGIC          0x45494252	/* "EIBR" */
+#define EIBSHMRING_VERSION        2
+#define EIBSHMRING_MAXCONSUMERS   16
+/** maximum frame size stored in a slot (extended frames included) */
+#define EIBSHMRING_SLOTDATA       264
+
+/** frame types stored in EIBShmRingSlot::type */
+#define EIBSHMRING_FRAME_LDATA      0	//< L_Data frame in TP1 format
+#define EIBSHMRING_FRAME_BUSMONITOR 1	//< raw busmonitor frame
+
+/** per consumer state, in a page of its own */
+typedef struct
+{
+  volatile uint32_t inuse;
+  volatile uint32_t waiting;
+  uint32_t pad[14];
+} EIBShmRingConsumer;
+
+/** ring header at the start of the shared memory */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  /** number of slots, power of two */
+  uint32_t slots;
+  /** size of a slot in bytes */
+  uint32_t slotsize;
+  uint32_t pad1[12];
+  /** sequence of the next frame written */
+  volatile uint32_t head;
+  uint32_t pad2[15];
+} EIBShmRingHeader;
+
+/** a frame slot, follows the header */
+typedef struct
+{
+  /** odd while the slot is written */
+  volatile uint32_t lock;
+  /** sequence of the frame in the slot */
+  volatile uint32_t seq;
+  /** receive time in us since the epoch */
+  uint64_t timestamp;
+  uint16_t len;
+  uint8_t type;
+  uint8_t pad[5];
+  uint8_t data[EIBSHMRING_SLOTDATA];
+} EIBShmRingSlot;
+
+#endif
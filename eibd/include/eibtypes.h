@@ -38,6 +38,25 @@
 #define EIB_OPEN_VBUSMONITOR            0x0012
 #define EIB_OPEN_VBUSMONITOR_TEXT       0x0013
 #define EIB_BUSMONITOR_PACKET           0x0014
+#define EIB_OPEN_SHM_RING               0x0015
+#define EIB_OPEN_BUSMONITOR_TS          0x0016
+#define EIB_OPEN_VBUSMONITOR_TS         0x0017
+#define EIB_BUSMONITOR_PACKET_TS        0x0018
+
+/** bus status of a busmonitor frame, as in the cEMI bus monitor status info */
+#define EIB_BUSMONITOR_STATUS_FRAMEERROR  0x80
+#define EIB_BUSMONITOR_STATUS_BITERROR    0x40
+#define EIB_BUSMONITOR_STATUS_PARITYERROR 0x20
+#define EIB_BUSMONITOR_STATUS_LOST        0x08
+#define EIB_BUSMONITOR_STATUS_SEQMASK     0x07
+
+#define EIB_SET_OVERFLOW_POLICY         0x0019
+
+/** what eibd does with frames for a client, which does not read fast enough */
+#define EIB_OVERFLOW_DROP_NEWEST          0x00
+#define EIB_OVERFLOW_DROP_OLDEST          0x01
+#define EIB_OVERFLOW_COALESCE             0x02
+#define EIB_OVERFLOW_DISCONNECT           0x03
 
 #define EIB_OPEN_T_CONNECTION           0x0020
 #define EIB_OPEN_T_INDIVIDUAL           0x0021
@@ -83,10 +102,24 @@
 #define EIB_CACHE_READ                  0x0074
 #define EIB_CACHE_READ_NOWAIT           0x0075
 #define EIB_CACHE_LAST_UPDATES          0x0076
+#define EIB_CACHE_READ_AGE              0x0077
+#define EIB_CACHE_DUMP                  0x0078
+#define EIB_CACHE_DUMP_NEXT             0x0079
+
+/** flags of EIB_CACHE_READ_AGE */
+#define EIB_CACHE_STALE_WHILE_REVALIDATE  0x01
+/** state of a value returned by EIB_CACHE_READ_AGE */
+#define EIB_CACHE_VALUE_FRESH             0x00
+#define EIB_CACHE_VALUE_STALE             0x01
+/** flags of EIB_CACHE_DUMP */
+#define EIB_CACHE_DUMP_CHANGED            0x01
+/** largest message of an EIB_CACHE_DUMP reply */
+#define EIB_CACHE_DUMP_MSGSIZE            0xffff
 
 #define EIB_STATE_REQ_THREADS           0x0101
 #define EIB_STATE_REQ_BACKENDS          0x0102
 #define EIB_STATE_REQ_SERVERS           0x0103
+#define EIB_STATE_REQ_BUSSTATS          0x0104
 
 /** XML constants delivered */
 
@@ -110,6 +143,8 @@
 #define XMLBACKENDELEMENTTYPEATTR    "type"     //< type of backend
 #define XMLBACKENDSTATUSATTR         "status"   //< status of backend (up, down, unknown)
 #define XMLBACKENDADDRESSATTR        "address" //< backend's to address, optional
+#define XMLBACKENDGROUPFILTERATTR    "group-filter" //< group addresses passed by the backend's filter or "all", optional
+#define XMLBACKENDFILTEREDATTR       "filtered" //< frames dropped by the backend's group filter, optional
 /// @}
 
 /// @{ driver group, contained in backend, can contain any of the optional XMLSTAT... elements
@@ -154,9 +189,154 @@
 #define XMLCLIENTSSENDERRATTR        "send-errors" //< how many errors sending, optional
 
 #define XMLCLIENTADDRESSATTR         "address" //< client's from address, optional
+#define XMLCLIENTOVERFLOWPOLICYATTR  "overflow-policy" //< what happens to frames if the client queue is full
+#define XMLCLIENTDROPPEDNEWESTATTR   "dropped-newest"  //< new frames dropped on a full queue, optional
+#define XMLCLIENTDROPPEDOLDESTATTR   "dropped-oldest"  //< queued frames dropped for new ones, optional
+#define XMLCLIENTCOALESCEDATTR       "coalesced"       //< queued frames replaced by a newer value for the same group, optional
+#define XMLCLIENTOVERFLOWDISCONNECTATTR "overflow-disconnects" //< client disconnected because of a full queue, optional
 
 #define XMLCLIENTSTATEADDR           "state" //< string definining state, optional
 
+/// @{ shared memory frame ring
+#define XMLSHMRINGELEMENT            "shared-ring" //< shared memory ring for local consumers
+#define XMLSHMRINGSLOTSATTR          "slots"       //< number of frame slots
+#define XMLSHMRINGFRAMESATTR         "frames"      //< frames published
+#define XMLSHMRINGCONSUMERSATTR      "consumers"   //< consumers currently attached
+#define XMLSHMRINGWAKEUPSATTR        "wakeups"     //< eventfd wakeups sent
+#define XMLSHMRINGTRUNCATEDATTR      "truncated"   //< frames too long for a slot, optional
+/// @}
+
+/// @{ group cache
+#define XMLGROUPCACHEELEMENT         "group-cache" //< cache of group values
+#define XMLGROUPCACHEENABLEDATTR     "enabled"     //< caching active (true/false)
+#define XMLGROUPCACHEENTRIESATTR     "entries"     //< group addresses with a cached value
+#define XMLGROUPCACHEUPDATESATTR     "updates"     //< values stored
+#define XMLGROUPCACHEHITSATTR        "hits"        //< reads answered from the cache
+#define XMLGROUPCACHEMISSESATTR      "misses"      //< reads not answered from the cache
+#define XMLGROUPCACHEBUSREADSATTR    "bus-reads"   //< reads sent to the bus for misses
+#define XMLGROUPCACHECOALESCEDATTR   "coalesced-reads" //< bus reads saved by joining a pending read
+#define XMLGROUPCACHESTALESERVEDATTR "stale-served" //< stale values returned while being revalidated
+#define XMLGROUPCACHESTALEATTR       "stale"       //< values reloaded from the snapshot, not yet confirmed by the bus
+#define XMLGROUPCACHESNAPSHOTATTR    "snapshot"    //< file the cache is persisted to
+#define XMLGROUPCACHESNAPSHOTLOADEDATTR  "snapshot-loaded"  //< values reloaded at startup
+#define XMLGROUPCACHESNAPSHOTCORRUPTATTR "snapshot-corrupt" //< records dropped because of a bad checksum
+#define XMLGROUPCACHEWARMUPELEMENT   "warmup"      //< background reads filling the cache
+#define XMLGROUPCACHEWARMUPTOTALATTR "addresses"   //< group addresses to read per pass
+#define XMLGROUPCACHEWARMUPDONEATTR  "done"        //< addresses processed in the current pass
+#define XMLGROUPCACHEWARMUPREMAININGATTR "remaining" //< addresses left in the current pass
+#define XMLGROUPCACHEWARMUPPASSESATTR "passes"     //< passes started
+#define XMLGROUPCACHEWARMUPRATEATTR  "rate"        //< maximum reads per second
+#define XMLGROUPCACHEWARMUPREADSATTR "reads"       //< A_GroupValue_Read sent
+#define XMLGROUPCACHEWARMUPSKIPPEDATTR "skipped"   //< addresses skipped, value fresh or read pending
+#define XMLGROUPCACHEWARMUPBACKOFFSATTR "backoffs" //< waits for a busy interface
+#define XMLGROUPCACHEWARMUPANSWEREDATTR "answered" //< addresses answered in the current pass
+#define XMLGROUPCACHEWARMUPRESPONSEATTR "response-rate" //< answered reads in percent
+/// @}
+
+/// @{ transmit pacer, contained in backend or driver
+#define XMLPACERELEMENT              "pacer"       //< token bucket limiting the send rate
+#define XMLPACERRATEATTR             "rate"        //< standard frames per second, 0 for unlimited
+#define XMLPACERBURSTATTR            "burst"       //< standard frames which may be sent back to back
+#define XMLPACERTOKENSATTR           "available"   //< bus time currently available, in percent of a standard frame
+#define XMLPACERFRAMESATTR           "frames"      //< frames sent
+#define XMLPACERBITSATTR             "bus-bits"    //< bus time used, in bit times
+#define XMLPACERDELAYEDATTR          "delayed"     //< frames held back to keep the rate
+#define XMLPACERMAXWAITATTR          "maximum-wait-us" //< longest time a frame was held back
+#define XMLPACERTOTALWAITATTR        "total-wait-us"   //< time all frames were held back
+/// @}
+
+/// @{ per origin send queues in front of the bus interface
+#define XMLSENDQUEUESELEMENT         "send-queues" //< deficit round robin over all origins
+#define XMLSENDQUEUESORIGINSATTR     "origins"     //< origins currently registered
+#define XMLSENDQUEUESPENDINGATTR     "pending"     //< frames queued over all origins
+#define XMLSENDQUEUESCOMPACTATTR     "compact-group-writes" //< a queued group write is replaced by a newer one, optional
+#define XMLSENDQUEUESUPERSEDEDATTR   "superseded"  //< queued group writes replaced by a newer value
+#define XMLSENDQUEUEELEMENT          "origin"      //< send queue of one client or EIBnet/IP connection
+#define XMLSENDQUEUENAMEATTR         "name"        //< kind and peer of the origin
+#define XMLSENDQUEUEWEIGHTATTR       "weight"      //< share of the bus relative to other origins
+#define XMLSENDQUEUEDEPTHATTR        "depth"       //< frames currently queued
+#define XMLSENDQUEUEMAXDEPTHATTR     "maximum-depth" //< most frames ever queued
+#define XMLSENDQUEUESENTATTR         "sent"        //< frames handed to the bus interface
+#define XMLSENDQUEUEDROPPEDATTR      "dropped"     //< frames dropped, queue full
+#define XMLSENDQUEUEMAXWAITATTR      "maximum-wait-us" //< longest time a frame was queued
+#define XMLSENDQUEUEMEANWAITATTR     "mean-wait-us"    //< average time a frame was queued
+/// @}
+
+/// @{ bus statistics
+#define XMLBUSSTATSELEMENT           "bus-statistics" //< frames seen on the bus since startup
+#define XMLBUSSTATSUPTIMEATTR        "seconds"     //< time the statistics cover
+#define XMLBUSSTATSFRAMESATTR        "frames"      //< frames seen
+#define XMLBUSSTATSBYTESATTR         "bytes"       //< length of the frames seen on TP1
+#define XMLBUSSTATSBITSATTR          "bus-bits"    //< bus time of the frames in bit times
+#define XMLBUSSTATSREPEATEDATTR      "repeated"    //< frames with the repeat flag set
+#define XMLBUSSTATSSOURCESATTR       "sources"     //< individual addresses seen sending
+#define XMLBUSSTATSGROUPSATTR        "groups"      //< group addresses seen
+#define XMLBUSSTATSTOPATTR           "top"         //< entries requested per top list
+#define XMLBUSSTATSRANKATTR          "ranked-by"   //< window the top lists are ranked by, 0 for all frames
+#define XMLBUSSTATSWINDOWELEMENT     "window"      //< frames of a sliding window
+#define XMLBUSSTATSSECONDSATTR       "seconds"     //< length of the window
+#define XMLBUSSTATSREPEATRATEATTR    "repeat-permille" //< repeated per thousand frames
+#define XMLBUSSTATSUTILISATIONATTR   "utilisation-permille" //< bus time used at 9600 bit/s
+#define XMLBUSSTATSTOPSOURCESELEMENT "top-sources" //< busiest individual addresses
+#define XMLBUSSTATSTOPGROUPSELEMENT  "top-groups"  //< busiest group addresses
+#define XMLBUSSTATSTALKERELEMENT     "talker"      //< one entry of a top list
+#define XMLBUSSTATSADDRATTR          "address"     //< individual or group address
+#define XMLBUSSTATSIDLEATTR          "idle-seconds" //< time since the last frame
+/// @}
+
+/// @{ TPUART link layer acknowledge
+#define XMLTPUARTACKELEMENT          "link-ack"    //< acknowledges sent by eibd for the TPUART
+#define XMLTPUARTACKINDIVIDUALATTR   "individual-addresses" //< individual addresses acknowledged
+#define XMLTPUARTACKGROUPATTR        "group-addresses"      //< group addresses acknowledged
+#define XMLTPUARTACKSATTR            "acks"        //< frames addressed to eibd
+#define XMLTPUARTNOACKSATTR          "not-addressed" //< frames for other devices
+#define XMLTPUARTACKLATEATTR         "late"        //< acknowledges sent late
+#define XMLTPUARTACKMAXATTR          "maximum-latency-us" //< longest time from receive to acknowledge
+#define XMLTPUARTACKTOTALATTR        "total-latency-us"   //< sum of all acknowledge latencies
+#define XMLTPUARTACKBUCKETELEMENT    "latency"     //< histogram bucket of acknowledge latencies
+#define XMLTPUARTACKBELOWATTR        "below-us"    //< upper bound of the bucket, missing for the last
+#define XMLTPUARTACKCOUNTATTR        "acks"        //< acknowledges in the bucket
+#define XMLTPUARTIOTHREADATTR        "io-thread"   //< pth, os or realtime (SCHED_FIFO) thread handling the bytes
+#define XMLTPUARTMEMLOCKATTR         "memory-locked" //< memory locked for the I/O thread
+#define XMLTPUARTDROPPEDATTR         "dropped"     //< received frames the I/O thread could not pass on
+/// @}
+
+/// @{ USB transfers
+#define XMLUSBTRANSFERSELEMENT       "usb-transfers" //< libusb transfers of one direction
+#define XMLUSBDIRECTIONATTR          "direction"   //< receive or send
+#define XMLUSBPOOLATTR               "pool-size"   //< transfers which may be in flight
+#define XMLUSBINFLIGHTATTR           "in-flight"   //< transfers submitted now
+#define XMLUSBMAXINFLIGHTATTR        "maximum-in-flight" //< most transfers submitted at once
+#define XMLUSBTRANSFERSATTR          "transfers"   //< transfers completed successfully
+#define XMLUSBMAXLATENCYATTR         "maximum-latency-us" //< longest time from submit to completion
+#define XMLUSBMEANLATENCYATTR        "mean-latency-us"    //< mean time from submit to completion
+#define XMLUSBDRYATTR                "ran-dry"     //< reports which left no receive transfer submitted
+/// @}
+
+/// @{ FT1.2 acknowledge
+#define XMLFT12ACKELEMENT            "ft12-ack"    //< acknowledges of frames sent to the FT1.2 interface
+#define XMLFT12ACKSATTR              "acks"        //< frames acknowledged
+#define XMLFT12RETRANSMITSATTR       "retransmits" //< frames repeated after the timeout
+#define XMLFT12FAILURESATTR          "failures"    //< frames given up, followed by a reset
+#define XMLFT12TIMEOUTATTR           "timeout-us"  //< current retransmit timeout
+#define XMLFT12MINRTTATTR            "minimum-rtt-us" //< shortest round trip to the acknowledge
+#define XMLFT12MAXRTTATTR            "maximum-rtt-us" //< longest round trip to the acknowledge
+#define XMLFT12MEANRTTATTR           "mean-rtt-us"    //< mean round trip to the acknowledge
+#define XMLFT12SMOOTHEDRTTATTR       "smoothed-rtt-us" //< round trip the timeout is derived from
+/// @}
+
+/// @{ reconnect, contained in backend
+#define XMLRECONNECTELEMENT          "reconnect"   //< reopening the backend after its link was lost
+#define XMLRECONNECTLOSSESATTR       "losses"      //< times the link was lost
+#define XMLRECONNECTRECOVERIESATTR   "recoveries"  //< times the link came up again
+#define XMLRECONNECTATTEMPTSATTR     "attempts"    //< open attempts since the link was lost, only while down
+#define XMLRECONNECTDOWNATTR         "down-ms"     //< time the link is down, only while down
+#define XMLRECONNECTLASTATTR         "last-recovery-ms"    //< time to recovery of the last loss
+#define XMLRECONNECTMINATTR          "minimum-recovery-ms" //< shortest time to recovery
+#define XMLRECONNECTMAXATTR          "maximum-recovery-ms" //< longest time to recovery
+#define XMLRECONNECTMEANATTR         "mean-recovery-ms"    //< mean time to recovery
+/// @}
+
 //@{{
 #define EIBD_LOG_EMERG    "emerg"
 #define EIBD_LOG_ALERT    "alert"
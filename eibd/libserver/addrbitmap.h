@@ -0,0 +1,80 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef ADDRBITMAP_H
+#define ADDRBITMAP_H
+
+#include <string.h>
+#include "common.h"
+
+/** set of 16 bit EIB addresses as a bitmap of 64K bits, a membership test
+ * is a single bit test */
+class AddressBitmap
+{
+  uint32_t bits[0x10000 / 32];
+  /** addresses in the set */
+  unsigned count;
+
+public:
+  AddressBitmap ()
+  {
+    clear ();
+  }
+
+  /** removes all addresses */
+  void clear ()
+  {
+    memset (bits, 0, sizeof (bits));
+    count = 0;
+  }
+
+  /** returns true, if addr is in the set */
+  bool test (eibaddr_t addr) const
+  {
+    return bits[addr >> 5] & (1U << (addr & 31));
+  }
+
+  /** adds addr, returns false if it was already in the set */
+  bool set (eibaddr_t addr)
+  {
+    if (test (addr))
+      return false;
+    bits[addr >> 5] |= 1U << (addr & 31);
+    count++;
+    return true;
+  }
+
+  /** removes addr, returns false if it was not in the set */
+  bool reset (eibaddr_t addr)
+  {
+    if (!test (addr))
+      return false;
+    bits[addr >> 5] &= ~(1U << (addr & 31));
+    count--;
+    return true;
+  }
+
+  /** number of addresses in the set */
+  unsigned operator () () const
+  {
+    return count;
+  }
+};
+
+#endif
@@ -21,10 +21,70 @@
 #include <string.h>
 #include "apdu.h"
 
-APDU *
-APDU::fromPacket (const CArray & c)
+String
+APDU::Decode ()
+{
+  char buf[DECODE_BUFSIZE];
+  return Decode (buf, sizeof (buf));
+}
+
+const char *
+APDU::Decode (char *buf, unsigned size)
+{
+  DecodeBuf b (buf, size);
+  DecodeTo (b);
+  return buf;
+}
+
+/** creates the APDU on the heap */
+class APDUCreator
+{
+  const CArray & c;
+public:
+  typedef APDU *Result;
+  APDUCreator (const CArray & c):c (c)
+  {
+  }
+  template < class T > APDU *make ()
+  {
+    APDU *a = new T ();
+    if (a->init (c))
+      return a;
+    delete a;
+    a = new A_Unknown_PDU;
+    a->init (c);
+    return a;
+  }
+};
+
+/** decodes the APDU with an object on the stack */
+class APDUDecoder
+{
+  const CArray & c;
+  DecodeBuf & s;
+public:
+  typedef void Result;
+  APDUDecoder (const CArray & c, DecodeBuf & s):c (c), s (s)
+  {
+  }
+  template < class T > void make ()
+  {
+    T a;
+    if (a.init (c))
+      {
+	a.DecodeTo (s);
+	return;
+      }
+    A_Unknown_PDU u;
+    u.init (c);
+    u.DecodeTo (s);
+  }
+};
+
+/** selects the APDU class for c and passes it to f.make */
+template < class F > static typename F::Result
+dispatchAPDU (const CArray & c, F & f)
 {
-  APDU *a = 0;
   if (c () >= 2)
     {
       switch (c[0] & 0x03)
@@ -33,69 +93,52 @@ APDU::fromPacket (const CArray & c)
 	  switch (c[1] & 0xC0)
 	    {
 	    case 0x00:
-	      a = new A_GroupValue_Read_PDU ();
-	      break;
+	      return f.template make < A_GroupValue_Read_PDU > ();
 	    case 0x40:
-	      a = new A_GroupValue_Response_PDU ();
-	      break;
+	      return f.template make < A_GroupValue_Response_PDU > ();
 	    case 0x80:
-	      a = new A_GroupValue_Write_PDU ();
-	      break;
+	      return f.template make < A_GroupValue_Write_PDU > ();
 	    case 0xC0:
-	      a = new A_IndividualAddress_Write_PDU ();
-	      break;
+	      return f.template make < A_IndividualAddress_Write_PDU > ();
 	    }
 	  break;
 	case 1:
 	  switch (c[1] & 0xC0)
 	    {
 	    case 0x00:
-	      a = new A_IndividualAddress_Read_PDU ();
-	      break;
+	      return f.template make < A_IndividualAddress_Read_PDU > ();
 	    case 0x40:
-	      a = new A_IndividualAddress_Response_PDU ();
-	      break;
+	      return f.template make < A_IndividualAddress_Response_PDU > ();
 	    case 0x80:
-	      a = new A_ADC_Read_PDU ();
-	      break;
+	      return f.template make < A_ADC_Read_PDU > ();
 	    case 0xC0:
-	      a = new A_ADC_Response_PDU ();
-	      break;
+	      return f.template make < A_ADC_Response_PDU > ();
 	    }
 	  break;
 	case 2:
 	  switch (c[1] & 0xC0)
 	    {
 	    case 0x00:
-	      a = new A_Memory_Read_PDU ();
-	      break;
+	      return f.template make < A_Memory_Read_PDU > ();
 	    case 0x40:
-	      a = new A_Memory_Response_PDU ();
-	      break;
+	      return f.template make < A_Memory_Response_PDU > ();
 	    case 0x80:
-	      a = new A_Memory_Write_PDU ();
-	      break;
+	      return f.template make < A_Memory_Write_PDU > ();
 	    case 0xC0:
 	      switch (c[1])
 		{
 		case 0xC0:
-		  a = new A_UserMemory_Read_PDU ();
-		  break;
+		  return f.template make < A_UserMemory_Read_PDU > ();
 		case 0xC1:
-		  a = new A_UserMemory_Response_PDU ();
-		  break;
+		  return f.template make < A_UserMemory_Response_PDU > ();
 		case 0xC2:
-		  a = new A_UserMemory_Write_PDU ();
-		  break;
+		  return f.template make < A_UserMemory_Write_PDU > ();
 		case 0xC4:
-		  a = new A_UserMemoryBit_Write_PDU ();
-		  break;
+		  return f.template make < A_UserMemoryBit_Write_PDU > ();
 		case 0xC5:
-		  a = new A_UserManufacturerInfo_Read_PDU ();
-		  break;
+		  return f.template make < A_UserManufacturerInfo_Read_PDU > ();
 		case 0xC6:
-		  a = new A_UserManufacturerInfo_Response_PDU ();
-		  break;
+		  return f.template make < A_UserManufacturerInfo_Response_PDU > ();
 		}
 	    }
 	  break;
@@ -103,83 +146,70 @@ APDU::fromPacket (const CArray & c)
 	  switch (c[1] & 0xC0)
 	    {
 	    case 0x00:
-	      a = new A_DeviceDescriptor_Read_PDU ();
-	      break;
+	      return f.template make < A_DeviceDescriptor_Read_PDU > ();
 	    case 0x40:
-	      a = new A_DeviceDescriptor_Response_PDU ();
-	      break;
+	      return f.template make < A_DeviceDescriptor_Response_PDU > ();
 	    case 0x80:
-	      a = new A_Restart_PDU ();
-	      break;
+	      return f.template make < A_Restart_PDU > ();
 	    case 0xC0:
 	      switch (c[1])
 		{
 		case 0xD0:
-		  a = new A_MemoryBit_Write_PDU ();
-		  break;
+		  return f.template make < A_MemoryBit_Write_PDU > ();
 		case 0xD1:
-		  a = new A_Authorize_Request_PDU ();
-		  break;
+		  return f.template make < A_Authorize_Request_PDU > ();
 		case 0xD2:
-		  a = new A_Authorize_Response_PDU ();
-		  break;
+		  return f.template make < A_Authorize_Response_PDU > ();
 		case 0xD3:
-		  a = new A_Key_Write_PDU ();
-		  break;
+		  return f.template make < A_Key_Write_PDU > ();
 		case 0xD4:
-		  a = new A_Key_Response_PDU ();
-		  break;
+		  return f.template make < A_Key_Response_PDU > ();
 		case 0xD5:
-		  a = new A_PropertyValue_Read_PDU ();
-		  break;
+		  return f.template make < A_PropertyValue_Read_PDU > ();
 		case 0xD6:
-		  a = new A_PropertyValue_Response_PDU ();
-		  break;
+		  return f.template make < A_PropertyValue_Response_PDU > ();
 		case 0xD7:
-		  a = new A_PropertyValue_Write_PDU ();
-		  break;
+		  return f.template make < A_PropertyValue_Write_PDU > ();
 		case 0xD8:
-		  a = new A_PropertyDescription_Read_PDU ();
-		  break;
+		  return f.template make < A_PropertyDescription_Read_PDU > ();
 		case 0xD9:
-		  a = new A_PropertyDescription_Response_PDU ();
-		  break;
+		  return f.template make < A_PropertyDescription_Response_PDU > ();
 		case 0xDC:
-		  a = new A_IndividualAddressSerialNumber_Read_PDU ();
-		  break;
+		  return f.template make < A_IndividualAddressSerialNumber_Read_PDU > ();
 		case 0xDD:
-		  a = new A_IndividualAddressSerialNumber_Response_PDU ();
-		  break;
+		  return f.template make < A_IndividualAddressSerialNumber_Response_PDU > ();
 		case 0xDE:
-		  a = new A_IndividualAddressSerialNumber_Write_PDU ();
-		  break;
+		  return f.template make < A_IndividualAddressSerialNumber_Write_PDU > ();
 		case 0xDF:
-		  a = new A_ServiceInformation_Indication_Write_PDU ();
-		  break;
+		  return f.template make < A_ServiceInformation_Indication_Write_PDU > ();
 		case 0xE0:
-		  a = new A_DomainAddress_Write_PDU ();
-		  break;
+		  return f.template make < A_DomainAddress_Write_PDU > ();
 		case 0xE1:
-		  a = new A_DomainAddress_Read_PDU ();
-		  break;
+		  return f.template make < A_DomainAddress_Read_PDU > ();
 		case 0xE2:
-		  a = new A_DomainAddress_Response_PDU ();
-		  break;
+		  return f.template make < A_DomainAddress_Response_PDU > ();
 		case 0xE3:
-		  a = new A_DomainAddressSelective_Read_PDU ();
-		  break;
+		  return f.template make < A_DomainAddressSelective_Read_PDU > ();
 		}
 	    }
 	  break;
 	}
     }
-  if (a && a->init (c))
-    return a;
-  if (a)
-    delete a;
-  a = new A_Unknown_PDU;
-  a->init (c);
-  return a;
+  return f.template make < A_Unknown_PDU > ();
+}
+
+APDU *
+APDU::fromPacket (const CArray & c)
+{
+  APDUCreator f (c);
+  return dispatchAPDU (c, f);
+}
+
+void
+APDU::DecodePacket (const CArray & c, DecodeBuf & s)
+{
+  APDUDecoder f (c, s);
+  dispatchAPDU (c, f);
 }
 
 /* A_Unknown_PDU */
@@ -200,21 +230,22 @@ CArray A_Unknown_PDU::ToPacket ()
   return pdu;
 }
 
-String A_Unknown_PDU::Decode ()
+void
+A_Unknown_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("Unknown APDU: ");
   unsigned
     i;
 
   if (pdu () == 0)
-    return "empty APDU";
-  addHex (s, pdu[0] & 0x03);
+    {
+      s.add ("empty APDU");
+      return;
+    }
+  s.add ("Unknown APDU: ");
+  s.addHex (pdu[0] & 0x03);
 
   for (i = 1; i < pdu (); i++)
-    addHex (s, pdu[i]);
-
-  return s;
+    s.addHex (pdu[i]);
 }
 
 bool A_Unknown_PDU::isResponse (const APDU * req) CONST
@@ -245,9 +276,10 @@ CArray A_GroupValue_Read_PDU::ToPacket ()
   return CArray (c, 2);
 }
 
-String A_GroupValue_Read_PDU::Decode ()
+void
+A_GroupValue_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "A_GroupValue_Read";
+  s.add ("A_GroupValue_Read");
 }
 
 bool A_GroupValue_Read_PDU::isResponse (const APDU * req) CONST
@@ -300,20 +332,18 @@ CArray A_GroupValue_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String A_GroupValue_Response_PDU::Decode ()
+void
+A_GroupValue_Response_PDU::DecodeTo (DecodeBuf & s)
 {
   unsigned
     i;
   assert (!issmall || (data () == 1 && (data[0] & 0xC0) == 0));
-  String
-  s ("A_GroupValue_Response ");
+  s.add ("A_GroupValue_Response ");
   if (issmall)
-    s += "(small) ";
+    s.add ("(small) ");
 
   for (i = 0; i < data (); i++)
-    addHex (s, data[i]);
-
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_GroupValue_Response_PDU::isResponse (const APDU * req) CONST
@@ -366,20 +396,18 @@ CArray A_GroupValue_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String A_GroupValue_Write_PDU::Decode ()
+void
+A_GroupValue_Write_PDU::DecodeTo (DecodeBuf & s)
 {
   unsigned
     i;
   assert (!issmall || (data () == 1 && (data[0] & 0xC0) == 0));
-  String
-  s ("A_GroupValue_Write ");
+  s.add ("A_GroupValue_Write ");
   if (issmall)
-    s += "(small) ";
+    s.add ("(small) ");
 
   for (i = 0; i < data (); i++)
-    addHex (s, data[i]);
-
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_GroupValue_Write_PDU::isResponse (const APDU * req) CONST
@@ -415,11 +443,11 @@ CArray A_IndividualAddress_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String A_IndividualAddress_Write_PDU::Decode ()
+void
+A_IndividualAddress_Write_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("A_IndividualAddress_Write ");
-  return s + FormatEIBAddr (addr);
+  s.add ("A_IndividualAddress_Write ");
+  s.addEIBAddr (addr);
 }
 
 bool A_IndividualAddress_Write_PDU::isResponse (const APDU * req) CONST
@@ -450,9 +478,10 @@ CArray A_IndividualAddress_Read_PDU::ToPacket ()
   return CArray (c, 2);
 }
 
-String A_IndividualAddress_Read_PDU::Decode ()
+void
+A_IndividualAddress_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "A_IndividualAddress_Read";
+  s.add ("A_IndividualAddress_Read");
 }
 
 bool A_IndividualAddress_Read_PDU::isResponse (const APDU * req) CONST
@@ -482,9 +511,10 @@ CArray A_IndividualAddress_Response_PDU::ToPacket ()
   return CArray (c, 2);
 }
 
-String A_IndividualAddress_Response_PDU::Decode ()
+void
+A_IndividualAddress_Response_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "A_IndividualAddress_Response";
+  s.add ("A_IndividualAddress_Response");
 }
 
 bool A_IndividualAddress_Response_PDU::isResponse (const APDU * req) CONST
@@ -520,17 +550,16 @@ CArray A_IndividualAddressSerialNumber_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String A_IndividualAddressSerialNumber_Read_PDU::Decode ()
+void
+A_IndividualAddressSerialNumber_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("A_IndividualAddressSerialNumber_Read ");
-  addHex (s, serno[0]);
-  addHex (s, serno[1]);
-  addHex (s, serno[2]);
-  addHex (s, serno[3]);
-  addHex (s, serno[4]);
-  addHex (s, serno[5]);
-  return s;
+  s.add ("A_IndividualAddressSerialNumber_Read ");
+  s.addHex (serno[0]);
+  s.addHex (serno[1]);
+  s.addHex (serno[2]);
+  s.addHex (serno[3]);
+  s.addHex (serno[4]);
+  s.addHex (serno[5]);
 }
 
 bool
@@ -574,19 +603,18 @@ CArray A_IndividualAddressSerialNumber_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String A_IndividualAddressSerialNumber_Response_PDU::Decode ()
+void
+A_IndividualAddressSerialNumber_Response_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("A_IndividualAddressSerialNumber_Response ");
-  addHex (s, serno[0]);
-  addHex (s, serno[1]);
-  addHex (s, serno[2]);
-  addHex (s, serno[3]);
-  addHex (s, serno[4]);
-  addHex (s, serno[5]);
-  s += "Addr: ";
-  add16Hex (s, addr);
-  return s;
+  s.add ("A_IndividualAddressSerialNumber_Response ");
+  s.addHex (serno[0]);
+  s.addHex (serno[1]);
+  s.addHex (serno[2]);
+  s.addHex (serno[3]);
+  s.addHex (serno[4]);
+  s.addHex (serno[5]);
+  s.add ("Addr: ");
+  s.add16Hex (addr);
 }
 
 bool
@@ -637,19 +665,18 @@ CArray A_IndividualAddressSerialNumber_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String A_IndividualAddressSerialNumber_Write_PDU::Decode ()
+void
+A_IndividualAddressSerialNumber_Write_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("A_IndividualAddressSerialNumber_Write ");
-  addHex (s, serno[0]);
-  addHex (s, serno[1]);
-  addHex (s, serno[2]);
-  addHex (s, serno[3]);
-  addHex (s, serno[4]);
-  addHex (s, serno[5]);
-  s += "Addr: ";
-  s += FormatEIBAddr (addr);
-  return s;
+  s.add ("A_IndividualAddressSerialNumber_Write ");
+  s.addHex (serno[0]);
+  s.addHex (serno[1]);
+  s.addHex (serno[2]);
+  s.addHex (serno[3]);
+  s.addHex (serno[4]);
+  s.addHex (serno[5]);
+  s.add ("Addr: ");
+  s.addEIBAddr (addr);
 }
 
 bool
@@ -695,18 +722,16 @@ A_ServiceInformation_Indication_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_ServiceInformation_Indication_Write_PDU::Decode ()
+void
+A_ServiceInformation_Indication_Write_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_ServiceInformation_Indication_Write ");
+  s.add ("A_ServiceInformation_Indication_Write ");
   if (verify_mode)
-    s += "verify ";
+    s.add ("verify ");
   if (duplicate_address)
-    s += "dupplicate_address ";
+    s.add ("dupplicate_address ");
   if (appl_stopped)
-    s += "appl_stopped ";
-
-  return s;
+    s.add ("appl_stopped ");
 }
 
 bool
@@ -744,11 +769,11 @@ CArray A_DomainAddress_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String A_DomainAddress_Write_PDU::Decode ()
+void
+A_DomainAddress_Write_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("A_DomainAddress_Write ");
-  return s + FormatDomainAddr (addr);
+  s.add ("A_DomainAddress_Write ");
+  s.addDomainAddr (addr);
 }
 
 
@@ -780,9 +805,10 @@ CArray A_DomainAddress_Read_PDU::ToPacket ()
   return CArray (c, 2);
 }
 
-String A_DomainAddress_Read_PDU::Decode ()
+void
+A_DomainAddress_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "A_DomainAddress_Read";
+  s.add ("A_DomainAddress_Read");
 }
 
 bool A_DomainAddress_Read_PDU::isResponse (const APDU * req) CONST
@@ -818,12 +844,11 @@ CArray A_DomainAddress_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String A_DomainAddress_Response_PDU::Decode ()
+void
+A_DomainAddress_Response_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("A_DomainAddress_Response");
-  s += FormatDomainAddr (addr);
-  return s;
+  s.add ("A_DomainAddress_Response");
+  s.addDomainAddr (addr);
 }
 
 bool A_DomainAddress_Response_PDU::isResponse (const APDU * req) CONST
@@ -866,16 +891,15 @@ CArray A_DomainAddressSelective_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_DomainAddressSelective_Read_PDU::Decode ()
+void
+A_DomainAddressSelective_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_DomainAddressSelective_Read ");
-  s += FormatDomainAddr (domainaddr);
-  s += " ";
-  s += FormatEIBAddr (addr);
-  s += " ";
-  addHex (s, range);
-  return s;
+  s.add ("A_DomainAddressSelective_Read ");
+  s.addDomainAddr (domainaddr);
+  s.add (" ");
+  s.addEIBAddr (addr);
+  s.add (" ");
+  s.addHex (range);
 }
 
 bool A_DomainAddressSelective_Read_PDU::isResponse (const APDU * req) CONST
@@ -921,20 +945,19 @@ A_PropertyValue_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_PropertyValue_Read_PDU::Decode ()
+void
+A_PropertyValue_Read_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert ((start & 0xf000) == 0);
-  String s ("A_PropertyValue_Read Obj:");
-  addHex (s, obj);
-  s += " Prop: ";
-  addHex (s, prop);
-  s += " start: ";
-  addHex (s, start);
-  s += " max_nr: ";
-  addHex (s, count);
-  return s;
+  s.add ("A_PropertyValue_Read Obj:");
+  s.addHex (obj);
+  s.add (" Prop: ");
+  s.addHex (prop);
+  s.add (" start: ");
+  s.addHex (start);
+  s.add (" max_nr: ");
+  s.addHex (count);
 }
 
 bool A_PropertyValue_Read_PDU::isResponse (const APDU * req) CONST
@@ -982,23 +1005,22 @@ A_PropertyValue_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_PropertyValue_Response_PDU::Decode ()
+void
+A_PropertyValue_Response_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert ((start & 0xf000) == 0);
-  String s ("A_PropertyValue_Response Obj:");
-  addHex (s, obj);
-  s += " Prop: ";
-  addHex (s, prop);
-  s += " start: ";
-  addHex (s, start);
-  s += " max_nr: ";
-  addHex (s, count);
-  s += "data: ";
+  s.add ("A_PropertyValue_Response Obj:");
+  s.addHex (obj);
+  s.add (" Prop: ");
+  s.addHex (prop);
+  s.add (" start: ");
+  s.addHex (start);
+  s.add (" max_nr: ");
+  s.addHex (count);
+  s.add ("data: ");
   for (unsigned i = 0; i < data (); i++)
-    addHex (s, data[i]);
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_PropertyValue_Response_PDU::isResponse (const APDU * req) CONST
@@ -1067,23 +1089,22 @@ A_PropertyValue_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_PropertyValue_Write_PDU::Decode ()
+void
+A_PropertyValue_Write_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert ((start & 0xf000) == 0);
-  String s ("A_PropertyValue_Write Obj:");
-  addHex (s, obj);
-  s += " Prop: ";
-  addHex (s, prop);
-  s += " start: ";
-  addHex (s, start);
-  s += " max_nr: ";
-  addHex (s, count);
-  s += "data: ";
+  s.add ("A_PropertyValue_Write Obj:");
+  s.addHex (obj);
+  s.add (" Prop: ");
+  s.addHex (prop);
+  s.add (" start: ");
+  s.addHex (start);
+  s.add (" max_nr: ");
+  s.addHex (count);
+  s.add ("data: ");
   for (unsigned i = 0; i < data (); i++)
-    addHex (s, data[i]);
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_PropertyValue_Write_PDU::isResponse (const APDU * req) CONST
@@ -1124,16 +1145,15 @@ A_PropertyDescription_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_PropertyDescription_Read_PDU::Decode ()
+void
+A_PropertyDescription_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_PropertyDescription_Read Obj: ");
-  addHex (s, obj);
-  s += " Property: ";
-  addHex (s, prop);
-  s += " Property_index: ";
-  addHex (s, property_index);
-  return s;
+  s.add ("A_PropertyDescription_Read Obj: ");
+  s.addHex (obj);
+  s.add (" Property: ");
+  s.addHex (prop);
+  s.add (" Property_index: ");
+  s.addHex (property_index);
 }
 
 bool A_PropertyDescription_Read_PDU::isResponse (const APDU * req) CONST
@@ -1184,22 +1204,21 @@ A_PropertyDescription_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_PropertyDescription_Response_PDU::Decode ()
-{
-  String s ("A_PropertyDescription_Response Obj:");
-  addHex (s, obj);
-  s += " Property: ";
-  addHex (s, prop);
-  s += " Property_index: ";
-  addHex (s, property_index);
-  s += " Type: ";
-  addHex (s, type);
-  s += "max_elements: ";
-  add16Hex (s, count);
-  s += " acces: ";
-  addHex (s, access);
-  return s;
+void
+A_PropertyDescription_Response_PDU::DecodeTo (DecodeBuf & s)
+{
+  s.add ("A_PropertyDescription_Response Obj:");
+  s.addHex (obj);
+  s.add (" Property: ");
+  s.addHex (prop);
+  s.add (" Property_index: ");
+  s.addHex (property_index);
+  s.add (" Type: ");
+  s.addHex (type);
+  s.add ("max_elements: ");
+  s.add16Hex (count);
+  s.add (" acces: ");
+  s.addHex (access);
 }
 
 bool A_PropertyDescription_Response_PDU::isResponse (const APDU * req) CONST
@@ -1240,13 +1259,12 @@ A_DeviceDescriptor_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_DeviceDescriptor_Read_PDU::Decode ()
+void
+A_DeviceDescriptor_Read_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((type & 0xC0) == 0);
-  String s ("A_DeviceDescriptor_Read Type:");
-  addHex (s, type);
-  return s;
+  s.add ("A_DeviceDescriptor_Read Type:");
+  s.addHex (type);
 }
 
 bool A_DeviceDescriptor_Read_PDU::isResponse (const APDU * req) CONST
@@ -1284,15 +1302,14 @@ A_DeviceDescriptor_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_DeviceDescriptor_Response_PDU::Decode ()
+void
+A_DeviceDescriptor_Response_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((type & 0xC0) == 0);
-  String s ("A_DeviceDescriptor_Response Type:");
-  addHex (s, type);
-  s += " Descriptor: ";
-  add16Hex (s, descriptor);
-  return s;
+  s.add ("A_DeviceDescriptor_Response Type:");
+  s.addHex (type);
+  s.add (" Descriptor: ");
+  s.add16Hex (descriptor);
 }
 
 bool A_DeviceDescriptor_Response_PDU::isResponse (const APDU * req) CONST
@@ -1336,15 +1353,14 @@ A_ADC_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_ADC_Read_PDU::Decode ()
+void
+A_ADC_Read_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((channel & 0xC0) == 0);
-  String s ("A_ADC_Read Channel:");
-  addHex (s, channel);
-  s += " Count: ";
-  addHex (s, count);
-  return s;
+  s.add ("A_ADC_Read Channel:");
+  s.addHex (channel);
+  s.add (" Count: ");
+  s.addHex (count);
 }
 
 bool A_ADC_Read_PDU::isResponse (const APDU * req) CONST
@@ -1386,17 +1402,16 @@ A_ADC_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_ADC_Response_PDU::Decode ()
+void
+A_ADC_Response_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((channel & 0xC0) == 0);
-  String s ("A_ADC_Response Channel:");
-  addHex (s, channel);
-  s += " Count: ";
-  addHex (s, count);
-  s += "Value: ";
-  addHex (s, val);
-  return s;
+  s.add ("A_ADC_Response Channel:");
+  s.addHex (channel);
+  s.add (" Count: ");
+  s.addHex (count);
+  s.add ("Value: ");
+  s.addHex (val);
 }
 
 bool A_ADC_Response_PDU::isResponse (const APDU * req) CONST
@@ -1443,15 +1458,14 @@ A_Memory_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Memory_Read_PDU::Decode ()
+void
+A_Memory_Read_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
-  String s ("A_Memory_Read Len: ");
-  addHex (s, count);
-  s += " Addr: ";
-  add16Hex (s, addr);
-  return s;
+  s.add ("A_Memory_Read Len: ");
+  s.addHex (count);
+  s.add (" Addr: ");
+  s.add16Hex (addr);
 }
 
 bool A_Memory_Read_PDU::isResponse (const APDU * req) CONST
@@ -1495,19 +1509,18 @@ A_Memory_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Memory_Response_PDU::Decode ()
+void
+A_Memory_Response_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert (data () == count);
-  String s ("A_Memory_Response Len:");
-  addHex (s, count);
-  s += " Addr: ";
-  add16Hex (s, addr);
-  s += "Data: ";
+  s.add ("A_Memory_Response Len:");
+  s.addHex (count);
+  s.add (" Addr: ");
+  s.add16Hex (addr);
+  s.add ("Data: ");
   for (unsigned i = 0; i < data (); i++)
-    addHex (s, data[i]);
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_Memory_Response_PDU::isResponse (const APDU * req) CONST
@@ -1559,19 +1572,18 @@ A_Memory_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Memory_Write_PDU::Decode ()
+void
+A_Memory_Write_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert (data () == count);
-  String s ("A_Memory_Write Len:");
-  addHex (s, count);
-  s += " Addr: ";
-  add16Hex (s, addr);
-  s += "Data: ";
+  s.add ("A_Memory_Write Len:");
+  s.addHex (count);
+  s.add (" Addr: ");
+  s.add16Hex (addr);
+  s.add ("Data: ");
   for (unsigned i = 0; i < data (); i++)
-    addHex (s, data[i]);
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_Memory_Write_PDU::isResponse (const APDU * req) CONST
@@ -1618,22 +1630,21 @@ A_MemoryBit_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_MemoryBit_Write_PDU::Decode ()
+void
+A_MemoryBit_Write_PDU::DecodeTo (DecodeBuf & s)
 {
   assert (andmask () == count);
   assert (xormask () == count);
-  String s ("A_MemoryBit_Write Len:");
-  addHex (s, count);
-  s += "Addr: ";
-  add16Hex (s, addr);
-  s += "And: ";
+  s.add ("A_MemoryBit_Write Len:");
+  s.addHex (count);
+  s.add ("Addr: ");
+  s.add16Hex (addr);
+  s.add ("And: ");
   for (unsigned i = 0; i < andmask (); i++)
-    addHex (s, andmask[i]);
-  s += "xor: ";
+    s.addHex (andmask[i]);
+  s.add ("xor: ");
   for (unsigned i = 0; i < xormask (); i++)
-    addHex (s, xormask[i]);
-  return s;
+    s.addHex (xormask[i]);
 }
 
 bool A_MemoryBit_Write_PDU::isResponse (const APDU * req) CONST
@@ -1676,18 +1687,17 @@ A_UserMemory_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_UserMemory_Read_PDU::Decode ()
+void
+A_UserMemory_Read_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert ((addr_extension & 0xf0) == 0);
-  String s ("A_UserMemory_Read Addr_ext:");
-  addHex (s, addr_extension);
-  s += " Len: ";
-  addHex (s, count);
-  s += " Addr: ";
-  add16Hex (s, addr);
-  return s;
+  s.add ("A_UserMemory_Read Addr_ext:");
+  s.addHex (addr_extension);
+  s.add (" Len: ");
+  s.addHex (count);
+  s.add (" Addr: ");
+  s.add16Hex (addr);
 }
 
 bool A_UserMemory_Read_PDU::isResponse (const APDU * req) CONST
@@ -1735,22 +1745,21 @@ A_UserMemory_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_UserMemory_Response_PDU::Decode ()
+void
+A_UserMemory_Response_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert ((addr_extension & 0xf0) == 0);
   assert (data () == count);
-  String s ("A_UserMemory_Response Addr_ext:");
-  addHex (s, addr_extension);
-  s += " Len: ";
-  addHex (s, count);
-  s += " Addr: ";
-  add16Hex (s, addr);
-  s += " Data: ";
+  s.add ("A_UserMemory_Response Addr_ext:");
+  s.addHex (addr_extension);
+  s.add (" Len: ");
+  s.addHex (count);
+  s.add (" Addr: ");
+  s.add16Hex (addr);
+  s.add (" Data: ");
   for (unsigned i = 0; i < data (); i++)
-    addHex (s, data[i]);
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_UserMemory_Response_PDU::isResponse (const APDU * req) CONST
@@ -1808,22 +1817,21 @@ A_UserMemory_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_UserMemory_Write_PDU::Decode ()
+void
+A_UserMemory_Write_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((count & 0xf0) == 0);
   assert ((addr_extension & 0xf0) == 0);
   assert (data () == count);
-  String s ("A_UserMemory_Write Addr_ext:");
-  addHex (s, addr_extension);
-  s += " Len: ";
-  addHex (s, count);
-  s += " Addr: ";
-  add16Hex (s, addr);
-  s += " Data: ";
+  s.add ("A_UserMemory_Write Addr_ext:");
+  s.addHex (addr_extension);
+  s.add (" Len: ");
+  s.addHex (count);
+  s.add (" Addr: ");
+  s.add16Hex (addr);
+  s.add (" Data: ");
   for (unsigned i = 0; i < data (); i++)
-    addHex (s, data[i]);
-  return s;
+    s.addHex (data[i]);
 }
 
 bool A_UserMemory_Write_PDU::isResponse (const APDU * req) CONST
@@ -1871,22 +1879,21 @@ A_UserMemoryBit_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_UserMemoryBit_Write_PDU::Decode ()
+void
+A_UserMemoryBit_Write_PDU::DecodeTo (DecodeBuf & s)
 {
   assert (andmask () == count);
   assert (xormask () == count);
-  String s ("A_UserMemoryBit_Write Len:");
-  addHex (s, count);
-  s += "Addr: ";
-  add16Hex (s, addr);
-  s += "And: ";
+  s.add ("A_UserMemoryBit_Write Len:");
+  s.addHex (count);
+  s.add ("Addr: ");
+  s.add16Hex (addr);
+  s.add ("And: ");
   for (unsigned i = 0; i < andmask (); i++)
-    addHex (s, andmask[i]);
-  s += "xor: ";
+    s.addHex (andmask[i]);
+  s.add ("xor: ");
   for (unsigned i = 0; i < xormask (); i++)
-    addHex (s, xormask[i]);
-  return s;
+    s.addHex (xormask[i]);
 }
 
 bool A_UserMemoryBit_Write_PDU::isResponse (const APDU * req) CONST
@@ -1917,11 +1924,10 @@ A_UserManufacturerInfo_Read_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_UserManufacturerInfo_Read_PDU::Decode ()
+void
+A_UserManufacturerInfo_Read_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_UserManufacturerInfo_Read");
-  return s;
+  s.add ("A_UserManufacturerInfo_Read");
 }
 
 bool A_UserManufacturerInfo_Read_PDU::isResponse (const APDU * req) CONST
@@ -1960,14 +1966,13 @@ A_UserManufacturerInfo_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_UserManufacturerInfo_Response_PDU::Decode ()
+void
+A_UserManufacturerInfo_Response_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_UserManufactueerInfo_Response Manufacturer:");
-  addHex (s, manufacturerid);
-  s += " data: ";
-  add16Hex (s, data);
-  return s;
+  s.add ("A_UserManufactueerInfo_Response Manufacturer:");
+  s.addHex (manufacturerid);
+  s.add (" data: ");
+  s.add16Hex (data);
 }
 
 bool A_UserManufacturerInfo_Response_PDU::isResponse (const APDU * req) CONST
@@ -1999,11 +2004,10 @@ A_Restart_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Restart_PDU::Decode ()
+void
+A_Restart_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_Restart");
-  return s;
+  s.add ("A_Restart");
 }
 
 bool A_Restart_PDU::isResponse (const APDU * req) CONST
@@ -2042,11 +2046,11 @@ A_Authorize_Request_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Authorize_Request_PDU::Decode ()
+void
+A_Authorize_Request_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_Authorize_Request Key:");
-  return s + FormatEIBKey (key);
+  s.add ("A_Authorize_Request Key:");
+  s.addEIBKey (key);
 }
 
 bool A_Authorize_Request_PDU::isResponse (const APDU * req) CONST
@@ -2081,12 +2085,11 @@ A_Authorize_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Authorize_Response_PDU::Decode ()
+void
+A_Authorize_Response_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_Authorize_Response Level:");
-  addHex (s, level);
-  return s;
+  s.add ("A_Authorize_Response Level:");
+  s.addHex (level);
 }
 
 bool A_Authorize_Response_PDU::isResponse (const APDU * req) CONST
@@ -2127,13 +2130,13 @@ A_Key_Write_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Key_Write_PDU::Decode ()
+void
+A_Key_Write_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_Key_Write Level:");
-  addHex (s, level);
-  s += " Key: ";
-  return s + FormatEIBKey (key);
+  s.add ("A_Key_Write Level:");
+  s.addHex (level);
+  s.add (" Key: ");
+  s.addEIBKey (key);
 }
 
 bool A_Key_Write_PDU::isResponse (const APDU * req) CONST
@@ -2168,12 +2171,11 @@ A_Key_Response_PDU::ToPacket ()
   return pdu;
 }
 
-String
-A_Key_Response_PDU::Decode ()
+void
+A_Key_Response_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("A_Key_Response Level:");
-  addHex (s, level);
-  return s;
+  s.add ("A_Key_Response Level:");
+  s.addHex (level);
 }
 
 bool A_Key_Response_PDU::isResponse (const APDU * req) CONST
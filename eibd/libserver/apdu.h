@@ -79,11 +79,19 @@ public:
   virtual bool init (const CArray &) = 0;
   /** convert to character array */
   virtual CArray ToPacket () = 0;
+  /** append decoded content to s */
+  virtual void DecodeTo (DecodeBuf & s) = 0;
   /** decode content as string */
-  virtual String Decode () = 0;
+  String Decode ();
+  /** decode content into buf of size bytes without allocating
+   * @return buf */
+  const char *Decode (char *buf, unsigned size);
 
   /** converts character array to a APDU */
   static APDU *fromPacket (const CArray &);
+  /** appends the decoded form of c to s, using an APDU object on the
+   * stack */
+  static void DecodePacket (const CArray & c, DecodeBuf & s);
   /** gets APDU type */
   virtual APDU_type getType () const = 0;
   /** returns true, if this is can be an answer of req */
@@ -98,7 +106,7 @@ public:
   A_Unknown_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Unknown;
@@ -112,7 +120,7 @@ public:
   A_GroupValue_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_GroupValue_Read;
@@ -128,7 +136,7 @@ public:
     A_GroupValue_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_GroupValue_Response;
@@ -144,7 +152,7 @@ public:
     A_GroupValue_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_GroupValue_Write;
@@ -158,7 +166,7 @@ public:
   A_IndividualAddress_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_IndividualAddress_Read;
@@ -172,7 +180,7 @@ public:
   A_IndividualAddress_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_IndividualAddress_Response;
@@ -187,7 +195,7 @@ public:
   A_IndividualAddress_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_IndividualAddress_Write;
@@ -202,7 +210,7 @@ public:
   A_IndividualAddressSerialNumber_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_IndividualAddressSerialNumber_Read;
@@ -218,7 +226,7 @@ public:
     A_IndividualAddressSerialNumber_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_IndividualAddressSerialNumber_Response;
@@ -234,7 +242,7 @@ public:
     A_IndividualAddressSerialNumber_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_IndividualAddressSerialNumber_Write;
@@ -251,7 +259,7 @@ public:
     A_ServiceInformation_Indication_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_ServiceInformation_Indication_Write;
@@ -266,7 +274,7 @@ public:
   A_DomainAddress_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_DomainAddress_Write;
@@ -280,7 +288,7 @@ public:
   A_DomainAddress_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_DomainAddress_Read;
@@ -295,7 +303,7 @@ public:
   A_DomainAddress_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_DomainAddress_Response;
@@ -312,7 +320,7 @@ public:
     A_DomainAddressSelective_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_DomainAddressSelective_Read;
@@ -330,7 +338,7 @@ public:
     A_PropertyValue_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_PropertyValue_Read;
@@ -349,7 +357,7 @@ public:
     A_PropertyValue_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_PropertyValue_Response;
@@ -368,7 +376,7 @@ public:
     A_PropertyValue_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_PropertyValue_Write;
@@ -385,7 +393,7 @@ public:
     A_PropertyDescription_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_PropertyDescription_Read;
@@ -405,7 +413,7 @@ public:
     A_PropertyDescription_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_PropertyDescription_Read;
@@ -420,7 +428,7 @@ public:
   A_DeviceDescriptor_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_DeviceDescriptor_Read;
@@ -436,7 +444,7 @@ public:
     A_DeviceDescriptor_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_DeviceDescriptor_Response;
@@ -452,7 +460,7 @@ public:
     A_ADC_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_ADC_Read;
@@ -469,7 +477,7 @@ public:
     A_ADC_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_ADC_Response;
@@ -485,7 +493,7 @@ public:
     A_Memory_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Memory_Read;
@@ -502,7 +510,7 @@ public:
     A_Memory_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Memory_Response;
@@ -519,7 +527,7 @@ public:
     A_Memory_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Memory_Write;
@@ -537,7 +545,7 @@ public:
     A_MemoryBit_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_MemoryBit_Write;
@@ -554,7 +562,7 @@ public:
     A_UserMemory_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_UserMemory_Read;
@@ -572,7 +580,7 @@ public:
     A_UserMemory_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_UserMemory_Response;
@@ -590,7 +598,7 @@ public:
     A_UserMemory_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_UserMemory_Write;
@@ -609,7 +617,7 @@ public:
     A_UserMemoryBit_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_UserMemoryBit_Write;
@@ -623,7 +631,7 @@ public:
   A_UserManufacturerInfo_Read_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_UserManufacturerInfo_Read;
@@ -639,7 +647,7 @@ public:
     A_UserManufacturerInfo_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_UserManufacturerInfo_Response;
@@ -653,7 +661,7 @@ public:
   A_Restart_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Restart;
@@ -668,7 +676,7 @@ public:
   A_Authorize_Request_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Authorize_Request;
@@ -683,7 +691,7 @@ public:
   A_Authorize_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Authorize_Response;
@@ -699,7 +707,7 @@ public:
     A_Key_Write_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Key_Write;
@@ -714,7 +722,7 @@ public:
   A_Key_Response_PDU ();
   bool init (const CArray & p);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   APDU_type getType () const
   {
     return A_Key_Response;
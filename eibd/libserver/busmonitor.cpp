@@ -60,7 +60,7 @@ A_Busmonitor::Get_L_Busmonitor (L_Busmonitor_PDU * l)
       pth_sem_inc(s,TRUE);
       // that will kill the do loop
   }
-  Put_On_Queue_Or_Drop<L_Busmonitor_PDU *, L_Busmonitor_PDU *>(data, l, &sem, false, outdropmsg);
+  con->flow.Put (data, l, &sem);
 #if 0
   data.put (l);
   pth_sem_inc (&sem, 0);
@@ -144,7 +144,7 @@ A_Text_Busmonitor::sendResponse (L_Busmonitor_PDU * p, pth_event_t stop)
   CArray buf;
   if (p) // empty one means we're going down
     {
-      String s = p->Decode();
+      const String &s = p->Text();
       buf.resize(2 + strlen(s()) + 1);
       EIBSETTYPE(buf, EIB_BUSMONITOR_PACKET);
       buf.setpart((const uchar *) s(), 2, strlen(s()));
@@ -155,3 +155,53 @@ A_Text_Busmonitor::sendResponse (L_Busmonitor_PDU * p, pth_event_t stop)
     }
   return -1;
 }
+
+/** upper bound for a batched busmonitor message */
+#define TS_BUSMONITOR_MAXMSG 8192
+
+/** appends one frame: timestamp (8 bytes, us since the epoch), status, length (2 bytes), frame */
+static void
+addTSRecord (CArray & buf, const L_Busmonitor_PDU * p)
+{
+  unsigned pos = buf ();
+  unsigned long long ts = p->timestamp;
+  int i;
+
+  buf.resize (pos + 11 + p->pdu ());
+  for (i = 0; i < 8; i++)
+    buf[pos + i] = (ts >> (56 - 8 * i)) & 0xff;
+  buf[pos + 8] = p->status;
+  buf[pos + 9] = (p->pdu () >> 8) & 0xff;
+  buf[pos + 10] = p->pdu () & 0xff;
+  buf.setpart (p->pdu.array (), pos + 11, p->pdu ());
+}
+
+int
+A_TS_Busmonitor::sendResponse (L_Busmonitor_PDU * p, pth_event_t stop)
+{
+  CArray buf;
+  unsigned frames = 1;
+  if (!p) // empty one means we're going down
+    return -1;
+
+  buf.resize (2);
+  EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET_TS);
+  addTSRecord (buf, p);
+  delete p;
+
+  // the client lags behind, take everything queued meanwhile along
+  while (!data.isempty ())
+    {
+      p = data.top ();
+      if (!p || buf () + 11 + p->pdu () > TS_BUSMONITOR_MAXMSG)
+        break;
+      pth_sem_dec (&sem);
+      data.get ();
+      addTSRecord (buf, p);
+      delete p;
+      frames++;
+    }
+  TRACEPRINTF (DroppableQueueInterface::Loggers (), 7, con, "Send %d Busmonitor-Packets", frames);
+
+  return con->sendmessage (buf (), buf.array (), stop);
+}
@@ -26,10 +26,6 @@
 /** implements busmonitor functions for a client */
 class A_Busmonitor:public L_Busmonitor_CallBack, private Thread, public DroppableQueueInterface
 {
-  /** semaphore for the input queue */
-  pth_sem_t sem;
-  /** input queue */
-    Queue < L_Busmonitor_PDU * >data;
     /** is virtual busmonitor */
   bool v;
 
@@ -37,6 +33,10 @@ class A_Busmonitor:public L_Busmonitor_CallBack, private Thread, public Droppabl
 
   void Run (pth_sem_t * stop);
 protected:
+  /** semaphore for the input queue */
+  pth_sem_t sem;
+  /** input queue */
+    Queue < L_Busmonitor_PDU * >data;
   /** Layer 3 Interface*/
     Layer3 * l3;
     /** client connection */
@@ -84,4 +84,25 @@ public:
   }
 };
 
+/** implements the timestamped busmonitor: each frame carries its receive time and
+ * bus status, all frames queued while the client lags are sent in one message */
+class A_TS_Busmonitor:public A_Busmonitor
+{
+protected:
+  int sendResponse (L_Busmonitor_PDU * p, pth_event_t stop);
+public:
+  /** initializes busmonitor
+   * @param c client connection
+   * @param tr debug output
+   * @param l3 Layer 3
+   * @param virt is virtual busmonitor
+   */
+  A_TS_Busmonitor (ClientConnection * c, Layer3 * l3,
+		   Logs * tr,
+		   int inquemaxlen, int outquemaxlen, int peerquemaxlen,
+		   bool virt = 0):A_Busmonitor (c, l3, tr, inquemaxlen, outquemaxlen, peerquemaxlen,virt)
+  {
+  }
+};
+
 #endif
@@ -0,0 +1,251 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "busstats.h"
+
+/** window lengths in seconds */
+static const unsigned windowlen[BUSSTATS_WINDOWS] = { 1, 60, 900 };
+
+static void
+Add (uint16_t & c, unsigned v)
+{
+  c = c + v > 0xffff ? 0xffff : c + v;
+}
+
+static void
+Add (uint32_t & c, unsigned v)
+{
+  c = c + v < c ? 0xffffffff : c + v;
+}
+
+/** moves the window to second now and adds v to it */
+template < class C > static void
+Slide (C & c, uint32_t last, uint32_t now, unsigned len, unsigned v)
+{
+  if (last && now / len == last / len)
+    {
+      Add (c.cur, v);
+      return;
+    }
+  c.prev = last && now / len == last / len + 1 ? c.cur : 0;
+  c.cur = 0;
+  Add (c.cur, v);
+}
+
+/** estimates the count of the last len seconds at rel microseconds after
+ * the start, the previous period is weighted with the part of it still
+ * inside the window */
+template < class C > static unsigned
+Estimate (const C & c, uint32_t last, timestamp_t rel, unsigned len)
+{
+  if (!last)
+    return 0;
+  // seconds are counted from 1
+  rel += 1000000;
+  unsigned long long period = len * 1000000ULL;
+  uint32_t epoch = rel / period;
+  unsigned long long rest = period - (rel - epoch * period);
+  if (epoch == last / len)
+    return c.cur + c.prev * rest / period;
+  if (epoch == last / len + 1)
+    return c.cur * rest / period;
+  return 0;
+}
+
+BusStatistics::BusStatistics ()
+{
+  memset (src, 0, sizeof (src));
+  memset (group, 0, sizeof (group));
+  srcentries = 0;
+  groupentries = 0;
+  frames = 0;
+  bytes = 0;
+  bits = 0;
+  repeated = 0;
+  last = 0;
+  memset (wframes, 0, sizeof (wframes));
+  memset (wbits, 0, sizeof (wbits));
+  memset (wrepeated, 0, sizeof (wrepeated));
+  started = getTime ();
+}
+
+BusStatistics::~BusStatistics ()
+{
+  for (unsigned i = 0; i < 0x10000 / BUSSTATS_PAGESIZE; i++)
+    {
+      delete[]src[i];
+      delete[]group[i];
+    }
+}
+
+BusStatsEntry *
+BusStatistics::Entry (BusStatsEntry ** table, unsigned &entries,
+		      eibaddr_t a)
+{
+  BusStatsEntry *&page = table[a / BUSSTATS_PAGESIZE];
+  if (!page)
+    {
+      page = new BusStatsEntry[BUSSTATS_PAGESIZE];
+      memset (page, 0, sizeof (BusStatsEntry) * BUSSTATS_PAGESIZE);
+    }
+  BusStatsEntry *e = &page[a % BUSSTATS_PAGESIZE];
+  if (!e->last)
+    entries++;
+  return e;
+}
+
+void
+BusStatistics::Count (BusStatsEntry * e, unsigned len, bool rep,
+		      uint32_t now)
+{
+  Add (e->frames, 1);
+  Add (e->bytes, len);
+  if (rep)
+    Add (e->repeated, 1);
+  for (int i = 0; i < BUSSTATS_WINDOWS; i++)
+    Slide (e->w[i], e->last, now, windowlen[i], 1);
+  e->last = now;
+}
+
+void
+BusStatistics::Frame (const L_Data_PDU * l)
+{
+  unsigned len = l->data () + 7;
+  unsigned b = PACER_BITS (len);
+  uint32_t now = (getTime () - started) / 1000000 + 1;
+
+  frames++;
+  bytes += len;
+  bits += b;
+  if (l->repeated)
+    repeated++;
+  for (int i = 0; i < BUSSTATS_WINDOWS; i++)
+    {
+      Slide (wframes[i], last, now, windowlen[i], 1);
+      Slide (wbits[i], last, now, windowlen[i], b);
+      Slide (wrepeated[i], last, now, windowlen[i], l->repeated ? 1 : 0);
+    }
+  last = now;
+
+  Count (Entry (src, srcentries, l->source), len, l->repeated, now);
+  if (l->AddrType == GroupAddress)
+    Count (Entry (group, groupentries, l->dest), len, l->repeated, now);
+}
+
+void
+BusStatistics::Top (Element * parent, const char *name,
+		    BusStatsEntry * const *table, bool groupaddr,
+		    unsigned n, int window, timestamp_t rel) const
+{
+  unsigned val[BUSSTATS_MAXTOP];
+  eibaddr_t addr[BUSSTATS_MAXTOP];
+  unsigned found = 0;
+
+  // keeps the n highest counts, sorted in descending order
+  for (unsigned p = 0; p < 0x10000 / BUSSTATS_PAGESIZE; p++)
+    {
+      if (!table[p])
+	continue;
+      for (unsigned i = 0; i < BUSSTATS_PAGESIZE; i++)
+	{
+	  const BusStatsEntry *e = &table[p][i];
+	  if (!e->last)
+	    continue;
+	  unsigned v = window == TOTAL ? e->frames :
+	    Estimate (e->w[window - 1], e->last, rel, windowlen[window - 1]);
+	  if (!v || (found == n && v <= val[n - 1]))
+	    continue;
+	  unsigned j = found < n ? found++ : n - 1;
+	  for (; j > 0 && val[j - 1] < v; j--)
+	    {
+	      val[j] = val[j - 1];
+	      addr[j] = addr[j - 1];
+	    }
+	  val[j] = v;
+	  addr[j] = p * BUSSTATS_PAGESIZE + i;
+	}
+    }
+
+  Element *t = parent->addElement (name);
+  for (unsigned i = 0; i < found; i++)
+    {
+      const BusStatsEntry *e =
+	&table[addr[i] / BUSSTATS_PAGESIZE][addr[i] % BUSSTATS_PAGESIZE];
+      Element *a = t->addElement (XMLBUSSTATSTALKERELEMENT);
+      a->addAttribute (XMLBUSSTATSADDRATTR,
+		       groupaddr ? FormatGroupAddr (addr[i]) () :
+		       FormatEIBAddr (addr[i]) ());
+      a->addAttribute (XMLBUSSTATSFRAMESATTR, e->frames);
+      a->addAttribute (XMLBUSSTATSBYTESATTR, e->bytes);
+      a->addAttribute (XMLBUSSTATSREPEATEDATTR, e->repeated);
+      a->addAttribute (XMLBUSSTATSIDLEATTR,
+		       (int) (rel / 1000000 + 1 - e->last));
+      for (int w = 0; w < BUSSTATS_WINDOWS; w++)
+	{
+	  Element *c = a->addElement (XMLBUSSTATSWINDOWELEMENT);
+	  c->addAttribute (XMLBUSSTATSSECONDSATTR, windowlen[w]);
+	  c->addAttribute (XMLBUSSTATSFRAMESATTR,
+			   Estimate (e->w[w], e->last, rel, windowlen[w]));
+	}
+    }
+}
+
+Element *
+BusStatistics::_xml (Element * parent, unsigned n, int window) const
+{
+  timestamp_t rel = getTime () - started;
+
+  if (n > BUSSTATS_MAXTOP)
+    n = BUSSTATS_MAXTOP;
+  if (window < TOTAL || window > QUARTER)
+    window = TOTAL;
+
+  Element *p = parent->addElement (XMLBUSSTATSELEMENT);
+  p->addAttribute (XMLBUSSTATSUPTIMEATTR, (int) (rel / 1000000));
+  p->addAttribute (XMLBUSSTATSFRAMESATTR, (long long) frames);
+  p->addAttribute (XMLBUSSTATSBYTESATTR, (long long) bytes);
+  p->addAttribute (XMLBUSSTATSBITSATTR, (long long) bits);
+  p->addAttribute (XMLBUSSTATSREPEATEDATTR, (long long) repeated);
+  p->addAttribute (XMLBUSSTATSSOURCESATTR, srcentries);
+  p->addAttribute (XMLBUSSTATSGROUPSATTR, groupentries);
+  for (int i = 0; i < BUSSTATS_WINDOWS; i++)
+    {
+      unsigned f = Estimate (wframes[i], last, rel, windowlen[i]);
+      unsigned r = Estimate (wrepeated[i], last, rel, windowlen[i]);
+      unsigned b = Estimate (wbits[i], last, rel, windowlen[i]);
+      Element *w = p->addElement (XMLBUSSTATSWINDOWELEMENT);
+      w->addAttribute (XMLBUSSTATSSECONDSATTR, windowlen[i]);
+      w->addAttribute (XMLBUSSTATSFRAMESATTR, f);
+      w->addAttribute (XMLBUSSTATSREPEATEDATTR, r);
+      // repeats per thousand frames
+      w->addAttribute (XMLBUSSTATSREPEATRATEATTR, f ? r * 1000 / f : 0);
+      w->addAttribute (XMLBUSSTATSUTILISATIONATTR,
+		       (int) (b * 1000ULL /
+			      (BUSSTATS_BITRATE * (unsigned long long)
+			       windowlen[i])));
+    }
+  if (n)
+    {
+      p->addAttribute (XMLBUSSTATSTOPATTR, n);
+      p->addAttribute (XMLBUSSTATSRANKATTR, window);
+      Top (p, XMLBUSSTATSTOPSOURCESELEMENT, src, false, n, window, rel);
+      Top (p, XMLBUSSTATSTOPGROUPSELEMENT, group, true, n, window, rel);
+    }
+  return p;
+}
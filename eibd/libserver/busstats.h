@@ -0,0 +1,112 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef BUSSTATS_H
+#define BUSSTATS_H
+
+#include "lpdu.h"
+#include "pacer.h"
+
+/** bit rate of the TP1 medium */
+#define BUSSTATS_BITRATE 9600
+/** addresses per table page */
+#define BUSSTATS_PAGESIZE 256
+/** sliding windows, in seconds */
+#define BUSSTATS_WINDOWS 3
+/** most entries a top report may contain */
+#define BUSSTATS_MAXTOP 255
+
+/** frames counted in one sliding window: the count of the current and of
+ * the previous period; the sliding value is estimated by weighting the
+ * previous period with the part of it still inside the window */
+typedef struct
+{
+  uint16_t cur;
+  uint16_t prev;
+} BusStatsWindow;
+
+/** counters of one source or group address */
+typedef struct
+{
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t repeated;
+  /** second of the last frame (counted from 1), 0 if none yet */
+  uint32_t last;
+  BusStatsWindow w[BUSSTATS_WINDOWS];
+} BusStatsEntry;
+
+/** counters of the whole line in one sliding window */
+typedef struct
+{
+  uint32_t cur;
+  uint32_t prev;
+} BusStatsTotalWindow;
+
+/** always on bus statistics, fed with every L_Data frame layer 3
+ * dispatches. Counters per source and per group address live in tables
+ * indexed directly by address (pages allocated on first use), so a frame
+ * costs a few array updates and no search. Sliding 1 s, 1 min and 15 min
+ * windows are kept per entry and for the line, which also yields the bus
+ * utilisation from the frame lengths at BUSSTATS_BITRATE. */
+class BusStatistics
+{
+public:
+  /** window selectors of a top report */
+  enum
+  { TOTAL = 0, SECOND = 1, MINUTE = 2, QUARTER = 3 };
+
+private:
+  BusStatsEntry *src[0x10000 / BUSSTATS_PAGESIZE];
+  BusStatsEntry *group[0x10000 / BUSSTATS_PAGESIZE];
+  unsigned srcentries;
+  unsigned groupentries;
+
+  unsigned long long frames;
+  unsigned long long bytes;
+  unsigned long long bits;
+  unsigned long long repeated;
+  uint32_t last;
+  BusStatsTotalWindow wframes[BUSSTATS_WINDOWS];
+  BusStatsTotalWindow wbits[BUSSTATS_WINDOWS];
+  BusStatsTotalWindow wrepeated[BUSSTATS_WINDOWS];
+  /** start of the statistics, all times are seconds since then */
+  timestamp_t started;
+
+  BusStatsEntry *Entry (BusStatsEntry ** table, unsigned &entries,
+			eibaddr_t a);
+  void Count (BusStatsEntry * e, unsigned len, bool rep, uint32_t now);
+  void Top (Element * parent, const char *name,
+	    BusStatsEntry * const *table, bool groupaddr, unsigned n,
+	    int window, timestamp_t rel) const;
+
+public:
+  BusStatistics ();
+  ~BusStatistics ();
+
+  /** counts a frame seen on the bus */
+  void Frame (const L_Data_PDU * l);
+
+  /** adds the line counters and the n busiest sources and group
+   * addresses, ranked by frames in window (TOTAL, SECOND, MINUTE or
+   * QUARTER) */
+  Element *_xml (Element * parent, unsigned n = 0, int window = TOTAL) const;
+};
+
+#endif
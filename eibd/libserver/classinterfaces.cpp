@@ -62,10 +62,10 @@ template <>
     }
   else
     {
-      pth_sem_inc(sem2inc, yield);
       if (emptysem2reset) {
     	  pth_sem_set_value (emptysem2reset, yieldvalue);
       }
+      pth_sem_inc(sem2inc, yield);
       return true;
     }
   return false;
@@ -89,10 +89,10 @@ template <>
     }
   else
     {
-      pth_sem_inc(sem2inc, yield);
       if (emptysem2reset) {
     	  pth_sem_set_value (emptysem2reset, yieldvalue);
       }
+      pth_sem_inc(sem2inc, yield);
       return true;
     }
   return false;
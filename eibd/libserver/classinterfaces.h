@@ -83,15 +83,36 @@ class DroppableQueueInterface
       }
     else
       {
-        pth_sem_inc(sem2inc, yield);
+        // reset before yielding, the reader may empty the queue at once
         if (emptysem2reset) {
       	  pth_sem_set_value (emptysem2reset, yieldvalue);
         }
+        pth_sem_inc(sem2inc, yield);
         return true;
       }
     return false;
   }
 
+  /** take up to max elements from queue under one lock and decrement
+   *  sem2dec for each, the caller has seen sem2dec occur
+   *  @return number of elements stored in l */
+  template <class QUET>
+  unsigned Take_From_Queue(Queue < QUET > &queue,
+		  QUET *l,
+		  unsigned max,
+		  pth_sem_t *sem2dec)
+  {
+    unsigned n = 0;
+    queue.Lock();
+    while (n < max && !queue.isempty())
+      {
+        pth_sem_dec(sem2dec);
+        l[n++] = queue.get();
+      }
+    queue.Unlock();
+    return n;
+  }
+
 };
 
 
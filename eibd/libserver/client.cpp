@@ -25,6 +25,7 @@
 #include "connection.h"
 #include "managementclient.h"
 #include "groupcacheclient.h"
+#include "shmring.h"
 #include "state.h"
 #include "xmlccwrap.h"
 #include "config.h"
@@ -38,13 +39,20 @@ ClientConnection::ClientConnection (Server * s, Layer3 * l3,
 				    Logs * tr,  int inquemaxlen, int outquemaxlen, int peerquemaxlen,
 				    int fd, struct sockaddr *addr) :
   Thread(tr,PTH_PRIO_STD, "client connection"),
-  created(pth_timeout(0,0))
+  created(pth_timeout(0,0)),
+  flow(tr, this, fd, s->overflowPolicy()),
+  origin(l3->Scheduler(), s->Name(), s->sendWeight())
 {
   TRACEPRINTF (Loggers(), 8, this, "ClientConnection Init %s", get_addr_str(addr));
   this->fd = fd;
   this->l3 = l3;
   if (addr)
-    this->addr = *addr;
+    {
+      char n[64];
+      this->addr = *addr;
+      snprintf (n, sizeof (n), "%s %s", s->Name (), get_addr_str (addr));
+      origin.setName (n);
+    }
   else
     this->addr.sa_family = AF_UNSPEC;
 
@@ -120,6 +128,41 @@ ClientConnection::Run (pth_sem_t * stop1)
 	  }
 	  break;
 
+	case EIB_OPEN_BUSMONITOR_TS:
+	  {
+            LogBusMon(true);
+	    A_TS_Busmonitor busmon (this, l3, Loggers(), s->maxInQueueLength(), s->maxOutQueueLength(), s->maxPeerQueueLength());
+	    busmon.Do (stop);
+            LogBusMon(false);
+	  }
+	  break;
+
+	case EIB_OPEN_VBUSMONITOR_TS:
+	  {
+            LogBusMon(true);
+	    A_TS_Busmonitor busmon (this, l3, Loggers(), s->maxInQueueLength(), s->maxOutQueueLength(), s->maxPeerQueueLength(), 1);
+	    busmon.Do (stop);
+            LogBusMon(false);
+	  }
+	  break;
+
+	case EIB_OPEN_SHM_RING:
+	  if (l3->SharedRing ())
+	    l3->SharedRing ()->Request (this, stop);
+	  else
+	    sendreject (stop);
+	  break;
+
+	case EIB_SET_OVERFLOW_POLICY:
+	  if (size != 3 || buf[2] > EIB_OVERFLOW_DISCONNECT)
+	    sendreject (stop);
+	  else
+	    {
+	      flow.policy = (OverflowPolicy) buf[2];
+	      sendreject (stop, EIB_SET_OVERFLOW_POLICY);
+	    }
+	  break;
+
 	case EIB_OPEN_T_BROADCAST:
 	  {
 	    A_Broadcast cl (l3, Loggers(), s->maxInQueueLength(), s->maxOutQueueLength(), s->maxPeerQueueLength(), this);
@@ -197,6 +240,8 @@ ClientConnection::Run (pth_sem_t * stop1)
 	case EIB_CACHE_READ:
 	case EIB_CACHE_READ_NOWAIT:
 	case EIB_CACHE_LAST_UPDATES:
+	case EIB_CACHE_READ_AGE:
+	case EIB_CACHE_DUMP:
 #ifdef HAVE_GROUPCACHE
 	  GroupCacheRequest (l3, Loggers(), this, stop);
 #else
@@ -221,6 +266,14 @@ ClientConnection::Run (pth_sem_t * stop1)
 	  this->s->Daemon()->StateServers(l3, Loggers(), this, stop);
 	  break;
 
+	case EIB_STATE_REQ_BUSSTATS:
+	  if (size != 4 || buf[3] > BusStatistics::QUARTER)
+	    sendreject (stop);
+	  else
+	    this->s->Daemon()->StateBusStatistics(l3, Loggers(), this, stop,
+						  buf[2], buf[3]);
+	  break;
+
 	default:
 	  WARNLOGSHAPE (Loggers(), LOG_NOTICE, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
 			"Received unknown request %d from %s",
@@ -285,6 +338,84 @@ lp:
   return 0;
 }
 
+int
+ClientConnection::sendmessagefds (int size, const uchar * msg, int nfds, const int *fds, pth_event_t stop)
+{
+  int i;
+  int start;
+  uchar head[2];
+  struct msghdr m;
+  struct iovec iov[2];
+  union
+  {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE (4 * sizeof (int))];
+  } ctl;
+  struct cmsghdr *cm;
+  assert (size >= 2);
+  assert (nfds > 0 && nfds <= 4);
+
+  if (this->addr.sa_family != AF_UNSPEC && this->addr.sa_family != AF_LOCAL)
+    {
+      ++stat_senderr;
+      return -1;
+    }
+
+  Loggers()->TracePacket (8, this, "SendMessage", size, msg);
+  head[0] = (size >> 8) & 0xff;
+  head[1] = (size) & 0xff;
+
+  // the descriptors ride on the first byte, so the header has to go in the same call
+  pth_event_t wr = pth_event (PTH_EVENT_FD | PTH_UNTIL_FD_WRITEABLE, fd);
+  pth_event_concat (wr, stop, NULL);
+  pth_wait (wr);
+  pth_event_isolate (wr);
+  pth_event_free (wr, PTH_FREE_THIS);
+  if (pth_event_status (stop) == PTH_STATUS_OCCURRED)
+    {
+      ++stat_senderr;
+      return -1;
+    }
+
+  iov[0].iov_base = head;
+  iov[0].iov_len = 2;
+  iov[1].iov_base = (void *) msg;
+  iov[1].iov_len = size;
+  memset (&m, 0, sizeof (m));
+  m.msg_iov = iov;
+  m.msg_iovlen = 2;
+  m.msg_control = ctl.buf;
+  m.msg_controllen = CMSG_SPACE (nfds * sizeof (int));
+  cm = CMSG_FIRSTHDR (&m);
+  cm->cmsg_level = SOL_SOCKET;
+  cm->cmsg_type = SCM_RIGHTS;
+  cm->cmsg_len = CMSG_LEN (nfds * sizeof (int));
+  memcpy (CMSG_DATA (cm), fds, nfds * sizeof (int));
+
+  do
+    i = sendmsg (fd, &m, MSG_NOSIGNAL);
+  while (i == -1 && errno == EINTR);
+  if (i < 2)
+    {
+      ++stat_senderr;
+      return -1;
+    }
+
+  start = i - 2;
+  while (start < size)
+    {
+      i = pth_write_ev (fd, msg + start, size - start, stop);
+      if (i <= 0)
+        {
+          ++stat_senderr;
+          return -1;
+        }
+      start += i;
+    }
+  ++stat_packets_sent;
+  return 0;
+}
+
 int
 ClientConnection::readmessage (pth_event_t stop)
 {
@@ -352,5 +483,6 @@ Element * ClientConnection::_xml(Element *parent) const
       snprintf(buf,sizeof(buf)-1,"%s:%d", (const char *) inet_ntoa(sin->sin_addr),(int) ntohs(sin->sin_port));
       p->addAttribute(XMLCLIENTADDRESSATTR,buf);
     }
+  flow._xml(p);
   return p;
 }
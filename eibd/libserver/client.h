@@ -26,6 +26,7 @@
 #include "stateinterface.h"
 #include "classinterfaces.h"
 #include "layer3.h"
+#include "flowcontrol.h"
 
 /** reads the type of a eibd packet */
 #define EIBTYPE(buf) (((buf)[0]<<8)|((buf)[1]))
@@ -63,6 +64,8 @@ public:
   int readmessage (pth_event_t stop);
   /** send a message and aborts if stop occurs */
   int sendmessage (int size, const uchar * msg, pth_event_t stop);
+  /** send a message passing file descriptors along (unix domain sockets only); aborts if stop occurs */
+  int sendmessagefds (int size, const uchar * msg, int nfds, const int *fds, pth_event_t stop);
   /** send a reject; aborts if stop occurs */
   int sendreject (pth_event_t stop);
   /** sends a reject with the code code; aborts, if stop occurs */
@@ -78,6 +81,11 @@ public:
   UIntStatisticsCounter  stat_recverr;
   UIntStatisticsCounter  stat_senderr;
 
+  /** overflow handling of the queues feeding this client */
+  FlowControl flow;
+  /** queue of the frames this client sends to the bus */
+  SendOrigin origin;
+
   /// this is dumping basic client structure with some counters, rest to be done by subclass
   virtual Element * _xml(Element *parent) const;
 
@@ -64,6 +64,104 @@ FormatEIBKey (eibkey_type key)
   return buf;
 }
 
+static const char hexdigits[] = "0123456789ABCDEF";
+
+void
+DecodeBuf::addUInt (unsigned v)
+{
+  char tmp[10];
+  int i = 0;
+  do
+    {
+      tmp[i++] = '0' + v % 10;
+      v /= 10;
+    }
+  while (v);
+  while (i)
+    addChar (tmp[--i]);
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::addHexDigits (unsigned v, int digits)
+{
+  while (digits--)
+    addChar (hexdigits[(v >> (digits * 4)) & 0xf]);
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::add (const char *s)
+{
+  if (!size)
+    return;
+  while (*s && pos + 1 < size)
+    buf[pos++] = *s++;
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::addHex (uchar c)
+{
+  if (!size)
+    return;
+  addHexDigits (c, 2);
+  addChar (' ');
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::add16Hex (uint16_t c)
+{
+  if (!size)
+    return;
+  addHexDigits (c, 4);
+  addChar (' ');
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::addEIBAddr (eibaddr_t a)
+{
+  if (!size)
+    return;
+  addUInt ((a >> 12) & 0xf);
+  addChar ('.');
+  addUInt ((a >> 8) & 0xf);
+  addChar ('.');
+  addUInt (a & 0xff);
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::addGroupAddr (eibaddr_t a)
+{
+  if (!size)
+    return;
+  addUInt ((a >> 11) & 0x1f);
+  addChar ('/');
+  addUInt ((a >> 8) & 0x7);
+  addChar ('/');
+  addUInt (a & 0xff);
+  buf[pos] = 0;
+}
+
+void
+DecodeBuf::addDomainAddr (domainaddr_t a)
+{
+  if (!size)
+    return;
+  addHexDigits (a, 4);
+}
+
+void
+DecodeBuf::addEIBKey (eibkey_type k)
+{
+  if (!size)
+    return;
+  addHexDigits (k, 8);
+}
+
 void
 addHex (String & s, uchar c)
 {
@@ -83,6 +83,66 @@ String FormatDomainAddr (domainaddr_t addr);
 /** formats an EIB key */
 String FormatEIBKey (eibkey_type addr);
 
+/** size of a stack buffer, which can hold the decoded form of any frame */
+#define DECODE_BUFSIZE 2048
+
+/** appends formatted text to a caller supplied buffer without allocating;
+ * output is truncated, if the buffer is too small */
+class DecodeBuf
+{
+  char *buf;
+  unsigned size;
+  unsigned pos;
+
+  void addChar (char c)
+  {
+    if (pos + 1 < size)
+      buf[pos++] = c;
+  }
+  void addUInt (unsigned v);
+  void addHexDigits (unsigned v, int digits);
+
+public:
+  /** initializes an empty buffer
+   * @param b storage
+   * @param s size of b including the terminating 0
+   */
+  DecodeBuf (char *b, unsigned s)
+  {
+    buf = b;
+    size = s;
+    pos = 0;
+    if (size)
+      buf[0] = 0;
+  }
+
+  /** add a string */
+  void add (const char *s);
+  /** add c as hex value */
+  void addHex (uchar c);
+  /** add c as 16 bit hex value */
+  void add16Hex (uint16_t c);
+  /** add an EIB individual address */
+  void addEIBAddr (eibaddr_t a);
+  /** add an EIB group address */
+  void addGroupAddr (eibaddr_t a);
+  /** add an EIB domain address */
+  void addDomainAddr (domainaddr_t a);
+  /** add an EIB key */
+  void addEIBKey (eibkey_type k);
+
+  /** returns the 0 terminated content */
+  const char *operator () () const
+  {
+    return buf;
+  }
+  /** returns the length of the content */
+  unsigned len () const
+  {
+    return pos;
+  }
+};
+
 #include "trace.h"
 #include "classinterfaces.h"
 #include "threads.h"
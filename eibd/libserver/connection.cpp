@@ -39,6 +39,8 @@ A_Broadcast::A_Broadcast (Layer3 * l3, Logs * tr,
     c = 0;
     return;
   }
+  c->setFlowControl (&con->flow);
+  c->setSendOrigin (&con->origin);
   Start ();
 }
 
@@ -63,6 +65,8 @@ A_Group::A_Group (Layer3 * l3, Logs * tr,  int inquemaxlen, int outquemaxlen, in
       c = 0;
       return;
     }
+  c->setFlowControl (&con->flow);
+  c->setSendOrigin (&con->origin);
   Start ();
 }
 
@@ -84,6 +88,8 @@ A_TPDU::A_TPDU (Layer3 * l3, Logs * tr,
       c = 0;
       return;
     }
+  c->setFlowControl (&con->flow);
+  c->setSendOrigin (&con->origin);
   Start ();
 }
 
@@ -106,6 +112,8 @@ A_Individual::A_Individual (Layer3 * l3, Logs * tr,
       c = 0;
       return;
     }
+  c->setFlowControl (&con->flow);
+  c->setSendOrigin (&con->origin);
   Start ();
 }
 
@@ -127,6 +135,7 @@ A_Connection::A_Connection (Layer3 * l3, Logs * tr,
       c = 0;
       return;
     }
+  c->setSendOrigin (&con->origin);
   Start ();
 }
 
@@ -148,6 +157,8 @@ A_GroupSocket::A_GroupSocket (Layer3 * l3, Logs * tr,
       c = 0;
       return;
     }
+  c->setFlowControl (&con->flow);
+  c->setSendOrigin (&con->origin);
   Start ();
 }
 
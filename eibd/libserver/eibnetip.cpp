@@ -241,18 +241,32 @@ EIBNetIPPacket::EIBNetIPPacket ()
 EIBNetIPPacket *
 EIBNetIPPacket::fromPacket (const CArray & c, const struct sockaddr_in src)
 {
-  EIBNetIPPacket *p;
-  unsigned len;
-  if (c () < 6)
-    return 0;
+  return fromPacket (c.array (), c (), src);
+}
+
+int
+EIBNetIPPacket::Service (const uchar * c, unsigned len)
+{
+  if (len < 6)
+    return -1;
   if (c[0] != 0x6 || c[1] != 0x10)
-    return 0;
-  len = (c[4] << 8) | c[5];
-  if (len != c ())
+    return -1;
+  if (len != (unsigned) ((c[4] << 8) | c[5]))
+    return -1;
+  return (c[2] << 8) | c[3];
+}
+
+EIBNetIPPacket *
+EIBNetIPPacket::fromPacket (const uchar * c, unsigned len,
+			    const struct sockaddr_in src)
+{
+  EIBNetIPPacket *p;
+  int service = Service (c, len);
+  if (service < 0)
     return 0;
   p = new EIBNetIPPacket;
-  p->service = (c[2] << 8) | c[3];
-  p->data.set (c.array () + 6, len - 6);
+  p->service = service;
+  p->data.set (c + 6, len - 6);
   p->src = src;
   return p;
 }
@@ -368,6 +382,8 @@ EIBNetIPSocket::EIBNetIPSocket (struct sockaddr_in bindaddr, bool reuseaddr,
   int i;
   TRACEPRINTF (Thread::Loggers(), 0, this, "Open");
   multicast = 0;
+  viewservice = -1;
+  viewcb = 0;
   pth_sem_init (&insignal);
   pth_sem_init (&outsignal);
   memset (&maddr, 0, sizeof (maddr));
@@ -530,8 +546,10 @@ EIBNetIPSocket::Run (pth_sem_t * stop1)
                   || (recvall == 3 && !memcmp(&r, &recvaddr2, sizeof(r))))
                 {
                   Thread::Loggers()->TracePacket(0, this, "Recv", i, buf);
-                  EIBNetIPPacket *p = EIBNetIPPacket::fromPacket(CArray(buf, i),
-                      r);
+                  EIBNetIPPacket *p = 0;
+                  if (!viewcb || EIBNetIPPacket::Service(buf, i) != viewservice
+                      || !viewcb->Recv_View(buf + 6, i - 6, r))
+                    p = EIBNetIPPacket::fromPacket(buf, i, r);
                   if (p)
                     {
                       Put_On_Queue_Or_Drop<EIBNetIPPacket, EIBNetIPPacket>(
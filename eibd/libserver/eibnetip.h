@@ -76,6 +76,12 @@ public:
     /** create from character array */
   static EIBNetIPPacket *fromPacket (const CArray & c,
 				     const struct sockaddr_in src);
+  /** create from the packet in c[0..len) */
+  static EIBNetIPPacket *fromPacket (const uchar * c, unsigned len,
+				     const struct sockaddr_in src);
+  /** checks the header of the packet in c[0..len) and returns its service,
+   * -1 if it is no valid packet */
+  static int Service (const uchar * c, unsigned len);
   /** convert to character array */
   CArray ToPacket () const;
     virtual ~ EIBNetIPPacket ()
@@ -295,6 +301,17 @@ public:
   struct sockaddr_in addr;
 };
 
+/** interface for a receiver parsing packets in the receive buffer of a socket */
+class EIBNetIPRecvCallBack
+{
+public:
+  /** callback: a packet has been received, data[0..len) is its payload and
+   * only valid during the call
+   * @return false, if the packet should be queued as usual */
+  virtual bool Recv_View (const uchar * data, unsigned len,
+			  const struct sockaddr_in & src) = 0;
+};
+
 /** EIBnet/IP socket */
 class EIBNetIPSocket:private Thread, public DroppableQueueInterface, public StateInterface
 {
@@ -312,6 +329,10 @@ class EIBNetIPSocket:private Thread, public DroppableQueueInterface, public Stat
   int fd;
   /** multicast in use */
   int multicast;
+  /** service passed to viewcb */
+  int viewservice;
+  /** receiver of packets in the receive buffer */
+  EIBNetIPRecvCallBack *viewcb;
 
   const static char outdropmsg[], indropmsg[];
 
@@ -331,6 +352,12 @@ public:
   bool Send (EIBNetIPPacket p);
   /** waits for an packet; aborts if stop occurs */
   EIBNetIPPacket *Get (pth_event_t stop);
+  /** passes packets of service to cb before queueing them, NULL to stop */
+  void SetRecvView (int service, EIBNetIPRecvCallBack * cb)
+  {
+    viewservice = service;
+    viewcb = cb;
+  }
 
   /** default send address */
   struct sockaddr_in sendaddr;
@@ -43,6 +43,8 @@ EIBnetServer::EIBnetServer(const char *multicastaddr, int port, bool Tunnel,
   struct sockaddr_in baddr;
   struct ip_mreq mcfg;
   l3 = layer3;
+  sendweight = 1;
+  routing = new SendOrigin(l3->Scheduler(), "EIBnet/IP routing");
   pth_mutex_init(&datalock);
   memset(&baddr, 0, sizeof(baddr));
 #ifdef HAVE_SOCKADDR_IN_LEN
@@ -158,6 +160,7 @@ EIBnetServer::~EIBnetServer()
     pth_event_free(i->second.timeout, PTH_FREE_THIS);
   if (sock)
     delete sock;
+  delete routing;
   ReleaseDataLock(&datalock);
 }
 
@@ -167,6 +170,13 @@ EIBnetServer::init()
   return sock != 0;
 }
 
+void
+EIBnetServer::setSendWeight(unsigned w)
+{
+  sendweight = w;
+  routing->setWeight(w);
+}
+
 void
 EIBnetServer::Get_L_Busmonitor(L_Busmonitor_PDU * l)
 {
@@ -339,6 +349,11 @@ EIBnetServer::addClient(int type, const EIBnet_ConnectRequest & r1)
   state[pos].no = 1;
   state[pos].type = type;
   state[pos].nat = r1.nat;
+  {
+    char n[48];
+    snprintf(n, sizeof(n), "EIBnet/IP tunnel %s", (const char *) inet_ntoa(r1.caddr.sin_addr));
+    state[pos].origin = new SendOrigin(l3->Scheduler(), n, sendweight);
+  }
   TRACEPRINTF(Thread::Loggers(), 8, this,
       "Added IP Client channel %d type %d from %s", state[pos].channel, state[pos].type, (const char *) inet_ntoa(state[pos].caddr.sin_addr));
   ++stat_totalclients;
@@ -380,6 +395,8 @@ EIBnetServer::delClient(connstatemap::iterator i, const char *reason)
   pth_event_free(i->second.outwait, PTH_FREE_THIS);
   delete i->second.out;
   i->second.out = NULL;
+  delete i->second.origin;
+  i->second.origin = NULL;
 
   state.erase(i->first);
 
@@ -540,8 +557,7 @@ EIBnetServer::Run(pth_sem_t * stop1)
             {
               if (p1->data() < 2 || p1->data[0] != 0x29)
                 goto out;
-              const CArray data = p1->data;
-              L_Data_PDU *c = CEMI_to_L_Data(data);
+              L_Data_PDU *c = CEMI_to_L_Data(p1->data.array(), p1->data());
               if (c)
                 {
                   TRACEPRINTF(Thread::Loggers(), 8, this,
@@ -551,7 +567,7 @@ EIBnetServer::Run(pth_sem_t * stop1)
                       c->hopcount--;
                       addNAT(*c);
                       c->object = this;
-                      l3->send_L_Data(c);
+                      l3->send_L_Data(c, routing);
                     }
                   else
                     {
@@ -729,7 +745,7 @@ EIBnetServer::Run(pth_sem_t * stop1)
                             }
                           c->object = this;
                           if (r1.CEMI[0] == 0x11 || r1.CEMI[0] == 0x29)
-                            l3->send_L_Data(c);
+                            l3->send_L_Data(c, i->second.origin);
                           else
                             delete c;
                         }
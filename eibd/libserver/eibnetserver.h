@@ -42,6 +42,8 @@ typedef struct
   pth_event_t sendtimeout;
 
   TimeVal created;
+  /** queue of the frames this connection sends to the bus */
+  SendOrigin *origin;
   UIntStatisticsCounter stat_senderr;
   UIntStatisticsCounter stat_recverr;
 } ConnState;
@@ -85,6 +87,10 @@ class EIBnetServer:public L_Data_CallBack, public L_Busmonitor_CallBack,
 
   int  peerqueuemaxlen;
   int clientsmax;
+  /** share of the bus of routing and each tunnel connection */
+  unsigned sendweight;
+  /** queue of the frames received by routing */
+  SendOrigin *routing;
 
   const static char outdropmsg[], indropmsg[];
 
@@ -115,6 +121,8 @@ public:
 		  int clientsmax, IPv4NetList &ipnetfilters );
     virtual ~ EIBnetServer ();
   bool init ();
+  /** sets the send weight of routing and of tunnel connections opened from now on */
+  void setSendWeight (unsigned w);
 
     const char *_str(void) const
       {
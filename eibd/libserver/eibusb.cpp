@@ -287,3 +287,9 @@ USBLayer2Interface::Get_L_Data (pth_event_t stop)
 {
   return  emi->Get_L_Data (stop);
 }
+
+unsigned
+USBLayer2Interface::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
+{
+  return  emi->Get_L_Data_Batch (stop, l, max);
+}
@@ -73,6 +73,7 @@ public:
 
   bool Send_L_Data (LPDU * l);
   LPDU *Get_L_Data (pth_event_t stop);
+  unsigned Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max);
 
   bool addAddress (eibaddr_t addr);
   bool addGroupAddress (eibaddr_t addr);
@@ -88,41 +88,47 @@ L_Data_ToCEMI (uchar code, const L_Data_PDU & l1)
 L_Data_PDU *
 CEMI_to_L_Data (const CArray & data)
 {
-  L_Data_PDU c;
-  if (data () < 2)
+  return CEMI_to_L_Data (data.array (), data ());
+}
+
+L_Data_PDU *
+CEMI_to_L_Data (const uchar * data, unsigned len)
+{
+  if (len < 2)
     return 0;
   unsigned start = data[1] + 2;
-  if (data () < 7 + start)
+  if (len < 7 + start)
     return 0;
-  if (data () < 7 + start + data[6 + start] + 1)
+  if (len < 7 + start + data[6 + start] + 1)
     return 0;
-  c.source = (data[start + 2] << 8) | (data[start + 3]);
-  c.dest = (data[start + 4] << 8) | (data[start + 5]);
-  c.data.set (data.array () + start + 7, data[6 + start] + 1);
+  if (!data[start] & 0x80 && data[start + 1] & 0x0f)
+    return 0;
+  L_Data_PDU *c = new L_Data_PDU;
+  c->source = (data[start + 2] << 8) | (data[start + 3]);
+  c->dest = (data[start + 4] << 8) | (data[start + 5]);
+  c->data.set (data + start + 7, data[6 + start] + 1);
   if (data[0] == 0x29)
-    c.repeated = (data[start] & 0x20) ? 0 : 1;
+    c->repeated = (data[start] & 0x20) ? 0 : 1;
   else
-    c.repeated = 0;
+    c->repeated = 0;
   switch ((data[start] >> 2) & 0x3)
     {
     case 0:
-      c.prio = PRIO_SYSTEM;
+      c->prio = PRIO_SYSTEM;
       break;
     case 1:
-      c.prio = PRIO_URGENT;
+      c->prio = PRIO_URGENT;
       break;
     case 2:
-      c.prio = PRIO_NORMAL;
+      c->prio = PRIO_NORMAL;
       break;
     case 3:
-      c.prio = PRIO_LOW;
+      c->prio = PRIO_LOW;
       break;
     }
-  c.hopcount = (data[start + 1] >> 4) & 0x07;
-  c.AddrType = (data[start + 1] & 0x80) ? GroupAddress : IndividualAddress;
-  if (!data[start] & 0x80 && data[start + 1] & 0x0f)
-    return 0;
-  return new L_Data_PDU (c);
+  c->hopcount = (data[start + 1] >> 4) & 0x07;
+  c->AddrType = (data[start + 1] & 0x80) ? GroupAddress : IndividualAddress;
+  return c;
 }
 
 L_Busmonitor_PDU *
@@ -134,6 +140,11 @@ CEMI_to_Busmonitor (const CArray & data)
   unsigned start = data[1] + 2;
   if (data () < 1 + start)
     return 0;
+  // additional info: type, length, value; pick up the bus monitor status info
+  for (unsigned i = 2; i + 2 <= start && i + 2 + data[i + 1] <= start;
+       i += 2 + data[i + 1])
+    if (data[i] == 0x03 && data[i + 1] == 1)
+      c.status = data[i + 2];
   c.pdu.set (data.array () + start, data () - start);
   return new L_Busmonitor_PDU (c);
 }
@@ -148,7 +159,7 @@ Busmonitor_to_CEMI (uchar code, const L_Busmonitor_PDU & p, int no)
   pdu[2] = 3;
   pdu[3] = 1;
   pdu[4] = 1;
-  pdu[5] = no & 0x7;
+  pdu[5] = (p.status & ~EIB_BUSMONITOR_STATUS_SEQMASK) | (no & EIB_BUSMONITOR_STATUS_SEQMASK);
   pdu.setpart (p.pdu, 6);
   return pdu;
 }
@@ -570,6 +581,7 @@ EMILayer2Interface::Send_L_Data (LPDU * l)
 
   if (mode != 2) {
     if (! Open()) {
+      delete l;
       return false;
     }
   }
@@ -578,7 +590,10 @@ EMILayer2Interface::Send_L_Data (LPDU * l)
   assert (l1->data () >= 1);
   /* discard long frames, as they are not supported by EMI 1/2 */
   if (l1->data () > 0x10)
+  {
+    delete l;
     return false;
+  }
   assert (l1->data () <= 0x10);
   assert ((l1->hopcount & 0xf8) == 0);
 
@@ -597,7 +612,12 @@ EMILayer2Interface::Send_L_Data (LPDU * l)
     pth_sem_inc (&out_signal, 1);
 #endif
   }
-  return Put_On_Queue_Or_Drop<LPDU *, LPDU *>(outqueue, l, &out_signal, true, outdropmsg);
+  if (!Put_On_Queue_Or_Drop<LPDU *, LPDU *>(outqueue, l, &out_signal, true, outdropmsg))
+  {
+    delete l;
+    return false;
+  }
+  return true;
 #if 0
   outqueue.put (l);
   pth_sem_inc (&out_signal, 1);
@@ -606,6 +626,13 @@ EMILayer2Interface::Send_L_Data (LPDU * l)
 
 LPDU *
 EMILayer2Interface::Get_L_Data (pth_event_t stop)
+{
+  LPDU *l;
+  return Get_L_Data_Batch (stop, &l, 1) ? l : NULL;
+}
+
+unsigned
+EMILayer2Interface::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
 {
   pth_event_t le = Connection_Wait_Until_Lost(); // will give us proxy
   pth_event_t getwait = pth_event (PTH_EVENT_SEM, &out_signal);
@@ -632,12 +659,12 @@ EMILayer2Interface::Get_L_Data (pth_event_t stop)
 
   if (s)
     {
-      pth_sem_dec(&out_signal);
-      LPDU *l = outqueue.get();
-      TRACEPRINTF(Thread::Loggers(), 2, this, "Recv %s", l->Decode ()());
-      return l;
+      unsigned n = Take_From_Queue<LPDU *>(outqueue, l, max, &out_signal);
+      for (unsigned i = 0; i < n; i++)
+        TRACEPRINTF(Thread::Loggers(), 2, this, "Recv %s", l[i]->Decode ()());
+      return n;
     }
-  return NULL; // upper layer, we lost connection
+  return 0; // upper layer, we lost connection
 }
 
 bool EMILayer2Interface::SendReset()
@@ -787,7 +814,7 @@ EMILayer2Interface::Run (pth_sem_t * stop1)
               p->pdu.set(c->array() + 4, c->len() - 4);
               delete c;
               TRACEPRINTF(Thread::Loggers(), 2, this,
-                  "Recv %s", p->Decode ()());
+                  "Recv %s", p->Text ()());
 
               Put_On_Queue_Or_Drop<LPDU *, L_Busmonitor_PDU *>(outqueue, p,
                   &out_signal, true, outdropmsg);
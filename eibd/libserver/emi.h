@@ -26,6 +26,9 @@
 CArray L_Data_ToCEMI (uchar code, const L_Data_PDU & p);
 /** create L_Data_PDU out of a CEMI frame */
 L_Data_PDU *CEMI_to_L_Data (const CArray & data);
+/** create L_Data_PDU out of the CEMI frame in data[0..len), only the
+ * payload is copied */
+L_Data_PDU *CEMI_to_L_Data (const uchar * data, unsigned len);
 
 L_Busmonitor_PDU *CEMI_to_Busmonitor (const CArray & data);
 CArray Busmonitor_to_CEMI (uchar code, const L_Busmonitor_PDU & p, int no);
@@ -76,6 +79,8 @@ public:
   Send_L_Data(LPDU * l);
   LPDU *
   Get_L_Data(pth_event_t stop);
+  unsigned
+  Get_L_Data_Batch(pth_event_t stop, LPDU ** l, unsigned max);
 
   bool
   addAddress(eibaddr_t addr);
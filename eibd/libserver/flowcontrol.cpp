@@ -0,0 +1,102 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <sys/socket.h>
+#include "flowcontrol.h"
+
+static const char *policynames[] = {
+  "drop-newest", "drop-oldest", "coalesce", "disconnect"
+};
+
+FlowControl::FlowControl (Logs * tr, const LoggableObjectInterface * owner,
+			  int fd, OverflowPolicy policy)
+{
+  t = tr;
+  this->owner = owner;
+  this->fd = fd;
+  this->policy = policy;
+  overloaded = false;
+}
+
+void
+FlowControl::Overloaded ()
+{
+  if (overloaded)
+    return;
+  overloaded = true;
+  WARNLOG (t, LOG_WARNING, owner,
+	   "client does not keep up, queue full (policy %s)",
+	   PolicyName (policy));
+}
+
+void
+FlowControl::Recovered ()
+{
+  overloaded = false;
+  INFOLOG (t, LOG_INFO, owner,
+	   "client caught up (dropped %u/%u, coalesced %u so far)",
+	   *stat_dropped_newest, *stat_dropped_oldest, *stat_coalesced);
+}
+
+void
+FlowControl::Disconnect ()
+{
+  if (fd == -1)
+    return;
+  ++stat_disconnects;
+  ERRORLOG (t, LOG_ERR, owner, "client does not keep up, disconnecting");
+  // wakes the client thread blocked on the socket, which then closes it
+  shutdown (fd, SHUT_RDWR);
+  fd = -1;
+}
+
+const char *
+FlowControl::PolicyName (OverflowPolicy p)
+{
+  if ((unsigned) p >= sizeof (policynames) / sizeof (policynames[0]))
+    return "unknown";
+  return policynames[p];
+}
+
+bool
+FlowControl::ParsePolicy (const char *name, OverflowPolicy & p)
+{
+  for (unsigned i = 0; i < sizeof (policynames) / sizeof (policynames[0]);
+       i++)
+    if (!strcmp (name, policynames[i]))
+      {
+	p = (OverflowPolicy) i;
+	return true;
+      }
+  return false;
+}
+
+void
+FlowControl::_xml (Element * client) const
+{
+  client->addAttribute (XMLCLIENTOVERFLOWPOLICYATTR, PolicyName (policy));
+  if (*stat_dropped_newest)
+    client->addAttribute (XMLCLIENTDROPPEDNEWESTATTR, *stat_dropped_newest);
+  if (*stat_dropped_oldest)
+    client->addAttribute (XMLCLIENTDROPPEDOLDESTATTR, *stat_dropped_oldest);
+  if (*stat_coalesced)
+    client->addAttribute (XMLCLIENTCOALESCEDATTR, *stat_coalesced);
+  if (*stat_disconnects)
+    client->addAttribute (XMLCLIENTOVERFLOWDISCONNECTATTR, *stat_disconnects);
+}
@@ -0,0 +1,134 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef FLOWCONTROL_H
+#define FLOWCONTROL_H
+
+#include "common.h"
+
+/** what to do with a frame for a client, whose queue is full */
+typedef enum
+{
+  /** discard the new frame */
+  OVERFLOW_DROP_NEWEST = EIB_OVERFLOW_DROP_NEWEST,
+  /** discard the oldest queued frame */
+  OVERFLOW_DROP_OLDEST = EIB_OVERFLOW_DROP_OLDEST,
+  /** replace a queued group value write/response by a newer one of the same kind */
+  OVERFLOW_COALESCE = EIB_OVERFLOW_COALESCE,
+  /** close the client connection */
+  OVERFLOW_DISCONNECT = EIB_OVERFLOW_DISCONNECT
+} OverflowPolicy;
+
+/** overflow handling of the queues feeding one client connection.
+ * Drops are only counted; a message is logged when the client starts
+ * and stops falling behind, not for each frame. */
+class FlowControl
+{
+  Logs *t;
+  /** object used for logging */
+  const LoggableObjectInterface *owner;
+  /** client socket, shut down by OVERFLOW_DISCONNECT */
+  int fd;
+  /** queue has been full and not yet drained to the low watermark */
+  bool overloaded;
+
+  UIntStatisticsCounter stat_dropped_newest;
+  UIntStatisticsCounter stat_dropped_oldest;
+  UIntStatisticsCounter stat_coalesced;
+  UIntStatisticsCounter stat_disconnects;
+
+  template < class T > static void dispose (T &)
+  {
+  }
+  template < class T > static void dispose (T * p)
+  {
+    delete p;
+  }
+  void Overloaded ();
+  void Recovered ();
+  void Disconnect ();
+
+public:
+  OverflowPolicy policy;
+
+  FlowControl (Logs * tr, const LoggableObjectInterface * owner, int fd,
+	       OverflowPolicy policy = OVERFLOW_DROP_NEWEST);
+
+  /** puts el on q and increments sem, or applies the policy if q is full;
+   * for pointer types, a discarded element is deleted.
+   * The client counts as recovered once q is down to half its length.
+   * @param same returns true, if el may replace a queued element (OVERFLOW_COALESCE);
+   *   without it, OVERFLOW_COALESCE behaves like OVERFLOW_DROP_NEWEST
+   * @return true, if el has been queued */
+  template < class T >
+    bool Put (Queue < T > &q, T el, pth_sem_t * sem,
+	      bool (*same) (const T &, const T &) = NULL)
+  {
+    if (!q.full ())
+      {
+	q.put (el);
+	pth_sem_inc (sem, FALSE);
+	if (overloaded && q.len () <= q.maxlength () / 2)
+	  Recovered ();
+	return true;
+      }
+    Overloaded ();
+    switch (policy)
+      {
+      case OVERFLOW_DROP_OLDEST:
+	{
+	  T old = q.get ();
+	  dispose (old);
+	  q.put (el);
+	  ++stat_dropped_oldest;
+	  return true;
+	}
+      case OVERFLOW_COALESCE:
+	{
+	  T old;
+	  if (same && q.replace (same, el, &old))
+	    {
+	      dispose (old);
+	      ++stat_coalesced;
+	      return true;
+	    }
+	}
+	break;
+      case OVERFLOW_DISCONNECT:
+	dispose (el);
+	Disconnect ();
+	return false;
+      default:
+	break;
+      }
+    dispose (el);
+    ++stat_dropped_newest;
+    return false;
+  }
+
+  /** returns the name of a policy */
+  static const char *PolicyName (OverflowPolicy p);
+  /** parses a policy name; returns false if unknown */
+  static bool ParsePolicy (const char *name, OverflowPolicy & p);
+
+  /** adds the drop counters as attributes to a client element */
+  void _xml (Element * client) const;
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "frameparser.h"
+
+uchar *
+FrameRing::WritePtr (unsigned &n)
+{
+  unsigned pos = head & (FRAMERING_SIZE - 1);
+  n = FRAMERING_SIZE - pos;
+  if (n > space ())
+    n = space ();
+  return buf + pos;
+}
+
+unsigned
+FrameRing::Put (const uchar * data, unsigned n)
+{
+  unsigned done = 0;
+  while (done < n && space ())
+    {
+      unsigned l;
+      uchar *p = WritePtr (l);
+      if (l > n - done)
+	l = n - done;
+      memcpy (p, data + done, l);
+      Written (l);
+      done += l;
+    }
+  return done;
+}
+
+void
+FrameRing::Copy (uchar * dst, unsigned n) const
+{
+  unsigned pos = tail & (FRAMERING_SIZE - 1);
+  unsigned l = FRAMERING_SIZE - pos;
+  if (l > n)
+    l = n;
+  memcpy (dst, buf + pos, l);
+  memcpy (dst + l, buf, n - l);
+}
+
+TPUARTFrameParser::Token TPUARTFrameParser::Next ()
+{
+  if (!ring.len ())
+    return TP_NONE;
+
+  uchar c = ring[0];
+  // single byte services are checked first, 0x97 is a state answer
+  if (c == 0x8B || c == 0x0B || (c & 0x07) == 0x07
+      || c == 0xCC || c == 0xC0 || c == 0x0C)
+    {
+      frame[0] = c;
+      framelen = 1;
+      ring.Consume (1);
+      if (c == 0x8B)
+	return TP_CONFIRM;
+      if (c == 0x0B)
+	return TP_NACK;
+      if ((c & 0x07) == 0x07)
+	return TP_STATE;
+      return TP_MONITOR;
+    }
+
+  if ((c & 0xD0) == 0x90 || (c & 0xD0) == 0x10)
+    {
+      bool extended = (c & 0xD0) == 0x10;
+      if (!need)
+	{
+	  if (ring.len () < (extended ? 7U : 6U))
+	    return TP_NONE;
+	  need = extended ? ring[6] + 7 + 2 : (ring[5] & 0x0f) + 6 + 2;
+	}
+      if (!addressed)
+	{
+	  addressed = true;
+	  if (extended)
+	    {
+	      group = ring[1] & 0x80;
+	      dest = (ring[4] << 8) | ring[5];
+	    }
+	  else
+	    {
+	      group = ring[5] & 0x80;
+	      dest = (ring[3] << 8) | ring[4];
+	    }
+	  return TP_ADDRESS;
+	}
+      if (ring.len () < need)
+	return TP_NONE;
+      ring.Copy (frame, need);
+      framelen = need;
+      ring.Consume (need);
+      need = 0;
+      addressed = false;
+      return TP_FRAME;
+    }
+
+  frame[0] = c;
+  framelen = 1;
+  ring.Consume (1);
+  addressed = false;
+  return TP_GARBAGE;
+}
+
+void
+TPUARTFrameParser::Skip ()
+{
+  if (ring.len ())
+    ring.Consume (1);
+  need = 0;
+  addressed = false;
+}
+
+FT12FrameParser::Token FT12FrameParser::Next ()
+{
+  if (!ring.len ())
+    return FT_NONE;
+
+  switch (ring[0])
+    {
+    case ACKFRAME:
+      frame[0] = ACKFRAME;
+      framelen = 1;
+      ring.Consume (1);
+      return FT_ACK;
+
+    case FIXLENFRAME:
+      if (ring.len () < 4)
+	return FT_NONE;
+      ring.Copy (frame, 4);
+      framelen = 4;
+      ring.Consume (4);
+      if (frame[1] == frame[2] && frame[3] == 0x16)
+	return FT_FIXED;
+      return FT_IGNORED;
+
+    case VARLENFRAME:
+      {
+	if (ring.len () < 7)
+	  return FT_NONE;
+	if (ring[1] != ring[2] || ring[3] != 0x68)
+	  {
+	    ring.Consume (1);
+	    return FT_ERROR;
+	  }
+	unsigned len = ring[1] + 6;
+	if (ring.len () < len)
+	  return FT_NONE;
+	uchar sum = 0;
+	for (unsigned i = 4; i < len - 2; i++)
+	  sum += ring[i];
+	if (ring[len - 2] != sum || ring[len - 1] != 0x16)
+	  {
+	    ring.Consume (len);
+	    return FT_ERROR;
+	  }
+	ring.Copy (frame, len);
+	framelen = len;
+	ring.Consume (len);
+	return FT_VARIABLE;
+      }
+
+    default:
+      frame[0] = ring[0];
+      framelen = 1;
+      ring.Consume (1);
+      return FT_ERROR;
+    }
+}
@@ -0,0 +1,219 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef FRAMEPARSER_H
+#define FRAMEPARSER_H
+
+#include "common.h"
+
+/** bytes of a FrameRing, a power of 2 and larger than any frame */
+#define FRAMERING_SIZE 1024
+/** longest TPUART frame: extended frame with 255 bytes payload */
+#define TPUART_MAXFRAME (255 + 7 + 2)
+/** longest FT1.2 frame: 255 bytes user data with header and trailer */
+#define FT12_MAXFRAME (255 + 6)
+
+/** received bytes of a serial interface. Bytes are consumed from the
+ * front by moving an index, the memory is never shifted. */
+class FrameRing
+{
+  uchar buf[FRAMERING_SIZE];
+  /** free running indices, masked on access */
+  unsigned head;
+  unsigned tail;
+
+public:
+  FrameRing ()
+  {
+    head = 0;
+    tail = 0;
+  }
+
+  /** bytes stored */
+  unsigned len () const
+  {
+    return head - tail;
+  }
+  /** bytes that can be added */
+  unsigned space () const
+  {
+    return FRAMERING_SIZE - len ();
+  }
+  /** byte i counted from the front */
+  uchar operator[] (unsigned i) const
+  {
+    return buf[(tail + i) & (FRAMERING_SIZE - 1)];
+  }
+
+  /** returns contiguous free space to read into and its size in n */
+  uchar *WritePtr (unsigned &n);
+  /** adds n bytes written to WritePtr */
+  void Written (unsigned n)
+  {
+    head += n;
+  }
+  /** appends up to n bytes, returns the number stored */
+  unsigned Put (const uchar * data, unsigned n);
+  /** copies n bytes from the front to dst */
+  void Copy (uchar * dst, unsigned n) const;
+  /** drops n bytes from the front */
+  void Consume (unsigned n)
+  {
+    tail += n;
+  }
+  /** drops all bytes */
+  void clear ()
+  {
+    tail = head;
+  }
+};
+
+/** incremental parser of the byte stream of a TPUART. Next returns one
+ * item at a time; the length of a frame is determined once, when its
+ * header is complete, and kept until the frame is complete. */
+class TPUARTFrameParser
+{
+public:
+  typedef enum
+  {
+    /** more bytes are needed */
+    TP_NONE,
+    /** 0x8B, positive send confirmation */
+    TP_CONFIRM,
+    /** 0x0B, negative send confirmation */
+    TP_NACK,
+    /** answer to a state request */
+    TP_STATE,
+    /** 0xCC, 0xC0 or 0x0C, acknowledge seen on the bus */
+    TP_MONITOR,
+    /** the address of a frame is complete, it must be acknowledged now */
+    TP_ADDRESS,
+    /** complete frame */
+    TP_FRAME,
+    /** unexpected byte, dropped */
+    TP_GARBAGE,
+  } Token;
+
+  /** received bytes, fill with WritePtr/Written or Put */
+  FrameRing ring;
+
+private:
+  /** length of the frame at the front, 0 until its header is complete */
+  unsigned need;
+  /** TP_ADDRESS was returned for the frame at the front */
+  bool addressed;
+  bool group;
+  eibaddr_t dest;
+  uchar frame[TPUART_MAXFRAME];
+  unsigned framelen;
+
+public:
+  TPUARTFrameParser ()
+  {
+    need = 0;
+    addressed = false;
+    framelen = 0;
+  }
+
+  Token Next ();
+  /** drops the first byte of an incomplete frame, after a timeout */
+  void Skip ();
+  /** drops everything */
+  void clear ()
+  {
+    ring.clear ();
+    need = 0;
+    addressed = false;
+  }
+
+  /** the frame (TP_FRAME) or the byte (other tokens) returned last */
+  const uchar *Frame () const
+  {
+    return frame;
+  }
+  unsigned FrameLen () const
+  {
+    return framelen;
+  }
+  /** destination of the frame after TP_ADDRESS */
+  bool Group () const
+  {
+    return group;
+  }
+  eibaddr_t Dest () const
+  {
+    return dest;
+  }
+};
+
+/** incremental parser of the byte stream of an FT1.2 interface */
+class FT12FrameParser
+{
+public:
+  typedef enum
+  {
+    /** more bytes are needed */
+    FT_NONE,
+    /** single character acknowledge */
+    FT_ACK,
+    /** valid frame with fixed length */
+    FT_FIXED,
+    /** valid frame with variable length */
+    FT_VARIABLE,
+    /** fixed length frame with a bad trailer, dropped */
+    FT_IGNORED,
+    /** receive error: bad header, checksum or unknown byte, dropped */
+    FT_ERROR,
+  } Token;
+
+  static const uchar ACKFRAME = 0xE5;
+  static const uchar FIXLENFRAME = 0x10;
+  static const uchar VARLENFRAME = 0x68;
+
+  /** received bytes, fill with WritePtr/Written or Put */
+  FrameRing ring;
+
+private:
+  uchar frame[FT12_MAXFRAME];
+  unsigned framelen;
+
+public:
+  FT12FrameParser ()
+  {
+    framelen = 0;
+  }
+
+  Token Next ();
+  void clear ()
+  {
+    ring.clear ();
+  }
+
+  /** the complete frame returned last, including header and trailer */
+  const uchar *Frame () const
+  {
+    return frame;
+  }
+  unsigned FrameLen () const
+  {
+    return framelen;
+  }
+};
+
+#endif
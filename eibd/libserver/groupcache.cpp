@@ -0,0 +1,405 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "groupcache.h"
+#include "tpdu.h"
+#include "apdu.h"
+
+GroupCache::GroupCache (Layer3 * l3, Logs * tr)
+{
+  layer3 = l3;
+  t = tr;
+  enabled = false;
+  memset (page, 0, sizeof (page));
+  pos = 0;
+  snapshot = 0;
+  entries = 0;
+  stale = 0;
+  pth_mutex_init (&lock);
+  pth_cond_init (&cond);
+  TRACEPRINTF (t, 4, this, "GroupCacheInit");
+}
+
+GroupCache::~GroupCache ()
+{
+  TRACEPRINTF (t, 4, this, "GroupCacheDestroy");
+  Stop ();
+  // detach first, the values stay in the snapshot for the next start
+  delete snapshot;
+  snapshot = 0;
+  Clear ();
+  for (unsigned i = 0; i < sizeof (page) / sizeof (page[0]); i++)
+    delete[]page[i];
+}
+
+bool
+GroupCache::Persist (const char *file)
+{
+  GroupCacheSnapshot *s;
+  uchar data[GROUPCACHESNAPSHOT_DATA];
+  unsigned len;
+
+  try
+  {
+    s = new GroupCacheSnapshot (t, file);
+  }
+  catch (Exception & e)
+  {
+    return false;
+  }
+  delete snapshot;
+  snapshot = s;
+
+  for (unsigned ga = 1; ga < 0x10000; ga++)
+    {
+      GroupCacheEntry *e = find (ga);
+      if (e && e->len)
+	continue;
+      eibaddr_t src;
+      timestamp_t recvtime;
+      if (!snapshot->Load (ga, data, len, src, recvtime))
+	continue;
+      e = alloc (ga);
+      memcpy (e->data, data, len);
+      e->len = len;
+      e->src = src;
+      e->recvtime = recvtime;
+      e->stale = true;
+      entries++;
+      stale++;
+    }
+  TRACEPRINTF (t, 2, this, "GroupCache reloaded %d values from %s", stale,
+	       file);
+  return true;
+}
+
+bool
+GroupCache::Start ()
+{
+  TRACEPRINTF (t, 4, this, "GroupCacheEnable");
+  if (!enabled)
+    {
+      if (!layer3->registerGroupCallBack (this, 0))
+	return false;
+      enabled = true;
+    }
+  return true;
+}
+
+void
+GroupCache::Stop ()
+{
+  TRACEPRINTF (t, 4, this, "GroupCacheDisable");
+  if (enabled)
+    layer3->deregisterGroupCallBack (this, 0);
+  enabled = false;
+}
+
+GroupCacheEntry *
+GroupCache::alloc (eibaddr_t ga)
+{
+  GroupCacheEntry *&p = page[ga / GROUPCACHE_PAGESIZE];
+  if (!p)
+    {
+      p = new GroupCacheEntry[GROUPCACHE_PAGESIZE];
+      memset (p, 0, sizeof (GroupCacheEntry) * GROUPCACHE_PAGESIZE);
+    }
+  return &p[ga % GROUPCACHE_PAGESIZE];
+}
+
+void
+GroupCache::clearEntry (eibaddr_t ga, GroupCacheEntry * e)
+{
+  if (e->len)
+    entries--;
+  if (e->stale)
+    stale--;
+  e->stale = false;
+  if (snapshot)
+    snapshot->Erase (ga);
+  e->len = 0;
+  delete e->ext;
+  e->ext = 0;
+}
+
+void
+GroupCache::Get_L_Data (L_Data_PDU * l)
+{
+  // interface down: keep the values, layer 3 keeps us registered
+  if (!l)
+    return;
+
+  // T_DATA_XXX_REQ carrying A_GroupValue_Response or A_GroupValue_Write
+  if (l->data () >= 2 && l->data[0] == 0
+      && ((l->data[1] & 0xC0) == 0x40 || (l->data[1] & 0xC0) == 0x80))
+    {
+      GroupCacheEntry *e = alloc (l->dest);
+      if (!e->len)
+	entries++;
+      if (l->data () <= GROUPCACHE_INLINE)
+	{
+	  delete e->ext;
+	  e->ext = 0;
+	  memcpy (e->data, l->data.array (), l->data ());
+	}
+      else if (e->ext)
+	e->ext->set (l->data.array (), l->data ());
+      else
+	e->ext = new CArray (l->data);
+      e->len = l->data ();
+      e->src = l->source;
+      e->recvtime = getTime ();
+      e->readpending = 0;
+      if (e->stale)
+	stale--;
+      e->stale = false;
+      if (snapshot)
+	snapshot->Store (l->dest, *e);
+
+      e->seq = pos;
+      updates[pos % GROUPCACHE_UPDATES] = l->dest;
+      pos++;
+      ++stat_updates;
+      pth_cond_notify (&cond, TRUE);
+    }
+  // A_GroupValue_Read of another client: answer our readers from its response
+  else if (l->data () >= 2 && l->data[0] == 0 && (l->data[1] & 0xC0) == 0x00)
+    {
+      timestamp_t now = getTime ();
+      GroupCacheEntry *e = alloc (l->dest);
+      if (e->readpending <= now)
+	e->readpending = now + GROUPCACHE_READTIMEOUT * 1000000;
+    }
+  delete l;
+}
+
+void
+GroupCache::SendRead (eibaddr_t ga, unsigned timeout)
+{
+  A_GroupValue_Read_PDU apdu;
+  T_DATA_XXX_REQ_PDU tpdu;
+  L_Data_PDU *l = new L_Data_PDU;
+
+  ++stat_busreads;
+  alloc (ga)->readpending = getTime () + (timestamp_t) timeout * 1000000;
+  tpdu.data = apdu.ToPacket ();
+  l->source = 0;
+  l->dest = ga;
+  l->AddrType = GroupAddress;
+  l->data = tpdu.ToPacket ();
+  layer3->send_L_Data (l);
+}
+
+bool
+GroupCache::Refresh (eibaddr_t ga)
+{
+  GroupCacheEntry *e = find (ga);
+  if (e && e->readpending > getTime ())
+    {
+      ++stat_coalesced;
+      return false;
+    }
+  SendRead (ga, GROUPCACHE_READTIMEOUT);
+  return true;
+}
+
+const GroupCacheEntry *
+GroupCache::Lookup (eibaddr_t ga)
+{
+  GroupCacheEntry *e = find (ga);
+  if (e && e->len)
+    {
+      ++stat_hits;
+      return e;
+    }
+  ++stat_misses;
+  return 0;
+}
+
+const GroupCacheEntry *
+GroupCache::Read (eibaddr_t ga, unsigned timeout, uint16_t age,
+		  pth_event_t stop)
+{
+  timestamp_t requested = getTime ();
+  GroupCacheEntry *e = find (ga);
+
+  if (e && isFresh (e, age, requested))
+    {
+      ++stat_hits;
+      return e;
+    }
+  ++stat_misses;
+  if (!enabled)
+    return 0;
+
+  // join a read already on the bus, else send one
+  e = alloc (ga);
+  timestamp_t wait = (timestamp_t) timeout * 1000000;
+  if (e->readpending > requested)
+    {
+      ++stat_coalesced;
+      if (e->readpending - requested < wait)
+	wait = e->readpending - requested;
+    }
+  else
+    SendRead (ga, timeout);
+
+  pth_event_t timeout_ev = pth_event (PTH_EVENT_RTIME,
+				      pth_time (wait / 1000000,
+						wait % 1000000));
+  pth_event_concat (timeout_ev, stop, NULL);
+  pth_mutex_acquire (&lock, FALSE, NULL);
+  while (pth_event_status (timeout_ev) != PTH_STATUS_OCCURRED
+	 && pth_event_status (stop) != PTH_STATUS_OCCURRED)
+    {
+      e = find (ga);
+      if (e && e->len && e->recvtime >= requested)
+	break;
+      pth_cond_await (&cond, &lock, timeout_ev);
+    }
+  pth_mutex_release (&lock);
+  pth_event_isolate (timeout_ev);
+  pth_event_free (timeout_ev, PTH_FREE_THIS);
+
+  e = find (ga);
+  if (e && e->len && e->recvtime >= requested)
+    return e;
+  return 0;
+}
+
+const GroupCacheEntry *
+GroupCache::Revalidate (eibaddr_t ga, uint16_t age, bool & fresh)
+{
+  GroupCacheEntry *e = find (ga);
+
+  fresh = false;
+  if (!e || !e->len)
+    return 0;
+  ++stat_hits;
+  fresh = isFresh (e, age, getTime ());
+  if (!fresh)
+    {
+      ++stat_staleserved;
+      if (enabled)
+	Refresh (ga);
+    }
+  return e;
+}
+
+uint16_t
+GroupCache::LastUpdates (uint16_t start, uchar timeout, eibaddr_t * ga,
+			 unsigned &count, pth_event_t stop)
+{
+  if (start == pos && timeout)
+    {
+      pth_event_t timeout_ev =
+	pth_event (PTH_EVENT_RTIME, pth_time (timeout, 0));
+      pth_event_concat (timeout_ev, stop, NULL);
+      pth_mutex_acquire (&lock, FALSE, NULL);
+      while (start == pos
+	     && pth_event_status (timeout_ev) != PTH_STATUS_OCCURRED
+	     && pth_event_status (stop) != PTH_STATUS_OCCURRED)
+	pth_cond_await (&cond, &lock, timeout_ev);
+      pth_mutex_release (&lock);
+      pth_event_isolate (timeout_ev);
+      pth_event_free (timeout_ev, PTH_FREE_THIS);
+    }
+
+  uint16_t end = pos;
+  count = (uint16_t) (end - start);
+  if (count > GROUPCACHE_UPDATES)
+    {
+      // the ring has been overwritten, return what is left
+      start = end - GROUPCACHE_UPDATES;
+      count = GROUPCACHE_UPDATES;
+    }
+  for (unsigned i = 0; i < count; i++)
+    ga[i] = updates[(uint16_t) (start + i) % GROUPCACHE_UPDATES];
+  return end;
+}
+
+unsigned
+GroupCache::Dump (unsigned &ga, eibaddr_t last, bool changed,
+		  uint16_t since, uint16_t end, uchar * buf,
+		  unsigned size) const
+{
+  unsigned len = 0;
+
+  for (; ga <= last; ga++)
+    {
+      const GroupCacheEntry *e = find (ga);
+      if (!e)
+	{
+	  // skip the whole page, the loop steps to the start of the next one
+	  ga |= GROUPCACHE_PAGESIZE - 1;
+	  continue;
+	}
+      if (!e->len)
+	continue;
+      if (changed && (uint16_t) (e->seq - since) >= (uint16_t) (end - since))
+	continue;
+      if (len + 6 + e->len > size)
+	break;
+      buf[len] = (ga >> 8) & 0xff;
+      buf[len + 1] = (ga) & 0xff;
+      buf[len + 2] = (e->src >> 8) & 0xff;
+      buf[len + 3] = (e->src) & 0xff;
+      buf[len + 4] = e->stale ? EIB_CACHE_VALUE_STALE : EIB_CACHE_VALUE_FRESH;
+      buf[len + 5] = e->len;
+      memcpy (buf + len + 6, e->Data (), e->len);
+      len += 6 + e->len;
+    }
+  return len;
+}
+
+void
+GroupCache::Remove (eibaddr_t ga)
+{
+  GroupCacheEntry *e = find (ga);
+  if (e)
+    clearEntry (ga, e);
+}
+
+void
+GroupCache::Clear ()
+{
+  for (unsigned i = 0; i < sizeof (page) / sizeof (page[0]); i++)
+    if (page[i])
+      for (unsigned j = 0; j < GROUPCACHE_PAGESIZE; j++)
+	clearEntry (i * GROUPCACHE_PAGESIZE + j, &page[i][j]);
+}
+
+Element *
+GroupCache::_xml (Element * parent) const
+{
+  Element *n = parent->addElement (XMLGROUPCACHEELEMENT);
+
+  n->addAttribute (XMLGROUPCACHEENABLEDATTR, enabled ? "true" : "false");
+  n->addAttribute (XMLGROUPCACHEENTRIESATTR, entries);
+  n->addAttribute (XMLGROUPCACHEUPDATESATTR, *stat_updates);
+  n->addAttribute (XMLGROUPCACHEHITSATTR, *stat_hits);
+  n->addAttribute (XMLGROUPCACHEMISSESATTR, *stat_misses);
+  n->addAttribute (XMLGROUPCACHEBUSREADSATTR, *stat_busreads);
+  n->addAttribute (XMLGROUPCACHECOALESCEDATTR, *stat_coalesced);
+  n->addAttribute (XMLGROUPCACHESTALESERVEDATTR, *stat_staleserved);
+  n->addAttribute (XMLGROUPCACHESTALEATTR, stale);
+  if (snapshot)
+    snapshot->_xml (n);
+  return n;
+}
@@ -0,0 +1,184 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef GROUPCACHE_H
+#define GROUPCACHE_H
+
+#include "layer3.h"
+#include "groupcachesnapshot.h"
+
+/** group values up to this length are stored inside the table */
+#define GROUPCACHE_INLINE 16
+/** entries of the update ring, must divide 65536 */
+#define GROUPCACHE_UPDATES 1024
+/** group addresses per table page (one main group) */
+#define GROUPCACHE_PAGESIZE 2048
+/** seconds a read seen on the bus, but not sent by us, is considered pending */
+#define GROUPCACHE_READTIMEOUT 1
+
+/** cached value of one group address */
+class GroupCacheEntry
+{
+public:
+  /** length of the APDU, 0 if nothing is cached */
+  uchar len;
+  /** APDU (A_GroupValue_Write or A_GroupValue_Response) */
+  uchar data[GROUPCACHE_INLINE];
+  /** APDU, if longer than GROUPCACHE_INLINE */
+  CArray *ext;
+  /** sender */
+  eibaddr_t src;
+  /** time of reception */
+  timestamp_t recvtime;
+  /** end of the A_GroupValue_Read outstanding for this address, 0 if none */
+  timestamp_t readpending;
+  /** reloaded from the snapshot, not yet seen on the bus since */
+  bool stale;
+  /** update ring position of the last update */
+  uint16_t seq;
+
+  const uchar *Data () const
+  {
+    return ext ? ext->array () : data;
+  }
+};
+
+/** caches the last value of every group address seen on the bus.
+ * Values live in a table indexed directly by group address, so a lookup
+ * never searches. Every update is also recorded in a ring of group
+ * addresses, indexed by a 16 bit sequence number, which clients poll with
+ * EIB_CACHE_LAST_UPDATES. */
+class GroupCache:public L_Data_CallBack, public StateInterface, public LoggableObjectInterface
+{
+  Layer3 *layer3;
+  Logs *t;
+  bool enabled;
+
+  /** value table, one page per main group, allocated on first use */
+  GroupCacheEntry *page[0x10000 / GROUPCACHE_PAGESIZE];
+  /** group addresses of the last updates */
+  eibaddr_t updates[GROUPCACHE_UPDATES];
+  /** sequence number of the next update */
+  uint16_t pos;
+
+  /** signalled on every update */
+  pth_mutex_t lock;
+  pth_cond_t cond;
+
+  /** persistent copy, NULL if none */
+  GroupCacheSnapshot *snapshot;
+
+  unsigned entries;
+  unsigned stale;
+  UIntStatisticsCounter stat_updates;
+  UIntStatisticsCounter stat_hits;
+  UIntStatisticsCounter stat_misses;
+  UIntStatisticsCounter stat_busreads;
+  UIntStatisticsCounter stat_coalesced;
+  UIntStatisticsCounter stat_staleserved;
+
+  GroupCacheEntry *find (eibaddr_t ga) const
+  {
+    GroupCacheEntry *p = page[ga / GROUPCACHE_PAGESIZE];
+    return p ? &p[ga % GROUPCACHE_PAGESIZE] : 0;
+  }
+  /** true, if e holds a confirmed value not older than age seconds (0: any) */
+  bool isFresh (const GroupCacheEntry * e, uint16_t age, timestamp_t now) const
+  {
+    return e->len && !e->stale
+      && (!age || now - e->recvtime < (timestamp_t) age * 1000000);
+  }
+  GroupCacheEntry *alloc (eibaddr_t ga);
+  void clearEntry (eibaddr_t ga, GroupCacheEntry * e);
+  void SendRead (eibaddr_t ga, unsigned timeout);
+
+public:
+  GroupCache (Layer3 * l3, Logs * t);
+  virtual ~GroupCache ();
+
+  /** reloads the values stored in file as stale entries and keeps file
+   * up to date from now on; returns false, if file cannot be used */
+  bool Persist (const char *file);
+  /** starts caching; returns false, if layer 3 refuses */
+  bool Start ();
+  /** stops caching, keeps the values */
+  void Stop ();
+  bool isEnabled () const
+  {
+    return enabled;
+  }
+
+  void Get_L_Data (L_Data_PDU * l);
+
+  /** returns the cached value of ga without counting it as hit or miss */
+  const GroupCacheEntry *Peek (eibaddr_t ga) const
+  {
+    return find (ga);
+  }
+  /** sends A_GroupValue_Read for ga, unless one is already pending;
+   * returns true, if a read was sent */
+  bool Refresh (eibaddr_t ga);
+  /** returns the cached value of ga without waiting, NULL if none;
+   * stale values are returned as well */
+  const GroupCacheEntry *Lookup (eibaddr_t ga);
+  /** returns the value of ga; if there is none or it is older than age
+   * seconds (0: any age) or stale, reads it from the bus and waits up to
+   * timeout seconds.
+   * Concurrent readers of the same address share one A_GroupValue_Read and
+   * wait at most until it expires.
+   * @return entry, NULL if no value could be obtained */
+  const GroupCacheEntry *Read (eibaddr_t ga, unsigned timeout, uint16_t age,
+			       pth_event_t stop);
+  /** returns the value of ga at once, also if it is not fresh (see Read);
+   * in that case a read is sent in the background (shared with pending reads)
+   * @param fresh set to whether the value is fresh
+   * @return entry, NULL if there is no value */
+  const GroupCacheEntry *Revalidate (eibaddr_t ga, uint16_t age,
+				     bool & fresh);
+  /** copies the group addresses updated since sequence number start to ga
+   * (at most GROUPCACHE_UPDATES); waits up to timeout seconds, if there is none
+   * @param count number of stored addresses
+   * @return sequence number of the next update */
+  uint16_t LastUpdates (uint16_t start, uchar timeout, eibaddr_t * ga,
+			unsigned &count, pth_event_t stop);
+  /** sequence number of the next update */
+  uint16_t Position () const
+  {
+    return pos;
+  }
+  /** serializes the values from ga up to last into buf, stopping when buf
+   * is full; records are group address, source, state, APDU length, APDU
+   * @param ga first address; set to the first address not yet serialized
+   * @param changed only values updated between the positions since and end
+   * @return bytes written */
+  unsigned Dump (unsigned &ga, eibaddr_t last, bool changed, uint16_t since,
+		 uint16_t end, uchar * buf, unsigned size) const;
+  /** forgets the value of ga */
+  void Remove (eibaddr_t ga);
+  /** forgets all values */
+  void Clear ();
+
+  const char *_str (void) const
+  {
+    return "Group Cache";
+  }
+  Element *_xml (Element * parent) const;
+};
+
+#endif
@@ -0,0 +1,308 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "groupcacheclient.h"
+#include "groupcache.h"
+#include "groupcachewarmup.h"
+#include "client.h"
+
+/** the cache, NULL before CreateGroupCache */
+static GroupCache *cache = 0;
+/** background reader, NULL if none */
+static GroupCacheWarmup *warmup = 0;
+
+bool
+CreateGroupCache (Layer3 * l3, Logs * t, bool enable, const char *snapshot)
+{
+  cache = new GroupCache (l3, t);
+  if (snapshot && !cache->Persist (snapshot))
+    {
+      delete cache;
+      cache = 0;
+      return false;
+    }
+  if (enable && !cache->Start ())
+    {
+      delete cache;
+      cache = 0;
+      return false;
+    }
+  return true;
+}
+
+bool
+StartGroupCacheWarmup (Layer3 * l3, Logs * t, const char *list,
+		       unsigned rate, unsigned refresh)
+{
+  Array < GroupRange > ranges;
+  if (!cache || !GroupCacheWarmup::ParseList (list, ranges))
+    return false;
+  delete warmup;
+  warmup = new GroupCacheWarmup (l3, t, cache, ranges, rate, refresh);
+  return true;
+}
+
+void
+DeleteGroupCache ()
+{
+  delete warmup;
+  warmup = 0;
+  delete cache;
+  cache = 0;
+}
+
+void
+GroupCacheState (Element * parent)
+{
+  if (cache)
+    {
+      Element *n = cache->_xml (parent);
+      if (warmup)
+	warmup->_xml (n);
+    }
+}
+
+/** answers a read with the value e of dst (NULL: no value) */
+static void
+sendValue (ClientConnection * c, int type, eibaddr_t dst,
+	   const GroupCacheEntry * e, pth_event_t stop)
+{
+  uchar small[6 + GROUPCACHE_INLINE];
+  CArray large;
+  uchar *buf = small;
+  int len = 6;
+
+  if (e)
+    {
+      len += e->len;
+      if (e->len > GROUPCACHE_INLINE)
+	{
+	  large.resize (len);
+	  buf = large.array ();
+	}
+      memcpy (buf + 6, e->Data (), e->len);
+    }
+  EIBSETTYPE (buf, type);
+  buf[2] = e ? (e->src >> 8) & 0xff : 0;
+  buf[3] = e ? (e->src) & 0xff : 0;
+  buf[4] = (dst >> 8) & 0xff;
+  buf[5] = (dst) & 0xff;
+  c->sendmessage (len, buf, stop);
+}
+
+void
+GroupCacheRequest (Layer3 * l3, Logs * t, ClientConnection * c,
+		   pth_event_t stop)
+{
+  eibaddr_t dst;
+  uchar buf[4 + 2 * GROUPCACHE_UPDATES];
+
+  if (!cache)
+    {
+      c->sendreject (stop);
+      return;
+    }
+
+  switch (EIBTYPE (c->buf))
+    {
+    case EIB_CACHE_ENABLE:
+      if (cache->Start ())
+	c->sendreject (stop, EIB_CACHE_ENABLE);
+      else
+	c->sendreject (stop, EIB_CONNECTION_INUSE);
+      break;
+
+    case EIB_CACHE_DISABLE:
+      cache->Stop ();
+      c->sendreject (stop, EIB_CACHE_DISABLE);
+      break;
+
+    case EIB_CACHE_CLEAR:
+      cache->Clear ();
+      c->sendreject (stop, EIB_CACHE_CLEAR);
+      break;
+
+    case EIB_CACHE_REMOVE:
+      if (c->size < 4)
+	{
+	  c->sendreject (stop);
+	  break;
+	}
+      dst = (c->buf[2] << 8) | (c->buf[3]);
+      cache->Remove (dst);
+      c->sendreject (stop, EIB_CACHE_REMOVE);
+      break;
+
+    case EIB_CACHE_READ:
+    case EIB_CACHE_READ_NOWAIT:
+      if (c->size < 4)
+	{
+	  c->sendreject (stop);
+	  break;
+	}
+      dst = (c->buf[2] << 8) | (c->buf[3]);
+      if (!cache->isEnabled ())
+	{
+	  // dst 0 tells the client, that the cache is off
+	  sendValue (c, EIBTYPE (c->buf), 0, 0, stop);
+	  break;
+	}
+      if (EIBTYPE (c->buf) == EIB_CACHE_READ_NOWAIT)
+	sendValue (c, EIB_CACHE_READ_NOWAIT, dst, cache->Lookup (dst), stop);
+      else
+	{
+	  uint16_t age = 0;
+	  if (c->size >= 6)
+	    age = (c->buf[4] << 8) | (c->buf[5]);
+	  const GroupCacheEntry *e = cache->Read (dst, 1, age, stop);
+	  sendValue (c, EIB_CACHE_READ, dst, e, stop);
+	}
+      break;
+
+    case EIB_CACHE_READ_AGE:
+      {
+	const GroupCacheEntry *e = 0;
+	bool fresh = false;
+	uchar small[9 + GROUPCACHE_INLINE];
+	CArray large;
+	uchar *rbuf = small;
+	int len = 9;
+
+	if (c->size < 7)
+	  {
+	    c->sendreject (stop);
+	    break;
+	  }
+	dst = (c->buf[2] << 8) | (c->buf[3]);
+	uint16_t age = (c->buf[4] << 8) | (c->buf[5]);
+	if (!cache->isEnabled ())
+	  dst = 0;
+	else
+	  {
+	    if (c->buf[6] & EIB_CACHE_STALE_WHILE_REVALIDATE)
+	      e = cache->Revalidate (dst, age, fresh);
+	    if (!e)
+	      fresh = (e = cache->Read (dst, 1, age, stop)) != 0;
+	  }
+
+	memset (rbuf, 0, len);
+	if (e)
+	  {
+	    timestamp_t a = (getTime () - e->recvtime) / 1000000;
+	    if (a > 0xffff)
+	      a = 0xffff;
+	    if (e->len > GROUPCACHE_INLINE)
+	      {
+		large.resize (len + e->len);
+		rbuf = large.array ();
+	      }
+	    memcpy (rbuf + 9, e->Data (), e->len);
+	    rbuf[2] = (e->src >> 8) & 0xff;
+	    rbuf[3] = (e->src) & 0xff;
+	    rbuf[6] = fresh ? EIB_CACHE_VALUE_FRESH : EIB_CACHE_VALUE_STALE;
+	    rbuf[7] = (a >> 8) & 0xff;
+	    rbuf[8] = (a) & 0xff;
+	    len += e->len;
+	  }
+	EIBSETTYPE (rbuf, EIB_CACHE_READ_AGE);
+	rbuf[4] = (dst >> 8) & 0xff;
+	rbuf[5] = (dst) & 0xff;
+	c->sendmessage (len, rbuf, stop);
+      }
+      break;
+
+    case EIB_CACHE_DUMP:
+      {
+	CArray msg;
+	unsigned ga;
+	eibaddr_t last;
+	uint16_t since, end;
+	bool changed;
+
+	if (c->size < 9)
+	  {
+	    c->sendreject (stop);
+	    break;
+	  }
+	if (!cache->isEnabled ())
+	  {
+	    c->sendreject (stop, EIB_CACHE_DUMP);
+	    break;
+	  }
+	ga = (c->buf[2] << 8) | (c->buf[3]);
+	last = (c->buf[4] << 8) | (c->buf[5]);
+	since = (c->buf[6] << 8) | (c->buf[7]);
+	changed = c->buf[8] & EIB_CACHE_DUMP_CHANGED;
+	end = cache->Position ();
+
+	// one message per EIB_CACHE_DUMP_MSGSIZE bytes, the last has more = 0;
+	// the client asks for each further one with EIB_CACHE_DUMP_NEXT
+	msg.resize (EIB_CACHE_DUMP_MSGSIZE);
+	while (1)
+	  {
+	    unsigned len = 5 + cache->Dump (ga, last, changed, since, end,
+					    msg.array () + 5,
+					    EIB_CACHE_DUMP_MSGSIZE - 5);
+	    EIBSETTYPE (msg.array (), EIB_CACHE_DUMP);
+	    msg[2] = (end >> 8) & 0xff;
+	    msg[3] = (end) & 0xff;
+	    msg[4] = ga <= last;
+	    if (c->sendmessage (len, msg.array (), stop) == -1)
+	      break;
+	    if (ga > last)
+	      break;
+	    if (c->readmessage (stop) == -1)
+	      break;
+	    if (EIBTYPE (c->buf) != EIB_CACHE_DUMP_NEXT)
+	      {
+		// any other request abandons the dump
+		c->sendreject (stop);
+		break;
+	      }
+	  }
+      }
+      break;
+
+    case EIB_CACHE_LAST_UPDATES:
+      {
+	unsigned count;
+	eibaddr_t ga[GROUPCACHE_UPDATES];
+	if (c->size < 5)
+	  {
+	    c->sendreject (stop);
+	    break;
+	  }
+	uint16_t end = cache->LastUpdates ((c->buf[2] << 8) | (c->buf[3]),
+					   c->buf[4], ga, count, stop);
+	EIBSETTYPE (buf, EIB_CACHE_LAST_UPDATES);
+	buf[2] = (end >> 8) & 0xff;
+	buf[3] = (end) & 0xff;
+	for (unsigned i = 0; i < count; i++)
+	  {
+	    buf[4 + 2 * i] = (ga[i] >> 8) & 0xff;
+	    buf[5 + 2 * i] = (ga[i]) & 0xff;
+	  }
+	c->sendmessage (4 + 2 * count, buf, stop);
+      }
+      break;
+
+    default:
+      c->sendreject (stop);
+    }
+}
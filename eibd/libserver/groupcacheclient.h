@@ -24,10 +24,24 @@
 
 class ClientConnection;
 
-bool CreateGroupCache (Layer3 * l3, Logs * t, bool enable);
+/** highest accepted warmup rate in reads per second */
+#define GROUPCACHE_WARMUP_MAXRATE 1000
+
+/** creates the group cache; if snapshot is not NULL, the cache is reloaded
+ * from and persisted to this file */
+bool CreateGroupCache (Layer3 * l3, Logs * t, bool enable,
+		       const char *snapshot = NULL);
 void DeleteGroupCache ();
+/** starts reading the group addresses in list (see
+ * GroupCacheWarmup::ParseList) into the cache at most rate (up to
+ * GROUPCACHE_WARMUP_MAXRATE) per second, repeated every refresh seconds
+ * (0: once); returns false on errors */
+bool StartGroupCacheWarmup (Layer3 * l3, Logs * t, const char *list,
+			    unsigned rate, unsigned refresh);
 
 void GroupCacheRequest (Layer3 * l3, Logs * t, ClientConnection * c,
 			pth_event_t stop);
+/** adds the cache state to parent */
+void GroupCacheState (Element * parent);
 
 #endif
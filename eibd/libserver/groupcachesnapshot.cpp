@@ -0,0 +1,166 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include "groupcachesnapshot.h"
+#include "groupcache.h"
+
+GroupCacheSnapshot::GroupCacheSnapshot (Logs * tr, const char *f)
+{
+  t = tr;
+  file = strdup (f);
+  loaded = 0;
+  corrupt = 0;
+  mapsize = sizeof (GroupCacheSnapshotHeader) +
+    0x10000 * sizeof (GroupCacheSnapshotRecord);
+
+  fd = open (file, O_RDWR | O_CREAT, 0600);
+  if (fd == -1)
+    {
+      ERRORLOG (t, LOG_CRIT, this, "Group cache snapshot %s cannot be opened",
+		file);
+      free (file);
+      throw Exception (DEV_OPEN_FAIL);
+    }
+  // two daemons writing the same mapping would corrupt each other's records
+  if (flock (fd, LOCK_EX | LOCK_NB) == -1)
+    {
+      ERRORLOG (t, LOG_CRIT, this,
+		"Group cache snapshot %s is in use by another process", file);
+      close (fd);
+      free (file);
+      throw Exception (DEV_OPEN_FAIL);
+    }
+  // the file is sparse, only used group addresses occupy disk blocks
+  if (ftruncate (fd, mapsize) == -1)
+    {
+      ERRORLOG (t, LOG_CRIT, this, "Group cache snapshot %s cannot be sized",
+		file);
+      close (fd);
+      free (file);
+      throw Exception (DEV_OPEN_FAIL);
+    }
+  void *m = mmap (NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (m == MAP_FAILED)
+    {
+      ERRORLOG (t, LOG_CRIT, this, "Group cache snapshot %s cannot be mapped",
+		file);
+      close (fd);
+      free (file);
+      throw Exception (DEV_OPEN_FAIL);
+    }
+  hdr = (GroupCacheSnapshotHeader *) m;
+  rec = (GroupCacheSnapshotRecord *) (hdr + 1);
+
+  if (hdr->magic != GROUPCACHESNAPSHOT_MAGIC
+      || hdr->version != GROUPCACHESNAPSHOT_VERSION
+      || hdr->recordsize != sizeof (GroupCacheSnapshotRecord)
+      || hdr->records != 0x10000)
+    {
+      if (hdr->magic)
+	WARNLOG (t, LOG_WARNING, this,
+		 "Group cache snapshot %s has an unknown format, discarded",
+		 file);
+      memset (m, 0, mapsize);
+      hdr->version = GROUPCACHESNAPSHOT_VERSION;
+      hdr->recordsize = sizeof (GroupCacheSnapshotRecord);
+      hdr->records = 0x10000;
+      hdr->magic = GROUPCACHESNAPSHOT_MAGIC;
+    }
+  TRACEPRINTF (t, 2, this, "Group cache snapshot %s mapped", file);
+}
+
+GroupCacheSnapshot::~GroupCacheSnapshot ()
+{
+  TRACEPRINTF (t, 2, this, "Group cache snapshot %s closed", file);
+  msync (hdr, mapsize, MS_SYNC);
+  munmap (hdr, mapsize);
+  close (fd);
+  free (file);
+}
+
+/** FNV-1a over the record, with check taken as 0 */
+uint32_t
+GroupCacheSnapshot::checksum (const GroupCacheSnapshotRecord * r)
+{
+  const uchar *p = (const uchar *) r + sizeof (r->check);
+  const uchar *end = (const uchar *) (r + 1);
+  uint32_t h = 2166136261U;
+  while (p < end)
+    h = (h ^ *p++) * 16777619U;
+  return h;
+}
+
+bool
+GroupCacheSnapshot::Load (eibaddr_t ga, uchar * data, unsigned &len,
+			  eibaddr_t & src, timestamp_t & recvtime)
+{
+  GroupCacheSnapshotRecord r = rec[ga];
+  if (!r.len)
+    return false;
+  if (r.len > GROUPCACHESNAPSHOT_DATA || r.check != checksum (&r))
+    {
+      corrupt++;
+      memset (&rec[ga], 0, sizeof (rec[ga]));
+      return false;
+    }
+  loaded++;
+  len = r.len;
+  memcpy (data, r.data, r.len);
+  src = r.src;
+  recvtime = r.recvtime;
+  return true;
+}
+
+void
+GroupCacheSnapshot::Store (eibaddr_t ga, const GroupCacheEntry & e)
+{
+  GroupCacheSnapshotRecord r;
+
+  if (e.len > GROUPCACHESNAPSHOT_DATA)
+    {
+      Erase (ga);
+      return;
+    }
+  memset (&r, 0, sizeof (r));
+  r.src = e.src;
+  r.len = e.len;
+  r.recvtime = e.recvtime;
+  memcpy (r.data, e.Data (), e.len);
+  r.check = checksum (&r);
+  rec[ga] = r;
+}
+
+void
+GroupCacheSnapshot::Erase (eibaddr_t ga)
+{
+  if (rec[ga].len)
+    memset (&rec[ga], 0, sizeof (rec[ga]));
+}
+
+void
+GroupCacheSnapshot::_xml (Element * n) const
+{
+  n->addAttribute (XMLGROUPCACHESNAPSHOTATTR, file);
+  n->addAttribute (XMLGROUPCACHESNAPSHOTLOADEDATTR, loaded);
+  n->addAttribute (XMLGROUPCACHESNAPSHOTCORRUPTATTR, corrupt);
+}
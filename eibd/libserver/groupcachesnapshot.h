@@ -0,0 +1,97 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef GROUPCACHESNAPSHOT_H
+#define GROUPCACHESNAPSHOT_H
+
+#include "common.h"
+
+class GroupCacheEntry;
+
+#define GROUPCACHESNAPSHOT_MAGIC 0x43474245	/* "EBGC" */
+#define GROUPCACHESNAPSHOT_VERSION 1
+/** values up to this length are persisted */
+#define GROUPCACHESNAPSHOT_DATA 16
+
+/** file header */
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordsize;
+  uint32_t records;
+  uint32_t reserved;
+} GroupCacheSnapshotHeader;
+
+/** one record per group address, at offset ga in the record array */
+typedef struct
+{
+  /** checksum of the record, computed with check = 0 */
+  uint32_t check;
+  /** sender */
+  uint16_t src;
+  /** length of the APDU, 0 if the record is empty */
+  uint8_t len;
+  uint8_t reserved;
+  /** time of reception (us since the epoch) */
+  int64_t recvtime;
+  /** APDU */
+  uint8_t data[GROUPCACHESNAPSHOT_DATA];
+} GroupCacheSnapshotRecord;
+
+/** keeps a copy of the group cache in a memory mapped file, so values
+ * survive a restart. Each update writes only the record of its group
+ * address into the mapping; the kernel writes it back. Every record
+ * carries its own checksum, so a record torn by a crash is dropped on
+ * reload instead of yielding a wrong value. The file is locked while
+ * mapped, so a second daemon cannot use the same snapshot. */
+class GroupCacheSnapshot:public LoggableObjectInterface
+{
+  Logs *t;
+  char *file;
+  int fd;
+  size_t mapsize;
+  GroupCacheSnapshotHeader *hdr;
+  GroupCacheSnapshotRecord *rec;
+
+  unsigned loaded;
+  unsigned corrupt;
+
+  static uint32_t checksum (const GroupCacheSnapshotRecord * r);
+public:
+  /** opens or creates file; throws Exception (DEV_OPEN_FAIL) on failure */
+  GroupCacheSnapshot (Logs * tr, const char *file);
+  virtual ~GroupCacheSnapshot ();
+
+  /** returns the stored value of ga, false if there is none or it is corrupt */
+  bool Load (eibaddr_t ga, uchar * data, unsigned &len, eibaddr_t & src,
+	     timestamp_t & recvtime);
+  /** stores the value of ga; values too long to persist are removed */
+  void Store (eibaddr_t ga, const GroupCacheEntry & e);
+  /** removes the value of ga */
+  void Erase (eibaddr_t ga);
+
+  const char *_str (void) const
+  {
+    return "Group Cache Snapshot";
+  }
+  void _xml (Element * n) const;
+};
+
+#endif
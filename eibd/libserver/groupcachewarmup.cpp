@@ -0,0 +1,220 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include "groupcachewarmup.h"
+
+GroupCacheWarmup::GroupCacheWarmup (Layer3 * l3, Logs * t, GroupCache * c,
+				    const Array < GroupRange > &r,
+				    unsigned rate, unsigned refresh):
+Thread (t, PTH_PRIO_STD, "GroupCacheWarmup")
+{
+  layer3 = l3;
+  cache = c;
+  ranges = r;
+  total = 0;
+  for (unsigned i = 0; i < ranges (); i++)
+    total += ranges[i].last - ranges[i].first + 1;
+  if (rate > GROUPCACHE_WARMUP_MAXRATE)
+    rate = GROUPCACHE_WARMUP_MAXRATE;
+  interval = 1000000 / (rate ? rate : 1);
+  this->refresh = refresh;
+  passes = 0;
+  passstart = 0;
+  done = 0;
+  passreads = 0;
+  lastreads = 0;
+  lastanswered = 0;
+  TRACEPRINTF (t, 4, this, "GroupCacheWarmup %d addresses, %d reads/s",
+	       total, rate);
+  Start ();
+}
+
+GroupCacheWarmup::~GroupCacheWarmup ()
+{
+  Stop ();
+}
+
+/** parses a single group address */
+static bool
+parseGroupAddr (const char *s, char **end, eibaddr_t & ga)
+{
+  unsigned long a, b, c;
+
+  a = strtoul (s, end, 0);
+  if (*end == s)
+    return false;
+  if (**end != '/')
+    {
+      ga = a;
+      return a <= 0xffff;
+    }
+  s = *end + 1;
+  b = strtoul (s, end, 10);
+  if (*end == s)
+    return false;
+  if (**end != '/')
+    {
+      ga = (a << 11) | b;
+      return a <= 0x1f && b <= 0x7ff;
+    }
+  s = *end + 1;
+  c = strtoul (s, end, 10);
+  if (*end == s)
+    return false;
+  ga = (a << 11) | (b << 8) | c;
+  return a <= 0x1f && b <= 0x7 && c <= 0xff;
+}
+
+bool
+GroupCacheWarmup::ParseList (const char *list, Array < GroupRange > &ranges)
+{
+  char *end;
+  GroupRange r;
+
+  while (*list)
+    {
+      if (!parseGroupAddr (list, &end, r.first))
+	return false;
+      r.last = r.first;
+      if (*end == '-' && !parseGroupAddr (end + 1, &end, r.last))
+	return false;
+      if (r.last < r.first || (*end && *end != ','))
+	return false;
+      ranges.resize (ranges () + 1);
+      ranges[ranges () - 1] = r;
+      list = *end ? end + 1 : end;
+    }
+  return ranges () > 0;
+}
+
+bool
+GroupCacheWarmup::Sleep (timestamp_t us, pth_event_t stop)
+{
+  pth_event_t timeout =
+    pth_event (PTH_EVENT_RTIME, pth_time (us / 1000000, us % 1000000));
+  pth_event_concat (timeout, stop, NULL);
+  pth_wait (timeout);
+  pth_event_isolate (timeout);
+  pth_event_free (timeout, PTH_FREE_THIS);
+  return pth_event_status (stop) != PTH_STATUS_OCCURRED;
+}
+
+unsigned
+GroupCacheWarmup::Answered () const
+{
+  unsigned answered = 0, n = 0;
+  for (unsigned i = 0; i < ranges () && n < done; i++)
+    for (unsigned ga = ranges[i].first; ga <= ranges[i].last && n < done;
+	 ga++, n++)
+      {
+	if (!passread.test (ga))
+	  continue;
+	const GroupCacheEntry *e = cache->Peek (ga);
+	if (e && e->len && !e->stale && e->recvtime >= passstart)
+	  answered++;
+      }
+  return answered;
+}
+
+void
+GroupCacheWarmup::Run (pth_sem_t * stop1)
+{
+  pth_event_t stop = pth_event (PTH_EVENT_SEM, stop1);
+
+  while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
+    {
+      passes++;
+      passstart = getTime ();
+      done = 0;
+      passreads = 0;
+      passread.clear ();
+      for (unsigned i = 0; i < ranges (); i++)
+	for (unsigned ga = ranges[i].first; ga <= ranges[i].last; ga++)
+	  {
+	    // client telegrams first: wait for an idle interface
+	    while (!layer3->Send_Queue_Empty ())
+	      {
+		++stat_backoffs;
+		if (!Sleep (interval, stop))
+		  goto out;
+	      }
+	    const GroupCacheEntry *e = cache->Peek (ga);
+	    if (!cache->isEnabled ()
+		|| (e && e->len && !e->stale
+		    && (!refresh
+			|| passstart - e->recvtime <
+			(timestamp_t) refresh * 1000000)))
+	      ++stat_skipped;
+	    else if (cache->Refresh (ga))
+	      {
+		++stat_reads;
+		passreads++;
+		passread.set (ga);
+		if (!Sleep (interval, stop))
+		  goto out;
+	      }
+	    else
+	      ++stat_skipped;
+	    done++;
+	  }
+      // give the last answers time to arrive
+      if (!Sleep (GROUPCACHE_READTIMEOUT * 1000000, stop))
+	break;
+      lastreads = passreads;
+      lastanswered = Answered ();
+      TRACEPRINTF (Thread::Loggers (), 4, this,
+		   "pass %d: %d reads, %d answered", passes, lastreads,
+		   lastanswered);
+      if (!refresh)
+	break;
+      timestamp_t next = passstart + (timestamp_t) refresh * 1000000;
+      timestamp_t now = getTime ();
+      if (next > now && !Sleep (next - now, stop))
+	break;
+    }
+out:
+  pth_event_free (stop, PTH_FREE_THIS);
+}
+
+Element *
+GroupCacheWarmup::_xml (Element * parent) const
+{
+  Element *n = parent->addElement (XMLGROUPCACHEWARMUPELEMENT);
+  unsigned answered = Answered ();
+
+  n->addAttribute (XMLGROUPCACHEWARMUPTOTALATTR, total);
+  n->addAttribute (XMLGROUPCACHEWARMUPDONEATTR, done);
+  n->addAttribute (XMLGROUPCACHEWARMUPREMAININGATTR, total - done);
+  n->addAttribute (XMLGROUPCACHEWARMUPPASSESATTR, passes);
+  n->addAttribute (XMLGROUPCACHEWARMUPRATEATTR,
+		   interval ? 1000000 / interval : 0);
+  n->addAttribute (XMLGROUPCACHEWARMUPREADSATTR, *stat_reads);
+  n->addAttribute (XMLGROUPCACHEWARMUPSKIPPEDATTR, *stat_skipped);
+  n->addAttribute (XMLGROUPCACHEWARMUPBACKOFFSATTR, *stat_backoffs);
+  n->addAttribute (XMLGROUPCACHEWARMUPANSWEREDATTR, answered);
+  // percentage of answered reads, of the last pass once one finished
+  if (lastreads)
+    n->addAttribute (XMLGROUPCACHEWARMUPRESPONSEATTR,
+		     lastanswered * 100 / lastreads);
+  else if (passreads)
+    n->addAttribute (XMLGROUPCACHEWARMUPRESPONSEATTR,
+		     answered * 100 / passreads);
+  return n;
+}
@@ -0,0 +1,94 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef GROUPCACHEWARMUP_H
+#define GROUPCACHEWARMUP_H
+
+#include "groupcache.h"
+#include "groupcacheclient.h"
+#include "addrbitmap.h"
+
+/** range of group addresses, both ends included */
+typedef struct
+{
+  eibaddr_t first;
+  eibaddr_t last;
+} GroupRange;
+
+/** fills the group cache in the background by reading a list of group
+ * addresses at a bounded rate. A read is only sent while the outgoing
+ * queue of the bus interface is empty, so client telegrams always go
+ * first. Addresses with a fresh value are skipped. With a refresh interval,
+ * the list is read again after that many seconds. */
+class GroupCacheWarmup:private Thread, public StateInterface
+{
+  Layer3 *layer3;
+  GroupCache *cache;
+  Array < GroupRange > ranges;
+  /** addresses in ranges */
+  unsigned total;
+  /** minimum delay between two reads in us */
+  unsigned interval;
+  /** seconds between two passes, 0 for a single pass */
+  unsigned refresh;
+
+  /** passes started */
+  unsigned passes;
+  /** start of the current pass */
+  timestamp_t passstart;
+  /** addresses processed in the current pass */
+  unsigned done;
+  /** reads sent in the current pass */
+  unsigned passreads;
+  /** addresses read in the current pass */
+  AddressBitmap passread;
+  /** reads sent / answered in the last finished pass */
+  unsigned lastreads, lastanswered;
+
+  UIntStatisticsCounter stat_reads;
+  UIntStatisticsCounter stat_skipped;
+  UIntStatisticsCounter stat_backoffs;
+
+  void Run (pth_sem_t * stop);
+  /** waits us microseconds; returns false, if stop occurred */
+  bool Sleep (timestamp_t us, pth_event_t stop);
+  /** reads of the current pass, which have been answered */
+  unsigned Answered () const;
+
+public:
+  /** @param rate maximum reads per second, at most
+   * GROUPCACHE_WARMUP_MAXRATE
+   * @param refresh seconds between two passes, 0 for a single pass */
+    GroupCacheWarmup (Layer3 * l3, Logs * t, GroupCache * c,
+		      const Array < GroupRange > &ranges, unsigned rate,
+		      unsigned refresh);
+    virtual ~ GroupCacheWarmup ();
+
+  /** parses a comma separated list of group addresses (x/y/z, x/y or
+   * numeric) and ranges (a-b); returns false on syntax errors */
+  static bool ParseList (const char *list, Array < GroupRange > &ranges);
+
+  const char *_str (void) const
+  {
+    return "Group Cache Warmup";
+  }
+  Element *_xml (Element * parent) const;
+};
+
+#endif
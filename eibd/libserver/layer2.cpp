@@ -19,3 +19,21 @@
 
 #include "layer2.h"
 
+unsigned
+Layer2Interface::Send_L_Data_Batch (LPDU ** l, unsigned n)
+{
+  unsigned sent = 0;
+  for (unsigned i = 0; i < n; i++)
+    if (Send_L_Data (l[i]))
+      sent++;
+  return sent;
+}
+
+unsigned
+Layer2Interface::Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max)
+{
+  if (!max)
+    return 0;
+  l[0] = Get_L_Data (stop);
+  return l[0] ? 1 : 0;
+}
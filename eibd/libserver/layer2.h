@@ -32,6 +32,8 @@ class Layer2Interface : public DroppableQueueInterface, public ErrCounters, publ
 protected:
   int flags;
   Logs *t;
+  /** limits the frames sent by backends without a low level driver */
+  Pacer pacer;
 public:
 
   Layer2Interface(Logs * t, int flags) : DroppableQueueInterface(t), t(t), ConnectionStateInterface(t,NULL), flags(flags ){ };
@@ -39,13 +41,25 @@ public:
   virtual ~ Layer2Interface () {};
   virtual bool init () = 0;
 
-  /** sends a Layer 2 frame asynchronously. */
+  /** sends a Layer 2 frame asynchronously. The driver owns l afterwards,
+   * also if it refuses it.
+   * @return false, if l has been dropped */
   virtual bool Send_L_Data (LPDU * l) = 0;
   /** waits for the next frame
    * @param stop return NULL, if stop occurs
    * @return returns frame or NULL
    */
   virtual LPDU *Get_L_Data (pth_event_t stop) = 0;
+  /** sends n frames asynchronously, waking the driver once. As with
+   * Send_L_Data, the driver owns all n frames afterwards and deletes the
+   * ones it refuses.
+   * @return number of frames accepted */
+  virtual unsigned Send_L_Data_Batch (LPDU ** l, unsigned n);
+  /** waits for the next frame like Get_L_Data, then also takes the frames
+   * already received, up to max
+   * @return number of frames stored in l, 0 if stop occurred or the
+   * connection was lost */
+  virtual unsigned Get_L_Data_Batch (pth_event_t stop, LPDU ** l, unsigned max);
 
   /** try to add the individual address addr to the device, return true if successful */
   virtual bool addAddress (eibaddr_t addr) = 0;
@@ -55,6 +69,11 @@ public:
   virtual bool removeAddress (eibaddr_t addr) = 0;
   /** try to remove the group address addr to the device, return true if successful */
   virtual bool removeGroupAddress (eibaddr_t addr) = 0;
+  /** a receiver for all group addresses exists, the device must not filter
+   * group frames by the added group addresses, return true if successful */
+  virtual bool openGroupMonitor () { return true; }
+  /** the last receiver for all group addresses is gone, return true if successful */
+  virtual bool closeGroupMonitor () { return true; }
 
   /** try to enter the busmonitor mode, return true if successful */
   virtual bool enterBusmonitor () = 0;
@@ -76,9 +95,17 @@ public:
   virtual eibaddr_t getDefaultAddr () = 0;
   /** return true, if all frames have been sent */
   virtual bool Send_Queue_Empty () = 0;
+  /** returns semaphore, which becomes 1, if all frames are sent,
+   * or NULL, if Send_Queue_Empty has to be polled */
+  virtual pth_sem_t *Send_Queue_Empty_Cond ()
+  {
+    return LowLevelDriver () ? LowLevelDriver ()->Send_Queue_Empty_Cond () : NULL;
+  }
 
-  virtual Element * _xml(Element *parent) const { ErrCounters::_xml(parent); return parent; };
+  virtual Element * _xml(Element *parent) const { ErrCounters::_xml(parent); pacer._xml(parent); return parent; };
   virtual LowLevelDriverInterface *LowLevelDriver() { return NULL; }
+  /** returns the pacer limiting the frames sent to the bus */
+  Pacer *TxPacer() { return LowLevelDriver() ? &LowLevelDriver()->pacer : &pacer; }
 
   /* write a statistics tic to the log */
   virtual void logtic() =0;
@@ -170,4 +197,13 @@ typedef Layer2Interface *(*Layer2_Create_Func) (const char *conf, int flags, Log
 #define FLAG_B_TPUARTS_ACKINDIVIDUAL (1<<2)
 #define FLAG_B_TPUARTS_DISCH_RESET (1<<3)
 #define FLAG_B_RESET_ADDRESS_TABLE (1<<4)
+#define FLAG_B_TPUARTS_RTTHREAD (1<<5)
+/** USB: receive transfers kept submitted (1-8, up to USB_MAXTRANSFERS),
+ * 0 for the default */
+#define FLAG_B_USB_RECVPOOL(n) (((n) & 0xf) << 8)
+#define FLAG_B_USB_RECVPOOL_GET(f) (((f) >> 8) & 0xf)
+/** USB: send transfers in flight (1-8, up to USB_MAXTRANSFERS), 0 for the
+ * default */
+#define FLAG_B_USB_SENDRING(n) (((n) & 0xf) << 12)
+#define FLAG_B_USB_SENDRING_GET(f) (((f) >> 12) & 0xf)
 #endif
@@ -18,6 +18,7 @@
 */
 
 #include "layer3.h"
+#include "shmring.h"
 extern "C" {
 #include <inttypes.h>
 #include <stdint.h>
@@ -28,6 +29,8 @@ Layer3::Layer3 (Layer2Interface * l2, Logs * tr, bool resettables, bool _droponl
     ipnetfilters(ipnetfilters)
 {
   layer2 = l2;
+  shmring = NULL;
+  scheduler = new SendScheduler (l2, tr);
 
   TRACEPRINTF(Thread::Loggers(), 2, this, "Allocated @ %p proxy to l2: %p",
         this,
@@ -51,8 +54,39 @@ Layer3::~Layer3 ()
     layer2->Close();
 
   StopAllClients(true);
+  delete scheduler;
+  scheduler = NULL;
   delete layer2;
   layer2=NULL;
+  if (shmring)
+    delete shmring;
+  shmring=NULL;
+}
+
+bool
+Layer3::setSharedRing (ShmRing * r)
+{
+  if (!TraceDataLockWait(&datalock))
+    return false;
+  if (shmring)
+    delete shmring;
+  shmring = r;
+  TraceDataLockRelease(&datalock);
+  return true;
+}
+
+Element *
+Layer3::_xml(Element *parent) const
+{
+  Element *e = parent;
+  if (layer2)
+    e = layer2->_xml(parent);
+  reconnect._xml(e);
+  if (scheduler)
+    scheduler->_xml(parent);
+  if (shmring)
+    shmring->_xml(parent);
+  return e;
 }
 
 bool Layer3::TraceDataLockWait(pth_mutex_t *datalock)
@@ -111,14 +145,15 @@ bool Layer3::StopAllClients(bool hard=false)
 }
 
 bool
-Layer3::send_L_Data (L_Data_PDU * l)
+Layer3::send_L_Data (L_Data_PDU * l, SendOrigin * origin)
 {
   int ret = 0;
+  char buf[DECODE_BUFSIZE];
   if (!TraceDataLockWait(&datalock))
     return false;
   try
     {
-      TRACEPRINTF(Loggers(), 3, this, "Send %s", l->Decode ()());
+      TRACEPRINTF(Loggers(), 3, this, "Send %s", l->Decode (buf, sizeof (buf)));
       if (Connection_Lost())
         {
           if (!layer2->Open())
@@ -132,7 +167,7 @@ Layer3::send_L_Data (L_Data_PDU * l)
 
       if (l->source == 0)
         l->source = layer2->getDefaultAddr();
-      ret = layer2->Send_L_Data(l);
+      ret = scheduler->Send(l, origin);
       throw Exception(LOOP_RETURN);
     }
   catch (Exception &e)
@@ -282,6 +317,8 @@ Layer3::deregisterGroupCallBack (L_Data_CallBack * c, eibaddr_t addr)
               }
             if (addr)
               layer2->removeGroupAddress(addr);
+            else
+              layer2->closeGroupMonitor();
             ret = 1;
             throw Exception(LOOP_RETURN);
           }
@@ -477,12 +514,12 @@ Layer3::registerGroupCallBack (L_Data_CallBack * c, eibaddr_t addr)
             break;
         }
       if (i == group())
-        if (addr)
-          if (!layer2->addGroupAddress(addr))
-            {
-              ret = 0;
-              throw Exception(LOOP_RETURN);
-            }
+        if (addr ? !layer2->addGroupAddress(addr) :
+            !layer2->openGroupMonitor())
+          {
+            ret = 0;
+            throw Exception(LOOP_RETURN);
+          }
       group.resize(group() + 1);
       group[group() - 1].cb = c;
       group[group() - 1].dest = addr;
@@ -562,18 +599,136 @@ bool
   return false;
 }
 
+void
+Layer3::Dispatch (LPDU * l)
+// called with datalock held
+{
+  unsigned i;
+  char buf[DECODE_BUFSIZE];
+
+  if (l->getType() == L_Busmonitor)
+    {
+      L_Busmonitor_PDU *l1, *l2;
+      l1 = (L_Busmonitor_PDU *) l;
+
+      TRACEPRINTF(Loggers(), 3, this, "Recv %s", l1->Text ()());
+      if (shmring)
+        shmring->Publish(EIBSHMRING_FRAME_BUSMONITOR, l1->pdu.array(), l1->pdu(),
+                         l1->timestamp);
+      for (i = 0; i < busmonitor(); i++)
+        {
+          l2 = new L_Busmonitor_PDU(*l1);
+          busmonitor[i].cb->Get_L_Busmonitor(l2);
+        }
+      for (i = 0; i < vbusmonitor(); i++)
+        {
+          l2 = new L_Busmonitor_PDU(*l1);
+          vbusmonitor[i].cb->Get_L_Busmonitor(l2);
+        }
+    }
+  if (l->getType() == L_Data)
+    {
+      L_Data_PDU *l1;
+      l1 = (L_Data_PDU *) l;
+      statistics.Frame(l1);
+      // encoded once, in the repeated form the ignore list compares
+      bool repeated = l1->repeated;
+      l1->repeated = 1;
+      CArray d = l1->ToPacket();
+      l1->repeated = 0;
+      if (repeated)
+        {
+          for (i = 0; i < ignore(); i++)
+            if (d == ignore[i].data)
+              {
+                WARNLOGSHAPE(Loggers(), LOG_WARNING,
+                    Logging::DUPLICATESMAX1PER10SEC, this,
+                    Logging::MSGNOHASH, "Repeated discarded");
+                delete l;
+                return;
+              }
+        }
+      ignore.resize(ignore() + 1);
+      ignore[ignore() - 1].data = d;
+      ignore[ignore() - 1].end = getTime() + 1000000;
+      if (shmring)
+        {
+          // clear the repeat flag: set bit 0x20 in the control field and
+          // flip the same bit of the XOR checksum
+          d[0] |= 0x20;
+          d[d() - 1] ^= 0x20;
+          shmring->Publish(EIBSHMRING_FRAME_LDATA, d.array(), d(), getTime());
+        }
+
+      if (l1->AddrType == IndividualAddress
+          && l1->dest == layer2->getDefaultAddr())
+        l1->dest = 0;
+      TRACEPRINTF(Loggers(), 3, this, "Recv %s", l1->Decode (buf, sizeof (buf)));
+
+      if (l1->AddrType == GroupAddress && l1->dest == 0)
+        {
+          for (i = 0; i < broadcast(); i++)
+            broadcast[i].cb->Get_L_Data(new L_Data_PDU(*l1));
+        }
+      if (l1->AddrType == GroupAddress && l1->dest != 0)
+        {
+          for (i = 0; i < group(); i++)
+            if (group[i].dest == l1->dest || group[i].dest == 0)
+              group[i].cb->Get_L_Data(new L_Data_PDU(*l1));
+        }
+      if (l1->AddrType == IndividualAddress)
+        {
+          for (i = 0; i < individual(); i++)
+            if (individual[i].dest == l1->dest)
+              if (individual[i].src == l1->source || individual[i].src == 0)
+                individual[i].cb->Get_L_Data(new L_Data_PDU(*l1));
+        }
+    }
+  delete l;
+}
+
+void
+Layer3::WaitReconnect (pth_event_t stop, timestamp_t delay)
+{
+  if (!delay)
+    {
+      // let the backend threads work on the open
+      pth_yield(NULL);
+      return;
+    }
+  TRACEPRINTF(Loggers(), 3, this, "reopen in %d ms", (int) (delay / 1000));
+  pth_event_t up = Connection_Wait_Until_Up();
+  pth_event_t timeout = pth_event(PTH_EVENT_RTIME,
+      pth_time(delay / 1000000, delay % 1000000));
+  pth_event_concat(up, timeout, stop, NULL);
+  pth_wait(up);
+  pth_event_isolate(stop);
+  pth_event_free(up, PTH_FREE_ALL);
+}
+
 void
 Layer3::Run (pth_sem_t * stop1)
 {
   pth_event_t stop = pth_event(PTH_EVENT_SEM, stop1);
 
-  unsigned i;
+  unsigned i, n;
   unsigned long lastlowerversion = unknownVersion;
+  LPDU *batch[LAYER3_BATCH];
 
   while (pth_event_status(stop) != PTH_STATUS_OCCURRED)
     {
-      LPDU *l = layer2->Get_L_Data(stop);
-      if (!l)
+      // before waiting for frames, a reopened link may stay quiet
+      if (!Connection_Lost() && lastlowerversion != Proxy().currentVersion())
+        {
+          TRACEPRINTF(Thread::Loggers(), 2, this,
+                            "got lower layer connection");
+          lastlowerversion = Proxy().currentVersion();
+          bumpVersion();
+          reconnect.Up();
+          TRACEPRINTF(Loggers(), 1, this, "transition to up state");
+        }
+      n = layer2->Get_L_Data_Batch(stop, batch, LAYER3_BATCH);
+      if (!n)
         {
           // connection upper layer lost
           if (Connection_Lost())
@@ -584,100 +739,34 @@ Layer3::Run (pth_sem_t * stop1)
                     StopAllClients(false);
                   lastlowerversion = Proxy().currentVersion();
                   bumpVersion();
+                  reconnect.Lost();
                   TRACEPRINTF(Loggers(), 1, this, "transition to down state");
                   // try to reopen
                 }
               layer2->Open();
+              if (Connection_Lost())
+                WaitReconnect(stop, reconnect.Next());
             }
-
-          pth_sleep(1); // need to give it a break and not retry too often
           continue;
         }
-      else
-        {
-          if (!Connection_Lost() && lastlowerversion != Proxy().currentVersion())
-            {
-              TRACEPRINTF(Thread::Loggers(), 2, this,
-                                "got lower layer connection");
-              lastlowerversion = Proxy().currentVersion();
-              bumpVersion();
-              TRACEPRINTF(Loggers(), 1, this, "transition to up state");
-            }
-        }
 
+      // a burst is delivered under one lock
       if (!TraceDataLockWait(&datalock))
-        break;
-
-      if (l->getType() == L_Busmonitor)
-        {
-          L_Busmonitor_PDU *l1, *l2;
-          l1 = (L_Busmonitor_PDU *) l;
-
-          TRACEPRINTF(Loggers(), 3, this, "Recv %s", l1->Decode ()());
-          for (i = 0; i < busmonitor(); i++)
-            {
-              l2 = new L_Busmonitor_PDU(*l1);
-              busmonitor[i].cb->Get_L_Busmonitor(l2);
-            }
-          for (i = 0; i < vbusmonitor(); i++)
-            {
-              l2 = new L_Busmonitor_PDU(*l1);
-              vbusmonitor[i].cb->Get_L_Busmonitor(l2);
-            }
-        }
-      if (l->getType() == L_Data)
         {
-          L_Data_PDU *l1;
-          l1 = (L_Data_PDU *) l;
-          if (l1->repeated)
-            {
-              CArray d1 = l1->ToPacket();
-              for (i = 0; i < ignore(); i++)
-                if (d1 == ignore[i].data)
-                  {
-                    WARNLOGSHAPE(Loggers(), LOG_WARNING,
-                        Logging::DUPLICATESMAX1PER10SEC, this,
-                        Logging::MSGNOHASH, "Repeated discarded");
-                    goto wt;
-                  }
-            }
-          l1->repeated = 1;
-          ignore.resize(ignore() + 1);
-          ignore[ignore() - 1].data = l1->ToPacket();
-          ignore[ignore() - 1].end = getTime() + 1000000;
-          l1->repeated = 0;
-
-          if (l1->AddrType == IndividualAddress
-              && l1->dest == layer2->getDefaultAddr())
-            l1->dest = 0;
-          TRACEPRINTF(Loggers(), 3, this, "Recv %s", l1->Decode ()());
-
-          if (l1->AddrType == GroupAddress && l1->dest == 0)
-            {
-              for (i = 0; i < broadcast(); i++)
-                broadcast[i].cb->Get_L_Data(new L_Data_PDU(*l1));
-            }
-          if (l1->AddrType == GroupAddress && l1->dest != 0)
-            {
-              for (i = 0; i < group(); i++)
-                if (group[i].dest == l1->dest || group[i].dest == 0)
-                  group[i].cb->Get_L_Data(new L_Data_PDU(*l1));
-            }
-          if (l1->AddrType == IndividualAddress)
-            {
-              for (i = 0; i < individual(); i++)
-                if (individual[i].dest == l1->dest)
-                  if (individual[i].src == l1->source || individual[i].src == 0)
-                    individual[i].cb->Get_L_Data(new L_Data_PDU(*l1));
-            }
+          for (i = 0; i < n; i++)
+            delete batch[i];
+          break;
         }
+
+      for (i = 0; i < n; i++)
+        Dispatch(batch[i]);
+
       redel: for (i = 0; i < ignore(); i++)
         if (ignore[i].end < getTime())
           {
             ignore.deletepart(i, 1);
             goto redel;
           }
-      wt: delete l;
 
       TraceDataLockRelease(&datalock);
     }
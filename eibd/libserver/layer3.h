@@ -21,8 +21,16 @@
 #define LAYER3_H
 
 #include "layer2.h"
+#include "sendqueue.h"
+#include "busstats.h"
+#include "reconnect.h"
 #include "ip/ipv4net.h"
 
+/** frames taken from layer 2 and delivered under one lock */
+#define LAYER3_BATCH 16
+
+class ShmRing;
+
 /** stores a registered busmonitor callback */
 typedef struct
 {
@@ -89,6 +97,14 @@ class Layer3:private Thread, public StateInterface, public ConnectionStateInterf
     Array < Group_Info > group;
     /** individual callbacks */
     Array < Individual_Info > individual;
+    /** shared memory ring for local consumers, optional */
+    ShmRing *shmring;
+    /** per origin queues in front of layer2 */
+    SendScheduler *scheduler;
+    /** telegram counters of all frames seen */
+    BusStatistics statistics;
+    /** paces reopening layer 2 after a link loss */
+    Reconnector reconnect;
 
   void Run (pth_sem_t * stop);
 public:
@@ -133,18 +149,36 @@ public:
      */
   bool deregisterIndividualCallBack (L_Data_CallBack * c, eibaddr_t src,
 				     eibaddr_t dest = 0);
-  /** sends a L_Data frame asynchronouse. returns true on success. */
-  bool send_L_Data (L_Data_PDU * l);
+  /** sends a L_Data frame asynchronouse. returns true on success.
+   * @param origin send queue of the sender, NULL for daemon internal frames */
+  bool send_L_Data (L_Data_PDU * l, SendOrigin * origin = NULL);
+
+  /** returns true, if no telegrams are waiting to be sent */
+  bool Send_Queue_Empty () { return scheduler->Empty () && layer2->Send_Queue_Empty (); }
+  /** scheduler, new send origins register with */
+  SendScheduler *Scheduler () { return scheduler; }
+  /** counters of the frames seen on the bus */
+  const BusStatistics & Statistics () const { return statistics; }
+
+  /** installs the shared memory ring all frames are published to, takes ownership */
+  bool setSharedRing (ShmRing * r);
+  /** shared memory ring or NULL */
+  ShmRing *SharedRing () const { return shmring; }
 
   const char *_str(void) const
     {
       return "Layer3";
     }
 
-  Element * _xml(Element *parent) const { if (layer2) { return layer2->_xml(parent); } return parent; };
+  Element * _xml(Element *parent) const;
   bool SendReset () { return true; };
 private:
   bool StopAllClients(bool hard);
+  /** delivers a frame received from layer 2 to the registered callbacks */
+  void Dispatch(LPDU * l);
+  /** waits delay microseconds for the next open attempt, returns early if
+   * layer 2 comes up or stop occurs */
+  void WaitReconnect(pth_event_t stop, timestamp_t delay);
   mutable pth_mutex_t datalock;
   bool TraceDataLockWait(pth_mutex_t *datalock);
   void TraceDataLockRelease(pth_mutex_t *datalock);
@@ -39,6 +39,8 @@ T_Broadcast::T_Broadcast (Layer3 * l3,
   TRACEPRINTF (Loggers(), 4, this, "OpenBroadcast %s", write_only ? "WO" : "RW");
   layer3 = l3;
   pth_sem_init (&sem);
+  flow = 0;
+  origin = 0;
   init_ok = false;
   if (!write_only)
     if (!layer3->registerBroadcastCallBack (this))
@@ -71,7 +73,10 @@ T_Broadcast::Get_L_Data (L_Data_PDU * l)
       c.data = t1->data;
       c.src = l->source;
 
-      Put_On_Queue_Or_Drop<BroadcastComm, BroadcastComm>(outqueue, c, &sem, false, outdropmsg);
+      if (flow)
+	flow->Put (outqueue, c, &sem);
+      else
+	Put_On_Queue_Or_Drop<BroadcastComm, BroadcastComm>(outqueue, c, &sem, false, outdropmsg);
 #if 0
       outqueue.put (c);
       pth_sem_inc (&sem, 0);
@@ -86,14 +91,14 @@ T_Broadcast::Send (const CArray & c)
 {
   T_DATA_XXX_REQ_PDU t;
   t.data = c;
-  String s = t.Decode ();
-  TRACEPRINTF (this->Loggers(), 4, this, "Send Broadcast %s", s ());
+  char buf[DECODE_BUFSIZE];
+  TRACEPRINTF (this->Loggers(), 4, this, "Send Broadcast %s", t.Decode (buf, sizeof (buf)));
   L_Data_PDU *l = new L_Data_PDU;
   l->source = 0;
   l->dest = 0;
   l->AddrType = GroupAddress;
   l->data = t.ToPacket ();
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 BroadcastComm *
@@ -131,6 +136,8 @@ T_Group::T_Group (Layer3 * l3, eibaddr_t group, int write_only, EIB_Priority pri
   groupaddr = group;
   sendprio = prio;
   pth_sem_init (&sem);
+  flow = 0;
+  origin = 0;
   init_ok = false;
   if (group == 0)
     {
@@ -156,6 +163,29 @@ bool T_Group::init ()
   return init_ok;
 }
 
+/** returns the APCI of an A_GroupValue_Response/Write APDU, 0 otherwise */
+static int
+groupValueAPCI (const CArray & apdu)
+{
+  if (apdu () < 2 || (apdu[0] & 0x03) != 0)
+    return 0;
+  switch (apdu[1] & 0xC0)
+    {
+    case 0x40:
+    case 0x80:
+      return apdu[1] & 0xC0;
+    }
+  return 0;
+}
+
+/* a T_Group only receives a single group address */
+bool
+GroupComm::Coalesce (const GroupComm & q, const GroupComm & el)
+{
+  int apci = groupValueAPCI (el.data);
+  return apci && groupValueAPCI (q.data) == apci;
+}
+
 void
 T_Group::Get_L_Data (L_Data_PDU * l)
 {
@@ -168,7 +198,10 @@ T_Group::Get_L_Data (L_Data_PDU * l)
       c.data = t1->data;
       c.src = l->source;
 
-      Put_On_Queue_Or_Drop<GroupComm,GroupComm>(outqueue, c, &sem, false, outdropmsg);
+      if (flow)
+	flow->Put (outqueue, c, &sem, GroupComm::Coalesce);
+      else
+	Put_On_Queue_Or_Drop<GroupComm,GroupComm>(outqueue, c, &sem, false, outdropmsg);
 #if 0
       outqueue.put (c);
       pth_sem_inc (&sem, 0);
@@ -183,8 +216,8 @@ T_Group::Send (const CArray & c)
 {
   T_DATA_XXX_REQ_PDU t;
   t.data = c;
-  String s = t.Decode ();
-  TRACEPRINTF (this->Loggers(), 4, this, "Send Group %s", s ());
+  char buf[DECODE_BUFSIZE];
+  TRACEPRINTF (this->Loggers(), 4, this, "Send Group %s", t.Decode (buf, sizeof (buf)));
   L_Data_PDU *l = new L_Data_PDU;
   l->source = 0;
   l->dest = groupaddr;
@@ -192,7 +225,7 @@ T_Group::Send (const CArray & c)
   l->prio = sendprio;
   l->data = t.ToPacket ();
   // printf("send with prio %d %s\n", (int) sendprio, s());
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 T_Group::~T_Group ()
@@ -235,6 +268,8 @@ T_TPDU::T_TPDU (Layer3 * l3,
   layer3 = l3;
   src = d;
   pth_sem_init (&sem);
+  flow = 0;
+  origin = 0;
   init_ok = false;
   if (!layer3->
       registerIndividualCallBack (this, Individual_Lock_None, 0, src))
@@ -258,7 +293,10 @@ T_TPDU::Get_L_Data (L_Data_PDU * l)
   t.data = l->data;
   t.addr = l->source;
 
-  Put_On_Queue_Or_Drop<TpduComm, TpduComm>(outqueue, t, &sem, false, outdropmsg);
+  if (flow)
+    flow->Put (outqueue, t, &sem);
+  else
+    Put_On_Queue_Or_Drop<TpduComm, TpduComm>(outqueue, t, &sem, false, outdropmsg);
 #if 0
   outqueue.put (t);
   pth_sem_inc (&sem, 0);
@@ -275,7 +313,7 @@ T_TPDU::Send (const TpduComm & c)
   l->dest = c.addr;
   l->AddrType = IndividualAddress;
   l->data = c.data;
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 T_TPDU::~T_TPDU ()
@@ -318,6 +356,8 @@ T_Individual::T_Individual (Layer3 * l3,
   layer3 = l3;
   dest = d;
   pth_sem_init (&sem);
+  flow = 0;
+  origin = 0;
   init_ok = false;
   if (!write_only)
     if (!layer3->
@@ -346,7 +386,10 @@ T_Individual::Get_L_Data (L_Data_PDU * l)
       T_DATA_XXX_REQ_PDU *t1 = (T_DATA_XXX_REQ_PDU *) t;
       c = t1->data;
 
-      Put_On_Queue_Or_Drop<CArray, CArray>(outqueue, c, &sem, false, outdropmsg);
+      if (flow)
+	flow->Put (outqueue, c, &sem);
+      else
+	Put_On_Queue_Or_Drop<CArray, CArray>(outqueue, c, &sem, false, outdropmsg);
 #if 0
       outqueue.put (c);
       pth_sem_inc (&sem, 0);
@@ -361,14 +404,14 @@ T_Individual::Send (const CArray & c)
 {
   T_DATA_XXX_REQ_PDU t;
   t.data = c;
-  String s = t.Decode ();
-  TRACEPRINTF (this->Loggers(), 4, this, "Send Individual %s", s ());
+  char buf[DECODE_BUFSIZE];
+  TRACEPRINTF (this->Loggers(), 4, this, "Send Individual %s", t.Decode (buf, sizeof (buf)));
   L_Data_PDU *l = new L_Data_PDU;
   l->source = 0;
   l->dest = dest;
   l->AddrType = IndividualAddress;
   l->data = t.ToPacket ();
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 T_Individual::~T_Individual ()
@@ -420,6 +463,7 @@ T_Connection::T_Connection (Layer3 * l3,
   recvno = 0;
   sendno = 0;
   mode = 0;
+  origin = 0;
   if (!layer3->
       registerIndividualCallBack (this, Individual_Lock_Connection, dest))
     {
@@ -505,7 +549,7 @@ T_Connection::SendConnect ()
   l->AddrType = IndividualAddress;
   l->data = p.ToPacket ();
   l->prio = PRIO_SYSTEM;
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 void
@@ -519,7 +563,7 @@ T_Connection::SendDisconnect ()
   l->AddrType = IndividualAddress;
   l->data = p.ToPacket ();
   l->prio = PRIO_SYSTEM;
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 void
@@ -533,7 +577,7 @@ T_Connection::SendAck (int serno)
   l->dest = dest;
   l->AddrType = IndividualAddress;
   l->data = p.ToPacket ();
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 void
@@ -548,7 +592,7 @@ T_Connection::SendData (int serno, const CArray & c)
   l->dest = dest;
   l->AddrType = IndividualAddress;
   l->data = p.ToPacket ();
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 /*
@@ -721,6 +765,8 @@ GroupSocket::GroupSocket (Layer3 * l3, Logs * tr,  int write_only,
   TRACEPRINTF (tr, 4, this, "OpenGroupSocket %s", write_only ? "WO" : "RW");
   layer3 = l3;
   pth_sem_init (&sem);
+  flow = 0;
+  origin = 0;
   init_ok = false;
   if (!write_only)
     if (!layer3->registerGroupCallBack (this, 0))
@@ -744,6 +790,13 @@ bool GroupSocket::init ()
   return init_ok;
 }
 
+bool
+GroupAPDU::Coalesce (const GroupAPDU & q, const GroupAPDU & el)
+{
+  int apci = groupValueAPCI (el.data);
+  return q.dst == el.dst && apci && groupValueAPCI (q.data) == apci;
+}
+
 void
 GroupSocket::Get_L_Data (L_Data_PDU * l)
 {
@@ -756,7 +809,10 @@ GroupSocket::Get_L_Data (L_Data_PDU * l)
       c.data = t1->data;
       c.src = l->source;
       c.dst = l->dest;
-      Put_On_Queue_Or_Drop<GroupAPDU, GroupAPDU>(outqueue, c, &sem, false, outdropmsg);
+      if (flow)
+	flow->Put (outqueue, c, &sem, GroupAPDU::Coalesce);
+      else
+	Put_On_Queue_Or_Drop<GroupAPDU, GroupAPDU>(outqueue, c, &sem, false, outdropmsg);
 
 #if 0
       outqueue.put (c);
@@ -772,14 +828,14 @@ GroupSocket::Send (const GroupAPDU & c)
 {
   T_DATA_XXX_REQ_PDU t;
   t.data = c.data;
-  String s = t.Decode ();
-  TRACEPRINTF (this->Loggers(), 4, this, "Send GroupSocket %s", s ());
+  char buf[DECODE_BUFSIZE];
+  TRACEPRINTF (this->Loggers(), 4, this, "Send GroupSocket %s", t.Decode (buf, sizeof (buf)));
   L_Data_PDU *l = new L_Data_PDU;
   l->source = 0;
   l->dest = c.dst;
   l->AddrType = GroupAddress;
   l->data = t.ToPacket ();
-  layer3->send_L_Data (l);
+  layer3->send_L_Data (l, origin);
 }
 
 GroupAPDU *
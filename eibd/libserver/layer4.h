@@ -21,6 +21,7 @@
 #define LAYER4_H
 
 #include "layer3.h"
+#include "flowcontrol.h"
 
 /** information about a broadcast packet */
 class BroadcastComm: public LoggableObjectInterface
@@ -40,6 +41,10 @@ public:
   CArray data;
   /** source address */
   eibaddr_t src;
+
+  /** returns true, if el supersedes the queued q on overflow: both are
+   * A_GroupValue_Write or both A_GroupValue_Response */
+  static bool Coalesce (const GroupComm & q, const GroupComm & el);
 };
 
 /** a raw layer 4 connection packet */
@@ -62,6 +67,10 @@ public:
   eibaddr_t src;
   /** destination address */
   eibaddr_t dst;
+
+  /** returns true, if el supersedes the queued q on overflow: same
+   * destination and both A_GroupValue_Write or both A_GroupValue_Response */
+  static bool Coalesce (const GroupAPDU & q, const GroupAPDU & el);
 } ;
 
 /** a class allowing carray to behave like loggable object */
@@ -79,6 +88,10 @@ class T_Broadcast:public L_Data_CallBack, public DroppableQueueInterface,  publi
     /** semaphore for output queue */
   pth_sem_t sem;
 
+  /** overflow handling of the client reading outqueue, NULL if none */
+  FlowControl *flow;
+  /** send queue of the client, NULL for daemon internal use */
+  SendOrigin *origin;
   bool init_ok;
   const static char outdropmsg[], indropmsg[];
 
@@ -88,6 +101,16 @@ public:
 	       int inquemaxlen, int outquemaxlen, int peerquemaxlen);
     virtual ~ T_Broadcast ();
   bool init ();
+  /** applies the overflow policy of a client to outqueue */
+  void setFlowControl (FlowControl * f)
+  {
+    flow = f;
+  }
+  /** queues frames sent by this object in the send queue of a client */
+  void setSendOrigin (SendOrigin * o)
+  {
+    origin = o;
+  }
 
   void Get_L_Data (L_Data_PDU * l);
 
@@ -107,6 +130,10 @@ class GroupSocket:public L_Data_CallBack, public DroppableQueueInterface,  publi
     /** semaphore for output queue */
   pth_sem_t sem;
 
+  /** overflow handling of the client reading outqueue, NULL if none */
+  FlowControl *flow;
+  /** send queue of the client, NULL for daemon internal use */
+  SendOrigin *origin;
   bool init_ok;
   const static char outdropmsg[], indropmsg[];
 
@@ -115,6 +142,16 @@ public:
 	       int inquemaxlen, int outquemaxlen, int peerquemaxlen);
   virtual ~ GroupSocket ();
   bool init();
+  /** applies the overflow policy of a client to outqueue */
+  void setFlowControl (FlowControl * f)
+  {
+    flow = f;
+  }
+  /** queues frames sent by this object in the send queue of a client */
+  void setSendOrigin (SendOrigin * o)
+  {
+    origin = o;
+  }
 
   void Get_L_Data (L_Data_PDU * l);
 
@@ -135,6 +172,10 @@ class T_Group:public L_Data_CallBack, public DroppableQueueInterface, public Log
   pth_sem_t sem;
   /** group address */
   eibaddr_t groupaddr;
+  /** overflow handling of the client reading outqueue, NULL if none */
+  FlowControl *flow;
+  /** send queue of the client, NULL for daemon internal use */
+  SendOrigin *origin;
   bool init_ok;
   EIB_Priority sendprio;
   const static char outdropmsg[], indropmsg[];
@@ -145,6 +186,16 @@ public:
 	   Logs * t, int inquemaxlen, int outquemaxlen, int peerquemaxlen);
     virtual ~ T_Group ();
   bool init ();
+  /** applies the overflow policy of a client to outqueue */
+  void setFlowControl (FlowControl * f)
+  {
+    flow = f;
+  }
+  /** queues frames sent by this object in the send queue of a client */
+  void setSendOrigin (SendOrigin * o)
+  {
+    origin = o;
+  }
 
   void Get_L_Data (L_Data_PDU * l);
 
@@ -166,6 +217,10 @@ class T_TPDU:public L_Data_CallBack, public DroppableQueueInterface,  public Log
   /** source address to use */
   eibaddr_t src;
 
+  /** overflow handling of the client reading outqueue, NULL if none */
+  FlowControl *flow;
+  /** send queue of the client, NULL for daemon internal use */
+  SendOrigin *origin;
   bool init_ok;
   const static char outdropmsg[], indropmsg[];
 
@@ -174,6 +229,16 @@ public:
 	   int inquemaxlen, int outquemaxlen, int peerquemaxlen);
   virtual ~ T_TPDU ();
   bool init();
+  /** applies the overflow policy of a client to outqueue */
+  void setFlowControl (FlowControl * f)
+  {
+    flow = f;
+  }
+  /** queues frames sent by this object in the send queue of a client */
+  void setSendOrigin (SendOrigin * o)
+  {
+    origin = o;
+  }
 
   void Get_L_Data (L_Data_PDU * l);
 
@@ -195,6 +260,10 @@ class T_Individual:public L_Data_CallBack, public DroppableQueueInterface,  publ
   /** destination address */
   eibaddr_t dest;
 
+  /** overflow handling of the client reading outqueue, NULL if none */
+  FlowControl *flow;
+  /** send queue of the client, NULL for daemon internal use */
+  SendOrigin *origin;
   bool init_ok;
   const static char outdropmsg[], indropmsg[];
 
@@ -205,6 +274,16 @@ public:
 		  int inquemaxlen, int outquemaxlen, int peerquemaxlen);
     virtual ~ T_Individual ();
   bool init ();
+  /** applies the overflow policy of a client to outqueue */
+  void setFlowControl (FlowControl * f)
+  {
+    flow = f;
+  }
+  /** queues frames sent by this object in the send queue of a client */
+  void setSendOrigin (SendOrigin * o)
+  {
+    origin = o;
+  }
 
   void Get_L_Data (L_Data_PDU * l);
 
@@ -241,6 +320,8 @@ class T_Connection:public L_Data_CallBack, private Thread, public DroppableQueue
     /** semaphore for output queue */
   pth_sem_t outsem;
   bool init_ok;
+  /** send queue of the client, NULL for daemon internal use */
+  SendOrigin *origin;
 
   /** sends T_Connect */
   void SendConnect ();
@@ -261,6 +342,11 @@ public:
 
   bool init ();
   void Get_L_Data (L_Data_PDU * l);
+  /** queues frames sent by this object in the send queue of a client */
+  void setSendOrigin (SendOrigin * o)
+  {
+    origin = o;
+  }
 
   /** receives APDU of a telegram; aborts with NULL if stop occurs */
   CArray *Get (pth_event_t stop);
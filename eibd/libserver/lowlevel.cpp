@@ -84,7 +84,7 @@ LowLevelDriverInterface::LowLevelDriverInterface(Logs *t,
     int maxpacketsoutpersecond,
     char *inqueuename ,
     char *outqueuename ) :
-DroppableQueueInterface(t), maxpktsoutpersec(maxpacketsoutpersecond),
+DroppableQueueInterface(t), pacer(maxpacketsoutpersecond),
 inqueue(inqueuename, inquemaxlen),
 outqueue(outqueuename, outquemaxlen),
 ConnectionStateInterface(t,NULL)
@@ -44,6 +44,7 @@
 
 #include "common.h"
 #include "classinterfaces.h"
+#include "pacer.h"
 
 typedef enum { vUnknown, vEMI1, vEMI2, vCEMI, vRaw } EMIVer;
 
@@ -55,7 +56,8 @@ class LowLevelDriverInterface : public DroppableQueueInterface, public ErrCounte
 {
 public:
 
-  int maxpktsoutpersec;
+  /** limits the frames sent to the interface */
+  Pacer pacer;
 
   LowLevelDriverInterface (Logs *t,
                            int flags,
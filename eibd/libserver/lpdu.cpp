@@ -21,28 +21,96 @@
 #include "lpdu.h"
 #include "tpdu.h"
 
-LPDU *
-LPDU::fromPacket (const CArray & c)
+String
+LPDU::Decode ()
+{
+  char buf[DECODE_BUFSIZE];
+  return Decode (buf, sizeof (buf));
+}
+
+const char *
+LPDU::Decode (char *buf, unsigned size)
+{
+  DecodeBuf b (buf, size);
+  DecodeTo (b);
+  return buf;
+}
+
+/** creates the LPDU on the heap */
+class LPDUCreator
+{
+  const CArray & c;
+public:
+  typedef LPDU *Result;
+  LPDUCreator (const CArray & c):c (c)
+  {
+  }
+  template < class T > LPDU *make ()
+  {
+    LPDU *l = new T ();
+    if (l->init (c))
+      return l;
+    delete l;
+    l = new L_Unknown_PDU ();
+    l->init (c);
+    return l;
+  }
+};
+
+/** decodes the LPDU with an object on the stack */
+class LPDUDecoder
+{
+  const CArray & c;
+  DecodeBuf & s;
+public:
+  typedef void Result;
+  LPDUDecoder (const CArray & c, DecodeBuf & s):c (c), s (s)
+  {
+  }
+  template < class T > void make ()
+  {
+    T l;
+    if (l.init (c))
+      {
+	l.DecodeTo (s);
+	return;
+      }
+    L_Unknown_PDU u;
+    u.init (c);
+    u.DecodeTo (s);
+  }
+};
+
+/** selects the LPDU class for c and passes it to f.make */
+template < class F > static typename F::Result
+dispatchLPDU (const CArray & c, F & f)
 {
-  LPDU *l = 0;
   if (c () >= 1)
     {
       if (c[0] == 0xCC)
-	l = new L_ACK_PDU ();
+	return f.template make < L_ACK_PDU > ();
       if (c[0] == 0xC0)
-	l = new L_BUSY_PDU ();
+	return f.template make < L_BUSY_PDU > ();
       if (c[0] == 0x0C)
-	l = new L_NACK_PDU ();
+	return f.template make < L_NACK_PDU > ();
       if ((c[0] & 0x53) == 0x10)
-	l = new L_Data_PDU ();
+	return f.template make < L_Data_PDU > ();
     }
-  if (l && l->init (c))
-    return l;
-  if (l)
-    delete l;
-  l = new L_Unknown_PDU ();
-  l->init (c);
-  return l;
+  return f.template make < L_Unknown_PDU > ();
+}
+
+LPDU *
+LPDU::fromPacket (const CArray & c)
+{
+  LPDUCreator f (c);
+  return dispatchLPDU (c, f);
+}
+
+void
+LPDU::DecodePacket (const CArray & c, DecodeBuf & s)
+{
+  LPDUDecoder f (c, s);
+  dispatchLPDU (c, f);
 }
 
 /* L_NACK */
@@ -66,9 +134,10 @@ CArray L_NACK_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String L_NACK_PDU::Decode ()
+void
+L_NACK_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "NACK";
+  s.add ("NACK");
 }
 
 /* L_ACK */
@@ -92,9 +161,10 @@ CArray L_ACK_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String L_ACK_PDU::Decode ()
+void
+L_ACK_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "ACK";
+  s.add ("ACK");
 }
 
 /* L_BUSY */
@@ -118,9 +188,10 @@ CArray L_BUSY_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String L_BUSY_PDU::Decode ()
+void
+L_BUSY_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "BUSY";
+  s.add ("BUSY");
 }
 
 /* L_Unknown  */
@@ -142,30 +213,88 @@ L_Unknown_PDU::ToPacket ()
   return pdu;
 }
 
-String
-L_Unknown_PDU::Decode ()
+void
+L_Unknown_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("Unknown LPDU: ");
   unsigned i;
 
   if (pdu () == 0)
-    return "empty LPDU";
+    {
+      s.add ("empty LPDU");
+      return;
+    }
+  s.add ("Unknown LPDU: ");
 
   for (i = 0; i < pdu (); i++)
-    addHex (s, pdu[i]);
-
-  return s;
+    s.addHex (pdu[i]);
 }
 
 /* L_Busmonitor  */
 
 L_Busmonitor_PDU::L_Busmonitor_PDU ()
 {
+  timestamp = getTime ();
+  status = 0;
+  text = 0;
+}
+
+L_Busmonitor_PDU::L_Busmonitor_PDU (const L_Busmonitor_PDU & p):LPDU (p)
+{
+  pdu = p.pdu;
+  timestamp = p.timestamp;
+  status = p.status;
+  if (!p.text)
+    p.text = new L_Busmonitor_Text;
+  text = p.text;
+  text->refs++;
+}
+
+L_Busmonitor_PDU::~L_Busmonitor_PDU ()
+{
+  releaseText ();
+}
+
+L_Busmonitor_PDU & L_Busmonitor_PDU::operator = (const L_Busmonitor_PDU & p)
+{
+  if (&p == this)
+    return *this;
+  releaseText ();
+  LPDU::operator = (p);
+  pdu = p.pdu;
+  timestamp = p.timestamp;
+  status = p.status;
+  if (!p.text)
+    p.text = new L_Busmonitor_Text;
+  text = p.text;
+  text->refs++;
+  return *this;
+}
+
+void
+L_Busmonitor_PDU::releaseText ()
+{
+  if (text && --text->refs == 0)
+    delete text;
+  text = 0;
+}
+
+const String &
+L_Busmonitor_PDU::Text () const
+{
+  if (!text)
+    text = new L_Busmonitor_Text;
+  if (!text->valid)
+    {
+      text->text = const_cast < L_Busmonitor_PDU * >(this)->Decode ();
+      text->valid = true;
+    }
+  return text->text;
 }
 
 bool
 L_Busmonitor_PDU::init (const CArray & c)
 {
+  releaseText ();
   pdu = c;
   return true;
 }
@@ -176,22 +305,22 @@ L_Busmonitor_PDU::ToPacket ()
   return pdu;
 }
 
-String
-L_Busmonitor_PDU::Decode ()
+void
+L_Busmonitor_PDU::DecodeTo (DecodeBuf & s)
 {
-  String s ("LPDU: ");
   unsigned i;
 
   if (pdu () == 0)
-    return "empty LPDU";
+    {
+      s.add ("empty LPDU");
+      return;
+    }
+  s.add ("LPDU: ");
 
   for (i = 0; i < pdu (); i++)
-    addHex (s, pdu[i]);
-  s += ":";
-  LPDU *l = LPDU::fromPacket (pdu);
-  s += l->Decode ();
-  delete l;
-  return s;
+    s.addHex (pdu[i]);
+  s.add (":");
+  LPDU::DecodePacket (pdu, s);
 }
 
 /* L_Data */
@@ -347,48 +476,45 @@ CArray L_Data_PDU::ToPacket ()
   return pdu;
 }
 
-String L_Data_PDU::Decode ()
+void
+L_Data_PDU::DecodeTo (DecodeBuf & s)
 {
   assert (data () >= 1);
   assert (data () <= 0xff);
   assert ((hopcount & 0xf8) == 0);
 
-  String
-  s ("L_Data");
+  s.add ("L_Data");
   if (!valid_length)
-    s += " (incomplete)";
+    s.add (" (incomplete)");
   if (repeated)
-    s += " (repeated)";
+    s.add (" (repeated)");
   switch (prio)
     {
     case PRIO_LOW:
-      s += " low";
+      s.add (" low");
       break;
     case PRIO_NORMAL:
-      s += " normal";
+      s.add (" normal");
       break;
     case PRIO_URGENT:
-      s += " urgent";
+      s.add (" urgent");
       break;
     case PRIO_SYSTEM:
-      s += " system";
+      s.add (" system");
       break;
     }
   if (!valid_checksum)
-    s += " INVALID CHECKSUM";
-  s =
-    s + " from " + FormatEIBAddr (source) + " to " + (AddrType ==
-						      GroupAddress ?
-						      FormatGroupAddr (dest) :
-						      FormatEIBAddr (dest));
-  s += " hops: ";
-  addHex (s, hopcount);
-  TPDU *
-    d = TPDU::fromPacket (data);
-  s += d->Decode ();
-  delete
-    d;
-  return s;
+    s.add (" INVALID CHECKSUM");
+  s.add (" from ");
+  s.addEIBAddr (source);
+  s.add (" to ");
+  if (AddrType == GroupAddress)
+    s.addGroupAddr (dest);
+  else
+    s.addEIBAddr (dest);
+  s.add (" hops: ");
+  s.addHex (hopcount);
+  TPDU::DecodePacket (data, s);
 }
 
 
@@ -58,12 +58,20 @@ public:
   virtual bool init (const CArray & c) = 0;
   /** convert to a character array */
   virtual CArray ToPacket () = 0;
+  /** append decoded content to s */
+  virtual void DecodeTo (DecodeBuf & s) = 0;
   /** decode content as string */
-  virtual String Decode () = 0;
+  String Decode ();
+  /** decode content into buf of size bytes without allocating
+   * @return buf */
+  const char *Decode (char *buf, unsigned size);
   /** get frame type */
   virtual LPDU_Type getType () const = 0;
   /** converts a character array to a Layer 2 frame */
   static LPDU *fromPacket (const CArray & c);
+  /** appends the decoded form of c to s, using LPDU/TPDU/APDU objects
+   * on the stack */
+  static void DecodePacket (const CArray & c, DecodeBuf & s);
 
   void *object;
 };
@@ -80,7 +88,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   LPDU_Type getType () const
   {
     return L_Unknown;
@@ -111,7 +119,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   LPDU_Type getType () const
   {
     return (valid_length ? L_Data : L_Data_Part);
@@ -120,17 +128,45 @@ public:
 
 /* L_Busmonitor */
 
+/** decoded text of a busmonitor frame, shared by all copies of the frame */
+class L_Busmonitor_Text
+{
+public:
+  String text;
+  bool valid;
+  int refs;
+
+  L_Busmonitor_Text ()
+  {
+    valid = false;
+    refs = 1;
+  }
+};
+
 class L_Busmonitor_PDU:public LPDU
 {
+  /** decoded text cache, shared with copies */
+  mutable L_Busmonitor_Text *text;
+  void releaseText ();
 public:
   /** content of the TP1 frame */
   CArray pdu;
+  /** receive time, taken when the backend read the frame */
+  timestamp_t timestamp;
+  /** bus status (EIB_BUSMONITOR_STATUS_*) */
+  uchar status;
 
   L_Busmonitor_PDU ();
+  /** copies share the text cache of the original */
+  L_Busmonitor_PDU (const L_Busmonitor_PDU & p);
+  ~L_Busmonitor_PDU ();
+  L_Busmonitor_PDU & operator = (const L_Busmonitor_PDU & p);
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
+  /** decoded frame, rendered at most once for this frame and all its copies */
+  const String & Text () const;
   LPDU_Type getType () const
   {
     return L_Busmonitor;
@@ -163,7 +199,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   LPDU_Type getType () const
   {
     return L_ACK;
@@ -178,7 +214,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   LPDU_Type getType () const
   {
     return L_NACK;
@@ -193,7 +229,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   LPDU_Type getType () const
   {
     return L_BUSY;
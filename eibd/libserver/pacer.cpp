@@ -0,0 +1,136 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "pacer.h"
+
+Pacer::Pacer (unsigned rate, unsigned burst)
+{
+  stat_bits = 0;
+  stat_maxwait = 0;
+  stat_totalwait = 0;
+  waitstart = 0;
+  ready = pth_event (PTH_EVENT_RTIME, pth_time (0, 0));
+  setRate (rate, burst);
+}
+
+Pacer::~Pacer ()
+{
+  pth_event_free (ready, PTH_FREE_THIS);
+}
+
+void
+Pacer::setRate (unsigned rate, unsigned burst)
+{
+  this->rate = rate;
+  if (!burst)
+    burst = rate / 10;
+  this->burst = burst ? burst : 1;
+  // start with a full bucket
+  tokens = Capacity ();
+  last = getTime ();
+}
+
+void
+Pacer::Refill ()
+{
+  timestamp_t now = getTime ();
+  timestamp_t elapsed = now - last;
+  last = now;
+  if (elapsed <= 0)
+    return;
+  // avoid the overflow after a long idle time, the bucket is full anyway
+  if (elapsed > 1000000LL * burst)
+    tokens = Capacity ();
+  else
+    tokens += elapsed * rate * PACER_STANDARD_BITS;
+  if (tokens > Capacity ())
+    tokens = Capacity ();
+}
+
+bool
+Pacer::Ready (unsigned len)
+{
+  if (!rate)
+    return true;
+  Refill ();
+  // a frame longer than the bucket may go, once the bucket is full
+  if (tokens >= (long long) PACER_BITS (len) * 1000000
+      || tokens >= Capacity ())
+    return true;
+  if (!waitstart)
+    waitstart = last;
+  return false;
+}
+
+void
+Pacer::Sent (unsigned len)
+{
+  ++stat_frames;
+  stat_bits += PACER_BITS (len);
+  if (waitstart)
+    {
+      timestamp_t w = getTime () - waitstart;
+      ++stat_delayed;
+      stat_totalwait += w;
+      if (w > stat_maxwait)
+	stat_maxwait = w;
+      waitstart = 0;
+    }
+  if (!rate)
+    return;
+  Refill ();
+  tokens -= (long long) PACER_BITS (len) * 1000000;
+}
+
+pth_event_t
+Pacer::Wait (unsigned len)
+{
+  long long d = 0;
+  if (rate)
+    {
+      Refill ();
+      long long need = (long long) PACER_BITS (len) * 1000000;
+      if (need > Capacity ())
+	need = Capacity ();
+      if (need > tokens)
+	{
+	  long long perus = (long long) rate * PACER_STANDARD_BITS;
+	  d = (need - tokens + perus - 1) / perus;
+	}
+    }
+  pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, ready,
+	     pth_time (d / 1000000, d % 1000000));
+  return ready;
+}
+
+Element *
+Pacer::_xml (Element * parent) const
+{
+  Element *p = parent->addElement (XMLPACERELEMENT);
+  p->addAttribute (XMLPACERRATEATTR, rate);
+  p->addAttribute (XMLPACERBURSTATTR, burst);
+  p->addAttribute (XMLPACERTOKENSATTR,
+		   (int) (tokens / (PACER_STANDARD_BITS * 10000LL)));
+  p->addAttribute (XMLPACERFRAMESATTR, *stat_frames);
+  p->addAttribute (XMLPACERBITSATTR, (long long) stat_bits);
+  p->addAttribute (XMLPACERDELAYEDATTR, *stat_delayed);
+  p->addAttribute (XMLPACERMAXWAITATTR, (long long) stat_maxwait);
+  p->addAttribute (XMLPACERTOTALWAITATTR, (long long) stat_totalwait);
+  return p;
+}
@@ -0,0 +1,89 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef PACER_H
+#define PACER_H
+
+#include "common.h"
+#include "stateinterface.h"
+
+/** bus time of a frame of len bytes on TP1 in bit times: 13 bit times per
+ * character, the pause before the acknowledge, the acknowledge and the
+ * minimal gap before the next frame */
+#define PACER_BITS(len) ((len) * 13 + 15 + 13 + 50)
+/** frame all rates are expressed in: a short group telegram of 9 bytes */
+#define PACER_STANDARD_BITS PACER_BITS(9)
+
+/** token bucket limiting frames sent to an interface. The bucket is
+ * refilled continuously (with microsecond resolution) at rate standard
+ * frames per second and holds at most burst standard frames. Each frame
+ * takes tokens in proportion to its bus time, so long frames count more
+ * than short ones. */
+class Pacer:public StateInterface
+{
+  /** standard frames per second, 0 for unlimited */
+  unsigned rate;
+  /** capacity in standard frames */
+  unsigned burst;
+  /** available bus time in bit times * 1000000 */
+  long long tokens;
+  /** time of the last refill */
+  timestamp_t last;
+  /** time a frame started to wait, 0 if none is waiting */
+  timestamp_t waitstart;
+  /** signals the next possible send */
+  pth_event_t ready;
+
+  UIntStatisticsCounter stat_frames;
+  UIntStatisticsCounter stat_delayed;
+  unsigned long long stat_bits;
+  timestamp_t stat_maxwait;
+  timestamp_t stat_totalwait;
+
+  void Refill ();
+  long long Capacity () const
+  {
+    return (long long) burst * PACER_STANDARD_BITS * 1000000;
+  }
+
+public:
+  /** @param rate standard frames per second, 0 for unlimited
+   * @param burst frames which may be sent back to back, 0 for rate / 10 */
+  Pacer (unsigned rate = 0, unsigned burst = 0);
+  virtual ~Pacer ();
+
+  /** changes rate and burst, see constructor */
+  void setRate (unsigned rate, unsigned burst = 0);
+  unsigned Rate () const
+  {
+    return rate;
+  }
+
+  /** returns true, if a frame of len bytes may be sent now */
+  bool Ready (unsigned len);
+  /** accounts a frame of len bytes, which has been sent */
+  void Sent (unsigned len);
+  /** returns an event, which occurs when a frame of len bytes may be sent;
+   * owned by the pacer, isolate it after use */
+  pth_event_t Wait (unsigned len);
+
+  Element *_xml (Element * parent) const;
+};
+
+#endif
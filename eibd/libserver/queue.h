@@ -155,7 +155,6 @@ void Unlock(void) const { pth_mutex_release(&lock); };
   int put (const T & el, const int _maxlen=0)
   {
     Lock();
-    Entry *elem = new Entry;
     int l= _maxlen ? _maxlen : this->maxlen;
     if (l!=0 && _len>l) {
 #if HAVE_QUEUESTATS
@@ -164,6 +163,7 @@ void Unlock(void) const { pth_mutex_release(&lock); };
       Unlock();
       return -1;
     }
+    Entry *elem = new Entry;
 
 #if HAVE_QUEUESTATS
     elem->timestamp = TimeVal(pth_timeout(0,0));
@@ -229,6 +229,59 @@ void Unlock(void) const { pth_mutex_release(&lock); };
     return _len;
   }
 
+  /** return true, if put would drop the next element */
+  bool full () const
+  {
+    return maxlen != 0 && _len > maxlen;
+  }
+
+  /** @brief removes the newest queued element matching el and appends el
+   *
+   * The other elements keep their order and el is queued behind all
+   * older elements, as if it had been put.
+   * @param same    returns true, if the queued element may be replaced by el
+   * @param el      new value
+   * @param old     if not NULL, receives the removed element
+   * @return true if an element has been replaced
+   */
+  bool replace (bool (*same) (const T &, const T &), const T & el,
+		T * old = NULL)
+  {
+    Lock();
+    Entry **match = NULL;
+    for (Entry **p = &akt; *p; p = &(*p)->Next)
+      if (same ((*p)->entry, el))
+	match = p;
+    if (!match)
+      {
+	Unlock();
+	return false;
+      }
+    Entry *e = *match;
+    if (old)
+      *old = e->entry;
+    if (e->Next)
+      {
+	/* unlink and move to the end */
+	*match = e->Next;
+	e->Next = 0;
+	*head = e;
+	head = &e->Next;
+      }
+    e->entry = el;
+#if HAVE_QUEUESTATS
+    e->timestamp = TimeVal(pth_timeout(0,0));
+#endif
+    Unlock();
+    return true;
+  }
+
+  /** returns the maximum length, 0 if unlimited */
+  int maxlength () const
+  {
+    return maxlen;
+  }
+
   /** assign queue name by assigning char */
   void operator=(const char *n)
   {
@@ -0,0 +1,101 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "reconnect.h"
+
+Reconnector::Reconnector ()
+{
+  lost = 0;
+  attempts = 0;
+  seed = getTime () ^ getpid ();
+  stat_losses = 0;
+  stat_recoveries = 0;
+  stat_last = 0;
+  stat_min = 0;
+  stat_max = 0;
+  stat_total = 0;
+}
+
+void
+Reconnector::Lost ()
+{
+  if (lost)
+    return;
+  lost = getTime ();
+  if (!lost)
+    lost = 1;
+  attempts = 0;
+  stat_losses++;
+}
+
+void
+Reconnector::Up ()
+{
+  if (!lost)
+    return;
+  timestamp_t t = getTime () - lost;
+  lost = 0;
+  attempts = 0;
+  if (t < 0)
+    t = 0;
+  stat_last = t;
+  if (!stat_recoveries || t < stat_min)
+    stat_min = t;
+  if (t > stat_max)
+    stat_max = t;
+  stat_total += t;
+  stat_recoveries++;
+}
+
+timestamp_t
+Reconnector::Next ()
+{
+  attempts++;
+  if (attempts <= RECONNECT_IMMEDIATE)
+    return 0;
+  unsigned shift = attempts - RECONNECT_IMMEDIATE - 1;
+  timestamp_t delay = RECONNECT_MAXDELAY;
+  if (shift < 16 && ((timestamp_t) RECONNECT_MINDELAY << shift) < delay)
+    delay = (timestamp_t) RECONNECT_MINDELAY << shift;
+  return delay / 2 + rand_r (&seed) % (delay / 2 + 1);
+}
+
+Element *
+Reconnector::_xml (Element * parent) const
+{
+  Element *a = parent->addElement (XMLRECONNECTELEMENT);
+  a->addAttribute (XMLRECONNECTLOSSESATTR, (int) stat_losses);
+  a->addAttribute (XMLRECONNECTRECOVERIESATTR, (int) stat_recoveries);
+  if (lost)
+    {
+      a->addAttribute (XMLRECONNECTATTEMPTSATTR, (int) attempts);
+      a->addAttribute (XMLRECONNECTDOWNATTR, (int) ((getTime () - lost) / 1000));
+    }
+  if (stat_recoveries)
+    {
+      a->addAttribute (XMLRECONNECTLASTATTR, (int) (stat_last / 1000));
+      a->addAttribute (XMLRECONNECTMINATTR, (int) (stat_min / 1000));
+      a->addAttribute (XMLRECONNECTMAXATTR, (int) (stat_max / 1000));
+      a->addAttribute (XMLRECONNECTMEANATTR,
+		       (int) (stat_total / stat_recoveries / 1000));
+    }
+  return a;
+}
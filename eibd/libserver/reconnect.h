@@ -0,0 +1,72 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef RECONNECT_H
+#define RECONNECT_H
+
+#include "common.h"
+#include "stateinterface.h"
+
+/** open attempts without delay after the link was lost */
+#define RECONNECT_IMMEDIATE 2
+/** delay before the first delayed attempt in microseconds */
+#define RECONNECT_MINDELAY 50000
+/** longest delay between attempts in microseconds */
+#define RECONNECT_MAXDELAY 8000000
+
+/** paces the attempts to reopen a lost layer 2 link and measures the
+ * time to recovery. The first attempts are made at once, then the delay
+ * doubles up to RECONNECT_MAXDELAY; each delay is drawn from its upper
+ * half so that several daemons do not retry in lock step. */
+class Reconnector:public StateInterface
+{
+  /** time the link was lost, 0 while it is up */
+  timestamp_t lost;
+  /** attempts since the link was lost */
+  unsigned attempts;
+  /** state of the jitter generator */
+  unsigned seed;
+
+  uint32_t stat_losses;
+  uint32_t stat_recoveries;
+  timestamp_t stat_last;
+  timestamp_t stat_min;
+  timestamp_t stat_max;
+  timestamp_t stat_total;
+
+public:
+  Reconnector ();
+
+  /** the link has been lost, starts the recovery timer */
+  void Lost ();
+  /** the link is up again, records the time to recovery */
+  void Up ();
+  /** returns true, while the link is lost */
+  bool Down () const
+  {
+    return lost != 0;
+  }
+  /** counts an open attempt and returns the delay in microseconds before
+   * the next one, 0 to retry at once */
+  timestamp_t Next ();
+
+  Element *_xml (Element * parent) const;
+};
+
+#endif
@@ -0,0 +1,339 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sendqueue.h"
+
+/** bus time of a L_Data frame in bit times */
+#define FRAME_BITS(l) PACER_BITS ((l)->data () + 7)
+
+/** returns true, if l is an A_GroupValue_Write */
+static inline bool
+isGroupWrite (const L_Data_PDU * l)
+{
+  return l->AddrType == GroupAddress && l->data () >= 2
+    && l->data[0] == 0 && (l->data[1] & 0xC0) == 0x80;
+}
+
+SendOrigin::SendOrigin (SendScheduler * s, const char *name, unsigned weight)
+{
+  sched = s;
+  this->name = name;
+  this->weight = weight ? weight : 1;
+  deficit = 0;
+  stat_maxdepth = 0;
+  stat_maxwait = 0;
+  stat_totalwait = 0;
+  if (sched)
+    sched->Register (this);
+}
+
+SendOrigin::~SendOrigin ()
+{
+  if (sched)
+    sched->Deregister (this);
+  while (!queue.empty ())
+    {
+      delete queue.front ().l;
+      queue.pop_front ();
+    }
+}
+
+Element *
+SendOrigin::_xml (Element * parent) const
+{
+  Element *n = parent->addElement (XMLSENDQUEUEELEMENT);
+  n->addAttribute (XMLSENDQUEUENAMEATTR, name ());
+  n->addAttribute (XMLSENDQUEUEWEIGHTATTR, weight);
+  n->addAttribute (XMLSENDQUEUEDEPTHATTR, (unsigned) queue.size ());
+  n->addAttribute (XMLSENDQUEUEMAXDEPTHATTR, stat_maxdepth);
+  n->addAttribute (XMLSENDQUEUESENTATTR, *stat_sent);
+  n->addAttribute (XMLSENDQUEUEDROPPEDATTR, *stat_dropped);
+  if (*stat_superseded)
+    n->addAttribute (XMLSENDQUEUESUPERSEDEDATTR, *stat_superseded);
+  n->addAttribute (XMLSENDQUEUEMAXWAITATTR, (long long) stat_maxwait);
+  n->addAttribute (XMLSENDQUEUEMEANWAITATTR,
+		   (long long) (*stat_sent ? stat_totalwait / *stat_sent : 0));
+  return n;
+}
+
+SendScheduler::SendScheduler (Layer2Interface * l2, Logs * tr):
+Thread (tr, PTH_PRIO_STD, "SendScheduler")
+{
+  layer2 = l2;
+  current = 0;
+  inturn = false;
+  compact = false;
+  pth_sem_init (&pending);
+  poll = pth_event (PTH_EVENT_RTIME, pth_time (0, 0));
+  internal = new SendOrigin (this, "internal");
+  Start ();
+}
+
+SendScheduler::~SendScheduler ()
+{
+  Stop ();
+  delete internal;
+  // origins still alive send directly from now on
+  for (unsigned i = 0; i < origins (); i++)
+    origins[i]->sched = NULL;
+  pth_event_free (poll, PTH_FREE_THIS);
+}
+
+void
+SendScheduler::Register (SendOrigin * o)
+{
+  origins.resize (origins () + 1);
+  origins[origins () - 1] = o;
+}
+
+void
+SendScheduler::Deregister (SendOrigin * o)
+{
+  for (unsigned i = 0; i < origins (); i++)
+    if (origins[i] == o)
+      {
+	if (o != internal)
+	  {
+	    // frames already accepted are still sent, in their order
+	    while (!o->queue.empty ())
+	      {
+		internal->queue.push_back (o->queue.front ());
+		o->queue.pop_front ();
+	      }
+	    if (internal->queue.size () > internal->stat_maxdepth)
+	      internal->stat_maxdepth = internal->queue.size ();
+	  }
+	else
+	  for (unsigned j = 0; j < o->queue.size (); j++)
+	    pth_sem_dec (&pending);
+	origins.deletepart (i, 1);
+	if (current > i || (current == i && inturn))
+	  {
+	    // the visit of the removed origin ends here
+	    if (current == i)
+	      inturn = false;
+	    else
+	      current--;
+	  }
+	if (current >= origins ())
+	  current = 0;
+	return;
+      }
+}
+
+bool
+SendScheduler::Send (L_Data_PDU * l, SendOrigin * o)
+{
+  if (!o)
+    o = internal;
+  if (!o->sched)
+    return layer2->Send_L_Data (l);
+  if (compact && isGroupWrite (l))
+    for (std::deque < SendOrigin::Frame >::iterator i = o->queue.end ();
+	 i != o->queue.begin ();)
+      {
+	i--;
+	if (i->l->AddrType != GroupAddress || i->l->dest != l->dest)
+	  continue;
+	// a read or response in between must see the old value first
+	if (!isGroupWrite (i->l) || i->l->source != l->source)
+	  break;
+	// only the latest value matters; it may take the place of the old
+	// one only if nothing was queued after it
+	++o->stat_superseded;
+	++stat_superseded;
+	delete i->l;
+	if (i + 1 == o->queue.end ())
+	  {
+	    i->l = l;
+	    return true;
+	  }
+	o->queue.erase (i);
+	SendOrigin::Frame f;
+	f.l = l;
+	f.queued = getTime ();
+	o->queue.push_back (f);
+	return true;
+      }
+  if (o->queue.size () >= SENDQUEUE_MAXLEN)
+    {
+      ++o->stat_dropped;
+      WARNLOGSHAPE (Loggers (), LOG_WARNING, Logging::DUPLICATESMAX1PER10SEC,
+		    this, Logging::MSGNOHASH,
+		    "send queue of %s full, dropping frame", o->name ());
+      delete l;
+      return false;
+    }
+  SendOrigin::Frame f;
+  f.l = l;
+  f.queued = getTime ();
+  o->queue.push_back (f);
+  if (o->queue.size () > o->stat_maxdepth)
+    o->stat_maxdepth = o->queue.size ();
+  pth_sem_inc (&pending, FALSE);
+  return true;
+}
+
+bool
+SendScheduler::Empty ()
+{
+  unsigned v;
+  pth_sem_get_value (&pending, &v);
+  return v == 0;
+}
+
+void
+SendScheduler::setInternalWeight (unsigned w)
+{
+  internal->setWeight (w);
+}
+
+L_Data_PDU *
+SendScheduler::Next ()
+{
+  if (Empty () || !origins ())
+    return NULL;
+  for (;;)
+    {
+      if (current >= origins ())
+	current = 0;
+      SendOrigin *o = origins[current];
+      if (o->queue.empty ())
+	{
+	  // an idle origin must not save up credit
+	  o->deficit = 0;
+	  current++;
+	  inturn = false;
+	  continue;
+	}
+      if (!inturn)
+	{
+	  o->deficit += o->weight * PACER_STANDARD_BITS;
+	  inturn = true;
+	}
+      SendOrigin::Frame & f = o->queue.front ();
+      long cost = FRAME_BITS (f.l);
+      if (o->deficit < cost)
+	{
+	  current++;
+	  inturn = false;
+	  continue;
+	}
+      o->deficit -= cost;
+      L_Data_PDU *l = f.l;
+      timestamp_t w = getTime () - f.queued;
+      o->queue.pop_front ();
+      pth_sem_dec (&pending);
+      ++o->stat_sent;
+      o->stat_totalwait += w;
+      if (w > o->stat_maxwait)
+	o->stat_maxwait = w;
+      return l;
+    }
+}
+
+void
+SendScheduler::Run (pth_sem_t * stop1)
+{
+  pth_event_t stop = pth_event (PTH_EVENT_SEM, stop1);
+  pth_event_t input = pth_event (PTH_EVENT_SEM, &pending);
+  while (pth_event_status (stop) != PTH_STATUS_OCCURRED)
+    {
+      if (Empty ())
+	{
+	  pth_event_concat (stop, input, NULL);
+	  pth_wait (stop);
+	  pth_event_isolate (input);
+	  continue;
+	}
+      // the backend queue is plain FIFO, only fill it while it is idle
+      if (!layer2->Send_Queue_Empty ())
+	{
+	  pth_sem_t *cond = layer2->Send_Queue_Empty_Cond ();
+	  if (cond)
+	    pth_event (PTH_EVENT_SEM | PTH_MODE_REUSE, poll, cond);
+	  else
+	    pth_event (PTH_EVENT_RTIME | PTH_MODE_REUSE, poll,
+		       pth_time (0, SENDQUEUE_POLL));
+	  pth_event_concat (stop, poll, NULL);
+	  pth_wait (stop);
+	  pth_event_isolate (poll);
+	  continue;
+	}
+      LPDU *batch[SENDQUEUE_BATCH];
+      unsigned n = 0;
+      while (n < SENDQUEUE_BATCH && (batch[n] = Next ()))
+	n++;
+      // the backend owns the frames now, also the refused ones
+      unsigned sent = layer2->Send_L_Data_Batch (batch, n);
+      if (sent < n)
+	TRACEPRINTF (Loggers (), 3, this, "backend refused %d frames",
+		     n - sent);
+    }
+  pth_event_free (stop, PTH_FREE_THIS);
+  pth_event_free (input, PTH_FREE_THIS);
+}
+
+bool
+SendScheduler::ParseWeights (const char *list, SendWeights & w)
+{
+  while (*list)
+    {
+      const char *eq = strchr (list, '=');
+      if (!eq)
+	return false;
+      char *end;
+      unsigned long v = strtoul (eq + 1, &end, 10);
+      if (end == eq + 1 || v == 0 || (*end && *end != ','))
+	return false;
+      size_t len = eq - list;
+      if (len == 5 && !strncmp (list, "local", len))
+	w.local = v;
+      else if (len == 4 && !strncmp (list, "inet", len))
+	w.inet = v;
+      else if (len == 6 && !strncmp (list, "eibnet", len))
+	w.eibnet = v;
+      else if (len == 8 && !strncmp (list, "internal", len))
+	w.internal = v;
+      else
+	return false;
+      list = *end ? end + 1 : end;
+    }
+  return true;
+}
+
+Element *
+SendScheduler::_xml (Element * parent) const
+{
+  unsigned v;
+  pth_sem_get_value (const_cast < pth_sem_t * >(&pending), &v);
+  Element *n = parent->addElement (XMLSENDQUEUESELEMENT);
+  n->addAttribute (XMLSENDQUEUESORIGINSATTR, (unsigned) origins ());
+  n->addAttribute (XMLSENDQUEUESPENDINGATTR, v);
+  if (compact)
+    {
+      n->addAttribute (XMLSENDQUEUESCOMPACTATTR, "yes");
+      n->addAttribute (XMLSENDQUEUESUPERSEDEDATTR, *stat_superseded);
+    }
+  for (unsigned i = 0; i < origins (); i++)
+    origins[i]->_xml (n);
+  return n;
+}
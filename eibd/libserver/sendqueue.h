@@ -0,0 +1,158 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <deque>
+#include "layer2.h"
+
+/** frames one origin may have queued before new ones are dropped */
+#define SENDQUEUE_MAXLEN 256
+/** frames handed to an idle bus interface at once */
+#define SENDQUEUE_BATCH 4
+/** how often a busy bus interface without Send_Queue_Empty_Cond is
+ * polled for room, in microseconds */
+#define SENDQUEUE_POLL 5000
+
+class SendScheduler;
+
+/** weights of the origin kinds, see SendScheduler::ParseWeights */
+typedef struct
+{
+  unsigned local;
+  unsigned inet;
+  unsigned eibnet;
+  unsigned internal;
+} SendWeights;
+
+/** send queue of one origin of frames: a client connection, an EIBnet/IP
+ * tunnel or routing. Registers itself with the scheduler while it exists;
+ * frames still queued on destruction are sent as daemon internal ones. */
+class SendOrigin
+{
+  friend class SendScheduler;
+
+  typedef struct
+  {
+    L_Data_PDU *l;
+    timestamp_t queued;
+  } Frame;
+
+  SendScheduler *sched;
+  String name;
+  unsigned weight;
+  /** bus time (in bit times) this origin may still send in its turn */
+  long deficit;
+  std::deque < Frame > queue;
+
+  UIntStatisticsCounter stat_sent;
+  UIntStatisticsCounter stat_dropped;
+  UIntStatisticsCounter stat_superseded;
+  unsigned stat_maxdepth;
+  timestamp_t stat_maxwait;
+  timestamp_t stat_totalwait;
+
+public:
+  /** @param s scheduler, may be NULL (frames are then sent unscheduled)
+   * @param name kind and peer, for the state output
+   * @param weight share of the bus relative to other origins, at least 1 */
+  SendOrigin (SendScheduler * s, const char *name, unsigned weight = 1);
+  ~SendOrigin ();
+
+  void setWeight (unsigned w)
+  {
+    weight = w ? w : 1;
+  }
+  void setName (const char *n)
+  {
+    name = n;
+  }
+  unsigned Depth () const
+  {
+    return queue.size ();
+  }
+
+  Element *_xml (Element * parent) const;
+};
+
+/** queues frames per origin in front of the bus interface and hands them
+ * over a few at a time in deficit round robin order, so that one client
+ * sending bulk traffic cannot delay the frames of the others by more than
+ * one round. A frame costs its bus time, each turn adds weight standard
+ * frames to the deficit of an origin. */
+class SendScheduler:private Thread, public StateInterface
+{
+  Layer2Interface *layer2;
+  /** registered origins, visited in order */
+  Array < SendOrigin * >origins;
+  /** origin of frames without one (daemon internal) */
+  SendOrigin *internal;
+  /** origin currently visited */
+  unsigned current;
+  /** the current origin has already got its quantum */
+  bool inturn;
+  /** frames queued over all origins */
+  pth_sem_t pending;
+  /** waits for the bus interface while it is busy */
+  pth_event_t poll;
+  /** replace queued group writes by newer ones */
+  bool compact;
+  UIntStatisticsCounter stat_superseded;
+
+  L_Data_PDU *Next ();
+  void Run (pth_sem_t * stop);
+
+public:
+  SendScheduler (Layer2Interface * l2, Logs * tr);
+  virtual ~SendScheduler ();
+
+  void Register (SendOrigin * o);
+  void Deregister (SendOrigin * o);
+
+  /** queues l for origin o (NULL for daemon internal frames)
+   * @return false, if the queue of o is full and l has been dropped */
+  bool Send (L_Data_PDU * l, SendOrigin * o);
+  /** returns true, if no frame is queued */
+  bool Empty ();
+  /** sets the weight of daemon internal frames */
+  void setInternalWeight (unsigned w);
+  /** if enabled, an A_GroupValue_Write replaces the newest still queued
+   * write of the same origin and source to the same group address, unless
+   * another frame to that address is queued after it. The new value keeps
+   * the old position only if nothing was queued behind it, else it is
+   * queued at the end, so frames to other addresses keep their order */
+  void setCompaction (bool on)
+  {
+    compact = on;
+  }
+
+  /** parses a list kind=weight[,kind=weight...] with kind one of local,
+   * inet, eibnet or internal; unlisted kinds keep their value
+   * @return false on syntax errors */
+  static bool ParseWeights (const char *list, SendWeights & w);
+
+  const char *_str (void) const
+  {
+    return "send queues";
+  }
+  Element *_xml (Element * parent) const;
+};
+
+#endif
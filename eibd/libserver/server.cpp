@@ -81,6 +81,8 @@ Server::Server (Layer3 * layer3,
   this->outqueuemaxlen = outquemaxlen;
   this->peerqueuemaxlen = peerqueuemaxlen;
   this->clientsmax = clientsmax;
+  this->overflowpolicy = OVERFLOW_DROP_NEWEST;
+  this->sendweight = 1;
   pth_mutex_init (&this->lock);
   fd = -1;
 }
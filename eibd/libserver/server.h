@@ -24,6 +24,7 @@
 #include "layer3.h"
 #include "state.h"
 #include "ip/ipv4net.h"
+#include "flowcontrol.h"
 
 class ClientConnection;
 /** implements the frontend (but opens no connection) */
@@ -56,6 +57,8 @@ class Server:protected Thread, public StateInterface
   int  inqueuemaxlen;
 
   int  clientsmax;  //< maximum concurrent clients, 0 means anything goes
+  OverflowPolicy overflowpolicy; //< initial overflow policy of new clients
+  unsigned sendweight; //< share of the bus of each client, see SendScheduler
 protected:
     /** server socket */
   int fd;
@@ -79,6 +82,14 @@ public:
   int  maxInQueueLength(void) { return inqueuemaxlen; }
   int  maxOutQueueLength(void) { return outqueuemaxlen; }
   int  maxPeerQueueLength(void) { return peerqueuemaxlen; }
+  OverflowPolicy overflowPolicy(void) { return overflowpolicy; }
+  /** sets the overflow policy for clients connecting from now on */
+  void setOverflowPolicy(OverflowPolicy p) { overflowpolicy = p; }
+  unsigned sendWeight(void) { return sendweight; }
+  /** name of the server, for the state output of its clients */
+  const char *Name(void) const { return _str(); }
+  /** sets the send weight for clients connecting from now on */
+  void setSendWeight(unsigned w) { sendweight = w; }
 
   virtual Element *_xml(Element *parent);
 
@@ -0,0 +1,268 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include "shmring.h"
+#include "client.h"
+
+/** creates an anonymous shared memory file of size bytes
+ * @param rofd if not NULL, returns a read-only descriptor of the file
+ * @return read-write descriptor, -1 on error */
+static int
+createSharedFile (size_t size, int *rofd)
+{
+  int fd;
+  char name[40];
+#ifdef SYS_memfd_create
+  fd = syscall (SYS_memfd_create, "eibd-ring", 0);
+  if (fd != -1)
+    {
+      snprintf (name, sizeof (name), "/proc/self/fd/%d", fd);
+      if (rofd && (*rofd = open (name, O_RDONLY)) == -1)
+	{
+	  close (fd);
+	  return -1;
+	}
+    }
+  else
+#endif
+    {
+      strcpy (name, "/dev/shm/eibd-ringXXXXXX");
+      fd = mkstemp (name);
+      if (fd == -1)
+	return -1;
+      if (rofd && (*rofd = open (name, O_RDONLY)) == -1)
+	{
+	  unlink (name);
+	  close (fd);
+	  return -1;
+	}
+      unlink (name);
+    }
+  if (ftruncate (fd, size) == -1)
+    {
+      if (rofd)
+	close (*rofd);
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
+
+ShmRing::ShmRing (Logs * tr, unsigned slots)
+{
+  int i;
+  unsigned n = 1;
+
+  t = tr;
+  hdr = NULL;
+  slot = NULL;
+  for (i = 0; i < EIBSHMRING_MAXCONSUMERS; i++)
+    {
+      evfd[i] = -1;
+      ctlfd[i] = -1;
+      ctl[i] = NULL;
+    }
+  ctlsize = sysconf (_SC_PAGESIZE);
+  if (ctlsize < sizeof (EIBShmRingConsumer))
+    ctlsize = sizeof (EIBShmRingConsumer);
+
+  while (n < slots)
+    n <<= 1;
+  mask = n - 1;
+  mapsize = sizeof (EIBShmRingHeader) + n * sizeof (EIBShmRingSlot);
+
+  memfd = createSharedFile (mapsize, &rofd);
+  if (memfd == -1)
+    {
+      ERRORLOGSHAPE (t, LOG_CRIT, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+                  "Shared Ring memory allocation failed");
+      throw Exception (DEV_OPEN_FAIL);
+    }
+  void *m = mmap (NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+  if (m == MAP_FAILED)
+    {
+      close (rofd);
+      close (memfd);
+      ERRORLOGSHAPE (t, LOG_CRIT, Logging::DUPLICATESMAX1PER10SEC, this, Logging::MSGNOHASH,
+                  "Shared Ring mapping failed");
+      throw Exception (DEV_OPEN_FAIL);
+    }
+  memset (m, 0, mapsize);
+  hdr = (EIBShmRingHeader *) m;
+  slot = (EIBShmRingSlot *) (hdr + 1);
+  hdr->slots = n;
+  hdr->slotsize = sizeof (EIBShmRingSlot);
+  hdr->version = EIBSHMRING_VERSION;
+  __sync_synchronize ();
+  hdr->magic = EIBSHMRING_MAGIC;
+
+  TRACEPRINTF (t, 2, this, "Shared Ring with %d slots (%d bytes) created", n, (int) mapsize);
+}
+
+ShmRing::~ShmRing ()
+{
+  int i;
+  TRACEPRINTF (t, 2, this, "Destroy");
+  for (i = 0; i < EIBSHMRING_MAXCONSUMERS; i++)
+    if (evfd[i] != -1)
+      freeConsumer (i);
+  munmap (hdr, mapsize);
+  close (rofd);
+  close (memfd);
+}
+
+void
+ShmRing::Publish (uchar type, const uchar * data, unsigned len, timestamp_t ts)
+{
+  int i;
+  uint32_t seq = hdr->head;
+  EIBShmRingSlot *s = &slot[seq & mask];
+
+  if (len > EIBSHMRING_SLOTDATA)
+    {
+      len = EIBSHMRING_SLOTDATA;
+      ++stat_truncated;
+    }
+
+  s->lock++;
+  __sync_synchronize ();
+  s->seq = seq;
+  s->timestamp = ts;
+  s->len = len;
+  s->type = type;
+  memcpy (s->data, data, len);
+  __sync_synchronize ();
+  s->lock++;
+  hdr->head = seq + 1;
+  // pairs with the barrier between setting waiting and re-reading head in the consumer
+  __sync_synchronize ();
+  ++stat_frames;
+
+  for (i = 0; i < EIBSHMRING_MAXCONSUMERS; i++)
+    if (evfd[i] != -1 && ctl[i]->waiting)
+      {
+        uint64_t one = 1;
+        ctl[i]->waiting = 0;
+        if (write (evfd[i], &one, sizeof (one)) == sizeof (one))
+          ++stat_wakeups;
+      }
+}
+
+int
+ShmRing::allocConsumer ()
+{
+  int i;
+  for (i = 0; i < EIBSHMRING_MAXCONSUMERS; i++)
+    if (evfd[i] == -1)
+      {
+        ctlfd[i] = createSharedFile (ctlsize, NULL);
+        if (ctlfd[i] == -1)
+          return -1;
+        void *m = mmap (NULL, ctlsize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        ctlfd[i], 0);
+        if (m == MAP_FAILED)
+          {
+            close (ctlfd[i]);
+            ctlfd[i] = -1;
+            return -1;
+          }
+        evfd[i] = eventfd (0, EFD_NONBLOCK);
+        if (evfd[i] == -1)
+          {
+            munmap (m, ctlsize);
+            close (ctlfd[i]);
+            ctlfd[i] = -1;
+            return -1;
+          }
+        ctl[i] = (EIBShmRingConsumer *) m;
+        ctl[i]->waiting = 0;
+        ctl[i]->inuse = 1;
+        return i;
+      }
+  return -1;
+}
+
+void
+ShmRing::freeConsumer (int no)
+{
+  munmap (ctl[no], ctlsize);
+  ctl[no] = NULL;
+  close (ctlfd[no]);
+  ctlfd[no] = -1;
+  close (evfd[no]);
+  evfd[no] = -1;
+}
+
+void
+ShmRing::Request (ClientConnection * c, pth_event_t stop)
+{
+  uchar buf[4];
+  int fds[3];
+  int no = allocConsumer ();
+
+  if (no == -1)
+    {
+      c->sendreject (stop, EIB_CONNECTION_INUSE);
+      return;
+    }
+  EIBSETTYPE (buf, EIB_OPEN_SHM_RING);
+  buf[2] = 0;
+  buf[3] = no;
+  fds[0] = rofd;
+  fds[1] = ctlfd[no];
+  fds[2] = evfd[no];
+  TRACEPRINTF (t, 7, this, "Attach consumer %d", no);
+  if (c->sendmessagefds (sizeof (buf), buf, 3, fds, stop) != -1)
+    {
+      // the ring is read without us, just wait for the client to go away
+      while (1)
+        {
+          if (c->readmessage (stop) == -1)
+            break;
+          if (EIBTYPE (c->buf) == EIB_RESET_CONNECTION)
+            break;
+        }
+    }
+  TRACEPRINTF (t, 7, this, "Detach consumer %d", no);
+  freeConsumer (no);
+}
+
+Element *
+ShmRing::_xml (Element * parent) const
+{
+  int i, consumers = 0;
+  Element *n = parent->addElement (XMLSHMRINGELEMENT);
+
+  for (i = 0; i < EIBSHMRING_MAXCONSUMERS; i++)
+    if (evfd[i] != -1)
+      consumers++;
+  n->addAttribute (XMLSHMRINGSLOTSATTR, (int) mask + 1);
+  n->addAttribute (XMLSHMRINGFRAMESATTR, *stat_frames);
+  n->addAttribute (XMLSHMRINGCONSUMERSATTR, consumers);
+  n->addAttribute (XMLSHMRINGWAKEUPSATTR, *stat_wakeups);
+  if (*stat_truncated)
+    n->addAttribute (XMLSHMRINGTRUNCATEDATTR, *stat_truncated);
+  return n;
+}
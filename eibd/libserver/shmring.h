@@ -0,0 +1,79 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include "common.h"
+#include "eibshmring.h"
+
+class ClientConnection;
+
+/** publishes all frames seen by layer 3 into a memory mapped ring, which
+ * local consumers map read-only (memfd passed over the unix socket) and
+ * read without any system call. Each consumer writes only its own control
+ * page; sleeping consumers are woken through an eventfd each. */
+class ShmRing:public StateInterface, public LoggableObjectInterface
+{
+  Logs *t;
+  /** memfd backing the ring */
+  int memfd;
+  /** size of the mapping */
+  size_t mapsize;
+  EIBShmRingHeader *hdr;
+  EIBShmRingSlot *slot;
+  /** slots - 1 */
+  uint32_t mask;
+  /** read-only descriptor of the ring passed to the consumers */
+  int rofd;
+  /** eventfd per consumer, -1 if unused */
+  int evfd[EIBSHMRING_MAXCONSUMERS];
+  /** shared file of the consumer page, -1 if unused */
+  int ctlfd[EIBSHMRING_MAXCONSUMERS];
+  /** consumer page, writable by the consumer */
+  EIBShmRingConsumer *ctl[EIBSHMRING_MAXCONSUMERS];
+  /** size of a consumer page */
+  size_t ctlsize;
+
+  UIntStatisticsCounter stat_frames;
+  UIntStatisticsCounter stat_wakeups;
+  UIntStatisticsCounter stat_truncated;
+
+  int allocConsumer ();
+  void freeConsumer (int no);
+public:
+  /** creates the ring
+   * @param tr logging
+   * @param slots number of slots, rounded up to a power of two */
+  ShmRing (Logs * tr, unsigned slots);
+  virtual ~ShmRing ();
+
+  /** writes a frame into the ring and wakes waiting consumers */
+  void Publish (uchar type, const uchar * data, unsigned len, timestamp_t ts);
+  /** handles an EIB_OPEN_SHM_RING request; returns when the client closes the connection */
+  void Request (ClientConnection * c, pth_event_t stop);
+
+  const char *_str (void) const
+  {
+    return "Shared Ring";
+  }
+  Element *_xml (Element * parent) const;
+};
+
+#endif
@@ -79,4 +79,15 @@ void DaemonInstance::StateServers(Layer3 * l3, Logs * t, ClientConnection * c,
   StateWrapper(xmltree,erg,l3,t,c,stop,2);
 }
 
+void DaemonInstance::StateBusStatistics(Layer3 * l3, Logs * t,
+			ClientConnection * c, pth_event_t stop,
+			int top, int window)
+{
+  /* generate XML output of the bus statistics */
+  XMLTree xmltree;
+  CArray erg;
+
+  StateWrapper(xmltree,erg,l3,t,c,stop,4 | (top << 8) | (window << 16));
+}
+
 
@@ -110,6 +110,18 @@ public:
 	  void StateServers(Layer3 * l3, Logs * t, ClientConnection * c,
 	  		  pth_event_t stop);
 
+	  /** returns a buffer with the XML description of the bus statistics
+	   *  and the busiest sources and group addresses, gzipped.
+	   *  @param l3 Layer 3 interface
+	   *  @param t debug output
+	   *  @param c client connection
+	   *  @param stop if occurs, function should abort
+	   *  @param top number of sources and group addresses to list
+	   *  @param window window to rank them by, see BusStatistics
+	   * */
+	  void StateBusStatistics(Layer3 * l3, Logs * t, ClientConnection * c,
+			  pth_event_t stop, int top, int window);
+
 };
 
 
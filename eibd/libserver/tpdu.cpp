@@ -20,35 +20,101 @@
 #include "tpdu.h"
 #include "apdu.h"
 
-TPDU *
-TPDU::fromPacket (const CArray & c)
+String
+TPDU::Decode ()
+{
+  char buf[DECODE_BUFSIZE];
+  return Decode (buf, sizeof (buf));
+}
+
+const char *
+TPDU::Decode (char *buf, unsigned size)
+{
+  DecodeBuf b (buf, size);
+  DecodeTo (b);
+  return buf;
+}
+
+/** creates the TPDU on the heap */
+class TPDUCreator
+{
+  const CArray & c;
+public:
+  typedef TPDU *Result;
+  TPDUCreator (const CArray & c):c (c)
+  {
+  }
+  template < class T > TPDU *make ()
+  {
+    TPDU *t = new T ();
+    if (t->init (c))
+      return t;
+    delete t;
+    t = new T_UNKNOWN_PDU ();
+    t->init (c);
+    return t;
+  }
+};
+
+/** decodes the TPDU with an object on the stack */
+class TPDUDecoder
+{
+  const CArray & c;
+  DecodeBuf & s;
+public:
+  typedef void Result;
+  TPDUDecoder (const CArray & c, DecodeBuf & s):c (c), s (s)
+  {
+  }
+  template < class T > void make ()
+  {
+    T t;
+    if (t.init (c))
+      {
+	t.DecodeTo (s);
+	return;
+      }
+    T_UNKNOWN_PDU u;
+    u.init (c);
+    u.DecodeTo (s);
+  }
+};
+
+/** selects the TPDU class for c and passes it to f.make */
+template < class F > static typename F::Result
+dispatchTPDU (const CArray & c, F & f)
 {
-  TPDU *t = 0;
   if (c () >= 1)
     {
       if ((c[0] & 0xfc) == 0)
-	t = new T_DATA_XXX_REQ_PDU ();
+	return f.template make < T_DATA_XXX_REQ_PDU > ();
       if (c[0] == 0x80)
-	t = new T_CONNECT_REQ_PDU ();
+	return f.template make < T_CONNECT_REQ_PDU > ();
       if (c[0] == 0x81)
-	t = new T_DISCONNECT_REQ_PDU ();
+	return f.template make < T_DISCONNECT_REQ_PDU > ();
       if ((c[0] & 0xC3) == 0xC2)
-	t = new T_ACK_PDU ();
+	return f.template make < T_ACK_PDU > ();
       if ((c[0] & 0xC3) == 0xC3)
-	t = new T_NACK_PDU ();
+	return f.template make < T_NACK_PDU > ();
       if ((c[0] & 0xC0) == 0x40)
-	t = new T_DATA_CONNECTED_REQ_PDU ();
+	return f.template make < T_DATA_CONNECTED_REQ_PDU > ();
     }
-  if (t && t->init (c))
-    return t;
-  if (t)
-    delete t;
+  return f.template make < T_UNKNOWN_PDU > ();
+}
 
-  t = new T_UNKNOWN_PDU ();
-  t->init (c);
-  return t;
+TPDU *
+TPDU::fromPacket (const CArray & c)
+{
+  TPDUCreator f (c);
+  return dispatchTPDU (c, f);
 }
 
+void
+TPDU::DecodePacket (const CArray & c, DecodeBuf & s)
+{
+  TPDUDecoder f (c, s);
+  dispatchTPDU (c, f);
+}
 
 /* T_UNKNOWN  */
 
@@ -68,20 +134,21 @@ CArray T_UNKNOWN_PDU::ToPacket ()
   return pdu;
 }
 
-String T_UNKNOWN_PDU::Decode ()
+void
+T_UNKNOWN_PDU::DecodeTo (DecodeBuf & s)
 {
-  String
-  s ("Unknown TPDU: ");
   unsigned
     i;
 
   if (pdu () == 0)
-    return "empty TPDU";
+    {
+      s.add ("empty TPDU");
+      return;
+    }
+  s.add ("Unknown TPDU: ");
 
   for (i = 0; i < pdu (); i++)
-    addHex (s, pdu[i]);
-
-  return s;
+    s.addHex (pdu[i]);
 }
 
 /* T_DATA_XXX_REQ  */
@@ -108,16 +175,11 @@ CArray T_DATA_XXX_REQ_PDU::ToPacket ()
   return pdu;
 }
 
-String T_DATA_XXX_REQ_PDU::Decode ()
+void
+T_DATA_XXX_REQ_PDU::DecodeTo (DecodeBuf & s)
 {
-  APDU *
-    a = APDU::fromPacket (data);
-  String
-  s ("T_DATA_XXX_REQ ");
-  s += a->Decode ();
-  delete
-    a;
-  return s;
+  s.add ("T_DATA_XXX_REQ ");
+  APDU::DecodePacket (data, s);
 }
 
 /* T_DATA_CONNECTED_REQ  */
@@ -147,18 +209,13 @@ CArray T_DATA_CONNECTED_REQ_PDU::ToPacket ()
   return pdu;
 }
 
-String T_DATA_CONNECTED_REQ_PDU::Decode ()
+void
+T_DATA_CONNECTED_REQ_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((serno & 0xf0) == 0);
-  APDU *
-    a = APDU::fromPacket (data);
-  String
-  s ("T_DATA_CONNECTED_REQ serno:");
-  addHex (s, serno);
-  s += a->Decode ();
-  delete
-    a;
-  return s;
+  s.add ("T_DATA_CONNECTED_REQ serno:");
+  s.addHex (serno);
+  APDU::DecodePacket (data, s);
 }
 
 /* T_CONNECT_REQ  */
@@ -182,9 +239,10 @@ CArray T_CONNECT_REQ_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String T_CONNECT_REQ_PDU::Decode ()
+void
+T_CONNECT_REQ_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "T_CONNECT_REQ";
+  s.add ("T_CONNECT_REQ");
 }
 
 /* T_DISCONNECT_REQ  */
@@ -208,9 +266,10 @@ CArray T_DISCONNECT_REQ_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String T_DISCONNECT_REQ_PDU::Decode ()
+void
+T_DISCONNECT_REQ_PDU::DecodeTo (DecodeBuf & s)
 {
-  return "T_DISCONNECT_REQ";
+  s.add ("T_DISCONNECT_REQ");
 }
 
 /* T_ACK */
@@ -237,13 +296,12 @@ CArray T_ACK_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String T_ACK_PDU::Decode ()
+void
+T_ACK_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((serno & 0xf0) == 0);
-  String
-  s ("T_ACK Serno:");
-  addHex (s, serno);
-  return s;
+  s.add ("T_ACK Serno:");
+  s.addHex (serno);
 }
 
 /* T_NACK  */
@@ -269,11 +327,10 @@ CArray T_NACK_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String T_NACK_PDU::Decode ()
+void
+T_NACK_PDU::DecodeTo (DecodeBuf & s)
 {
   assert ((serno & 0xf0) == 0);
-  String
-  s ("T_NACK Serno:");
-  addHex (s, serno);
-  return s;
+  s.add ("T_NACK Serno:");
+  s.addHex (serno);
 }
@@ -53,12 +53,20 @@ public:
   virtual bool init (const CArray & c) = 0;
   /** convert to character array */
   virtual CArray ToPacket () = 0;
+  /** append decoded content to s */
+  virtual void DecodeTo (DecodeBuf & s) = 0;
   /** decode content as string */
-  virtual String Decode () = 0;
+  String Decode ();
+  /** decode content into buf of size bytes without allocating
+   * @return buf */
+  const char *Decode (char *buf, unsigned size);
   /** gets TPDU type */
   virtual TPDU_Type getType () const = 0;
   /** converts character array to a TPDU */
   static TPDU *fromPacket (const CArray & c);
+  /** appends the decoded form of c to s, using TPDU/APDU objects on
+   * the stack */
+  static void DecodePacket (const CArray & c, DecodeBuf & s);
 };
 
 class T_UNKNOWN_PDU:public TPDU
@@ -69,7 +77,7 @@ public:
   T_UNKNOWN_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_UNKNOWN;
@@ -83,7 +91,7 @@ public:
   T_DATA_XXX_REQ_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_DATA_XXX_REQ;
@@ -98,7 +106,7 @@ public:
     T_DATA_CONNECTED_REQ_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_DATA_CONNECTED_REQ;
@@ -111,7 +119,7 @@ public:
   T_CONNECT_REQ_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_CONNECT_REQ;
@@ -124,7 +132,7 @@ public:
   T_DISCONNECT_REQ_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_DISCONNECT_REQ;
@@ -138,7 +146,7 @@ public:
   T_ACK_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_ACK;
@@ -152,7 +160,7 @@ public:
   T_NACK_PDU ();
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode ();
+  void DecodeTo (DecodeBuf & s);
   TPDU_Type getType () const
   {
     return T_NACK;
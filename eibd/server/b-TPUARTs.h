@@ -21,6 +21,7 @@
 #define C_TPUARTs_H
 
 #include "tpuartserial.h"
+#include "ip/ipv4net.h"
 
 #define TPUARTs_URL "tpuarts:/dev/ttySx\n"
 
@@ -33,8 +34,9 @@
 #define TPUARTs_CLEANUP NULL
 
 inline Layer2Interface *
-tpuarts_Create (const char *dev, int flags, Logs * t,  
-		int inquemaxlen, int outquemaxlen, int maxpacketsoutpersecond, int peerquemaxlen)
+tpuarts_Create (const char *dev, int flags, Logs * t,
+		int inquemaxlen, int outquemaxlen, int maxpacketsoutpersecond,
+		int peerquemaxlen, IPv4NetList &ipnetfilters)
 {
 	return new TPUARTSerialLayer2Driver (dev, arg.addr, flags, t, inquemaxlen, outquemaxlen);
 }
@@ -38,6 +38,7 @@ extern "C" {
 #include "eibnetserver.h"
 #include "groupcacheclient.h"
 #include "eibdstate.h"
+#include "shmring.h"
 extern "C" {
 #include <sys/types.h>
 #include <pwd.h>
@@ -56,6 +57,18 @@ static class Logs logger;
 #define OPT_BACK_TPUARTS_ACKGROUP 2
 #define OPT_BACK_TPUARTS_ACKINDIVIDUAL 3
 #define OPT_BACK_TPUARTS_DISCH_RESET 4
+#define OPT_SHARED_RING 5
+#define OPT_CLIENT_OVERFLOW 6
+#define OPT_GROUPCACHE_SNAPSHOT 7
+#define OPT_GROUPCACHE_WARMUP 8
+#define OPT_GROUPCACHE_WARMUP_RATE 9
+#define OPT_GROUPCACHE_REFRESH 10
+#define OPT_SEND_BURST 11
+#define OPT_SEND_WEIGHTS 12
+#define OPT_COMPACT_GROUP_WRITES 13
+#define OPT_BACK_TPUARTS_RTTHREAD 14
+#define OPT_BACK_USB_RECVPOOL 15
+#define OPT_BACK_USB_SENDRING 16
 
 
 /** structure to store the arguments */
@@ -84,6 +97,14 @@ struct arguments
   bool route;
   bool discover;
   bool groupcache;
+  /** file the group cache is persisted to, NULL if none */
+  const char *groupcachesnapshot;
+  /** group addresses read into the cache in the background, NULL if none */
+  const char *groupcachewarmup;
+  /** reads per second of the warmup, 0 for the default */
+  int groupcachewarmuprate;
+  /** seconds between two warmup passes, 0 for a single pass */
+  int groupcacherefresh;
   int backendflags;
   const char *serverip;
 
@@ -92,7 +113,17 @@ struct arguments
   int peerqlen;
   int clientsmax;
   int maxpacketspersecond;
+  /** frames which may be sent back to back, 0 for maxpacketspersecond / 10 */
+  int sendburst;
+  /** share of the bus per client of each kind */
+  SendWeights sendweights;
+  /** replace queued group writes by newer ones */
+  bool compactgroupwrites;
   bool dropclientsoninterfaceloss;
+  /** slots of the shared memory ring, 0 if disabled */
+  int sharedringslots;
+  /** initial overflow policy of client connections */
+  OverflowPolicy overflowpolicy;
   IPv4NetList ipnetfilters;
 
   uid_t userid;
@@ -233,6 +264,14 @@ static struct argp_option options[] = {
 #ifdef HAVE_GROUPCACHE
   {"GroupCache", 'c', 0, 0,
    "enable caching of group communication network state"},
+  {"groupcache-snapshot", OPT_GROUPCACHE_SNAPSHOT, "FILE", 0,
+   "keep the group cache in FILE and reload it at startup; reloaded values are marked stale until seen on the bus again"},
+  {"groupcache-warmup", OPT_GROUPCACHE_WARMUP, "LIST", 0,
+   "read the group addresses in LIST (comma separated, ranges as a-b) into the group cache in the background, while the bus interface is idle"},
+  {"groupcache-warmup-rate", OPT_GROUPCACHE_WARMUP_RATE, "INT", 0,
+   "maximum warmup reads per second (1-1000), default half of PacketsPerSecond or 5; never more than PacketsPerSecond"},
+  {"groupcache-refresh", OPT_GROUPCACHE_REFRESH, "SECONDS", 0,
+   "repeat the warmup every SECONDS, reading only addresses without a newer value"},
 #endif
 #ifdef HAVE_EIBNETIPTUNNEL
   {"no-tunnel-client-queuing", OPT_BACK_TUNNEL_NOQUEUE, 0, 0,
@@ -245,6 +284,14 @@ static struct argp_option options[] = {
    "tpuarts backend should generate L2 acks for all individual telegrams"},
   {"tpuarts-disch-reset", OPT_BACK_TPUARTS_DISCH_RESET, 0, 0,
    "tpuarts backend should should use a full interface reset (for Disch TPUART interfaces)"},
+  {"tpuarts-rt-thread", OPT_BACK_TPUARTS_RTTHREAD, 0, 0,
+   "tpuarts backend handles the TPUART in an OS thread with SCHED_FIFO priority and locked memory"},
+#endif
+#ifdef HAVE_USB
+  {"usb-receive-transfers", OPT_BACK_USB_RECVPOOL, "INT", 0,
+   "usb backend keeps INT receive transfers submitted (1-8, default 4)"},
+  {"usb-send-transfers", OPT_BACK_USB_SENDRING, "INT", 0,
+   "usb backend sends up to INT telegrams without waiting for the previous one to complete (1-8, default 2)"},
 #endif
   {"InQueueMax", 'Q', "INT", OPTION_ARG_OPTIONAL,
    "restrict incoming queue length, will drop & warn after queue length from bus is exceeded, without argument default 255"},
@@ -255,7 +302,17 @@ static struct argp_option options[] = {
   {"ClientsMax", 'C', "INT", OPTION_ARG_OPTIONAL,
    "restrict maximum number of concurrent clients on server, without argument default 32"},
   {"PacketsPerSecond", 'B', "INT", OPTION_ARG_OPTIONAL,
-   "throttling of sending to EIB interface to maximum telegrams per seconds, without argument default 10"},
+   "throttling of sending to EIB interface to maximum telegrams per seconds, without argument default 10; spread evenly, longer telegrams count more than short ones"},
+  {"send-burst", OPT_SEND_BURST, "INT", 0,
+   "number of telegrams which may be sent back to back when throttling, requires PacketsPerSecond; default a tenth of PacketsPerSecond"},
+  {"send-weights", OPT_SEND_WEIGHTS, "LIST", 0,
+   "share of the bus each client gets while several clients send, as kind=weight[,kind=weight...] with kind local, inet, eibnet or internal (e.g. local=4,inet=1); default 1 for all"},
+  {"compact-group-writes", OPT_COMPACT_GROUP_WRITES, 0, 0,
+   "a group write replaces a write of the same client to the same group address still waiting to be sent; only the latest value of e.g. a dimmer slider is sent"},
+  {"shared-ring", OPT_SHARED_RING, "SLOTS", OPTION_ARG_OPTIONAL,
+   "publish all frames into a shared memory ring local clients can attach to over the unix domain socket, without argument default 1024 slots"},
+  {"client-overflow", OPT_CLIENT_OVERFLOW, "POLICY", 0,
+   "what to do if a client does not read fast enough and its queue (PeerQueueMax) is full: drop-newest (default), drop-oldest, coalesce (keep the latest value per group address) or disconnect"},
    {"DropClientsOnInterfaceLoss", 'X', 0, 0,
        "drop attached clients when the underlying interface becomes unavailable",
    },
@@ -435,6 +492,21 @@ parse_opt (int key, char *arg, struct argp_state *state)
     case 'c':
       arguments->groupcache = 1;
       break;
+    case OPT_GROUPCACHE_SNAPSHOT:
+      arguments->groupcachesnapshot = arg;
+      break;
+    case OPT_GROUPCACHE_WARMUP:
+      arguments->groupcachewarmup = arg;
+      break;
+    case OPT_GROUPCACHE_WARMUP_RATE:
+      arguments->groupcachewarmuprate = atoi (arg);
+      if (arguments->groupcachewarmuprate <= 0
+	  || arguments->groupcachewarmuprate > GROUPCACHE_WARMUP_MAXRATE)
+	argp_error (state, "invalid group cache warmup rate %s", arg);
+      break;
+    case OPT_GROUPCACHE_REFRESH:
+      arguments->groupcacherefresh = atoi (arg);
+      break;
     case OPT_BACK_TUNNEL_NOQUEUE:
       arguments->backendflags |= FLAG_B_TUNNEL_NOQUEUE;
       break;
@@ -447,6 +519,22 @@ parse_opt (int key, char *arg, struct argp_state *state)
     case OPT_BACK_TPUARTS_DISCH_RESET:
       arguments->backendflags |= FLAG_B_TPUARTS_DISCH_RESET;
       break;
+    case OPT_BACK_TPUARTS_RTTHREAD:
+      arguments->backendflags |= FLAG_B_TPUARTS_RTTHREAD;
+      break;
+    case OPT_BACK_USB_RECVPOOL:
+      if (atoi (arg) < 1 || atoi (arg) > 8)
+	argp_error (state, "invalid number of USB receive transfers %s", arg);
+      // a repeated option replaces the value
+      arguments->backendflags &= ~FLAG_B_USB_RECVPOOL (0xf);
+      arguments->backendflags |= FLAG_B_USB_RECVPOOL (atoi (arg));
+      break;
+    case OPT_BACK_USB_SENDRING:
+      if (atoi (arg) < 1 || atoi (arg) > 8)
+	argp_error (state, "invalid number of USB send transfers %s", arg);
+      arguments->backendflags &= ~FLAG_B_USB_SENDRING (0xf);
+      arguments->backendflags |= FLAG_B_USB_SENDRING (atoi (arg));
+      break;
 
     case 'Q':
       arguments->inbusqlen= (arg ? atoi (arg) : 255);
@@ -466,6 +554,25 @@ parse_opt (int key, char *arg, struct argp_state *state)
       //      fprintf(stderr,"B %s.\n",arg);
       arguments->maxpacketspersecond = (arg ? atoi (arg) : 10);
       break;
+    case OPT_SEND_BURST:
+      arguments->sendburst = atoi (arg);
+      if (arguments->sendburst <= 0)
+	argp_error (state, "invalid send burst %s", arg);
+      break;
+    case OPT_COMPACT_GROUP_WRITES:
+      arguments->compactgroupwrites = 1;
+      break;
+    case OPT_SEND_WEIGHTS:
+      if (!SendScheduler::ParseWeights (arg, arguments->sendweights))
+	argp_error (state, "invalid send weights %s", arg);
+      break;
+    case OPT_SHARED_RING:
+      arguments->sharedringslots = (arg ? atoi (arg) : 1024);
+      break;
+    case OPT_CLIENT_OVERFLOW:
+      if (!FlowControl::ParsePolicy (arg, arguments->overflowpolicy))
+	argp_error (state, "unknown overflow policy %s", arg);
+      break;
     case 'X':
       arguments->dropclientsoninterfaceloss=1;
       break;
@@ -602,6 +709,10 @@ main (int ac, char *ag[])
   memset (&arg, 0, sizeof (arg));
   arg.addr = 0x0001;
   arg.errorlevel = LOG_WARNING;
+  arg.sendweights.local = 1;
+  arg.sendweights.inet = 1;
+  arg.sendweights.eibnet = 1;
+  arg.sendweights.internal = 1;
   arg.warnlevel=255;
   arg.tracelevel=1;
   arg.infolevel=255;
@@ -622,6 +733,8 @@ main (int ac, char *ag[])
 
   if (arg.port == 0 && arg.name == 0 && arg.serverip == 0)
     die ("No listen-address given");
+  if (arg.sendburst && !arg.maxpacketspersecond)
+    die ("--send-burst requires --PacketsPerSecond");
 
   signal (SIGPIPE, SIG_IGN);
   signal (SIGINT, _diehandler);
@@ -687,6 +800,8 @@ main (int ac, char *ag[])
     	// should have thrown exception ?
     	LOGANDDIE ("Layer 2 interface cannot be opened");
     }
+    if (arg.maxpacketspersecond > 0)
+      eibdinstance->l2->TxPacer()->setRate (arg.maxpacketspersecond, arg.sendburst);
 
     eibdinstance->l3 = new Layer3 (eibdinstance->l2, &logger,
         arg.backendflags & FLAG_B_RESET_ADDRESS_TABLE,
@@ -694,15 +809,44 @@ main (int ac, char *ag[])
     if (arg.port)
       eibdinstance->inetserver = new InetServer (eibdinstance->l3, &logger, eibdinstance, arg.port, arg.inbusqlen, arg.outbusqlen,
           arg.peerqlen, arg.clientsmax, arg.ipnetfilters);
+    eibdinstance->l3->Scheduler ()->setInternalWeight (arg.sendweights.internal);
+    eibdinstance->l3->Scheduler ()->setCompaction (arg.compactgroupwrites);
+    if (eibdinstance->inetserver)
+      {
+        eibdinstance->inetserver->setOverflowPolicy (arg.overflowpolicy);
+        eibdinstance->inetserver->setSendWeight (arg.sendweights.inet);
+      }
+    if (arg.name && arg.sharedringslots > 0)
+      eibdinstance->l3->setSharedRing (new ShmRing (&logger, arg.sharedringslots));
     if (arg.name)
       eibdinstance->localserver = new LocalServer (eibdinstance->l3,arg.name, &logger, eibdinstance,  arg.inbusqlen,
           arg.outbusqlen, arg.peerqlen, arg.clientsmax, arg.ipnetfilters);
+    if (eibdinstance->localserver)
+      {
+        eibdinstance->localserver->setOverflowPolicy (arg.overflowpolicy);
+        eibdinstance->localserver->setSendWeight (arg.sendweights.local);
+      }
 #ifdef HAVE_EIBNETIPSERVER
     eibdinstance->serv = startServer (eibdinstance->l3, &logger);
+    if (eibdinstance->serv)
+      eibdinstance->serv->setSendWeight (arg.sendweights.eibnet);
 #endif
 #ifdef HAVE_GROUPCACHE
-  if (!CreateGroupCache (eibdinstance->l3, &logger, arg.groupcache))
+  if (!CreateGroupCache (eibdinstance->l3, &logger, arg.groupcache,
+                         arg.groupcachesnapshot))
     LOGANDDIE ("initialisation of the group cache failed");
+  if (arg.groupcachewarmup)
+    {
+      int rate = arg.groupcachewarmuprate;
+      if (rate <= 0)
+        rate = arg.maxpacketspersecond ? arg.maxpacketspersecond / 2 : 5;
+      if (arg.maxpacketspersecond && rate > arg.maxpacketspersecond)
+        rate = arg.maxpacketspersecond;
+      if (!StartGroupCacheWarmup (eibdinstance->l3, &logger,
+                                  arg.groupcachewarmup, rate > 0 ? rate : 1,
+                                  arg.groupcacherefresh))
+        LOGANDDIE ("invalid group cache warmup list");
+    }
 #endif
   }
   catch (Exception &e)
@@ -18,6 +18,7 @@
 */
 
 #include "eibdstate.h"
+#include "groupcacheclient.h"
 extern "C" {
 #include <zlib.h>
 };
@@ -92,6 +93,16 @@ extern "C" {
       if (this->serv)
         this->serv->_xml(stat);
   #endif
+  #ifdef HAVE_GROUPCACHE
+      GroupCacheState(stat);
+  #endif
+    }
+
+    // bus statistics, top lists as requested
+    if (which & 4) {
+      if (l3) {
+        l3->Statistics()._xml(stat, (which >> 8) & 0xff, (which >> 16) & 0xff);
+      }
     }
 
     pth_mutex_release(&this->lock);
@@ -124,7 +135,7 @@ extern "C" {
 
     erg.resize(2+compressedlen);
 
-    EIBSETTYPE (erg, EIB_STATE_REQ_BACKENDS);
+    EIBSETTYPE (erg, which & 4 ? EIB_STATE_REQ_BUSSTATS : EIB_STATE_REQ_BACKENDS);
     erg.setpart(compressed.array(), 2, compressedlen);
 
   #if 0
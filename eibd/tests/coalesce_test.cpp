@@ -0,0 +1,109 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "common.h"
+#include "flowcontrol.h"
+#include "layer4.h"
+
+/** aborts program with a printf like message */
+void
+die (const char *msg, ...)
+{
+  va_list ap;
+  va_start (ap, msg);
+  vprintf (msg, ap);
+  printf ("\n");
+  va_end (ap);
+
+  exit (1);
+}
+
+/** builds a group frame; apci 0x00 read, 0x40 response, 0x80 write */
+static GroupAPDU
+frame (eibaddr_t dst, uchar apci, uchar value)
+{
+  GroupAPDU a;
+  uchar c[2] = { 0x00, (uchar) (apci | value) };
+  a.data.set (c, 2);
+  a.src = 0x1101;
+  a.dst = dst;
+  return a;
+}
+
+/** checks, that q holds exactly the frames of expect, in order */
+static void
+check (Queue < GroupAPDU > &q, const GroupAPDU * expect, int n)
+{
+  if (q.len () != n)
+    die ("queue holds %d frames, expected %d", q.len (), n);
+  for (int i = 0; i < n; i++)
+    {
+      GroupAPDU a = q.get ();
+      if (a.dst != expect[i].dst || !(a.data == expect[i].data))
+	die ("frame %d: got %04x %02x, expected %04x %02x", i, a.dst,
+	     a.data[1], expect[i].dst, expect[i].data[1]);
+    }
+}
+
+int
+main (int ac, char *ag[])
+{
+  Logs t;
+  pth_sem_t sem;
+
+  pth_init ();
+  pth_sem_init (&sem);
+
+  /* full() is true above 3 queued frames */
+  Queue < GroupAPDU > q ("coalesce", 3);
+  FlowControl fc (&t, NULL, -1, OVERFLOW_COALESCE);
+
+  fc.Put (q, frame (0x0901, 0x80, 1), &sem, GroupAPDU::Coalesce);
+  fc.Put (q, frame (0x0901, 0x00, 0), &sem, GroupAPDU::Coalesce);
+  fc.Put (q, frame (0x0902, 0x80, 1), &sem, GroupAPDU::Coalesce);
+  fc.Put (q, frame (0x0901, 0x80, 2), &sem, GroupAPDU::Coalesce);
+  if (!q.full ())
+    die ("queue not full");
+
+  /* replaces the newest write to 1/1/1, which is the last frame */
+  if (!fc.Put (q, frame (0x0901, 0x80, 3), &sem, GroupAPDU::Coalesce))
+    die ("write 1/1/1 not coalesced");
+  /* replaces the write to 1/1/2 and moves it behind the newer frames */
+  if (!fc.Put (q, frame (0x0902, 0x80, 2), &sem, GroupAPDU::Coalesce))
+    die ("write 1/1/2 not coalesced");
+  /* reads and responses never replace a write */
+  if (fc.Put (q, frame (0x0901, 0x00, 0), &sem, GroupAPDU::Coalesce))
+    die ("read coalesced");
+  if (fc.Put (q, frame (0x0901, 0x40, 4), &sem, GroupAPDU::Coalesce))
+    die ("response coalesced with a write");
+
+  GroupAPDU expect[] = {
+    frame (0x0901, 0x80, 1),
+    frame (0x0901, 0x00, 0),
+    frame (0x0901, 0x80, 3),
+    frame (0x0902, 0x80, 2),
+  };
+  check (q, expect, 4);
+
+  printf ("coalesce order ok\n");
+  return 0;
+}
@@ -0,0 +1,263 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2007 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "common.h"
+#include "lpdu.h"
+#include "tpdu.h"
+#include "apdu.h"
+
+/** structure to store the arguments */
+struct arguments
+{
+  /** number of iterations per frame */
+  int count;
+};
+/** storage for the arguments*/
+struct arguments arg = { 100000 };
+
+/** parses and stores an option */
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  struct arguments *arguments = (struct arguments *) state->input;
+  switch (key)
+    {
+    case 'n':
+      arguments->count = (arg ? atoi (arg) : 0);
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+  return 0;
+}
+
+/** aborts program with a printf like message */
+void
+die (const char *msg, ...)
+{
+  va_list ap;
+  va_start (ap, msg);
+  vprintf (msg, ap);
+  printf ("\n");
+  va_end (ap);
+
+  exit (1);
+}
+
+static char doc[] = "frame decode benchmark";
+
+/** option list */
+static struct argp_option options[] = {
+
+  {"count", 'n', "COUNT", 0, "number of decodes per frame"},
+  {0}
+};
+
+/** information for the argument parser*/
+static struct argp argp = { options, parse_opt, 0, doc };
+
+/** sample frames (TP1 L_Data incl. checksum) */
+static const struct
+{
+  const char *name;
+  int len;
+  uchar data[24];
+} frames[] = {
+  {"GroupValue_Write small", 9,
+   {0xbc, 0x11, 0x01, 0x09, 0x01, 0xe1, 0x00, 0x81, 0x00}},
+  {"GroupValue_Write 2 byte", 10,
+   {0xbc, 0x11, 0x01, 0x09, 0x01, 0xe2, 0x00, 0x80, 0x0c, 0x1a}},
+  {"Memory_Write", 17,
+   {0xb0, 0x11, 0x01, 0x11, 0x05, 0x69, 0x42, 0x86, 0x10, 0x00,
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x00}},
+};
+
+/* The legacy decoder, as it was before DecodeBuf: every nested PDU is
+ * parsed into a heap object and the text is built by String
+ * concatenation. Only the PDU types of the sample frames are replicated,
+ * all others fall back to the current Decode (). */
+
+static String
+legacyAPDU (const CArray & c)
+{
+  APDU *a = APDU::fromPacket (c);
+  String s;
+  unsigned i;
+
+  switch (a->getType ())
+    {
+    case A_GroupValue_Write:
+      {
+	A_GroupValue_Write_PDU *w = (A_GroupValue_Write_PDU *) a;
+	s = "A_GroupValue_Write ";
+	if (w->issmall)
+	  s += "(small) ";
+	for (i = 0; i < w->data (); i++)
+	  addHex (s, w->data[i]);
+      }
+      break;
+    case A_Memory_Write:
+      {
+	A_Memory_Write_PDU *w = (A_Memory_Write_PDU *) a;
+	s = "A_Memory_Write Len:";
+	addHex (s, w->count);
+	s += " Addr: ";
+	add16Hex (s, w->addr);
+	s += "Data: ";
+	for (i = 0; i < w->data (); i++)
+	  addHex (s, w->data[i]);
+      }
+      break;
+    default:
+      s = a->Decode ();
+    }
+  delete a;
+  return s;
+}
+
+static String
+legacyTPDU (const CArray & c)
+{
+  TPDU *t = TPDU::fromPacket (c);
+  String s;
+
+  if (t->getType () == T_DATA_XXX_REQ)
+    {
+      s = "T_DATA_XXX_REQ ";
+      s += legacyAPDU (((T_DATA_XXX_REQ_PDU *) t)->data);
+    }
+  else if (t->getType () == T_DATA_CONNECTED_REQ)
+    {
+      s = "T_DATA_CONNECTED_REQ serno:";
+      addHex (s, ((T_DATA_CONNECTED_REQ_PDU *) t)->serno);
+      s += legacyAPDU (((T_DATA_CONNECTED_REQ_PDU *) t)->data);
+    }
+  else
+    s = t->Decode ();
+  delete t;
+  return s;
+}
+
+static String
+legacyDecode (const CArray & pdu)
+{
+  String s ("LPDU: ");
+  unsigned i;
+
+  if (pdu () == 0)
+    return "empty LPDU";
+  for (i = 0; i < pdu (); i++)
+    addHex (s, pdu[i]);
+  s += ":";
+
+  LPDU *l = LPDU::fromPacket (pdu);
+  if (l->getType () == L_Data)
+    {
+      L_Data_PDU *d = (L_Data_PDU *) l;
+      s += "L_Data";
+      if (d->repeated)
+	s += " (repeated)";
+      switch (d->prio)
+	{
+	case PRIO_LOW:
+	  s += " low";
+	  break;
+	case PRIO_NORMAL:
+	  s += " normal";
+	  break;
+	case PRIO_URGENT:
+	  s += " urgent";
+	  break;
+	case PRIO_SYSTEM:
+	  s += " system";
+	  break;
+	}
+      if (!d->valid_checksum)
+	s += " INVALID CHECKSUM";
+      s =
+	s + " from " + FormatEIBAddr (d->source) + " to " +
+	(d->AddrType == GroupAddress ? FormatGroupAddr (d->dest) :
+	 FormatEIBAddr (d->dest));
+      s += " hops: ";
+      addHex (s, d->hopcount);
+      s += legacyTPDU (d->data);
+    }
+  else
+    s += l->Decode ();
+  delete l;
+  return s;
+}
+
+int
+main (int ac, char *ag[])
+{
+  int index;
+  char buf[DECODE_BUFSIZE];
+
+  argp_parse (&argp, ac, ag, 0, &index, &arg);
+  if (index < ac)
+    die ("unexpected parameter");
+  if (arg.count <= 0)
+    die ("invalid count");
+
+  for (unsigned f = 0; f < sizeof (frames) / sizeof (frames[0]); f++)
+    {
+      L_Busmonitor_PDU b;
+      b.pdu.set (frames[f].data, frames[f].len);
+      timestamp_t start, t_legacy, t_string, t_buf;
+
+      start = getTime ();
+      for (int i = 0; i < arg.count; i++)
+	{
+	  String s = legacyDecode (b.pdu);
+	}
+      t_legacy = getTime () - start;
+
+      start = getTime ();
+      for (int i = 0; i < arg.count; i++)
+	{
+	  String s = b.Decode ();
+	}
+      t_string = getTime () - start;
+
+      start = getTime ();
+      for (int i = 0; i < arg.count; i++)
+	b.Decode (buf, sizeof (buf));
+      t_buf = getTime () - start;
+
+      String old = legacyDecode (b.pdu);
+      if (strcmp (old (), buf))
+	die ("%s: output differs\n  legacy: %s\n  buffer: %s",
+	     frames[f].name, old (), buf);
+
+      printf ("%s\n  %s\n", frames[f].name, buf);
+      printf ("  legacy:  %8.1f ns/frame\n",
+	      t_legacy * 1000.0 / arg.count);
+      printf ("  String:  %8.1f ns/frame\n",
+	      t_string * 1000.0 / arg.count);
+      printf ("  buffer:  %8.1f ns/frame\n", t_buf * 1000.0 / arg.count);
+    }
+
+  return 0;
+}
@@ -0,0 +1,354 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2007 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <vector>
+#include "common.h"
+#include "frameparser.h"
+
+/** structure to store the arguments */
+struct arguments
+{
+  /** random chunkings compared with the recorded one */
+  int iterations;
+  /** copies of the capture fed for the throughput */
+  int repeat;
+  /** seed of the random numbers */
+  int seed;
+  const char *tpuart;
+  const char *ft12;
+};
+/** storage for the arguments*/
+struct arguments arg = { 1000, 10000, 1, 0, 0 };
+
+/** parses and stores an option */
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  struct arguments *arguments = (struct arguments *) state->input;
+  switch (key)
+    {
+    case 'n':
+      arguments->iterations = (arg ? atoi (arg) : 0);
+      break;
+    case 'r':
+      arguments->repeat = (arg ? atoi (arg) : 0);
+      break;
+    case 's':
+      arguments->seed = (arg ? atoi (arg) : 0);
+      break;
+    case 't':
+      arguments->tpuart = arg;
+      break;
+    case 'f':
+      arguments->ft12 = arg;
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+  return 0;
+}
+
+/** aborts program with a printf like message */
+void
+die (const char *msg, ...)
+{
+  va_list ap;
+  va_start (ap, msg);
+  vprintf (msg, ap);
+  printf ("\n");
+  va_end (ap);
+
+  exit (1);
+}
+
+static char doc[] =
+  "feeds serial captures to the frame parsers in random pieces and with garbage, "
+  "checks the result does not depend on the pieces and measures the throughput";
+
+/** option list */
+static struct argp_option options[] = {
+
+  {"iterations", 'n', "COUNT", 0, "random splits of each capture"},
+  {"repeat", 'r', "COUNT", 0, "copies of each capture for the throughput"},
+  {"seed", 's', "SEED", 0, "seed of the random numbers"},
+  {"tpuart", 't', "FILE", 0, "TPUART capture, one read per line in hex"},
+  {"ft12", 'f', "FILE", 0, "FT1.2 capture, one read per line in hex"},
+  {0}
+};
+
+/** information for the argument parser*/
+static struct argp argp = { options, parse_opt, 0, doc };
+
+/** used without a capture file, same as captures/tpuart.cap */
+static const char tpuartcap[] =
+  "07\n"
+  "BC 11 01 09 01\n"
+  "E1 00 81 3B\n"
+  "CC\n"
+  "BC 11 05 0A 03 E3 00 80 0C 1A 2B CC\n"
+  "B0 11 01 11 05 63 42 80 01 10 FB\n"
+  "0C\n"
+  "10 B0 11 02 0A 02 03 00 80 12 34 E1 CC\n"
+  "55\n"
+  "BC 11 01 09 01 E1 00 81 3B 0B\n"
+  "BC 11 01 09 01 E1 00 81 3B 8B\n"
+  "07\n";
+
+/** used without a capture file, same as captures/ft12.cap */
+static const char ft12cap[] =
+  "E5\n"
+  "10 40 40 16\n"
+  "68 0B 0B 68 F3 29 00 BC 11 01\n"
+  "09 01 E1 00 81 56 16\n"
+  "E5\n"
+  "68 0D 0D 68 D3 29 00 BC 11 05 0A 03 E3 00 80 0C 1A 64 16 E5\n";
+
+/** reads of a capture */
+typedef std::vector < CArray > Capture;
+
+/** parses a capture: one read per line, hex bytes, # starts a comment */
+static void
+parse (const char *text, Capture & cap)
+{
+  CArray c;
+  while (*text)
+    {
+      if (*text == '#')
+	while (*text && *text != '\n')
+	  text++;
+      if (*text == '\n')
+	{
+	  if (c ())
+	    cap.push_back (c);
+	  c.resize (0);
+	  text++;
+	  continue;
+	}
+      if (isxdigit (text[0]) && isxdigit (text[1]))
+	{
+	  char h[3] = { text[0], text[1], 0 };
+	  c.resize (c () + 1);
+	  c[c () - 1] = strtoul (h, 0, 16);
+	  text += 2;
+	}
+      else if (*text)
+	text++;
+    }
+  if (c ())
+    cap.push_back (c);
+}
+
+static void
+load (const char *file, const char *builtin, Capture & cap)
+{
+  if (!file)
+    {
+      parse (builtin, cap);
+      return;
+    }
+  FILE *f = fopen (file, "r");
+  if (!f)
+    die ("cannot open %s", file);
+  CArray text;
+  uchar buf[1024];
+  size_t l;
+  while ((l = fread (buf, 1, sizeof (buf), f)) > 0)
+    text.setpart (buf, text (), l);
+  fclose (f);
+  text.resize (text () + 1);
+  text[text () - 1] = 0;
+  parse ((const char *) text.array (), cap);
+}
+
+/** every token with the bytes it carried, to compare runs */
+struct Result
+{
+  CArray log;
+  unsigned tokens;
+  unsigned frames;
+};
+
+static void
+add (Result & r, int token, const uchar * data, unsigned len)
+{
+  unsigned pos = r.log ();
+  r.log.resize (pos + 2 + len);
+  r.log[pos] = token;
+  r.log[pos + 1] = len;
+  r.log.setpart (data, pos + 2, len);
+  r.tokens++;
+}
+
+static void
+drain (TPUARTFrameParser & p, Result & r)
+{
+  TPUARTFrameParser::Token t;
+  while ((t = p.Next ()) != TPUARTFrameParser::TP_NONE)
+    if (t == TPUARTFrameParser::TP_ADDRESS)
+      {
+	uchar a[3];
+	a[0] = p.Group ();
+	a[1] = p.Dest () >> 8;
+	a[2] = p.Dest () & 0xff;
+	add (r, t, a, 3);
+      }
+    else
+      {
+	add (r, t, p.Frame (), p.FrameLen ());
+	if (t == TPUARTFrameParser::TP_FRAME)
+	  r.frames++;
+      }
+}
+
+static void
+drain (FT12FrameParser & p, Result & r)
+{
+  FT12FrameParser::Token t;
+  while ((t = p.Next ()) != FT12FrameParser::FT_NONE)
+    {
+      add (r, t, p.Frame (), p.FrameLen ());
+      if (t == FT12FrameParser::FT_VARIABLE)
+	r.frames++;
+    }
+}
+
+/** feeds len bytes as a single read */
+template < class P > static void
+feed (P & p, const uchar * data, unsigned len, Result & r)
+{
+  while (len)
+    {
+      unsigned n = p.ring.Put (data, len);
+      data += n;
+      len -= n;
+      drain (p, r);
+    }
+}
+
+template < class P > static void
+run (const char *name, const Capture & cap)
+{
+  Result ref = { CArray (), 0, 0 };
+  CArray all;
+  P p;
+
+  for (unsigned i = 0; i < cap.size (); i++)
+    {
+      feed (p, cap[i].array (), cap[i] (), ref);
+      all.setpart (cap[i], all ());
+    }
+  printf ("%s: %d reads, %d bytes, %d tokens, %d frames\n", name,
+	  (int) cap.size (), all (), ref.tokens, ref.frames);
+
+  // the result must not depend on how the bytes were split into reads
+  for (int n = 0; n < arg.iterations; n++)
+    {
+      Result r = { CArray (), 0, 0 };
+      P q;
+      unsigned pos = 0;
+      while (pos < all ())
+	{
+	  unsigned l = 1 + rand () % 32;
+	  if (l > all () - pos)
+	    l = all () - pos;
+	  feed (q, all.array () + pos, l, r);
+	  pos += l;
+	}
+      if (r.log != ref.log)
+	die ("%s: split %d differs from the recorded reads", name, n);
+    }
+  printf ("  %d random splits: identical\n", arg.iterations);
+
+  // garbage between the reads must neither crash nor stall the parser
+  unsigned recovered = 0, expected = 0;
+  for (int n = 0; n < arg.iterations; n++)
+    {
+      Result r = { CArray (), 0, 0 };
+      P q;
+      for (unsigned i = 0; i < cap.size (); i++)
+	{
+	  uchar g[8];
+	  unsigned l = rand () % 4 ? 0 : 1 + rand () % sizeof (g);
+	  for (unsigned j = 0; j < l; j++)
+	    g[j] = rand ();
+	  feed (q, g, l, r);
+	  feed (q, cap[i].array (), cap[i] (), r);
+	}
+      if (q.ring.len () > FRAMERING_SIZE / 2)
+	die ("%s: %d bytes left unparsed", name, q.ring.len ());
+      recovered += r.frames;
+      expected += ref.frames;
+    }
+  printf ("  with garbage: %u of %u frames recovered\n", recovered,
+	  expected);
+
+  // throughput of clean and of random input
+  for (int garbage = 0; garbage < 2; garbage++)
+    {
+      CArray in;
+      in.resize (all () * arg.repeat);
+      for (int i = 0; i < arg.repeat; i++)
+	if (garbage)
+	  for (unsigned j = 0; j < all (); j++)
+	    in[i * all () + j] = rand ();
+	else
+	  in.setpart (all, i * all ());
+
+      P q;
+      timestamp_t start = getTime ();
+      unsigned pos = 0;
+      while (pos < in ())
+	{
+	  unsigned l = in () - pos < 64 ? in () - pos : 64;
+	  pos += q.ring.Put (in.array () + pos, l);
+	  // the log is not needed here
+	  while (q.Next ())
+	    ;
+	}
+      timestamp_t t = getTime () - start;
+      printf ("  %s: %8.1f ns/byte, %8.1f MByte/s\n",
+	      garbage ? "random" : "clean ", t * 1000.0 / in (),
+	      t ? in () * 1.0 / t : 0.0);
+    }
+}
+
+int
+main (int ac, char *ag[])
+{
+  int index;
+  Capture tpuart, ft12;
+
+  argp_parse (&argp, ac, ag, 0, &index, &arg);
+  if (index < ac)
+    die ("unexpected parameter");
+  if (arg.iterations < 0 || arg.repeat <= 0)
+    die ("invalid count");
+  srand (arg.seed);
+
+  load (arg.tpuart, tpuartcap, tpuart);
+  load (arg.ft12, ft12cap, ft12);
+  run < TPUARTFrameParser > ("TPUART", tpuart);
+  run < FT12FrameParser > ("FT1.2", ft12);
+  return 0;
+}
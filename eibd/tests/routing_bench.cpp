@@ -0,0 +1,311 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2007 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "common.h"
+#include "emi.h"
+#include "eibnetip.h"
+#include "addrbitmap.h"
+#include "queue.h"
+
+/** structure to store the arguments */
+struct arguments
+{
+  /** number of packets per sample */
+  int count;
+};
+/** storage for the arguments*/
+struct arguments arg = { 1000000 };
+
+/** parses and stores an option */
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  struct arguments *arguments = (struct arguments *) state->input;
+  switch (key)
+    {
+    case 'n':
+      arguments->count = (arg ? atoi (arg) : 0);
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+  return 0;
+}
+
+/** aborts program with a printf like message */
+void
+die (const char *msg, ...)
+{
+  va_list ap;
+  va_start (ap, msg);
+  vprintf (msg, ap);
+  printf ("\n");
+  va_end (ap);
+
+  exit (1);
+}
+
+static char doc[] =
+  "EIBnet/IP routing indication receive benchmark (packets/s on one core), "
+  "comparing the former copying path with the receive buffer view";
+
+/** option list */
+static struct argp_option options[] = {
+
+  {"count", 'n', "COUNT", 0, "number of packets per sample frame"},
+  {0}
+};
+
+/** information for the argument parser*/
+static struct argp argp = { options, parse_opt, 0, doc };
+
+/** sample ROUTING_INDICATION datagrams carrying a cEMI L_Data.ind */
+static const struct
+{
+  const char *name;
+  int len;
+  uchar data[32];
+} frames[] = {
+  {"GroupValue_Write small", 17,
+   {0x06, 0x10, 0x05, 0x30, 0x00, 0x11, 0x29, 0x00, 0xbc, 0xe0,
+    0x11, 0x01, 0x09, 0x01, 0x01, 0x00, 0x81}},
+  {"GroupValue_Write 2 byte", 19,
+   {0x06, 0x10, 0x05, 0x30, 0x00, 0x13, 0x29, 0x00, 0xbc, 0xe0,
+    0x11, 0x01, 0x09, 0x01, 0x03, 0x00, 0x80, 0x0c, 0x1a}},
+  {"Memory_Write", 26,
+   {0x06, 0x10, 0x05, 0x30, 0x00, 0x1a, 0x29, 0x00, 0xb0, 0x60,
+    0x11, 0x01, 0x11, 0x05, 0x0a, 0x42, 0x86, 0x10, 0x00, 0x01,
+    0x02, 0x03, 0x04, 0x05, 0x06, 0x07}},
+};
+
+/** group addresses the router has subscribed to */
+static AddressBitmap groupaddr;
+
+/** the parser before CEMI_to_L_Data worked on a byte range: builds the
+ * frame on the stack and copies it to the heap */
+static L_Data_PDU *
+legacyCEMI_to_L_Data (const CArray & data)
+{
+  L_Data_PDU c;
+  if (data () < 2)
+    return 0;
+  unsigned start = data[1] + 2;
+  if (data () < 7 + start)
+    return 0;
+  if (data () < 7 + start + data[6 + start] + 1)
+    return 0;
+  c.source = (data[start + 2] << 8) | (data[start + 3]);
+  c.dest = (data[start + 4] << 8) | (data[start + 5]);
+  c.data.set (data.array () + start + 7, data[6 + start] + 1);
+  if (data[0] == 0x29)
+    c.repeated = (data[start] & 0x20) ? 0 : 1;
+  else
+    c.repeated = 0;
+  switch ((data[start] >> 2) & 0x3)
+    {
+    case 0:
+      c.prio = PRIO_SYSTEM;
+      break;
+    case 1:
+      c.prio = PRIO_URGENT;
+      break;
+    case 2:
+      c.prio = PRIO_NORMAL;
+      break;
+    case 3:
+      c.prio = PRIO_LOW;
+      break;
+    }
+  c.hopcount = (data[start + 1] >> 4) & 0x07;
+  c.AddrType = (data[start + 1] & 0x80) ? GroupAddress : IndividualAddress;
+  if (!data[start] & 0x80 && data[start + 1] & 0x0f)
+    return 0;
+  return new L_Data_PDU (c);
+}
+
+/** the former EIBNetIPPacket::fromPacket, taking a copy of the datagram */
+static EIBNetIPPacket *
+legacyFromPacket (const CArray & c, const struct sockaddr_in src)
+{
+  EIBNetIPPacket *p;
+  unsigned len;
+  if (c () < 6)
+    return 0;
+  if (c[0] != 0x6 || c[1] != 0x10)
+    return 0;
+  len = (c[4] << 8) | c[5];
+  if (len != c ())
+    return 0;
+  p = new EIBNetIPPacket;
+  p->service = (c[2] << 8) | c[3];
+  p->data.set (c.array () + 6, len - 6);
+  p->src = src;
+  return p;
+}
+
+/** the former EIBNetIPRouter::Wanted */
+static bool
+legacyWanted (const CArray & data)
+{
+  unsigned start = data[1] + 2;
+  if (data () < start + 6)
+    return true;
+  if (!(data[start + 1] & 0x80))
+    return true;
+  eibaddr_t dest = (data[start + 4] << 8) | (data[start + 5]);
+  return dest == 0 || groupaddr.test (dest);
+}
+
+/** the former path of a datagram: EIBNetIPSocket::Run queues a packet
+ * object, EIBNetIPSocket::Get copies it out, the router loop copies the
+ * payload and parses it
+ * @return false, if the frame was not queued */
+static bool
+legacyRecv (const uchar * buf, unsigned len, const struct sockaddr_in & src,
+	    Queue < EIBNetIPPacket > &sockq, Queue < LPDU * >&outq)
+{
+  EIBNetIPPacket *p = legacyFromPacket (CArray (buf, len), src);
+  if (!p)
+    return false;
+  sockq.put (*p);
+  delete p;
+  p = new EIBNetIPPacket (sockq.get ());
+  if (p->service != ROUTING_INDICATION || p->data () < 2
+      || p->data[0] != 0x29 || !legacyWanted (p->data))
+    {
+      delete p;
+      return false;
+    }
+  const CArray data = p->data;
+  delete p;
+  L_Data_PDU *c = legacyCEMI_to_L_Data (data);
+  if (!c)
+    return false;
+  outq.put (c);
+  return true;
+}
+
+/** EIBNetIPRouter::Wanted */
+static bool
+viewWanted (const uchar * data, unsigned len)
+{
+  unsigned start = data[1] + 2;
+  if (len < start + 6)
+    return true;
+  if (!(data[start + 1] & 0x80))
+    return true;
+  eibaddr_t dest = (data[start + 4] << 8) | (data[start + 5]);
+  return dest == 0 || groupaddr.test (dest);
+}
+
+/** the current path: EIBNetIPSocket::Run hands the receive buffer to
+ * EIBNetIPRouter::Recv_View, which filters, parses and queues the frame
+ * @return false, if the frame was not queued */
+static bool
+viewRecv (const uchar * buf, unsigned len, Queue < LPDU * >&outq)
+{
+  if (EIBNetIPPacket::Service (buf, len) != ROUTING_INDICATION)
+    return false;
+  const uchar *data = buf + 6;
+  len -= 6;
+  if (len < 2 || data[0] != 0x29 || !viewWanted (data, len))
+    return false;
+  L_Data_PDU *c = CEMI_to_L_Data (data, len);
+  if (!c)
+    return false;
+  outq.put (c);
+  return true;
+}
+
+/** prints the rate of count packets in t microseconds */
+static void
+rate (const char *name, timestamp_t t)
+{
+  if (t == 0)
+    t = 1;
+  printf ("  %-8s %10.0f packets/s %8.1f ns/packet\n", name,
+	  arg.count * 1000000.0 / t, t * 1000.0 / arg.count);
+}
+
+int
+main (int ac, char *ag[])
+{
+  int index;
+  struct sockaddr_in src;
+
+  argp_parse (&argp, ac, ag, 0, &index, &arg);
+  if (index < ac)
+    die ("unexpected parameter");
+  if (arg.count <= 0)
+    die ("invalid count");
+  memset (&src, 0, sizeof (src));
+  groupaddr.set (0x0901);
+  Queue < EIBNetIPPacket > sockq ("socket");
+  Queue < LPDU * >outq ("router");
+
+  for (unsigned f = 0; f < sizeof (frames) / sizeof (frames[0]); f++)
+    {
+      const uchar *buf = frames[f].data;
+      unsigned len = frames[f].len;
+      timestamp_t start, t_copy, t_view;
+
+      if (EIBNetIPPacket::Service (buf, len) != ROUTING_INDICATION)
+	die ("%s: bad sample", frames[f].name);
+
+      start = getTime ();
+      for (int i = 0; i < arg.count; i++)
+	{
+	  if (!legacyRecv (buf, len, src, sockq, outq))
+	    die ("%s: not queued", frames[f].name);
+	  delete outq.get ();
+	}
+      t_copy = getTime () - start;
+
+      start = getTime ();
+      for (int i = 0; i < arg.count; i++)
+	{
+	  if (!viewRecv (buf, len, outq))
+	    die ("%s: not queued", frames[f].name);
+	  delete outq.get ();
+	}
+      t_view = getTime () - start;
+
+      L_Data_PDU *a, *b;
+      if (!legacyRecv (buf, len, src, sockq, outq)
+	  || !viewRecv (buf, len, outq))
+	die ("%s: not queued", frames[f].name);
+      a = (L_Data_PDU *) outq.get ();
+      b = (L_Data_PDU *) outq.get ();
+      if (strcmp (a->Decode ()(), b->Decode ()()))
+	die ("%s: parsers differ", frames[f].name);
+      delete a;
+      delete b;
+
+      printf ("%s\n", frames[f].name);
+      rate ("copy:", t_copy);
+      rate ("view:", t_view);
+    }
+
+  return 0;
+}
@@ -0,0 +1,191 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "common.h"
+#include "sendqueue.h"
+
+/** aborts program with a printf like message */
+void
+die (const char *msg, ...)
+{
+  va_list ap;
+  va_start (ap, msg);
+  vprintf (msg, ap);
+  printf ("\n");
+  va_end (ap);
+
+  exit (1);
+}
+
+/** bus interface recording the frames handed over by the scheduler */
+class RecordingLayer2:public Layer2Interface
+{
+public:
+  Array < L_Data_PDU * >sent;
+
+  RecordingLayer2 (Logs * tr):Layer2Interface (tr, 0)
+  {
+  }
+  bool init ()
+  {
+    return true;
+  }
+  bool Send_L_Data (LPDU * l)
+  {
+    sent.resize (sent () + 1);
+    sent[sent () - 1] = (L_Data_PDU *) l;
+    return true;
+  }
+  LPDU *Get_L_Data (pth_event_t stop)
+  {
+    return 0;
+  }
+  bool addAddress (eibaddr_t addr)
+  {
+    return true;
+  }
+  bool addGroupAddress (eibaddr_t addr)
+  {
+    return true;
+  }
+  bool removeAddress (eibaddr_t addr)
+  {
+    return true;
+  }
+  bool removeGroupAddress (eibaddr_t addr)
+  {
+    return true;
+  }
+  bool enterBusmonitor ()
+  {
+    return true;
+  }
+  bool leaveBusmonitor ()
+  {
+    return true;
+  }
+  bool openVBusmonitor ()
+  {
+    return true;
+  }
+  bool closeVBusmonitor ()
+  {
+    return true;
+  }
+  bool Open ()
+  {
+    return true;
+  }
+  bool Close ()
+  {
+    return true;
+  }
+  eibaddr_t getDefaultAddr ()
+  {
+    return 0x1101;
+  }
+  bool Send_Queue_Empty ()
+  {
+    return true;
+  }
+  bool SendReset ()
+  {
+    return true;
+  }
+  void logtic ()
+  {
+  }
+};
+
+/** builds a group frame; apci 0x00 read, 0x40 response, 0x80 write */
+static L_Data_PDU *
+frame (eibaddr_t dest, uchar apci, uchar value)
+{
+  L_Data_PDU *l = new L_Data_PDU;
+  uchar c[2] = { 0x00, (uchar) (apci | value) };
+  l->data.set (c, 2);
+  l->AddrType = GroupAddress;
+  l->source = 0x1101;
+  l->dest = dest;
+  return l;
+}
+
+int
+main (int ac, char *ag[])
+{
+  Logs t;
+
+  pth_init ();
+
+  RecordingLayer2 l2 (&t);
+  SendScheduler s (&l2, &t);
+  s.setCompaction (true);
+  {
+    SendOrigin o (&s, "test");
+
+    /* nothing is sent before the scheduler thread runs */
+    s.Send (frame (0x0901, 0x80, 1), &o);
+    s.Send (frame (0x0902, 0x80, 1), &o);
+    /* the write to 1/1/2 is queued after it: moved to the end */
+    s.Send (frame (0x0901, 0x80, 2), &o);
+    /* the last frame: replaced in place */
+    s.Send (frame (0x0901, 0x80, 3), &o);
+    /* a read in between keeps the older write */
+    s.Send (frame (0x0901, 0x00, 0), &o);
+    s.Send (frame (0x0901, 0x80, 4), &o);
+    /* reads and responses are never replaced */
+    s.Send (frame (0x0901, 0x40, 5), &o);
+    s.Send (frame (0x0902, 0x80, 2), &o);
+
+    for (int i = 0; i < 100 && !s.Empty (); i++)
+      pth_usleep (10000);
+    if (!s.Empty ())
+      die ("frames not sent");
+  }
+
+  const struct
+  {
+    eibaddr_t dest;
+    uchar apdu;
+  } expect[] = {
+    {0x0901, 0x83},
+    {0x0901, 0x00},
+    {0x0901, 0x84},
+    {0x0901, 0x45},
+    {0x0902, 0x82},
+  };
+  const int n = sizeof (expect) / sizeof (expect[0]);
+  if (l2.sent () != n)
+    die ("%d frames sent, expected %d", l2.sent (), n);
+  for (int i = 0; i < n; i++)
+    {
+      if (l2.sent[i]->dest != expect[i].dest
+	  || l2.sent[i]->data[1] != expect[i].apdu)
+	die ("frame %d: got %04x %02x, expected %04x %02x", i,
+	     l2.sent[i]->dest, l2.sent[i]->data[1], expect[i].dest,
+	     expect[i].apdu);
+      delete l2.sent[i];
+    }
+
+  printf ("send queue compaction order ok\n");
+  return 0;
+}
@@ -18,6 +18,7 @@
  */
 
 #include <stdlib.h>
+#include <poll.h>
 #include "usb.h"
 
 USBLoop::USBLoop( Logs * tr) :
@@ -25,6 +26,8 @@ USBLoop::USBLoop( Logs * tr) :
 {
   TRACEPRINTF(Loggers(), 2, this, "USBLoop Runner");
   pth_mutex_init(&contextmutex);
+  pth_sem_init(&changed);
+  nfdevents = 0;
   int r = libusb_init(&_context);
   if (r)
     {
@@ -32,6 +35,7 @@ USBLoop::USBLoop( Logs * tr) :
           Logging::MSGNOHASH, "USB library init failed, cannot continue");
       throw;
     }
+  Watch(_context);
   Start();
   // libusb_set_debug(c,3);
 }
@@ -56,6 +60,7 @@ void USBLoop::RefreshContext(LoggableObjectInterface *who)
           Logging::MSGNOHASH, "USB library init failed, cannot continue");
       throw;
     }
+  Watch(_context);
   TRACEPRINTF(Loggers(), 3, who ? who: this, "context refresh");
   ReleaseContext();
 }
@@ -71,91 +76,131 @@ void USBLoop::ReleaseContext(LoggableObjectInterface *who)
 {
   TRACEPRINTF(Loggers(), 11, who ? who: this, "LIBUSB mutex release");
   pth_mutex_release(&contextmutex);
+  // a driver may have submitted transfers, the next timeout may be earlier
+  if (who)
+    pth_sem_inc(&changed, FALSE);
+}
+
+void USBLoop::Watch(libusb_context *context)
+// called with the context held
+{
+  libusb_set_pollfd_notifiers(context, PollfdAdded, PollfdRemoved, this);
+  fdschanged = true;
+  pth_sem_inc(&changed, FALSE);
+}
+
+void LIBUSB_CALL USBLoop::PollfdAdded(int fd, short events, void *user_data)
+{
+  USBLoop *l = (USBLoop *) user_data;
+  TRACEPRINTF(l->Loggers(), 9, l, "pollfd %d added", fd);
+  l->fdschanged = true;
+  pth_sem_inc(&l->changed, FALSE);
+}
+
+void LIBUSB_CALL USBLoop::PollfdRemoved(int fd, void *user_data)
+{
+  USBLoop *l = (USBLoop *) user_data;
+  TRACEPRINTF(l->Loggers(), 9, l, "pollfd %d removed", fd);
+  l->fdschanged = true;
+  pth_sem_inc(&l->changed, FALSE);
+}
+
+void USBLoop::FreeEvents()
+{
+  for (int i = 0; i < nfdevents; i++)
+    pth_event_free(fdevents[i], PTH_FREE_THIS);
+  nfdevents = 0;
+}
+
+void USBLoop::BuildEvents(libusb_context *context)
+// called with the context held, only when libusb reported a change; the
+// notifiers may run in any thread, so the events are only touched here
+{
+  const struct libusb_pollfd **usbfd, **usbfd_orig;
+
+  FreeEvents();
+  fdschanged = false;
+  usbfd = libusb_get_pollfds(context);
+  usbfd_orig = usbfd;
+  if (usbfd)
+    while (*usbfd)
+      {
+        if (nfdevents == USBLOOP_MAXFDS)
+          {
+            ERRORLOGSHAPE(Loggers(), LOG_CRIT, Logging::DUPLICATESMAX1PER10SEC, this,
+                Logging::MSGNOHASH, "too many USB file descriptors, ignoring %d", (*usbfd)->fd);
+            usbfd++;
+            continue;
+          }
+        unsigned long until = PTH_UNTIL_FD_EXCEPTION;
+        if ((*usbfd)->events & POLLIN)
+          until |= PTH_UNTIL_FD_READABLE;
+        if ((*usbfd)->events & POLLOUT)
+          until |= PTH_UNTIL_FD_WRITEABLE;
+        fdevents[nfdevents++] = pth_event(PTH_EVENT_FD | until, (*usbfd)->fd);
+        usbfd++;
+      }
+  free(usbfd_orig);
+  TRACEPRINTF(Loggers(), 9, this, "watching %d file descriptors", nfdevents);
 }
 
 void USBLoop::Run(pth_sem_t * stop1)
 {
-  fd_set r, w, e;
-  int rc, fds, i;
+  int i, j;
+  bool ready;
   struct timeval tv, tv1;
-  const struct libusb_pollfd **usbfd, **usbfd_orig;
   pth_event_t stop = pth_event(PTH_EVENT_SEM, stop1);
-  pth_event_t event = pth_event(PTH_EVENT_SEM, stop1);
-  pth_event_t timeout = pth_event(PTH_EVENT_SEM, stop1);
-  pth_event_t tic = pth_event(PTH_EVENT_RTIME, pth_time(5, 0));
+  pth_event_t timeout = pth_event(PTH_EVENT_RTIME, pth_time(0, 0));
+  pth_event_t kick = pth_event(PTH_EVENT_SEM, &changed);
 
   tv1.tv_sec = tv1.tv_usec = 0;
   TRACEPRINTF(Loggers(), 2, this, "USB Loop LoopStart");
   while (pth_event_status(stop) != PTH_STATUS_OCCURRED)
     {
       TRACEPRINTF(Loggers(), 11, this, "LoopBegin");
-      FD_ZERO(&r);
-      FD_ZERO(&w);
-      FD_ZERO(&e);
-      fds = 0;
-      rc = 0;
 
         {
           libusb_context *context = GrabContext();
-          usbfd = libusb_get_pollfds(context);
-          usbfd_orig = usbfd;
-          if (usbfd)
-            while (*usbfd)
-              {
-                if ((*usbfd)->fd > fds)
-                  fds = (*usbfd)->fd;
-                if ((*usbfd)->events & POLLIN)
-                  FD_SET((*usbfd)->fd, &r);
-                if ((*usbfd)->events & POLLOUT)
-                  FD_SET((*usbfd)->fd, &w);
-                FD_SET((*usbfd)->fd, &e);
-                usbfd++;
-              }
-          free(usbfd_orig);
-
+          if (fdschanged)
+            BuildEvents(context);
           i = libusb_get_next_timeout(context, &tv);
           ReleaseContext();
         }
 
       if (i < 0)
         break;
+      for (j = 0; j < nfdevents; j++)
+        pth_event_concat(stop, fdevents[j], NULL);
       if (i > 0)
         {
           pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, timeout,
               pth_time(tv.tv_sec, tv.tv_usec));
           pth_event_concat(stop, timeout, NULL);
         }
-      pth_event(PTH_EVENT_SELECT | PTH_MODE_REUSE, event, &rc, fds + 1, &r, &w,
-          &e);
-      pth_event(PTH_EVENT_RTIME | PTH_MODE_REUSE, tic, pth_time(1, 0));
-      // necessary if descriptors come and go, instead of writing the whole notify we poll ever so often
-      pth_event_concat(stop, event, tic, NULL);
+      // descriptors coming and going or new transfers wake us up, there is
+      // no need to poll
+      pth_event_concat(stop, kick, NULL);
 
       TRACEPRINTF(Loggers(), 11, this, "LoopWait");
 
       pth_wait(stop);
-#if 0
-      // here someone may have unplugged the thing
-
-      GrabContext();
-      if (!libusb_event_handling_ok(context))
-        {
-          ReleaseContext();
-          break;
-        }
-      ReleaseContext();
-#endif
 
       TRACEPRINTF(Loggers(), 9, this, "LoopProcess");
 
       pth_event_isolate(stop);
-      pth_event_isolate(event);
       pth_event_isolate(timeout);
-      pth_event_isolate(tic);
+      pth_event_isolate(kick);
+      ready = i > 0 && pth_event_status(timeout) == PTH_STATUS_OCCURRED;
+      for (j = 0; j < nfdevents; j++)
+        {
+          pth_event_isolate(fdevents[j]);
+          if (pth_event_status(fdevents[j]) == PTH_STATUS_OCCURRED)
+            ready = true;
+        }
+      // all reasons to wake up are handled in this pass
+      pth_sem_set_value(&changed, 0);
 
-      if ((pth_event_status(event) == PTH_STATUS_OCCURRED
-          || pth_event_status(timeout) == PTH_STATUS_OCCURRED)
-          && pth_event_status(stop) != PTH_STATUS_OCCURRED)
+      if (ready && pth_event_status(stop) != PTH_STATUS_OCCURRED)
         {
           libusb_context *context = GrabContext();
           if (libusb_handle_events_timeout(context, &tv1))
@@ -169,9 +214,9 @@ void USBLoop::Run(pth_sem_t * stop1)
     }
   TRACEPRINTF(Loggers(), 2, this, "LoopStop");
 
-  pth_event_free(tic, PTH_FREE_THIS);
+  FreeEvents();
+  pth_event_free(kick, PTH_FREE_THIS);
   pth_event_free(timeout, PTH_FREE_THIS);
-  pth_event_free(event, PTH_FREE_THIS);
   pth_event_free(stop, PTH_FREE_THIS);
 }
 
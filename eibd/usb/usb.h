@@ -28,6 +28,9 @@
 bool USBInit (Logs * tr);
 void USBEnd ();
 
+/** file descriptors of libusb watched at once */
+#define USBLOOP_MAXFDS 16
+
 class USBLoop:public Thread
 {
 private:
@@ -37,6 +40,20 @@ private:
 
   pth_mutex_t contextmutex;
 
+  /** one pth event per libusb file descriptor, kept across iterations */
+  pth_event_t fdevents[USBLOOP_MAXFDS];
+  int nfdevents;
+  /** libusb added or removed a file descriptor since the events were built */
+  bool fdschanged;
+  /** wakes the loop to look at descriptors and timeouts again */
+  pth_sem_t changed;
+
+  void Watch (libusb_context * context);
+  void BuildEvents (libusb_context * context);
+  void FreeEvents ();
+  static void LIBUSB_CALL PollfdAdded (int fd, short events, void *user_data);
+  static void LIBUSB_CALL PollfdRemoved (int fd, void *user_data);
+
 public:
     USBLoop ( Logs * tr);
     ~USBLoop();